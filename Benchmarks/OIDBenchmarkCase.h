@@ -0,0 +1,60 @@
+/*! @file OIDBenchmarkCase.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @var OIDBenchmarkResultsPathEnvironmentKey
+    @brief The environment variable naming the file benchmark results are appended to, one JSON
+        object per line. When unset, results are logged instead.
+ */
+extern NSString *const OIDBenchmarkResultsPathEnvironmentKey;
+
+/*! @class OIDBenchmarkCase
+    @brief Base class of the benchmarks, which records the results of @c measureBlock: in a
+        machine-readable format for regression tracking.
+    @discussion Each result is a JSON object with the keys @c name, @c operations (per sample),
+        @c samples (seconds per operation of each sample), and @c min, @c median and @c max
+        (seconds per operation). Results are appended to the file named by the
+        @c OID_BENCHMARK_RESULTS environment variable, or logged with the prefix
+        @c "OIDBenchmark: ".
+ */
+@interface OIDBenchmarkCase : XCTestCase
+
+/*! @fn measureOperation:operations:block:
+    @brief Measures an operation with @c measureBlock:, and records the time per operation.
+    @param name The name of the result, such as @c "OIDURLQueryComponent.parse".
+    @param operations The number of times @c block performs the operation.
+    @param block Performs the operation @c operations times. Called once per sample.
+ */
+- (void)measureOperation:(NSString *)name
+              operations:(NSUInteger)operations
+                   block:(void (^)(void))block;
+
+/*! @fn recordResultNamed:values:
+    @brief Records a result which isn't a time per operation, such as the throughput and latency
+        percentiles of a load test.
+    @param name The name of the result, such as @c "OIDAuthState.concurrentRefresh".
+    @param values The measured values, recorded alongside @c name.
+ */
+- (void)recordResultNamed:(NSString *)name values:(NSDictionary<NSString *, NSNumber *> *)values;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,91 @@
+/*! @file OIDBenchmarkCase.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDBenchmarkCase.h"
+
+NSString *const OIDBenchmarkResultsPathEnvironmentKey = @"OID_BENCHMARK_RESULTS";
+
+@implementation OIDBenchmarkCase
+
+- (void)measureOperation:(NSString *)name
+              operations:(NSUInteger)operations
+                   block:(void (^)(void))block {
+  NSMutableArray<NSNumber *> *samples = [NSMutableArray array];
+  [self measureBlock:^{
+    CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+    block();
+    CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+    [samples addObject:@(elapsed / MAX(operations, 1u))];
+  }];
+  [self recordResultNamed:name operations:operations samples:samples];
+}
+
+/*! @fn recordResultNamed:operations:samples:
+    @brief Records the time per operation of a measurement.
+    @param name The name of the result.
+    @param operations The number of operations per sample.
+    @param samples The seconds per operation of each sample.
+ */
+- (void)recordResultNamed:(NSString *)name
+               operations:(NSUInteger)operations
+                  samples:(NSArray<NSNumber *> *)samples {
+  if (!samples.count) {
+    return;
+  }
+  NSArray<NSNumber *> *sorted = [samples sortedArrayUsingSelector:@selector(compare:)];
+  [self writeResult:@{
+    @"name" : name,
+    @"operations" : @(operations),
+    @"samples" : samples,
+    @"min" : sorted.firstObject,
+    @"median" : sorted[sorted.count / 2],
+    @"max" : sorted.lastObject,
+  }];
+}
+
+- (void)recordResultNamed:(NSString *)name values:(NSDictionary<NSString *, NSNumber *> *)values {
+  NSMutableDictionary *result = [values mutableCopy];
+  result[@"name"] = name;
+  [self writeResult:result];
+}
+
+/*! @fn writeResult:
+    @brief Appends a result to the results file as a line of JSON, or logs it.
+    @param result The result.
+ */
+- (void)writeResult:(NSDictionary *)result {
+  NSData *JSONData = [NSJSONSerialization dataWithJSONObject:result options:0 error:NULL];
+  NSString *line = [[NSString alloc] initWithData:JSONData encoding:NSUTF8StringEncoding];
+
+  NSString *path = [NSProcessInfo processInfo].environment[OIDBenchmarkResultsPathEnvironmentKey];
+  if (!path.length) {
+    NSLog(@"OIDBenchmark: %@", line);
+    return;
+  }
+  if (![[NSFileManager defaultManager] fileExistsAtPath:path]) {
+    [[NSFileManager defaultManager] createFileAtPath:path contents:nil attributes:nil];
+  }
+  NSFileHandle *fileHandle = [NSFileHandle fileHandleForWritingAtPath:path];
+  XCTAssertNotNil(fileHandle, @"Can't write benchmark results to %@", path);
+  [fileHandle seekToEndOfFile];
+  [fileHandle writeData:[[line stringByAppendingString:@"\n"]
+                            dataUsingEncoding:NSUTF8StringEncoding]];
+  [fileHandle closeFile];
+}
+
+@end
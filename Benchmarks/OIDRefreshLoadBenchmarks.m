@@ -0,0 +1,185 @@
+/*! @file OIDRefreshLoadBenchmarks.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDBenchmarkCase.h"
+
+#import "Source/OIDAuthState.h"
+#import "Source/OIDAuthorizationRequest.h"
+#import "Source/OIDAuthorizationResponse.h"
+#import "Source/OIDResponseTypes.h"
+#import "Source/OIDServiceConfiguration.h"
+#import "Source/OIDTokenResponse.h"
+#import "UnitTests/OIDLoopbackServer.h"
+
+/*! @var kAuthStateCount
+    @brief The number of auth states refreshing concurrently.
+ */
+static const NSUInteger kAuthStateCount = 200;
+
+/*! @var kRounds
+    @brief The number of times every auth state is refreshed.
+ */
+static const NSUInteger kRounds = 5;
+
+/*! @var kServerLatency
+    @brief The latency of the stand-in token endpoint.
+ */
+static const NSTimeInterval kServerLatency = 0.005;
+
+/*! @var kFaultPercentage
+    @brief The percentage of token requests answered with HTTP 503 in the fault injection test.
+ */
+static const uint32_t kFaultPercentage = 5;
+
+/*! @class OIDRefreshLoadBenchmarks
+    @brief Measures the refresh throughput and latency percentiles of many concurrent
+        @c OIDAuthState objects against an @c OIDLoopbackServer.
+ */
+@interface OIDRefreshLoadBenchmarks : OIDBenchmarkCase
+@end
+
+@implementation OIDRefreshLoadBenchmarks {
+  /*! @var _server
+      @brief The stand-in provider.
+   */
+  OIDLoopbackServer *_server;
+}
+
+- (void)setUp {
+  [super setUp];
+  _server = [[OIDLoopbackServer alloc] init];
+  _server.latency = kServerLatency;
+  XCTAssert([_server start]);
+}
+
+- (void)tearDown {
+  [_server stop];
+  _server = nil;
+  [super tearDown];
+}
+
+/*! @fn authStates
+    @brief Creates auth states with expired access tokens and distinct refresh tokens.
+ */
+- (NSArray<OIDAuthState *> *)authStates {
+  OIDServiceConfiguration *configuration =
+      [[OIDServiceConfiguration alloc]
+          initWithAuthorizationEndpoint:[_server URLForPath:OIDLoopbackServerAuthorizationPath]
+                          tokenEndpoint:[_server URLForPath:OIDLoopbackServerTokenPath]];
+  NSMutableArray<OIDAuthState *> *authStates = [NSMutableArray array];
+  for (NSUInteger i = 0; i < kAuthStateCount; i++) {
+    OIDAuthorizationRequest *request =
+        [[OIDAuthorizationRequest alloc] initWithConfiguration:configuration
+                                                      clientId:@"client"
+                                                        scopes:@[ @"openid" ]
+                                                   redirectURL:[NSURL URLWithString:@"app:/cb"]
+                                                  responseType:OIDResponseTypeCode
+                                          additionalParameters:nil];
+    OIDAuthorizationResponse *authorizationResponse =
+        [[OIDAuthorizationResponse alloc] initWithRequest:request
+                                               parameters:@{ @"code" : @"code",
+                                                             @"state" : request.state }];
+    OIDTokenResponse *tokenResponse =
+        [[OIDTokenResponse alloc] initWithRequest:[authorizationResponse tokenExchangeRequest]
+                                       parameters:@{
+          @"access_token" : @"expired",
+          @"expires_in" : @0,
+          @"token_type" : @"Bearer",
+          @"refresh_token" : [NSString stringWithFormat:@"refresh-%lu", (unsigned long)i],
+        }];
+    [authStates addObject:[[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                                                tokenResponse:tokenResponse]];
+  }
+  return authStates;
+}
+
+/*! @fn measureRefreshesNamed:
+    @brief Refreshes every auth state concurrently, @c kRounds times, and records the throughput,
+        the number of failures and the latency percentiles of the actions.
+    @param name The name of the result.
+    @return The number of actions which got an error.
+ */
+- (NSUInteger)measureRefreshesNamed:(NSString *)name {
+  NSArray<OIDAuthState *> *authStates = [self authStates];
+  NSMutableArray<NSNumber *> *latencies = [NSMutableArray array];
+  __block NSUInteger failures = 0;
+
+  CFAbsoluteTime start = CFAbsoluteTimeGetCurrent();
+  for (NSUInteger round = 0; round < kRounds; round++) {
+    __block NSUInteger remaining = authStates.count;
+    for (OIDAuthState *authState in authStates) {
+      [authState setNeedsTokenRefresh];
+      CFAbsoluteTime requested = CFAbsoluteTimeGetCurrent();
+      // actions are called on the main queue, so the counters aren't shared between threads
+      [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                                NSString *_Nullable idToken,
+                                                NSError *_Nullable error) {
+        [latencies addObject:@(CFAbsoluteTimeGetCurrent() - requested)];
+        if (error) {
+          failures++;
+        }
+        remaining--;
+      }];
+    }
+    while (remaining) {
+      [[NSRunLoop mainRunLoop] runMode:NSDefaultRunLoopMode beforeDate:[NSDate distantFuture]];
+    }
+  }
+  CFAbsoluteTime elapsed = CFAbsoluteTimeGetCurrent() - start;
+
+  NSArray<NSNumber *> *sorted = [latencies sortedArrayUsingSelector:@selector(compare:)];
+  NSNumber *(^percentile)(double) = ^NSNumber *(double fraction) {
+    NSUInteger index = MIN((NSUInteger)(fraction * sorted.count), sorted.count - 1);
+    return sorted[index];
+  };
+  [self recordResultNamed:name values:@{
+    @"authStates" : @(authStates.count),
+    @"refreshes" : @(latencies.count),
+    @"failures" : @(failures),
+    @"serverLatency" : @(kServerLatency),
+    @"throughput" : @(latencies.count / elapsed),
+    @"p50" : percentile(0.5),
+    @"p90" : percentile(0.9),
+    @"p99" : percentile(0.99),
+    @"max" : sorted.lastObject,
+  }];
+  return failures;
+}
+
+/*! @fn testConcurrentRefresh
+    @brief Measures concurrent refreshes against a healthy token endpoint.
+ */
+- (void)testConcurrentRefresh {
+  XCTAssertEqual([self measureRefreshesNamed:@"OIDAuthState.concurrentRefresh"], 0u);
+}
+
+/*! @fn testConcurrentRefreshWithFaults
+    @brief Measures concurrent refreshes when some token requests fail with HTTP 503.
+ */
+- (void)testConcurrentRefreshWithFaults {
+  _server.faultInjector = ^OIDLoopbackResponse *_Nullable(OIDLoopbackRequest *request) {
+    if (arc4random_uniform(100) < kFaultPercentage) {
+      return [OIDLoopbackResponse serverErrorResponseWithStatusCode:503];
+    }
+    return nil;
+  };
+  NSUInteger failures = [self measureRefreshesNamed:@"OIDAuthState.concurrentRefreshWithFaults"];
+  XCTAssertLessThan(failures, kAuthStateCount * kRounds);
+}
+
+@end
@@ -17,19 +17,36 @@
  */
 
 #import "OIDAuthState.h"
+#import "OIDAuthStateAuthorizer.h"
 #import "OIDAuthStateChangeDelegate.h"
 #import "OIDAuthStateErrorDelegate.h"
+#import "OIDAuthorizationFlowPresenter.h"
 #import "OIDAuthorizationRequest.h"
 #import "OIDAuthorizationResponse.h"
 #import "OIDAuthorizationService.h"
+#import "OIDClockSkewEstimator.h"
 #import "OIDError.h"
 #import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
 #import "OIDGrantTypes.h"
+#import "OIDIDToken.h"
+#import "OIDIDTokenVerifier.h"
+#import "OIDIntrospectionCache.h"
+#import "OIDIntrospectionRequest.h"
+#import "OIDIntrospectionResponse.h"
+#import "OIDJSONWebKey.h"
+#import "OIDJSONWebKeySetCache.h"
+#import "OIDMetricsObserver.h"
+#import "OIDMonotonicClock.h"
 #import "OIDResponseTypes.h"
+#import "OIDRevocationRequest.h"
+#import "OIDScopeSet.h"
 #import "OIDScopes.h"
 #import "OIDServiceConfiguration.h"
 #import "OIDServiceDiscovery.h"
+#import "OIDSharedTokenStore.h"
 #import "OIDTokenRequest.h"
+#import "OIDTokenRequestScheduler.h"
 #import "OIDTokenResponse.h"
 
 /*! @mainpage AppAuth for iOS
@@ -26,11 +26,16 @@
 @class OIDAuthorizationRequest;
 @class OIDAuthorizationResponse;
 @class OIDAuthState;
+@class OIDClockSkewEstimate;
+@class OIDScopeSet;
+@class OIDSharedTokenStore;
 @class OIDTokenResponse;
 @class OIDTokenRequest;
+@protocol OIDAuthorizationFlowPresenter;
 @protocol OIDAuthorizationFlowSession;
 @protocol OIDAuthStateChangeDelegate;
 @protocol OIDAuthStateErrorDelegate;
+@protocol OIDCancellableRequest;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -44,6 +49,14 @@ typedef void (^OIDAuthStateAction)(NSString *_Nullable accessToken,
                                    NSString *_Nullable idToken,
                                    NSError *_Nullable error);
 
+/*! @typedef OIDUserInfoCallback
+    @brief Represents the type of block used as a callback for userinfo requests.
+    @param claims The claims about the user, if the request succeeded.
+    @param error The error if an error occurred.
+ */
+typedef void (^OIDUserInfoCallback)(NSDictionary<NSString *, id> *_Nullable claims,
+                                    NSError *_Nullable error);
+
 /*! @typedef OIDAuthStateAuthorizationCallback
     @brief The method called when the @c
         OIDAuthState.authStateByPresentingAuthorizationRequest:presentingViewController:callback:
@@ -54,6 +67,16 @@ typedef void (^OIDAuthStateAction)(NSString *_Nullable accessToken,
 typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authState,
                                                   NSError *_Nullable error);
 
+/*! @typedef OIDAuthStateRestoreCallback
+    @brief The method called once @c OIDAuthState.restoreAuthStatesFromArchives:completion: has
+        decoded every archive.
+    @param authStates The restored auth states, in the same order as the archives. Contains
+        @c NSNull for archives which couldn't be decoded.
+    @param errors The errors, in the same order as the archives. Contains @c NSNull for archives
+        which were restored.
+ */
+typedef void (^OIDAuthStateRestoreCallback)(NSArray *authStates, NSArray *errors);
+
 /*! @class OIDAuthState
     @brief A convenience class that retains the auth state between @c OIDAuthorizationResponse%s
         and @c OIDTokenResponse%s.
@@ -77,6 +100,13 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
  */
 @property(nonatomic, readonly, nullable) NSString *scope;
 
+/*! @property scopeSet
+    @brief The scopes of @c scope.
+    @discussion Use @c OIDScopeSet.containsScopeSet: to check whether the grant covers the scopes
+        an operation needs, without splitting @c scope each time.
+ */
+@property(nonatomic, readonly, nullable) OIDScopeSet *scopeSet;
+
 /*! @property lastAuthorizationResponse
     @brief The most recent authorization response used to update the authorization state. For the
         implicit flow, this will contain the latest access token.
@@ -112,6 +142,20 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
  */
 @property(nonatomic, readonly) BOOL isAuthorized;
 
+/*! @property cachedUserInfoClaims
+    @brief The claims about the user from the last userinfo response, if any.
+    @discussion Claims are cached per subject and shared between auth states, so they can be
+        shown before @c OIDAuthState.performUserInfoRequestWithCallback: has completed.
+ */
+@property(nonatomic, readonly, nullable) NSDictionary<NSString *, id> *cachedUserInfoClaims;
+
+/*! @property clockSkewEstimate
+    @brief How far the issuer's clock is ahead of the device's, if it is known, for diagnostics.
+    @discussion Estimated from the issuer's token responses, and archived with the state. Used to
+        count the access token's lifetime from when it was issued.
+ */
+@property(nonatomic, readonly, nullable) OIDClockSkewEstimate *clockSkewEstimate;
+
 /*! @property stateChangeDelegate
     @brief The @c OIDAuthStateChangeDelegate delegate.
     @discussion Use the delegate to observe state changes (and update storage) as well as error
@@ -126,6 +170,15 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
  */
 @property(nonatomic, weak, nullable) id<OIDAuthStateErrorDelegate> errorDelegate;
 
+/*! @property sharedTokenStore
+    @brief The store the tokens are shared with other processes through, if any.
+    @discussion When set, @c OIDAuthState.withFreshTokensPerformAction: first uses fresh tokens
+        another process published, without touching the network, and refreshes through the store,
+        so processes don't refresh at the same time or with a refresh token another already
+        rotated. It isn't archived with the state.
+ */
+@property(atomic, strong, nullable) OIDSharedTokenStore *sharedTokenStore;
+
 #if TARGET_OS_IPHONE
 /*! @fn authStateByPresentingAuthorizationRequest:presentingViewController:callback:
     @brief Convenience method to create a @c OIDAuthState by presenting an authorization request
@@ -164,6 +217,27 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
           completionCallback:(OIDAuthStateAuthorizationCallback)completion;
 #endif
 
+/*! @fn authStateByPresentingAuthorizationRequest:presenter:pipelinesCodeExchange:callback:
+    @brief Convenience method to create a @c OIDAuthState by presenting an authorization request
+        with a presenter provided by the app, and performing the authorization code exchange in
+        the case of code flow requests.
+    @param authorizationRequest The authorization request to present.
+    @param presenter The presenter showing the request to the user.
+    @param pipelinesCodeExchange Whether to start the code exchange as soon as the redirect
+        arrives, rather than once the presenter's UI is gone.
+    @param callback The method called when the request has completed or failed.
+    @return A @c OIDAuthorizationFlowSession instance which will terminate when it
+        receives a @c OIDAuthorizationFlowSession.cancel message, or after processing a
+        @c OIDAuthorizationFlowSession.resumeAuthorizationFlowWithURL: message.
+    @discussion With pipelining, the exchange round trip overlaps the dismissal animation instead
+        of following it. The callback is still only called once the UI is gone.
+ */
++ (id<OIDAuthorizationFlowSession>)authStateByPresentingAuthorizationRequest:
+    (OIDAuthorizationRequest *)authorizationRequest
+                   presenter:(id<OIDAuthorizationFlowPresenter>)presenter
+       pipelinesCodeExchange:(BOOL)pipelinesCodeExchange
+                    callback:(OIDAuthStateAuthorizationCallback)callback;
+
 /*! @fn init
     @internal
     @brief Unavailable. Please use @c initWithAuthorizationResponse:.
@@ -185,6 +259,19 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
     (OIDAuthorizationResponse *)authorizationResponse
                                          tokenResponse:(nullable OIDTokenResponse *)tokenResponse;
 
+/*! @fn restoreAuthStatesFromArchives:completion:
+    @brief Decodes many archived auth states at once, such as those of every account at launch.
+    @param archives The archives, each created by archiving an @c OIDAuthState with
+        \NSKeyedArchiver.
+    @param completion The method called on the main queue once every archive has been decoded.
+    @discussion The archives are decoded concurrently, off the main thread. Equal service
+        configurations and discovery documents are decoded into one shared instance, so accounts
+        of the same provider don't each keep a copy. An archive which can't be decoded fails with
+        @c ::OIDErrorCodeArchiveError, without affecting the others.
+ */
++ (void)restoreAuthStatesFromArchives:(NSArray<NSData *> *)archives
+                           completion:(OIDAuthStateRestoreCallback)completion;
+
 /*! @fn updateWithAuthorizationResponse:error:
     @brief Updates the authorization state based on a new authorization response.
     @param authorizationResponse The new authorization response to update the state with.
@@ -230,8 +317,55 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
         refresh was needed and failed, with the error that caused it to fail.
     @param action The block to execute with a fresh token. This block will be executed on the main
         thread.
+    @return A handle which may be used to abandon the action. Once cancelled, the action is called
+        with an error with code @c ::OIDErrorCodeRequestCanceled. When every action waiting on a
+        refresh has been abandoned, the refresh itself is cancelled if it wasn't sent yet.
+        Otherwise it completes and still updates the state, as its response may carry a rotated
+        refresh token which replaces the one sent.
+    @discussion Actions waiting on a refresh are also called with an error if the state is
+        invalidated before the refresh completes, by a new authorization response or an
+        authorization error, and the refresh is cancelled if it wasn't sent yet.
+ */
+- (id<OIDCancellableRequest>)withFreshTokensPerformAction:(OIDAuthStateAction)action;
+
+/*! @fn withFreshTokensPerformAction:deadline:
+    @brief Calls the block with a valid access token (refreshing it first, if needed), or with an
+        error if a needed refresh failed or didn't complete before a deadline.
+    @param action The block to execute with a fresh token. This block will be executed on the main
+        thread.
+    @param deadline The time by which the action must be called, or nil to wait for the refresh
+        however long it takes. Once the deadline passes, the action is called with an error with
+        code @c ::OIDErrorCodeTimeout.
+    @return A handle which may be used to abandon the action.
+    @discussion The refresh is shared by every action waiting on it, so it isn't bound to any single
+        deadline. Rather, an action whose deadline passes is abandoned, and the refresh cancelled
+        once every action waiting on it has been abandoned, unless it was already sent. A refresh
+        which was sent completes regardless, so that the state keeps any refresh token it rotated,
+        and the next call after one which timed out starts a new refresh if needed.
+ */
+- (id<OIDCancellableRequest>)withFreshTokensPerformAction:(OIDAuthStateAction)action
+                                                 deadline:(nullable NSDate *)deadline;
+
+/*! @fn withFreshTokensForScopes:audience:performAction:
+    @brief Calls the block with a valid access token narrowed to some scopes or audience,
+        obtaining one with the refresh token first if needed.
+    @param scopes The scopes the access token must be limited to, or nil for those of the grant.
+    @param audience The resource server the access token is for, sent as the @c resource
+        parameter, or nil for any.
+    @param action The block to execute with the token. This block will be executed on the main
+        thread.
+    @return A handle which may be used to abandon the action.
+    @discussion Tokens are cached per combination of scopes and audience, each with its own expiry,
+        and concurrent calls for the same combination share a single refresh. Only the least
+        recently used few combinations are kept. The state's own access token is not changed,
+        though a refresh token rotated by the provider replaces that of the state. With neither
+        @c scopes nor @c audience, this is the same as
+        @c OIDAuthState.withFreshTokensPerformAction:.
+    @see https://tools.ietf.org/html/rfc8707
  */
-- (void)withFreshTokensPerformAction:(OIDAuthStateAction)action;
+- (id<OIDCancellableRequest>)withFreshTokensForScopes:(nullable OIDScopeSet *)scopes
+                                             audience:(nullable NSString *)audience
+                                        performAction:(OIDAuthStateAction)action;
 
 /*! @fn setNeedsTokenRefresh
     @brief Forces a token refresh the next time @c OIDAuthState.withFreshTokensPerformAction: is
@@ -239,6 +373,49 @@ typedef void (^OIDAuthStateAuthorizationCallback)(OIDAuthState *_Nullable authSt
  */
 - (void)setNeedsTokenRefresh;
 
+/*! @fn setNeedsTokenRefreshForAccessToken:
+    @brief Forces a token refresh because a resource server rejected an access token, unless the
+        state has already moved on from that token.
+    @param accessToken The access token which was rejected, as passed to the action of
+        @c OIDAuthState.withFreshTokensPerformAction: or
+        @c OIDAuthState.withFreshTokensForScopes:audience:performAction:.
+    @return YES if the next call for fresh tokens will get a different access token, because of
+        this or a refresh already due or under way. NO if the access token was already replaced,
+        in which case the caller can simply retry with fresh tokens, or if refreshes are being
+        forced too often.
+    @discussion Use this rather than @c OIDAuthState.setNeedsTokenRefresh when handling HTTP 401
+        responses: late responses to requests made with an old token then don't trigger more
+        refreshes. Forced refreshes are also limited to a burst of three, and then one every ten
+        seconds, per state. A token which has expired is refreshed regardless.
+ */
+- (BOOL)setNeedsTokenRefreshForAccessToken:(NSString *)accessToken;
+
+/*! @fn freshAccessToken
+    @brief The access token, if it can be used right away.
+    @return The access token, or nil if @c OIDAuthState.withFreshTokensPerformAction: would
+        refresh it first, or wait for a refresh under way.
+ */
+- (nullable NSString *)freshAccessToken;
+
+/*! @fn performUserInfoRequestWithCallback:
+    @brief Fetches the claims about the user from the provider's userinfo endpoint, with a fresh
+        access token.
+    @param callback The method called on the main thread with the claims, or an error.
+    @discussion Once claims are cached, the request is conditional on their @c ETag, so an
+        unchanged profile isn't downloaded again. If the endpoint rejects the access token with
+        HTTP 401, the tokens are refreshed and the request is retried once. A second rejection is
+        reported as an error in the @c ::OIDResourceServerAuthorizationErrorDomain, which can be
+        passed to @c OIDAuthState.updateWithAuthorizationError:.
+
+        Fails with @c ::OIDErrorCodeUserInfoError if the configuration's discovery document has
+        no userinfo endpoint, if the claims are about a different subject than the ID Token, or if
+        the access token was rejected while refreshes are being forced too often to replace it.
+    @return A handle which may be used to cancel the request, whether it is waiting for fresh
+        tokens or was sent.
+    @see http://openid.net/specs/openid-connect-core-1_0.html#UserInfo
+ */
+- (id<OIDCancellableRequest>)performUserInfoRequestWithCallback:(OIDUserInfoCallback)callback;
+
 /*! @fn tokenRefreshRequest
     @brief Creates a token request suitable for refreshing an access token.
     @return A @c OIDTokenRequest suitable for using a refresh token to obtain a new access token.
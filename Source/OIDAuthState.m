@@ -20,15 +20,27 @@
 
 #import "OIDAuthStateChangeDelegate.h"
 #import "OIDAuthStateErrorDelegate.h"
+#import "OIDAuthorizationFlowPresenter.h"
 #import "OIDAuthorizationRequest.h"
 #import "OIDAuthorizationResponse.h"
 #import "OIDAuthorizationService.h"
+#import "OIDClockSkewEstimator.h"
 #import "OIDDefines.h"
 #import "OIDError.h"
 #import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
+#import "OIDIDToken.h"
+#import "OIDMetricsObserver.h"
+#import "OIDMonotonicClock.h"
+#import "OIDScopeSet.h"
+#import "OIDServiceConfiguration.h"
+#import "OIDServiceDiscovery.h"
+#import "OIDSharedTokenStore.h"
 #import "OIDTokenRequest.h"
 #import "OIDTokenResponse.h"
 
+@class OIDAuthStatePendingAction;
+
 /*! @var kRefreshTokenKey
     @brief Key used to encode the @c refreshToken property for @c NSSecureCoding.
  */
@@ -54,6 +66,16 @@ static NSString *const kLastTokenResponseKey = @"lastTokenResponse";
  */
 static NSString *const kAuthorizationErrorKey = @"authorizationError";
 
+/*! @var kClockSkewEstimateKey
+    @brief Key used to encode the issuer's @c OIDClockSkewEstimate for @c NSSecureCoding.
+ */
+static NSString *const kClockSkewEstimateKey = @"clockSkewEstimate";
+
+/*! @var kAccessTokenIssueAgeKey
+    @brief Key used to encode @c _accessTokenIssueAge for @c NSSecureCoding.
+ */
+static NSString *const kAccessTokenIssueAgeKey = @"accessTokenIssueAge";
+
 /*! @var kRefreshTokenRequestException
     @brief The exception thrown when a developer tries to create a refresh request from an
         authorization request with no authorization code.
@@ -66,6 +88,33 @@ static NSString *const kRefreshTokenRequestException =
  */
 static const NSUInteger kExpiryTimeTolerance = 60;
 
+/*! @var kUserInfoCacheCountLimit
+    @brief The number of subjects whose userinfo claims are cached.
+ */
+static const NSUInteger kUserInfoCacheCountLimit = 64;
+
+/*! @var kForcedRefreshBurst
+    @brief The number of refreshes @c setNeedsTokenRefreshForAccessToken: may force in quick
+        succession.
+ */
+static const double kForcedRefreshBurst = 3;
+
+/*! @var kForcedRefreshInterval
+    @brief How long it takes to regain the allowance for one forced refresh, in seconds.
+ */
+static const NSTimeInterval kForcedRefreshInterval = 10;
+
+/*! @var kTokenCacheCapacity
+    @brief The number of scope and audience combinations whose access tokens are cached.
+ */
+static const NSUInteger kTokenCacheCapacity = 8;
+
+/*! @var kResourceKey
+    @brief The token request parameter naming the audience of a downscoped access token.
+    @see https://tools.ietf.org/html/rfc8707
+ */
+static NSString *const kResourceKey = @"resource";
+
 @interface OIDAuthState ()
 
 /*! @property accessToken
@@ -82,6 +131,11 @@ static const NSUInteger kExpiryTimeTolerance = 60;
  */
 @property(nonatomic, readonly, nullable) NSDate *accessTokenExpirationDate;
 
+/*! @property accessTokenExpirationDeadline
+    @brief The monotonic expiration time of the access token, or 0 if it has no known expiry.
+ */
+@property(nonatomic, readonly) OIDMonotonicTime accessTokenExpirationDeadline;
+
 /*! @property idToken
     @brief ID Token value associated with the authenticated session.
     @discussion Rather than using this property directly, you should call
@@ -94,14 +148,292 @@ static const NSUInteger kExpiryTimeTolerance = 60;
  */
 - (void)didChangeState;
 
+/*! @fn cancelPendingAction:
+    @brief Removes an abandoned action from the actions waiting on a refresh, and cancels the
+        refresh if no other action is waiting on it and it hasn't been sent yet.
+    @param pendingAction The abandoned action.
+    @discussion A refresh which was already sent is left to complete, as the provider may have
+        rotated the refresh token, which only its response tells.
+ */
+- (void)cancelPendingAction:(OIDAuthStatePendingAction *)pendingAction;
+
+/*! @fn recordFreshTokensEventWithObserver:cacheResult:startTime:waiterCount:error:
+    @brief Reports a call to @c OIDAuthState.withFreshTokensPerformAction: to the metrics observer.
+    @param observer The metrics observer.
+    @param cacheResult Whether the action was served from the current tokens.
+    @param startTime When the action was requested, or when the refresh started.
+    @param waiterCount The number of actions served.
+    @param error The error the actions were called with, if any.
+ */
+- (void)recordFreshTokensEventWithObserver:(id<OIDMetricsObserver>)observer
+                               cacheResult:(OIDMetricsCacheResult)cacheResult
+                                 startTime:(CFAbsoluteTime)startTime
+                               waiterCount:(NSUInteger)waiterCount
+                                     error:(nullable NSError *)error;
+
+/*! @fn invalidatePendingActionsWithError:
+    @brief Cancels the in-flight refresh, if any and it hasn't been sent yet, and calls the actions
+        waiting on it with an error.
+    @param error The error to call the waiting actions with.
+ */
+- (void)invalidatePendingActionsWithError:(NSError *)error;
+
+@end
+
+/*! @class OIDAuthStatePendingAction
+    @brief An action passed to @c OIDAuthState.withFreshTokensPerformAction:, which is invoked
+        exactly once, whether with tokens, an error, or because it was abandoned.
+ */
+@interface OIDAuthStatePendingAction : NSObject <OIDCancellableRequest>
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithAuthState:action:
+    @brief Designated initializer.
+    @param authState The auth state the action is waiting on.
+    @param action The action.
+ */
+- (instancetype)initWithAuthState:(OIDAuthState *)authState
+                           action:(OIDAuthStateAction)action NS_DESIGNATED_INITIALIZER;
+
+/*! @fn invokeWithAccessToken:idToken:error:
+    @brief Invokes the action on the calling thread, unless it was already invoked.
+    @param accessToken The access token, if any.
+    @param idToken The ID token, if any.
+    @param error The error, if any.
+ */
+- (void)invokeWithAccessToken:(nullable NSString *)accessToken
+                      idToken:(nullable NSString *)idToken
+                        error:(nullable NSError *)error;
+
+/*! @fn cancelWithError:
+    @brief Abandons the action, and invokes it on the main thread with an error unless it was
+        already invoked.
+    @param error The error to invoke the action with.
+ */
+- (void)cancelWithError:(NSError *)error;
+
+@end
+
+@implementation OIDAuthStatePendingAction {
+  __weak OIDAuthState *_authState;
+
+  /*! @var _action
+      @brief The action, nil once it has been invoked. Access is synchronized on @c self.
+   */
+  OIDAuthStateAction _Nullable _action;
+}
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithAuthState:action:));
+
+- (instancetype)initWithAuthState:(OIDAuthState *)authState action:(OIDAuthStateAction)action {
+  self = [super init];
+  if (self) {
+    _authState = authState;
+    _action = action;
+  }
+  return self;
+}
+
+- (void)invokeWithAccessToken:(nullable NSString *)accessToken
+                      idToken:(nullable NSString *)idToken
+                        error:(nullable NSError *)error {
+  OIDAuthStateAction action;
+  @synchronized(self) {
+    action = _action;
+    _action = nil;
+  }
+  if (action) {
+    action(accessToken, idToken, error);
+  }
+}
+
+- (void)cancel {
+  NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                                    underlyingError:nil
+                                        description:nil];
+  [self cancelWithError:error];
+}
+
+- (void)cancelWithError:(NSError *)error {
+  [_authState cancelPendingAction:self];
+  [[OIDAuthorizationService executor] performBlock:^() {
+    [self invokeWithAccessToken:nil idToken:nil error:error];
+  }];
+}
+
 @end
 
+/*! @class OIDUserInfoCacheEntry
+    @brief The claims of a userinfo response, and the @c ETag to revalidate them with.
+ */
+@interface OIDUserInfoCacheEntry : NSObject
+
+/*! @property claims
+    @brief The claims about the user.
+ */
+@property(nonatomic, copy) NSDictionary<NSString *, id> *claims;
+
+/*! @property ETag
+    @brief The entity tag of the response, if it had one.
+ */
+@property(nonatomic, copy, nullable) NSString *ETag;
+
+@end
+
+@implementation OIDUserInfoCacheEntry
+@end
+
+/*! @class OIDUserInfoRequest
+    @brief The handle of a userinfo request, which goes through waiting for fresh tokens, the
+        request itself and possibly a retry, each cancellable in turn.
+ */
+@interface OIDUserInfoRequest : NSObject <OIDCancellableRequest>
+
+/*! @fn setStep:
+    @brief Sets the step under way, which is cancelled right away if the request already was.
+    @param step The step's handle.
+ */
+- (void)setStep:(id<OIDCancellableRequest>)step;
+
+@end
+
+@implementation OIDUserInfoRequest {
+  /*! @var _step
+      @brief The step under way. Access is synchronized on @c self.
+   */
+  id<OIDCancellableRequest> _step;
+
+  /*! @var _cancelled
+      @brief Whether the request was cancelled. Access is synchronized on @c self.
+   */
+  BOOL _cancelled;
+}
+
+- (void)setStep:(id<OIDCancellableRequest>)step {
+  BOOL cancelled;
+  @synchronized(self) {
+    _step = step;
+    cancelled = _cancelled;
+  }
+  if (cancelled) {
+    [step cancel];
+  }
+}
+
+- (void)cancel {
+  id<OIDCancellableRequest> step;
+  @synchronized(self) {
+    _cancelled = YES;
+    step = _step;
+  }
+  // each step calls back with the cancellation, ending the request
+  [step cancel];
+}
+
+@end
+
+/*! @class OIDAuthStateTokenCacheEntry
+    @brief An access token for a combination of scopes and audience, and the refresh of it in
+        flight, if any.
+ */
+@interface OIDAuthStateTokenCacheEntry : NSObject
+
+/*! @property accessToken
+    @brief The access token, if one was obtained.
+ */
+@property(nonatomic, copy, nullable) NSString *accessToken;
+
+/*! @property accessTokenExpirationDeadline
+    @brief The monotonic expiration time of the access token, or 0 if it has no known expiry.
+ */
+@property(nonatomic) OIDMonotonicTime accessTokenExpirationDeadline;
+
+/*! @property pendingActions
+    @brief The actions waiting on the refresh in flight, or nil if there is none.
+ */
+@property(nonatomic, strong, nullable) NSMutableArray<OIDAuthStatePendingAction *> *pendingActions;
+
+/*! @property refreshRequest
+    @brief The refresh in flight, if any.
+ */
+@property(nonatomic, strong, nullable) id<OIDCancellableRequest> refreshRequest;
+
+@end
+
+@implementation OIDAuthStateTokenCacheEntry
+@end
+
+/*! @class OIDAuthStateArchiveInterner
+    @brief The unarchiver delegate of @c OIDAuthState.restoreAuthStatesFromArchives:completion:,
+        which replaces service configurations and discovery documents with an equal instance
+        decoded earlier, so that archives of the same provider share them.
+    @discussion Used by several unarchivers at once, so access is synchronized on @c self.
+ */
+@interface OIDAuthStateArchiveInterner : NSObject <NSKeyedUnarchiverDelegate>
+@end
+
+@implementation OIDAuthStateArchiveInterner {
+  /*! @var _discoveryDocuments
+      @brief The discovery documents decoded so far, keyed by their dictionaries.
+   */
+  NSMutableDictionary<NSDictionary *, OIDServiceDiscovery *> *_discoveryDocuments;
+
+  /*! @var _configurations
+      @brief The configurations decoded so far, keyed by their endpoints and discovery dictionary.
+   */
+  NSMutableDictionary<NSArray *, OIDServiceConfiguration *> *_configurations;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _discoveryDocuments = [NSMutableDictionary dictionary];
+    _configurations = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (nullable id)unarchiver:(NSKeyedUnarchiver *)unarchiver didDecodeObject:(nullable id)object {
+  // subclasses may hold more than they archive, so only exact instances are interned
+  if ([object isMemberOfClass:[OIDServiceDiscovery class]]) {
+    NSDictionary *key = [(OIDServiceDiscovery *)object discoveryDictionary];
+    @synchronized(self) {
+      OIDServiceDiscovery *discoveryDocument = _discoveryDocuments[key];
+      if (discoveryDocument) {
+        return discoveryDocument;
+      }
+      _discoveryDocuments[key] = object;
+    }
+  } else if ([object isMemberOfClass:[OIDServiceConfiguration class]]) {
+    OIDServiceConfiguration *configuration = object;
+    NSArray *key = @[ configuration.authorizationEndpoint,
+                      configuration.tokenEndpoint,
+                      configuration.discoveryDocument.discoveryDictionary ?: [NSNull null] ];
+    @synchronized(self) {
+      OIDServiceConfiguration *internedConfiguration = _configurations[key];
+      if (internedConfiguration) {
+        return internedConfiguration;
+      }
+      _configurations[key] = configuration;
+    }
+  }
+  return object;
+}
+
+@end
 
 @implementation OIDAuthState {
   /*! @var _pendingActions
       @brief Array of pending actions (use @c _pendingActionsSyncObject to synchronize access).
    */
-  NSMutableArray *_pendingActions;
+  NSMutableArray<OIDAuthStatePendingAction *> *_pendingActions;
+
+  /*! @var _refreshRequest
+      @brief The in-flight refresh the pending actions are waiting on (use
+          @c _pendingActionsSyncObject to synchronize access).
+   */
+  id<OIDCancellableRequest> _refreshRequest;
 
   /*! @var _pendingActionsSyncObject
       @brief Object for synchronizing access to @c pendingActions.
@@ -112,10 +444,108 @@ static const NSUInteger kExpiryTimeTolerance = 60;
       @brief If YES, tokens will be refreshed on the next API call regardless of expiry.
    */
   BOOL _needsTokenRefresh;
+
+  /*! @var _userInfoSubject
+      @brief The subject of the last userinfo response, used to find cached claims when the
+          ID Token isn't at hand.
+   */
+  NSString *_userInfoSubject;
+
+  /*! @var _tokenCache
+      @brief The access tokens for other scopes and audiences than the grant's, keyed by
+          @c tokenCacheKeyForScopes:audience: (use @c _pendingActionsSyncObject to synchronize
+          access).
+   */
+  NSMutableDictionary<NSString *, OIDAuthStateTokenCacheEntry *> *_tokenCache;
+
+  /*! @var _tokenCacheKeys
+      @brief The keys of @c _tokenCache, least recently used first (use
+          @c _pendingActionsSyncObject to synchronize access).
+   */
+  NSMutableArray<NSString *> *_tokenCacheKeys;
+
+  /*! @var _refreshTokenInUse
+      @brief Whether a request carrying the refresh token is in flight (use
+          @c _pendingActionsSyncObject to synchronize access).
+   */
+  BOOL _refreshTokenInUse;
+
+  /*! @var _refreshTokenWaiters
+      @brief The refreshes waiting for the request carrying the refresh token to complete, in
+          order (use @c _pendingActionsSyncObject to synchronize access).
+   */
+  NSMutableArray<dispatch_block_t> *_refreshTokenWaiters;
+
+  /*! @var _accessTokenIssueAge
+      @brief How old the access token already was when it was received, by the issuer's clock.
+      @discussion @c expires_in counts from when the token was issued, which the ID Token's
+          @c iat tells when the token response has a newly issued one.
+   */
+  NSTimeInterval _accessTokenIssueAge;
+
+  /*! @var _archivedClockSkewEstimate
+      @brief The estimate archived with the state, used until the issuer's clock is measured
+          again.
+   */
+  OIDClockSkewEstimate *_archivedClockSkewEstimate;
+
+  /*! @var _forcedRefreshAllowance
+      @brief How many refreshes @c setNeedsTokenRefreshForAccessToken: may force right now, as of
+          @c _forcedRefreshAllowanceTime (use @c _pendingActionsSyncObject to synchronize access).
+   */
+  double _forcedRefreshAllowance;
+
+  /*! @var _forcedRefreshAllowanceTime
+      @brief When @c _forcedRefreshAllowance was last updated.
+   */
+  OIDMonotonicTime _forcedRefreshAllowanceTime;
 }
 
 #pragma mark - Convenience initializers
 
+/*! @fn finishAuthorizationWithResponse:error:callback:
+    @brief Creates an auth state from the result of an authorization flow, first performing the
+        authorization code exchange in the case of code flow requests.
+    @param authorizationResponse The authorization response, if the flow succeeded.
+    @param error The error of the flow, if it failed.
+    @param callback The method called with the auth state, or an error.
+ */
++ (void)finishAuthorizationWithResponse:(nullable OIDAuthorizationResponse *)authorizationResponse
+                                  error:(nullable NSError *)error
+                               callback:(OIDAuthStateAuthorizationCallback)callback {
+  // inspects response and processes further if needed (e.g. authorization code exchange)
+  if (!authorizationResponse) {
+    callback(nil, error);
+  } else if ([self isCodeFlowResponse:authorizationResponse]) {
+    // if the request is for the code flow (NB. not hybrid), assumes the code is intended for
+    // this client, and performs the authorization code exchange
+    OIDTokenRequest *tokenExchangeRequest = [authorizationResponse tokenExchangeRequest];
+    [OIDAuthorizationService performTokenRequest:tokenExchangeRequest
+                                        priority:OIDTokenRequestPriorityInteractive
+                                        callback:^(OIDTokenResponse *_Nullable tokenResponse,
+                                                   NSError *_Nullable tokenError) {
+      OIDAuthState *authState;
+      if (tokenResponse) {
+        authState = [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                                          tokenResponse:tokenResponse];
+      }
+      callback(authState, tokenError);
+    }];
+  } else {
+    // implicit or hybrid flow (hybrid flow assumes code is not for this client)
+    OIDAuthState *authState =
+        [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse];
+    callback(authState, error);
+  }
+}
+
+/*! @fn isCodeFlowResponse:
+    @brief Whether a response is of the code flow (NB. not hybrid), so its code is for this client.
+ */
++ (BOOL)isCodeFlowResponse:(OIDAuthorizationResponse *)authorizationResponse {
+  return [authorizationResponse.request.responseType isEqualToString:OIDResponseTypeCode];
+}
+
 #if TARGET_OS_IPHONE
 + (id<OIDAuthorizationFlowSession>)authStateByPresentingAuthorizationRequest:
     (OIDAuthorizationRequest *)authorizationRequest
@@ -127,31 +557,9 @@ static const NSUInteger kExpiryTimeTolerance = 60;
                                   presentingViewController:presentingViewController
           callback:^(OIDAuthorizationResponse *_Nullable authorizationResponse,
                      NSError *_Nullable error) {
-    // inspects response and processes further if needed (e.g. authorization code exchange)
-    if (authorizationResponse) {
-      if ([authorizationRequest.responseType isEqualToString:OIDResponseTypeCode]) {
-        // if the request is for the code flow (NB. not hybrid), assumes the code is intended for
-        // this client, and performs the authorization code exchange
-        OIDTokenRequest *tokenExchangeRequest = [authorizationResponse tokenExchangeRequest];
-        [OIDAuthorizationService performTokenRequest:tokenExchangeRequest
-                                            callback:^(OIDTokenResponse *_Nullable tokenResponse,
-                                                       NSError *_Nullable error) {
-          OIDAuthState *authState;
-          if (tokenResponse) {
-            authState = [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
-                                                              tokenResponse:tokenResponse];
-          }
-          callback(authState, error);
-        }];
-      } else {
-        // implicit or hybrid flow (hybrid flow assumes code is not for this client)
-        OIDAuthState *authState =
-            [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse];
-        callback(authState, error);
-      }
-    } else {
-      callback(nil, error);
-    }
+    [self finishAuthorizationWithResponse:authorizationResponse
+                                    error:error
+                                 callback:callback];
   }];
   return authFlowSession;
 }
@@ -170,35 +578,85 @@ static const NSUInteger kExpiryTimeTolerance = 60;
                                          dismissalCallback:dismissal
           completionCallback:^(OIDAuthorizationResponse * _Nullable authorizationResponse,
                                NSError * _Nullable error) {
-    // inspects response and processes further if needed (e.g. authorization code exchange)
-    if (authorizationResponse) {
-      if ([authorizationRequest.responseType isEqualToString:OIDResponseTypeCode]) {
-        // if the request is for the code flow (NB. not hybrid), assumes the code is intended for
-        // this client, and performs the authorization code exchange
-        OIDTokenRequest *tokenExchangeRequest = [authorizationResponse tokenExchangeRequest];
-        [OIDAuthorizationService performTokenRequest:tokenExchangeRequest
-                                            callback:^(OIDTokenResponse *_Nullable tokenResponse,
-                                                       NSError *_Nullable error) {
-          OIDAuthState *authState;
-          if (tokenResponse) {
-            authState = [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
-                                                              tokenResponse:tokenResponse];
-          }
-          completion(authState, error);
+    [self finishAuthorizationWithResponse:authorizationResponse
+                                    error:error
+                                 callback:completion];
+  }];
+  return authFlowSession;
+}
+#endif
+
++ (id<OIDAuthorizationFlowSession>)authStateByPresentingAuthorizationRequest:
+    (OIDAuthorizationRequest *)authorizationRequest
+                   presenter:(id<OIDAuthorizationFlowPresenter>)presenter
+       pipelinesCodeExchange:(BOOL)pipelinesCodeExchange
+                    callback:(OIDAuthStateAuthorizationCallback)callback {
+  if (!pipelinesCodeExchange) {
+    return [OIDAuthorizationService presentAuthorizationRequest:authorizationRequest
+                                                      presenter:presenter
+                                               responseCallback:nil
+        callback:^(OIDAuthorizationResponse *_Nullable authorizationResponse,
+                   NSError *_Nullable error) {
+      [self finishAuthorizationWithResponse:authorizationResponse
+                                      error:error
+                                   callback:callback];
+    }];
+  }
+
+  // the exchange and the dismissal run concurrently, whichever finishes last calls back, through
+  // the executor as either may finish on any thread
+  NSObject *syncObject = [[NSObject alloc] init];
+  __block BOOL exchangeStarted = NO;
+  __block BOOL finishedOne = NO;
+  __block OIDAuthState *exchangedAuthState;
+  __block NSError *exchangeError;
+  OIDAuthorizationCallback responseCallback =
+      ^(OIDAuthorizationResponse *_Nullable authorizationResponse, NSError *_Nullable error) {
+    if (!authorizationResponse || ![self isCodeFlowResponse:authorizationResponse]) {
+      return;
+    }
+    exchangeStarted = YES;
+    [self finishAuthorizationWithResponse:authorizationResponse
+                                    error:nil
+                                 callback:^(OIDAuthState *_Nullable authState,
+                                            NSError *_Nullable tokenError) {
+      BOOL dismissed;
+      @synchronized(syncObject) {
+        exchangedAuthState = authState;
+        exchangeError = tokenError;
+        dismissed = finishedOne;
+        finishedOne = YES;
+      }
+      if (dismissed) {
+        [[OIDAuthorizationService executor] performBlock:^() {
+          callback(authState, tokenError);
         }];
-      } else {
-        // implicit or hybrid flow (hybrid flow assumes code is not for this client)
-        OIDAuthState *authState =
-            [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse];
-        completion(authState, error);
       }
-    } else {
-      completion(nil, error);
+    }];
+  };
+  return [OIDAuthorizationService presentAuthorizationRequest:authorizationRequest
+                                                    presenter:presenter
+                                             responseCallback:responseCallback
+      callback:^(OIDAuthorizationResponse *_Nullable authorizationResponse,
+                 NSError *_Nullable error) {
+    if (!exchangeStarted) {
+      [self finishAuthorizationWithResponse:authorizationResponse
+                                      error:error
+                                   callback:callback];
+      return;
+    }
+    BOOL exchanged;
+    @synchronized(syncObject) {
+      exchanged = finishedOne;
+      finishedOne = YES;
+    }
+    if (exchanged) {
+      [[OIDAuthorizationService executor] performBlock:^() {
+        callback(exchangedAuthState, exchangeError);
+      }];
     }
   }];
-  return authFlowSession;
 }
-#endif
 
 #pragma mark - Initializers
 
@@ -226,6 +684,11 @@ static const NSUInteger kExpiryTimeTolerance = 60;
   self = [super init];
   if (self) {
     _pendingActionsSyncObject = [[NSObject alloc] init];
+    _tokenCache = [NSMutableDictionary dictionary];
+    _tokenCacheKeys = [NSMutableArray array];
+    _refreshTokenWaiters = [NSMutableArray array];
+    _forcedRefreshAllowance = kForcedRefreshBurst;
+    _forcedRefreshAllowanceTime = [OIDMonotonicClock now];
     [self updateWithAuthorizationResponse:authorizationResponse error:nil];
 
     if (tokenResponse) {
@@ -273,11 +736,83 @@ static const NSUInteger kExpiryTimeTolerance = 60;
     _authorizationError =
         [aDecoder decodeObjectOfClass:[NSError class] forKey:kAuthorizationErrorKey];
     _scope = [aDecoder decodeObjectOfClass:[NSString class] forKey:kScopeKey];
+    _scopeSet = _scope ? [OIDScopeSet scopeSetWithString:_scope] : nil;
     _refreshToken = [aDecoder decodeObjectOfClass:[NSString class] forKey:kRefreshTokenKey];
+    _accessTokenIssueAge = [aDecoder decodeDoubleForKey:kAccessTokenIssueAgeKey];
+    // decoding mustn't change the shared estimates, as the archive may be stale or untrusted
+    _archivedClockSkewEstimate =
+        [aDecoder decodeObjectOfClass:[OIDClockSkewEstimate class] forKey:kClockSkewEstimateKey];
   }
   return self;
 }
 
++ (void)restoreAuthStatesFromArchives:(NSArray<NSData *> *)archives
+                           completion:(OIDAuthStateRestoreCallback)completion {
+  NSUInteger count = archives.count;
+  NSMutableArray *authStates = [NSMutableArray arrayWithCapacity:count];
+  NSMutableArray *errors = [NSMutableArray arrayWithCapacity:count];
+  for (NSUInteger i = 0; i < count; i++) {
+    [authStates addObject:[NSNull null]];
+    [errors addObject:[NSNull null]];
+  }
+  OIDAuthStateArchiveInterner *interner = [[OIDAuthStateArchiveInterner alloc] init];
+  dispatch_queue_t queue = dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_HIGH, 0);
+  dispatch_async(queue, ^() {
+    // decoding dominates, so the results are collected under a lock rather than per thread
+    dispatch_apply(count, queue, ^(size_t index) {
+      NSError *error;
+      OIDAuthState *authState = [self authStateFromArchive:archives[index]
+                                                  interner:interner
+                                                     error:&error];
+      @synchronized(authStates) {
+        if (authState) {
+          authStates[index] = authState;
+        } else {
+          errors[index] = error;
+        }
+      }
+    });
+    [[OIDAuthorizationService executor] performBlock:^() {
+      completion([authStates copy], [errors copy]);
+    }];
+  });
+}
+
+/*! @fn authStateFromArchive:interner:error:
+    @brief Decodes an archived auth state.
+    @param archive The archive.
+    @param interner The delegate sharing configurations across archives.
+    @param error Set to an @c ::OIDErrorCodeArchiveError if the archive couldn't be decoded.
+    @return The auth state, or nil if the archive couldn't be decoded.
+ */
++ (nullable OIDAuthState *)authStateFromArchive:(NSData *)archive
+                                       interner:(OIDAuthStateArchiveInterner *)interner
+                                          error:(NSError **)error {
+  id object = nil;
+  NSString *description = @"The archive doesn't contain an auth state.";
+  // a malformed archive raises, which mustn't abort the restore of the others
+  @try {
+    NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:archive];
+    unarchiver.requiresSecureCoding = YES;
+    unarchiver.delegate = interner;
+    object = [unarchiver decodeObjectOfClass:[OIDAuthState class]
+                                      forKey:NSKeyedArchiveRootObjectKey];
+    [unarchiver finishDecoding];
+  } @catch (NSException *exception) {
+    object = nil;
+    description = exception.reason;
+  }
+  if (![object isKindOfClass:[OIDAuthState class]]) {
+    if (error) {
+      *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeArchiveError
+                                underlyingError:nil
+                                    description:description];
+    }
+    return nil;
+  }
+  return object;
+}
+
 - (void)encodeWithCoder:(NSCoder *)aCoder {
   [aCoder encodeObject:_lastAuthorizationResponse forKey:kLastAuthorizationResponseKey];
   [aCoder encodeObject:_lastTokenResponse forKey:kLastTokenResponseKey];
@@ -289,6 +824,8 @@ static const NSUInteger kExpiryTimeTolerance = 60;
   }
   [aCoder encodeObject:_scope forKey:kScopeKey];
   [aCoder encodeObject:_refreshToken forKey:kRefreshTokenKey];
+  [aCoder encodeDouble:_accessTokenIssueAge forKey:kAccessTokenIssueAgeKey];
+  [aCoder encodeObject:self.clockSkewEstimate forKey:kClockSkewEstimateKey];
 }
 
 #pragma mark - Private convenience getters
@@ -317,6 +854,14 @@ static const NSUInteger kExpiryTimeTolerance = 60;
                             : _lastAuthorizationResponse.accessTokenExpirationDate;
 }
 
+- (OIDMonotonicTime)accessTokenExpirationDeadline {
+  if (_authorizationError) {
+    return 0;
+  }
+  return _lastTokenResponse ? _lastTokenResponse.accessTokenExpirationDeadline
+                            : _lastAuthorizationResponse.accessTokenExpirationDeadline;
+}
+
 - (NSString *)idToken {
   if (_authorizationError) {
     return nil;
@@ -325,12 +870,63 @@ static const NSUInteger kExpiryTimeTolerance = 60;
                             : _lastAuthorizationResponse.idToken;
 }
 
+/*! @fn issuer
+    @brief The issuer whose clock the tokens' times are by.
+ */
+- (nullable NSURL *)issuer {
+  OIDServiceConfiguration *configuration = _lastAuthorizationResponse.request.configuration;
+  return [OIDClockSkewEstimator issuerForConfiguration:configuration];
+}
+
 #pragma mark - Getters
 
 - (BOOL)isAuthorized {
   return !self.authorizationError && (self.accessToken || self.idToken);
 }
 
+- (nullable OIDClockSkewEstimate *)clockSkewEstimate {
+  NSURL *issuer = [self issuer];
+  OIDClockSkewEstimate *estimate =
+      issuer ? [[OIDClockSkewEstimator sharedEstimator] estimateForIssuer:issuer] : nil;
+  return estimate ?: _archivedClockSkewEstimate;
+}
+
+/*! @fn accessTokenIsFresh
+    @brief Whether the access token is valid for longer than @c kExpiryTimeTolerance, counting
+        from when it was issued.
+    @discussion Compares monotonic times, so it's cheap and isn't fooled by changes to the device's
+        time.
+ */
+- (BOOL)accessTokenIsFresh {
+  OIDMonotonicTime deadline = self.accessTokenExpirationDeadline;
+  NSTimeInterval tolerance = kExpiryTimeTolerance + _accessTokenIssueAge;
+  return deadline
+      && [OIDMonotonicClock now] + [OIDMonotonicClock durationForInterval:tolerance] < deadline;
+}
+
+/*! @fn accessTokenIssueAgeOfResponse:
+    @brief How old a just-received access token is by the issuer's clock, if its response has an
+        ID Token to tell when it was issued, and the skew of the issuer's clock is known.
+    @param tokenResponse The token response, which hasn't been recorded in the state yet.
+    @discussion Some providers return the original ID Token when refreshing, whose @c iat says
+        nothing about the new access token, so only an ID Token other than the current one counts.
+ */
+- (NSTimeInterval)accessTokenIssueAgeOfResponse:(OIDTokenResponse *)tokenResponse {
+  NSString *idToken = tokenResponse.idToken;
+  if (!idToken || [idToken isEqualToString:self.idToken]) {
+    return 0;
+  }
+  NSDate *issuedAt = tokenResponse.parsedIDToken.issuedAt;
+  OIDClockSkewEstimate *estimate = self.clockSkewEstimate;
+  if (!issuedAt || !estimate || !tokenResponse.accessTokenExpirationDeadline) {
+    return 0;
+  }
+  NSTimeInterval age = estimate.skew + [[OIDMonotonicClock date] timeIntervalSinceDate:issuedAt];
+  NSTimeInterval lifetime =
+      [OIDMonotonicClock intervalUntilTime:tokenResponse.accessTokenExpirationDeadline];
+  return (age > 0 && age < lifetime) ? age : 0;
+}
+
 #pragma mark - Updating the state
 
 - (void)updateWithAuthorizationResponse:(nullable OIDAuthorizationResponse *)authorizationResponse
@@ -346,16 +942,27 @@ static const NSUInteger kExpiryTimeTolerance = 60;
 
   _lastAuthorizationResponse = authorizationResponse;
 
+  // tokens refreshed for the previous authorization are no longer relevant
+  [self invalidatePendingActionsWithError:
+      [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                       underlyingError:nil
+                           description:@"The authorization changed while refreshing tokens."]];
+
   // clears the last token response and refresh token as these now relate to an old authorization
   // that is no longer relevant
   _lastTokenResponse = nil;
+  _accessTokenIssueAge = 0;
   _refreshToken = nil;
   _authorizationError = nil;
+  _userInfoSubject = nil;
 
   // if the response's scope is nil, it means that it equals that of the request
   // see: https://tools.ietf.org/html/rfc6749#section-5.1
   _scope = (authorizationResponse.scope) ? authorizationResponse.scope
                                          : authorizationResponse.request.scope;
+  _scopeSet = (authorizationResponse.scope)
+      ? [OIDScopeSet scopeSetWithString:authorizationResponse.scope]
+      : authorizationResponse.request.scopeSet;
 
   [self didChangeState];
 }
@@ -383,6 +990,7 @@ static const NSUInteger kExpiryTimeTolerance = 60;
     return;
   }
 
+  _accessTokenIssueAge = [self accessTokenIssueAgeOfResponse:tokenResponse];
   _lastTokenResponse = tokenResponse;
 
   // updates the scope and refresh token if they are present on the TokenResponse.
@@ -391,9 +999,12 @@ static const NSUInteger kExpiryTimeTolerance = 60;
   // https://tools.ietf.org/html/rfc6749#section-6
   if (tokenResponse.scope) {
     _scope = tokenResponse.scope;
+    _scopeSet = [OIDScopeSet scopeSetWithString:_scope];
   }
   if (tokenResponse.refreshToken) {
-    _refreshToken = tokenResponse.refreshToken;
+    @synchronized(_pendingActionsSyncObject) {
+      _refreshToken = tokenResponse.refreshToken;
+    }
   }
 
   [self didChangeState];
@@ -402,6 +1013,9 @@ static const NSUInteger kExpiryTimeTolerance = 60;
 - (void)updateWithAuthorizationError:(NSError *)oauthError {
   _authorizationError = oauthError;
 
+  // no refresh can succeed anymore
+  [self invalidatePendingActionsWithError:oauthError];
+
   [self didChangeState];
 
   [_errorDelegate authState:self didEncounterAuthorizationError:oauthError];
@@ -441,66 +1055,736 @@ static const NSUInteger kExpiryTimeTolerance = 60;
 
 - (void)setNeedsTokenRefresh {
   _needsTokenRefresh = YES;
+  @synchronized(_pendingActionsSyncObject) {
+    for (OIDAuthStateTokenCacheEntry *entry in _tokenCache.allValues) {
+      entry.accessTokenExpirationDeadline = 0;
+    }
+  }
 }
 
-- (void)withFreshTokensPerformAction:(OIDAuthStateAction)action {
+- (BOOL)setNeedsTokenRefreshForAccessToken:(NSString *)accessToken {
+  @synchronized(_pendingActionsSyncObject) {
+    OIDAuthStateTokenCacheEntry *cachedEntry;
+    if ([accessToken isEqualToString:self.accessToken]) {
+      // a refresh that is already due or under way replaces the token anyway
+      if (_needsTokenRefresh || _pendingActions) {
+        return YES;
+      }
+    } else {
+      for (OIDAuthStateTokenCacheEntry *entry in _tokenCache.allValues) {
+        if ([entry.accessToken isEqualToString:accessToken]) {
+          cachedEntry = entry;
+          break;
+        }
+      }
+      // the token was already replaced, so whatever rejected it is out of date
+      if (!cachedEntry) {
+        return NO;
+      }
+      if (!cachedEntry.accessTokenExpirationDeadline || cachedEntry.pendingActions) {
+        return YES;
+      }
+    }
+
+    if (![self takeForcedRefreshAllowance]) {
+      return NO;
+    }
+    if (cachedEntry) {
+      cachedEntry.accessTokenExpirationDeadline = 0;
+    } else {
+      _needsTokenRefresh = YES;
+    }
+    return YES;
+  }
+}
+
+/*! @fn takeForcedRefreshAllowance
+    @brief Takes the allowance for one forced refresh from the token bucket, if there is one left.
+    @discussion The bucket holds up to @c kForcedRefreshBurst, and regains one every
+        @c kForcedRefreshInterval. Must be called with @c _pendingActionsSyncObject held.
+    @return YES if a refresh may be forced.
+ */
+- (BOOL)takeForcedRefreshAllowance {
+  OIDMonotonicTime now = [OIDMonotonicClock now];
+  NSTimeInterval elapsed = -[OIDMonotonicClock intervalUntilTime:_forcedRefreshAllowanceTime];
+  _forcedRefreshAllowance =
+      MIN(kForcedRefreshBurst, _forcedRefreshAllowance + elapsed / kForcedRefreshInterval);
+  _forcedRefreshAllowanceTime = now;
+  if (_forcedRefreshAllowance < 1) {
+    return NO;
+  }
+  _forcedRefreshAllowance -= 1;
+  return YES;
+}
+
+- (nullable NSString *)freshAccessToken {
+  @synchronized(_pendingActionsSyncObject) {
+    // a refresh under way replaces the token, even if it is still fresh
+    if (_needsTokenRefresh || _pendingActions || ![self accessTokenIsFresh]) {
+      return nil;
+    }
+  }
+  return self.accessToken;
+}
+
+- (id<OIDCancellableRequest>)withFreshTokensPerformAction:(OIDAuthStateAction)action {
+  return [self withFreshTokensPerformAction:action deadline:nil];
+}
+
+- (id<OIDCancellableRequest>)withFreshTokensPerformAction:(OIDAuthStateAction)action
+                                                 deadline:(nullable NSDate *)deadline {
   if (!_refreshToken) {
     [OIDErrorUtilities raiseException:kRefreshTokenRequestException];
   }
 
-  if ([self.accessTokenExpirationDate timeIntervalSinceNow] > kExpiryTimeTolerance
-      && !_needsTokenRefresh) {
+  // only timed when someone is listening
+  id<OIDMetricsObserver> metricsObserver = [OIDAuthorizationService metricsObserver];
+  CFAbsoluteTime startTime = metricsObserver ? [OIDMonotonicClock absoluteTime] : 0;
+
+  OIDAuthStatePendingAction *pendingAction =
+      [[OIDAuthStatePendingAction alloc] initWithAuthState:self action:action];
+  if (deadline) {
+    // has no effect if the action was already invoked by then
+    NSTimeInterval delay =
+        deadline.timeIntervalSinceReferenceDate - [OIDMonotonicClock absoluteTime];
+    [[OIDAuthorizationService executor] performBlock:^() {
+      NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeTimeout
+                                        underlyingError:nil
+                                            description:nil];
+      [pendingAction cancelWithError:error];
+    } afterDelay:delay];
+  }
+
+  if (_sharedTokenStore && (_needsTokenRefresh || ![self accessTokenIsFresh])) {
+    // another process may already have refreshed the tokens
+    OIDTokenResponse *sharedTokenResponse =
+        [_sharedTokenStore tokenResponseForRequest:[self tokenRefreshRequest]
+                            newerThanTokenResponse:_lastTokenResponse];
+    if (sharedTokenResponse) {
+      [self updateWithTokenResponse:sharedTokenResponse error:nil];
+      _needsTokenRefresh = NO;
+    }
+  }
+
+  if ([self accessTokenIsFresh] && !_needsTokenRefresh) {
     // access token is valid within tolerance levels, perform action
-    dispatch_async(dispatch_get_main_queue(), ^() {
-      action(self.accessToken, self.idToken, nil);
-    });
-  } else {
-    // else, first refresh the token, then perform action
-    _needsTokenRefresh = NO;
-    NSAssert(_pendingActionsSyncObject, @"_pendingActionsSyncObject cannot be nil");
-    @synchronized(_pendingActionsSyncObject) {
-      // if a token is already in the process of being refreshed, adds to pending actions
-      if (_pendingActions) {
-        [_pendingActions addObject:action];
-        return;
-      }
+    [[OIDAuthorizationService executor] performBlock:^() {
+      [pendingAction invokeWithAccessToken:self.accessToken idToken:self.idToken error:nil];
+    }];
+    if (metricsObserver) {
+      [self recordFreshTokensEventWithObserver:metricsObserver
+                                   cacheResult:OIDMetricsCacheResultHit
+                                     startTime:startTime
+                                   waiterCount:1
+                                         error:nil];
+    }
+    return pendingAction;
+  }
 
-      // creates a list of pending actions, starting with this one
-      _pendingActions = [NSMutableArray arrayWithObject:action];
+  // else, first refresh the token, then perform action
+  _needsTokenRefresh = NO;
+  NSAssert(_pendingActionsSyncObject, @"_pendingActionsSyncObject cannot be nil");
+  NSMutableArray<OIDAuthStatePendingAction *> *pendingActions;
+  @synchronized(_pendingActionsSyncObject) {
+    // if a token is already in the process of being refreshed, adds to pending actions
+    if (_pendingActions) {
+      [_pendingActions addObject:pendingAction];
+      return pendingAction;
     }
 
-    // refresh the tokens
-    OIDTokenRequest *tokenRefreshRequest = [self tokenRefreshRequest];
-    [OIDAuthorizationService performTokenRequest:tokenRefreshRequest
-                                        callback:^(OIDTokenResponse *_Nullable response,
-                                                   NSError *_Nullable error) {
-      dispatch_async(dispatch_get_main_queue(), ^() {
-        // update OIDAuthState based on response
-        if (response) {
-          [self updateWithTokenResponse:response error:nil];
-        } else {
-          if (error.domain == OIDOAuthTokenErrorDomain) {
-            [self updateWithAuthorizationError:error];
-          } else {
-            if ([_errorDelegate respondsToSelector:
-                @selector(authState:didEncounterTransientError:)]) {
-              [_errorDelegate authState:self didEncounterTransientError:error];
-            }
+    // creates a list of pending actions, starting with this one
+    pendingActions = [NSMutableArray arrayWithObject:pendingAction];
+    _pendingActions = pendingActions;
+  }
+
+  // refresh the tokens
+  OIDAuthorizationResponse *authorizationResponse = _lastAuthorizationResponse;
+  OIDTokenCallback refreshCallback = ^(OIDTokenResponse *_Nullable response,
+                                       NSError *_Nullable error) {
+    [[OIDAuthorizationService executor] performBlock:^() {
+      // the grant was replaced while the refresh was in flight, invalidating its actions
+      if (_lastAuthorizationResponse != authorizationResponse) {
+        [self relinquishRefreshToken];
+        return;
+      }
+
+      // update OIDAuthState based on response
+      if (response) {
+        [self updateWithTokenResponse:response error:nil];
+      } else {
+        if (error.domain == OIDOAuthTokenErrorDomain) {
+          [self updateWithAuthorizationError:error];
+        } else if (!(error.domain == OIDGeneralErrorDomain
+                     && error.code == OIDErrorCodeRequestCanceled)) {
+          if ([_errorDelegate respondsToSelector:
+              @selector(authState:didEncounterTransientError:)]) {
+            [_errorDelegate authState:self didEncounterTransientError:error];
           }
         }
+      }
 
-        // nil the pending queue and process everything that was queued up
-        NSArray *actionsToProcess;
-        @synchronized(_pendingActionsSyncObject) {
+      // nil the pending queue and process everything that was queued up, unless the actions were
+      // already abandoned or invalidated while the refresh was in flight
+      NSArray<OIDAuthStatePendingAction *> *actionsToProcess;
+      @synchronized(_pendingActionsSyncObject) {
+        if (_pendingActions == pendingActions) {
           actionsToProcess = _pendingActions;
           _pendingActions = nil;
+          _refreshRequest = nil;
         }
-        for (OIDAuthStateAction actionToProcess in actionsToProcess) {
-          actionToProcess(self.accessToken, self.idToken, error);
+        // a refresh that failed, timed out or was abandoned is retried on the next call, even if
+        // it was forced by setNeedsTokenRefresh rather than by the token expiring
+        if (!response && (!_pendingActions || actionsToProcess)) {
+          _needsTokenRefresh = YES;
         }
-      });
+      }
+      for (OIDAuthStatePendingAction *actionToProcess in actionsToProcess) {
+        [actionToProcess invokeWithAccessToken:self.accessToken idToken:self.idToken error:error];
+      }
+      if (metricsObserver && actionsToProcess) {
+        [self recordFreshTokensEventWithObserver:metricsObserver
+                                     cacheResult:OIDMetricsCacheResultMiss
+                                       startTime:startTime
+                                     waiterCount:actionsToProcess.count
+                                           error:error];
+      }
+      [self relinquishRefreshToken];
     }];
+  };
+  [self performRefreshWithRefreshToken:^() {
+    // every action was abandoned while waiting for another refresh
+    BOOL abandonedWhileWaiting;
+    @synchronized(_pendingActionsSyncObject) {
+      abandonedWhileWaiting = (_pendingActions != pendingActions);
+    }
+    if (abandonedWhileWaiting) {
+      [self relinquishRefreshToken];
+      return;
+    }
+    OIDTokenRequest *tokenRefreshRequest = [self tokenRefreshRequest];
+    id<OIDCancellableRequest> refreshRequest = _sharedTokenStore
+        ? [_sharedTokenStore performTokenRefreshRequest:tokenRefreshRequest
+                                 replacingTokenResponse:_lastTokenResponse
+                                               callback:refreshCallback]
+        : [OIDAuthorizationService performTokenRequest:tokenRefreshRequest
+                                              priority:OIDTokenRequestPriorityForegroundRefresh
+                                              callback:refreshCallback];
+
+    BOOL abandoned;
+    @synchronized(_pendingActionsSyncObject) {
+      abandoned = (_pendingActions != pendingActions);
+      if (!abandoned) {
+        _refreshRequest = refreshRequest;
+      }
+    }
+    // every action was abandoned before the refresh was even started
+    if (abandoned) {
+      [refreshRequest cancel];
+    }
+  }];
+  return pendingAction;
+}
+
+/*! @fn performRefreshWithRefreshToken:
+    @brief Starts a refresh once no other request carrying the refresh token is in flight.
+    @discussion Providers which rotate refresh tokens reject the old one once a refresh completes,
+        with an @c invalid_grant error which would end the whole grant. Serializing the refreshes
+        of the grant's tokens and of downscoped tokens means each uses the latest refresh token.
+    @param refresh Starts the refresh, and calls @c relinquishRefreshToken once it completes.
+ */
+- (void)performRefreshWithRefreshToken:(dispatch_block_t)refresh {
+  @synchronized(_pendingActionsSyncObject) {
+    if (_refreshTokenInUse) {
+      [_refreshTokenWaiters addObject:refresh];
+      return;
+    }
+    _refreshTokenInUse = YES;
+  }
+  refresh();
+}
+
+/*! @fn relinquishRefreshToken
+    @brief Starts the next refresh waiting for the refresh token, if any.
+ */
+- (void)relinquishRefreshToken {
+  dispatch_block_t refresh;
+  @synchronized(_pendingActionsSyncObject) {
+    refresh = _refreshTokenWaiters.firstObject;
+    if (!refresh) {
+      _refreshTokenInUse = NO;
+      return;
+    }
+    [_refreshTokenWaiters removeObjectAtIndex:0];
+  }
+  refresh();
+}
+
+#pragma mark - Downscoped tokens
+
+/*! @fn tokenCacheKeyForScopes:audience:
+    @brief The key of the access token for a combination of scopes and audience.
+ */
++ (NSString *)tokenCacheKeyForScopes:(nullable OIDScopeSet *)scopes
+                            audience:(nullable NSString *)audience {
+  return [NSString stringWithFormat:@"%@\n%@", audience ?: @"", scopes.scopeString ?: @""];
+}
+
+/*! @fn tokenRefreshRequestForScopes:audience:
+    @brief Creates a token request for an access token narrowed to some scopes and audience.
+ */
+- (OIDTokenRequest *)tokenRefreshRequestForScopes:(nullable OIDScopeSet *)scopes
+                                         audience:(nullable NSString *)audience {
+  NSDictionary<NSString *, NSString *> *additionalParameters =
+      audience ? @{ kResourceKey : audience } : nil;
+  return [[OIDTokenRequest alloc]
+      initWithConfiguration:_lastAuthorizationResponse.request.configuration
+                  grantType:OIDGrantTypeRefreshToken
+          authorizationCode:nil
+                redirectURL:_lastAuthorizationResponse.request.redirectURL
+                   clientID:_lastAuthorizationResponse.request.clientID
+                      scope:scopes ? scopes.scopeString : _lastAuthorizationResponse.request.scope
+               refreshToken:_refreshToken
+               codeVerifier:nil
+       additionalParameters:additionalParameters];
+}
+
+- (id<OIDCancellableRequest>)withFreshTokensForScopes:(nullable OIDScopeSet *)scopes
+                                             audience:(nullable NSString *)audience
+                                        performAction:(OIDAuthStateAction)action {
+  if (!scopes && !audience) {
+    return [self withFreshTokensPerformAction:action];
+  }
+  if (!_refreshToken) {
+    [OIDErrorUtilities raiseException:kRefreshTokenRequestException];
+  }
+
+  id<OIDMetricsObserver> metricsObserver = [OIDAuthorizationService metricsObserver];
+  CFAbsoluteTime startTime = metricsObserver ? [OIDMonotonicClock absoluteTime] : 0;
+  OIDAuthStatePendingAction *pendingAction =
+      [[OIDAuthStatePendingAction alloc] initWithAuthState:self action:action];
+  NSString *key = [[self class] tokenCacheKeyForScopes:scopes audience:audience];
+  OIDMonotonicTime freshUntil =
+      [OIDMonotonicClock now] + [OIDMonotonicClock durationForInterval:kExpiryTimeTolerance];
+
+  OIDAuthStateTokenCacheEntry *entry;
+  NSString *cachedAccessToken;
+  NSMutableArray<OIDAuthStatePendingAction *> *pendingActions;
+  @synchronized(_pendingActionsSyncObject) {
+    entry = _tokenCache[key];
+    if (entry) {
+      [_tokenCacheKeys removeObject:key];
+    } else {
+      entry = [[OIDAuthStateTokenCacheEntry alloc] init];
+      _tokenCache[key] = entry;
+      [self evictTokenCacheEntries];
+    }
+    [_tokenCacheKeys addObject:key];
+
+    if (entry.accessToken && freshUntil < entry.accessTokenExpirationDeadline) {
+      cachedAccessToken = entry.accessToken;
+    } else if (entry.pendingActions) {
+      // a refresh for these scopes is already in flight
+      [entry.pendingActions addObject:pendingAction];
+      return pendingAction;
+    } else {
+      pendingActions = [NSMutableArray arrayWithObject:pendingAction];
+      entry.pendingActions = pendingActions;
+    }
+  }
+
+  if (cachedAccessToken) {
+    [[OIDAuthorizationService executor] performBlock:^() {
+      [pendingAction invokeWithAccessToken:cachedAccessToken idToken:self.idToken error:nil];
+    }];
+    if (metricsObserver) {
+      [self recordFreshTokensEventWithObserver:metricsObserver
+                                   cacheResult:OIDMetricsCacheResultHit
+                                     startTime:startTime
+                                   waiterCount:1
+                                         error:nil];
+    }
+    return pendingAction;
+  }
+
+  OIDAuthorizationResponse *authorizationResponse = _lastAuthorizationResponse;
+  OIDTokenCallback refreshCallback = ^(OIDTokenResponse *_Nullable response,
+                                       NSError *_Nullable error) {
+    [[OIDAuthorizationService executor] performBlock:^() {
+      // the grant was replaced while the refresh was in flight
+      if (_lastAuthorizationResponse != authorizationResponse) {
+        [self relinquishRefreshToken];
+        return;
+      }
+      if (response.refreshToken) {
+        // a rotated refresh token replaces that of the whole grant
+        @synchronized(_pendingActionsSyncObject) {
+          _refreshToken = response.refreshToken;
+        }
+        [self didChangeState];
+      }
+      // only an invalid grant concerns the whole grant, as errors such as invalid_scope or
+      // invalid_target only concern these scopes and audience
+      if (error.domain == OIDOAuthTokenErrorDomain && error.code == OIDErrorCodeOAuthInvalidGrant) {
+        [self updateWithAuthorizationError:error];
+      }
+
+      NSArray<OIDAuthStatePendingAction *> *actionsToProcess;
+      @synchronized(_pendingActionsSyncObject) {
+        if (response) {
+          entry.accessToken = response.accessToken;
+          entry.accessTokenExpirationDeadline = response.accessTokenExpirationDeadline;
+        }
+        if (entry.pendingActions == pendingActions) {
+          actionsToProcess = pendingActions;
+          entry.pendingActions = nil;
+          entry.refreshRequest = nil;
+        }
+      }
+      for (OIDAuthStatePendingAction *actionToProcess in actionsToProcess) {
+        [actionToProcess invokeWithAccessToken:response.accessToken
+                                       idToken:self.idToken
+                                         error:error];
+      }
+      if (metricsObserver && actionsToProcess) {
+        [self recordFreshTokensEventWithObserver:metricsObserver
+                                     cacheResult:OIDMetricsCacheResultMiss
+                                       startTime:startTime
+                                     waiterCount:actionsToProcess.count
+                                           error:error];
+      }
+      [self relinquishRefreshToken];
+    }];
+  };
+  // uses the refresh token only once the refreshes before this one are done with it
+  [self performRefreshWithRefreshToken:^() {
+    BOOL abandonedWhileWaiting;
+    @synchronized(_pendingActionsSyncObject) {
+      abandonedWhileWaiting = (entry.pendingActions != pendingActions);
+    }
+    if (abandonedWhileWaiting) {
+      [self relinquishRefreshToken];
+      return;
+    }
+    OIDTokenRequest *tokenRefreshRequest = [self tokenRefreshRequestForScopes:scopes
+                                                                     audience:audience];
+    id<OIDCancellableRequest> refreshRequest =
+        [OIDAuthorizationService performTokenRequest:tokenRefreshRequest
+                                            priority:OIDTokenRequestPriorityForegroundRefresh
+                                            callback:refreshCallback];
+
+    BOOL abandoned;
+    @synchronized(_pendingActionsSyncObject) {
+      abandoned = (entry.pendingActions != pendingActions);
+      if (!abandoned) {
+        entry.refreshRequest = refreshRequest;
+      }
+    }
+    if (abandoned) {
+      [refreshRequest cancel];
+    }
+  }];
+  return pendingAction;
+}
+
+/*! @fn evictTokenCacheEntries
+    @brief Evicts the least recently used access tokens while the cache is over capacity. Entries
+        with a refresh in flight are kept. Must be called synchronized on
+        @c _pendingActionsSyncObject.
+ */
+- (void)evictTokenCacheEntries {
+  NSUInteger index = 0;
+  while (_tokenCache.count > kTokenCacheCapacity && index < _tokenCacheKeys.count) {
+    NSString *key = _tokenCacheKeys[index];
+    if (_tokenCache[key].pendingActions) {
+      index++;
+      continue;
+    }
+    [_tokenCache removeObjectForKey:key];
+    [_tokenCacheKeys removeObjectAtIndex:index];
+  }
+}
+
+- (void)cancelPendingAction:(OIDAuthStatePendingAction *)pendingAction {
+  id<OIDCancellableRequest> refreshRequest;
+  @synchronized(_pendingActionsSyncObject) {
+    if (![_pendingActions containsObject:pendingAction]) {
+      for (OIDAuthStateTokenCacheEntry *entry in _tokenCache.allValues) {
+        if ([entry.pendingActions containsObject:pendingAction]) {
+          [entry.pendingActions removeObjectIdenticalTo:pendingAction];
+          if (!entry.pendingActions.count) {
+            refreshRequest = entry.refreshRequest;
+            entry.refreshRequest = nil;
+            entry.pendingActions = nil;
+          }
+          break;
+        }
+      }
+      [refreshRequest cancelIfNotSent];
+      return;
+    }
+    [_pendingActions removeObjectIdenticalTo:pendingAction];
+    if (!_pendingActions.count) {
+      refreshRequest = _refreshRequest;
+      _refreshRequest = nil;
+      _pendingActions = nil;
+    }
+  }
+  // a refresh still waiting in _refreshTokenWaiters returns once it finds itself abandoned
+  [refreshRequest cancelIfNotSent];
+}
+
+- (void)recordFreshTokensEventWithObserver:(id<OIDMetricsObserver>)observer
+                               cacheResult:(OIDMetricsCacheResult)cacheResult
+                                 startTime:(CFAbsoluteTime)startTime
+                               waiterCount:(NSUInteger)waiterCount
+                                     error:(nullable NSError *)error {
+  OIDMetricsEvent *event = [[OIDMetricsEvent alloc] initWithType:OIDMetricsEventTypeFreshTokens];
+  event.URL = _lastAuthorizationResponse.request.configuration.tokenEndpoint;
+  event.duration = [OIDMonotonicClock absoluteTime] - startTime;
+  event.cacheResult = cacheResult;
+  event.coalescedWaiterCount = waiterCount;
+  event.error = error;
+  [observer didRecordMetricsEvent:event];
+}
+
+- (void)invalidatePendingActionsWithError:(NSError *)error {
+  NSMutableArray<OIDAuthStatePendingAction *> *actionsToProcess = [NSMutableArray array];
+  NSMutableArray<id<OIDCancellableRequest>> *refreshRequests = [NSMutableArray array];
+  @synchronized(_pendingActionsSyncObject) {
+    if (_pendingActions) {
+      [actionsToProcess addObjectsFromArray:_pendingActions];
+    }
+    if (_refreshRequest) {
+      [refreshRequests addObject:_refreshRequest];
+    }
+    _pendingActions = nil;
+    _refreshRequest = nil;
+    // downscoped tokens were issued for the previous grant
+    for (OIDAuthStateTokenCacheEntry *entry in _tokenCache.allValues) {
+      if (entry.pendingActions) {
+        [actionsToProcess addObjectsFromArray:entry.pendingActions];
+      }
+      if (entry.refreshRequest) {
+        [refreshRequests addObject:entry.refreshRequest];
+      }
+      entry.pendingActions = nil;
+      entry.refreshRequest = nil;
+    }
+    [_tokenCache removeAllObjects];
+    [_tokenCacheKeys removeAllObjects];
+  }
+  for (id<OIDCancellableRequest> refreshRequest in refreshRequests) {
+    [refreshRequest cancelIfNotSent];
+  }
+  if (!actionsToProcess.count) {
+    return;
+  }
+  [[OIDAuthorizationService executor] performBlock:^() {
+    for (OIDAuthStatePendingAction *actionToProcess in actionsToProcess) {
+      [actionToProcess invokeWithAccessToken:nil idToken:nil error:error];
+    }
+  }];
+}
+
+#pragma mark - UserInfo
+
+/*! @fn userInfoCache
+    @brief The userinfo claims of recently seen subjects, shared by every auth state and keyed by
+        endpoint and subject.
+ */
++ (NSCache<NSString *, OIDUserInfoCacheEntry *> *)userInfoCache {
+  static NSCache<NSString *, OIDUserInfoCacheEntry *> *cache;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    cache = [[NSCache alloc] init];
+    cache.countLimit = kUserInfoCacheCountLimit;
+  });
+  return cache;
+}
+
+/*! @fn userInfoEndpoint
+    @brief The userinfo endpoint of the provider, if its configuration was discovered.
+ */
+- (nullable NSURL *)userInfoEndpoint {
+  return _lastAuthorizationResponse.request.configuration.discoveryDocument.userinfoEndpoint;
+}
+
+/*! @fn userInfoCacheKeyForSubject:
+    @brief The key of a subject's claims in the userinfo cache.
+ */
+- (nullable NSString *)userInfoCacheKeyForSubject:(nullable NSString *)subject {
+  NSURL *userInfoEndpoint = [self userInfoEndpoint];
+  if (!subject || !userInfoEndpoint) {
+    return nil;
+  }
+  return [NSString stringWithFormat:@"%@ %@", userInfoEndpoint.absoluteString, subject];
+}
+
+/*! @fn subject
+    @brief The subject the tokens were issued for, if known.
+ */
+- (nullable NSString *)subject {
+  OIDIDToken *idToken = _lastTokenResponse.parsedIDToken
+      ?: _lastAuthorizationResponse.parsedIDToken;
+  return idToken.subject ?: _userInfoSubject;
+}
+
+- (nullable NSDictionary<NSString *, id> *)cachedUserInfoClaims {
+  NSString *cacheKey = [self userInfoCacheKeyForSubject:[self subject]];
+  return cacheKey ? [[[self class] userInfoCache] objectForKey:cacheKey].claims : nil;
+}
+
+- (id<OIDCancellableRequest>)performUserInfoRequestWithCallback:(OIDUserInfoCallback)callback {
+  OIDUserInfoRequest *request = [[OIDUserInfoRequest alloc] init];
+  [self performUserInfoRequest:request retryingUnauthorized:YES callback:callback];
+  return request;
+}
+
+/*! @fn performUserInfoRequest:retryingUnauthorized:callback:
+    @brief Performs a userinfo request with a fresh access token.
+    @param request The handle of the request, which is given each step.
+    @param retriesUnauthorized Whether to refresh the tokens and retry once if the endpoint
+        rejects the access token.
+    @param callback The method called on the main thread with the claims, or an error.
+ */
+- (void)performUserInfoRequest:(OIDUserInfoRequest *)request
+          retryingUnauthorized:(BOOL)retriesUnauthorized
+                      callback:(OIDUserInfoCallback)callback {
+  NSURL *userInfoEndpoint = [self userInfoEndpoint];
+  if (!userInfoEndpoint) {
+    NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeUserInfoError
+                                      underlyingError:nil
+                                          description:@"The provider has no userinfo endpoint."];
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(nil, error);
+    }];
+    return;
+  }
+
+  id<OIDCancellableRequest> freshTokensRequest =
+      [self withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                       NSString *_Nullable idToken,
+                                       NSError *_Nullable error) {
+    if (!accessToken) {
+      callback(nil, error);
+      return;
+    }
+    NSString *subject = [self subject];
+    NSString *cacheKey = [self userInfoCacheKeyForSubject:subject];
+    OIDUserInfoCacheEntry *cachedEntry =
+        cacheKey ? [[[self class] userInfoCache] objectForKey:cacheKey] : nil;
+
+    NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:userInfoEndpoint];
+    // revalidated against the per-subject cache rather than NSURLCache, which isn't keyed by user
+    URLRequest.cachePolicy = NSURLRequestReloadIgnoringLocalCacheData;
+    [URLRequest setValue:[@"Bearer " stringByAppendingString:accessToken]
+      forHTTPHeaderField:@"Authorization"];
+    [URLRequest setValue:@"application/json" forHTTPHeaderField:@"Accept"];
+    if (cachedEntry.ETag) {
+      [URLRequest setValue:cachedEntry.ETag forHTTPHeaderField:@"If-None-Match"];
+    }
+
+    id<OIDCancellableRequest> userInfoRequest =
+        [OIDAuthorizationService performUserInfoRequest:URLRequest
+                                               callback:^(NSHTTPURLResponse *_Nullable response,
+                                                          NSData *_Nullable data,
+                                                          NSError *_Nullable userInfoError) {
+      if (!response) {
+        callback(nil, userInfoError);
+        return;
+      }
+      if (response.statusCode == 401 && retriesUnauthorized) {
+        // the access token was revoked or expired early, so retries once with a new one, if this
+        // forced a refresh or another caller already replaced the token
+        BOOL replaced = [self setNeedsTokenRefreshForAccessToken:accessToken]
+            || ![accessToken isEqualToString:self.accessToken];
+        if (replaced) {
+          [self performUserInfoRequest:request retryingUnauthorized:NO callback:callback];
+          return;
+        }
+        // refreshes are being forced too often, so the same token would only be rejected again
+        NSError *serverError = [OIDErrorUtilities HTTPErrorWithHTTPResponse:response data:data];
+        callback(nil, [OIDErrorUtilities errorWithCode:OIDErrorCodeUserInfoError
+                                       underlyingError:serverError
+                                           description:@"The access token was rejected."]);
+        return;
+      }
+      NSError *claimsError = nil;
+      NSDictionary<NSString *, id> *claims = [self claimsFromUserInfoResponse:response
+                                                                         data:data
+                                                                  cachedEntry:cachedEntry
+                                                                      subject:subject
+                                                                        error:&claimsError];
+      callback(claims, claimsError);
+    }];
+    [request setStep:userInfoRequest];
+  }];
+  // the action is always called asynchronously, so replaces this step rather than the reverse
+  [request setStep:freshTokensRequest];
+}
+
+/*! @fn claimsFromUserInfoResponse:data:cachedEntry:subject:error:
+    @brief Checks a userinfo response, caching the claims if it has new ones.
+    @param response The HTTP response.
+    @param data The response body.
+    @param cachedEntry The cached claims the request was conditional on, if any.
+    @param subject The subject the tokens were issued for, if known.
+    @param error Set to the error if the response has no valid claims.
+    @return The claims, or nil if the response has no valid claims.
+ */
+- (nullable NSDictionary<NSString *, id> *)
+    claimsFromUserInfoResponse:(NSHTTPURLResponse *)response
+                          data:(nullable NSData *)data
+                   cachedEntry:(nullable OIDUserInfoCacheEntry *)cachedEntry
+                       subject:(nullable NSString *)subject
+                         error:(NSError **)error {
+  if (response.statusCode == 304 && cachedEntry) {
+    return cachedEntry.claims;
+  }
+  if (response.statusCode != 200) {
+    NSError *serverError = [OIDErrorUtilities HTTPErrorWithHTTPResponse:response data:data];
+    *error = (response.statusCode == 401)
+        ? [OIDErrorUtilities resourceServerAuthorizationErrorWithCode:response.statusCode
+                                                        errorResponse:nil
+                                                      underlyingError:serverError]
+        : [OIDErrorUtilities errorWithCode:OIDErrorCodeServerError
+                           underlyingError:serverError
+                               description:nil];
+    return nil;
+  }
+
+  NSError *JSONError;
+  NSDictionary<NSString *, id> *claims =
+      data ? [NSJSONSerialization JSONObjectWithData:data options:0 error:&JSONError] : nil;
+  NSString *claimedSubject =
+      [claims isKindOfClass:[NSDictionary class]] ? claims[@"sub"] : nil;
+  if (![claimedSubject isKindOfClass:[NSString class]]) {
+    *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeJSONDeserializationError
+                              underlyingError:JSONError
+                                  description:@"Not a userinfo response."];
+    return nil;
+  }
+  // the claims must be about the user the tokens were issued for
+  // http://openid.net/specs/openid-connect-core-1_0.html#UserInfoResponse
+  if (subject && ![claimedSubject isEqualToString:subject]) {
+    *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeUserInfoError
+                              underlyingError:nil
+                                  description:@"The claims are about a different subject."];
+    return nil;
+  }
+
+  OIDUserInfoCacheEntry *entry = [[OIDUserInfoCacheEntry alloc] init];
+  entry.claims = claims;
+  // header names are case-insensitive, but allHeaderFields may not be on older systems
+  for (NSString *name in response.allHeaderFields) {
+    if ([name caseInsensitiveCompare:@"ETag"] == NSOrderedSame) {
+      entry.ETag = response.allHeaderFields[name];
+    }
   }
+  _userInfoSubject = claimedSubject;
+  [[[self class] userInfoCache] setObject:entry
+                                   forKey:[self userInfoCacheKeyForSubject:claimedSubject]];
+  return claims;
 }
 
 #pragma mark -
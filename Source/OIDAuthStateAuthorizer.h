@@ -0,0 +1,113 @@
+/*! @file OIDAuthStateAuthorizer.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDAuthState;
+@protocol OIDCancellableRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @typedef OIDAuthStateAuthorizerCallback
+    @brief Represents the type of block used as a callback for authorizing requests.
+    @param error The error if the requests couldn't be authorized, in which case they were left
+        unchanged.
+ */
+typedef void (^OIDAuthStateAuthorizerCallback)(NSError *_Nullable error);
+
+/*! @typedef OIDAuthStateAuthorizerDataTaskCallback
+    @brief Represents the type of block used as a callback for performing an authorized request,
+        the same as that of an \NSURLSessionDataTask.
+ */
+typedef void (^OIDAuthStateAuthorizerDataTaskCallback)(NSData *_Nullable data,
+                                                       NSURLResponse *_Nullable response,
+                                                       NSError *_Nullable error);
+
+/*! @class OIDAuthStateAuthorizer
+    @brief Authorizes requests to resource servers with the fresh access token of an
+        @c OIDAuthState.
+    @discussion Requests are signed with a @c Bearer @c Authorization header. While the tokens are
+        being refreshed, requests are held in a bounded queue, and all released together when the
+        new access token arrives. The time each batch spends queued is reported to the
+        @c OIDAuthorizationService.metricsObserver as an
+        @c ::OIDMetricsEventTypeRequestAuthorization event.
+    @see https://tools.ietf.org/html/rfc6750#section-2.1
+ */
+@interface OIDAuthStateAuthorizer : NSObject
+
+/*! @property authState
+    @brief The auth state whose access token requests are authorized with.
+ */
+@property(nonatomic, readonly) OIDAuthState *authState;
+
+/*! @property maxQueuedRequests
+    @brief The maximum number of requests held while waiting for a refresh. Requests are
+        authorized without being held when the access token is fresh.
+ */
+@property(nonatomic, readonly) NSUInteger maxQueuedRequests;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithAuthState:.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithAuthState:
+    @brief Creates an authorizer which holds up to 64 requests while waiting for fresh tokens.
+    @param authState The auth state whose access token requests are authorized with.
+ */
+- (instancetype)initWithAuthState:(OIDAuthState *)authState;
+
+/*! @fn initWithAuthState:maxQueuedRequests:
+    @brief Designated initializer.
+    @param authState The auth state whose access token requests are authorized with.
+    @param maxQueuedRequests The maximum number of requests held while waiting for fresh tokens.
+ */
+- (instancetype)initWithAuthState:(OIDAuthState *)authState
+                maxQueuedRequests:(NSUInteger)maxQueuedRequests NS_DESIGNATED_INITIALIZER;
+
+/*! @fn authorizeRequests:callback:
+    @brief Sets the @c Authorization header of requests to a fresh access token.
+    @param requests The requests to authorize.
+    @param callback The method called on the main thread once the requests were authorized, or
+        with an error. If the requests would have to wait for a refresh and adding them would
+        exceed @c maxQueuedRequests, the error has code @c ::OIDErrorCodeRequestQueueFull.
+    @return A handle which removes the requests from the queue if cancelled before they were
+        authorized.
+ */
+- (id<OIDCancellableRequest>)authorizeRequests:(NSArray<NSMutableURLRequest *> *)requests
+                                      callback:(OIDAuthStateAuthorizerCallback)callback;
+
+/*! @fn performRequest:session:completionHandler:
+    @brief Authorizes and performs a request, replaying it once with a fresh access token if the
+        resource server rejects the first one with HTTP 401.
+    @param request The request, which is copied rather than modified.
+    @param session The session to perform the request in.
+    @param completionHandler The method called with the result of the last attempt, on the
+        session's delegate queue, or on the main thread if the request couldn't be authorized.
+    @discussion The rejected token is passed to
+        @c OIDAuthState.setNeedsTokenRefreshForAccessToken:, so a burst of rejections of the same
+        token only refreshes it once.
+ */
+- (void)performRequest:(NSURLRequest *)request
+               session:(NSURLSession *)session
+     completionHandler:(OIDAuthStateAuthorizerDataTaskCallback)completionHandler;
+
+@end
+
+NS_ASSUME_NONNULL_END
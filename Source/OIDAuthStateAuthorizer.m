@@ -0,0 +1,352 @@
+/*! @file OIDAuthStateAuthorizer.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDAuthStateAuthorizer.h"
+
+#import "OIDAuthState.h"
+#import "OIDAuthorizationService.h"
+#import "OIDDefines.h"
+#import "OIDError.h"
+#import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
+#import "OIDMetricsObserver.h"
+#import "OIDMonotonicClock.h"
+
+/*! @var kDefaultMaxQueuedRequests
+    @brief The default of @c OIDAuthStateAuthorizer.maxQueuedRequests.
+ */
+static const NSUInteger kDefaultMaxQueuedRequests = 64;
+
+/*! @var kAuthorizationHeader
+    @brief The header requests are authorized with.
+ */
+static NSString *const kAuthorizationHeader = @"Authorization";
+
+/*! @var kUnauthorizedStatusCode
+    @brief The HTTP status with which resource servers reject access tokens.
+ */
+static const NSInteger kUnauthorizedStatusCode = 401;
+
+/*! @typedef OIDAuthStateAuthorizerBatchCallback
+    @brief Represents the type of block called when a batch of requests was authorized.
+    @param accessToken The access token the requests were authorized with, if they were.
+    @param error The error if the requests couldn't be authorized.
+ */
+typedef void (^OIDAuthStateAuthorizerBatchCallback)(NSString *_Nullable accessToken,
+                                                    NSError *_Nullable error);
+
+NS_ASSUME_NONNULL_BEGIN
+
+@class OIDAuthStateAuthorizerBatch;
+
+@interface OIDAuthStateAuthorizer ()
+
+/*! @fn authorizeRequests:batchCallback:
+    @brief Queues requests to be authorized with the next fresh access token.
+    @param requests The requests to authorize.
+    @param callback The method called on the main thread with the access token, or an error.
+ */
+- (id<OIDCancellableRequest>)authorizeRequests:(NSArray<NSMutableURLRequest *> *)requests
+                                 batchCallback:(OIDAuthStateAuthorizerBatchCallback)callback;
+
+/*! @fn cancelBatch:
+    @brief Removes a batch from the queue, and calls it with a cancellation error if it was still
+        queued.
+ */
+- (void)cancelBatch:(OIDAuthStateAuthorizerBatch *)batch;
+
+@end
+
+/*! @class OIDAuthStateAuthorizerBatch
+    @brief Requests passed together to @c OIDAuthStateAuthorizer.authorizeRequests:callback:.
+ */
+@interface OIDAuthStateAuthorizerBatch : NSObject <OIDCancellableRequest>
+
+/*! @property requests
+    @brief The requests to authorize.
+ */
+@property(nonatomic, readonly) NSArray<NSMutableURLRequest *> *requests;
+
+/*! @property callback
+    @brief The method called when the requests were authorized.
+ */
+@property(nonatomic, readonly) OIDAuthStateAuthorizerBatchCallback callback;
+
+/*! @property queueTime
+    @brief When the batch was queued.
+ */
+@property(nonatomic, readonly) CFAbsoluteTime queueTime;
+
+/*! @property authorizer
+    @brief The authorizer the batch is queued in.
+ */
+@property(nonatomic, weak, readonly) OIDAuthStateAuthorizer *authorizer;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithRequests:callback:authorizer:
+    @brief Designated initializer.
+ */
+- (instancetype)initWithRequests:(NSArray<NSMutableURLRequest *> *)requests
+                        callback:(OIDAuthStateAuthorizerBatchCallback)callback
+                      authorizer:(OIDAuthStateAuthorizer *)authorizer NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation OIDAuthStateAuthorizerBatch
+
+- (instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithRequests:callback:authorizer:));
+
+- (instancetype)initWithRequests:(NSArray<NSMutableURLRequest *> *)requests
+                        callback:(OIDAuthStateAuthorizerBatchCallback)callback
+                      authorizer:(OIDAuthStateAuthorizer *)authorizer {
+  self = [super init];
+  if (self) {
+    _requests = [requests copy];
+    _callback = [callback copy];
+    _queueTime = [OIDMonotonicClock absoluteTime];
+    _authorizer = authorizer;
+  }
+  return self;
+}
+
+- (void)cancel {
+  [_authorizer cancelBatch:self];
+}
+
+@end
+
+@implementation OIDAuthStateAuthorizer {
+  /*! @var _queue
+      @brief The batches waiting for fresh tokens, in order (use @c self to synchronize access).
+   */
+  NSMutableArray<OIDAuthStateAuthorizerBatch *> *_queue;
+
+  /*! @var _queuedRequestCount
+      @brief The number of requests in @c _queue.
+   */
+  NSUInteger _queuedRequestCount;
+
+  /*! @var _waitingForTokens
+      @brief Whether fresh tokens were requested for the batches in @c _queue.
+   */
+  BOOL _waitingForTokens;
+}
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithAuthState:));
+
+- (instancetype)initWithAuthState:(OIDAuthState *)authState {
+  return [self initWithAuthState:authState maxQueuedRequests:kDefaultMaxQueuedRequests];
+}
+
+- (instancetype)initWithAuthState:(OIDAuthState *)authState
+                maxQueuedRequests:(NSUInteger)maxQueuedRequests {
+  self = [super init];
+  if (self) {
+    _authState = authState;
+    _maxQueuedRequests = maxQueuedRequests;
+    _queue = [NSMutableArray array];
+  }
+  return self;
+}
+
+#pragma mark - Authorizing requests
+
+- (id<OIDCancellableRequest>)authorizeRequests:(NSArray<NSMutableURLRequest *> *)requests
+                                      callback:(OIDAuthStateAuthorizerCallback)callback {
+  return [self authorizeRequests:requests
+                   batchCallback:^(NSString *_Nullable accessToken, NSError *_Nullable error) {
+    callback(error);
+  }];
+}
+
+- (id<OIDCancellableRequest>)authorizeRequests:(NSArray<NSMutableURLRequest *> *)requests
+                                 batchCallback:(OIDAuthStateAuthorizerBatchCallback)callback {
+  OIDAuthStateAuthorizerBatch *batch =
+      [[OIDAuthStateAuthorizerBatch alloc] initWithRequests:requests
+                                                   callback:callback
+                                                 authorizer:self];
+  // a fresh access token authorizes the requests right away, so only a refresh holds them
+  NSString *freshAccessToken = [_authState freshAccessToken];
+  if (freshAccessToken) {
+    [[OIDAuthorizationService executor] performBlock:^() {
+      [self authorizeBatches:@[ batch ] withAccessToken:freshAccessToken error:nil];
+    }];
+    return batch;
+  }
+
+  BOOL full = NO;
+  BOOL requestsTokens = NO;
+  @synchronized(self) {
+    if (_queuedRequestCount + requests.count > _maxQueuedRequests) {
+      full = YES;
+    } else {
+      [_queue addObject:batch];
+      _queuedRequestCount += requests.count;
+      requestsTokens = !_waitingForTokens;
+      _waitingForTokens = YES;
+    }
+  }
+
+  if (full) {
+    NSString *description =
+        [NSString stringWithFormat:@"More than %lu requests are waiting for a refresh.",
+                                   (unsigned long)_maxQueuedRequests];
+    NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestQueueFull
+                                      underlyingError:nil
+                                          description:description];
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(nil, error);
+    }];
+    return batch;
+  }
+
+  // the batches queued until the tokens arrive all share them
+  if (requestsTokens) {
+    [_authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                               NSString *_Nullable idToken,
+                                               NSError *_Nullable error) {
+      [self releaseQueueWithAccessToken:accessToken error:error];
+    }];
+  }
+  return batch;
+}
+
+/*! @fn releaseQueueWithAccessToken:error:
+    @brief Authorizes every queued request with an access token, or fails them with an error.
+    @param accessToken The fresh access token, if any.
+    @param error The error if there is no access token.
+ */
+- (void)releaseQueueWithAccessToken:(nullable NSString *)accessToken
+                              error:(nullable NSError *)error {
+  NSArray<OIDAuthStateAuthorizerBatch *> *batches;
+  @synchronized(self) {
+    batches = [_queue copy];
+    [_queue removeAllObjects];
+    _queuedRequestCount = 0;
+    _waitingForTokens = NO;
+  }
+  [self authorizeBatches:batches withAccessToken:accessToken error:error];
+}
+
+/*! @fn authorizeBatches:withAccessToken:error:
+    @brief Authorizes the requests of batches with an access token, or fails them with an error,
+        and calls them back.
+    @param batches The batches.
+    @param accessToken The fresh access token, if any.
+    @param error The error if there is no access token.
+ */
+- (void)authorizeBatches:(NSArray<OIDAuthStateAuthorizerBatch *> *)batches
+         withAccessToken:(nullable NSString *)accessToken
+                   error:(nullable NSError *)error {
+  NSString *authorization =
+      accessToken ? [@"Bearer " stringByAppendingString:accessToken] : nil;
+  id<OIDMetricsObserver> metricsObserver = [OIDAuthorizationService metricsObserver];
+  CFAbsoluteTime releaseTime = [OIDMonotonicClock absoluteTime];
+  for (OIDAuthStateAuthorizerBatch *batch in batches) {
+    if (authorization) {
+      for (NSMutableURLRequest *request in batch.requests) {
+        [request setValue:authorization forHTTPHeaderField:kAuthorizationHeader];
+      }
+    }
+    if (metricsObserver) {
+      OIDMetricsEvent *event =
+          [[OIDMetricsEvent alloc] initWithType:OIDMetricsEventTypeRequestAuthorization];
+      event.duration = releaseTime - batch.queueTime;
+      event.coalescedWaiterCount = batch.requests.count;
+      event.error = authorization ? nil : error;
+      [metricsObserver didRecordMetricsEvent:event];
+    }
+    batch.callback(accessToken, authorization ? nil : error);
+  }
+}
+
+- (void)cancelBatch:(OIDAuthStateAuthorizerBatch *)batch {
+  BOOL removed = NO;
+  @synchronized(self) {
+    NSUInteger index = [_queue indexOfObjectIdenticalTo:batch];
+    if (index != NSNotFound) {
+      [_queue removeObjectAtIndex:index];
+      _queuedRequestCount -= batch.requests.count;
+      removed = YES;
+    }
+  }
+  if (!removed) {
+    return;
+  }
+  NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                                    underlyingError:nil
+                                        description:nil];
+  [[OIDAuthorizationService executor] performBlock:^() {
+    batch.callback(nil, error);
+  }];
+}
+
+#pragma mark - Performing requests
+
+- (void)performRequest:(NSURLRequest *)request
+               session:(NSURLSession *)session
+     completionHandler:(OIDAuthStateAuthorizerDataTaskCallback)completionHandler {
+  [self performRequest:request
+                  session:session
+      replaysUnauthorized:YES
+        completionHandler:completionHandler];
+}
+
+/*! @fn performRequest:session:replaysUnauthorized:completionHandler:
+    @brief Authorizes and performs a request.
+    @param replaysUnauthorized Whether to replay the request once with a fresh access token if
+        the resource server rejects the first one.
+ */
+- (void)performRequest:(NSURLRequest *)request
+                session:(NSURLSession *)session
+    replaysUnauthorized:(BOOL)replaysUnauthorized
+      completionHandler:(OIDAuthStateAuthorizerDataTaskCallback)completionHandler {
+  NSMutableURLRequest *authorizedRequest = [request mutableCopy];
+  [self authorizeRequests:@[ authorizedRequest ]
+            batchCallback:^(NSString *_Nullable accessToken, NSError *_Nullable error) {
+    if (!accessToken) {
+      completionHandler(nil, nil, error);
+      return;
+    }
+    [[session dataTaskWithRequest:authorizedRequest
+                completionHandler:^(NSData *_Nullable data,
+                                    NSURLResponse *_Nullable response,
+                                    NSError *_Nullable taskError) {
+      NSHTTPURLResponse *HTTPURLResponse =
+          [response isKindOfClass:[NSHTTPURLResponse class]] ? (NSHTTPURLResponse *)response : nil;
+      if (!taskError && HTTPURLResponse.statusCode == kUnauthorizedStatusCode
+          && replaysUnauthorized) {
+        [[OIDAuthorizationService executor] performBlock:^() {
+          [self->_authState setNeedsTokenRefreshForAccessToken:accessToken];
+          [self performRequest:request
+                          session:session
+              replaysUnauthorized:NO
+                completionHandler:completionHandler];
+        }];
+        return;
+      }
+      completionHandler(data, response, taskError);
+    }] resume];
+  }];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,46 @@
+/*! @file OIDAuthorizationFlowPresenter.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2015 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@protocol OIDAuthorizationFlowSession;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @protocol OIDAuthorizationFlowPresenter
+    @brief Shows the authorization request to the user, in whatever user agent the app chooses.
+    @discussion The presenter passes the redirect to
+        @c OIDAuthorizationFlowSession.resumeAuthorizationFlowWithURL: when it arrives, and the
+        session then asks it to dismiss its UI.
+ */
+@protocol OIDAuthorizationFlowPresenter <NSObject>
+
+/*! @brief Presents the authorization request.
+    @param URL The authorization request URL to load.
+    @param session The session to resume with the redirect.
+ */
+- (void)presentAuthorizationURL:(NSURL *)URL session:(id<OIDAuthorizationFlowSession>)session;
+
+/*! @brief Dismisses the UI presented by @c presentAuthorizationURL:session:.
+    @param completion The block to call once the UI is gone.
+ */
+- (void)dismissWithCompletion:(void (^)(void))completion;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -23,6 +23,7 @@
 #import "OIDResponseTypes.h"
 #import "OIDScopes.h"
 
+@class OIDScopeSet;
 @class OIDServiceConfiguration;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -72,6 +73,11 @@ extern NSString *const OIDOAuthorizationRequestCodeChallengeMethodS256;
  */
 @property(nonatomic, readonly, nullable) NSString *scope;
 
+/*! @property scopeSet
+    @brief The scopes of @c scope, for cheap containment checks.
+ */
+@property(nonatomic, readonly, nullable) OIDScopeSet *scopeSet;
+
 /*! @property redirectURL
     @brief The client's redirect URI.
     @remarks redirect_uri
@@ -19,6 +19,7 @@
 #import "OIDAuthorizationRequest.h"
 
 #import "OIDDefines.h"
+#import "OIDScopeSet.h"
 #import "OIDScopeUtilities.h"
 #import "OIDServiceConfiguration.h"
 #import "OIDTokenUtilities.h"
@@ -90,7 +91,13 @@ static NSUInteger const kCodeVerifierBytes = 32;
 
 NSString *const OIDOAuthorizationRequestCodeChallengeMethodS256 = @"S256";
 
-@implementation OIDAuthorizationRequest
+@implementation OIDAuthorizationRequest {
+  /*! @var _scopeSet
+      @brief The cached value of @c scopeSet, created on first use, as most requests never need it.
+          Access is synchronized on @c self.
+   */
+  OIDScopeSet *_scopeSet;
+}
 
 - (instancetype)init
     OID_UNAVAILABLE_USE_INITIALIZER(
@@ -154,6 +161,18 @@ NSString *const OIDOAuthorizationRequestCodeChallengeMethodS256 = @"S256";
                 additionalParameters:additionalParameters];
 }
 
+- (nullable OIDScopeSet *)scopeSet {
+  if (!_scope) {
+    return nil;
+  }
+  @synchronized(self) {
+    if (!_scopeSet) {
+      _scopeSet = [OIDScopeSet scopeSetWithString:_scope];
+    }
+    return _scopeSet;
+  }
+}
+
 #pragma mark - NSCopying
 
 - (instancetype)copyWithZone:(nullable NSZone *)zone {
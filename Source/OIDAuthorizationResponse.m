@@ -22,6 +22,7 @@
 #import "OIDDefines.h"
 #import "OIDError.h"
 #import "OIDFieldMapping.h"
+#import "OIDIDToken.h"
 #import "OIDTokenRequest.h"
 
 /*! @var kAuthorizationCodeKey
@@ -44,6 +45,7 @@ static NSString *const kAccessTokenKey = @"access_token";
 /*! @var kExpiresInKey
     @brief The key for the @c accessTokenExpirationDate property in the incoming parameters and for
         @c NSSecureCoding.
+    @discussion Not in the @c fieldMap, as the expiry is derived from it lazily.
  */
 static NSString *const kExpiresInKey = @"expires_in";
 
@@ -81,7 +83,32 @@ static NSString *const kTokenExchangeRequestException =
     @"Attempted to create a token exchange request from an authorization response with no "
     "authorization code.";
 
-@implementation OIDAuthorizationResponse
+@implementation OIDAuthorizationResponse {
+  /*! @var _parsedIDToken
+      @brief The cached value of @c parsedIDToken.
+   */
+  OIDIDToken *_parsedIDToken;
+
+  /*! @var _hasParsedIDToken
+      @brief Whether @c idToken was parsed, which it is at most once.
+   */
+  BOOL _hasParsedIDToken;
+
+  /*! @var _accessTokenIssueTime
+      @brief The wall-clock time @c expires_in was received at.
+   */
+  CFAbsoluteTime _accessTokenIssueTime;
+
+  /*! @var _accessTokenLifetime
+      @brief The @c expires_in of the access token.
+   */
+  NSTimeInterval _accessTokenLifetime;
+
+  /*! @var _accessTokenExpirationDate
+      @brief The cached value of @c accessTokenExpirationDate, created on first use.
+   */
+  NSDate *_accessTokenExpirationDate;
+}
 
 /*! @fn fieldMap
     @brief Returns a mapping of incoming parameters to instance variables.
@@ -98,16 +125,6 @@ static NSString *const kTokenExchangeRequestException =
         [[OIDFieldMapping alloc] initWithName:@"_authorizationCode" type:[NSString class]];
     fieldMap[kAccessTokenKey] =
         [[OIDFieldMapping alloc] initWithName:@"_accessToken" type:[NSString class]];
-    fieldMap[kExpiresInKey] =
-        [[OIDFieldMapping alloc] initWithName:@"_accessTokenExpirationDate"
-                                         type:[NSDate class]
-                                   conversion:^id _Nullable(NSObject *_Nullable value) {
-          if (![value isKindOfClass:[NSNumber class]]) {
-            return value;
-          }
-          NSNumber *valueAsNumber = (NSNumber *)value;
-          return [NSDate dateWithTimeIntervalSinceNow:[valueAsNumber longLongValue]];
-        }];
     fieldMap[kTokenTypeKey] =
         [[OIDFieldMapping alloc] initWithName:@"_tokenType" type:[NSString class]];
     fieldMap[kIDTokenKey] =
@@ -132,6 +149,14 @@ static NSString *const kTokenExchangeRequestException =
         [OIDFieldMapping remainingParametersWithMap:[[self class] fieldMap]
                                          parameters:parameters
                                            instance:self];
+    NSObject *expiresIn = additionalParameters[kExpiresInKey];
+    if ([expiresIn isKindOfClass:[NSNumber class]]) {
+      [self setAccessTokenLifetime:[(NSNumber *)expiresIn longLongValue]];
+      NSMutableDictionary<NSString *, NSObject<NSCopying> *> *remainingParameters =
+          [additionalParameters mutableCopy];
+      [remainingParameters removeObjectForKey:kExpiresInKey];
+      additionalParameters = remainingParameters;
+    }
     _additionalParameters = additionalParameters;
   }
   return self;
@@ -159,6 +184,12 @@ static NSString *const kTokenExchangeRequestException =
   self = [self initWithRequest:request parameters:@{ }];
   if (self) {
     [OIDFieldMapping decodeWithCoder:aDecoder map:[[self class] fieldMap] instance:self];
+    // archives keep the expiry as a date, so they stay readable by and from earlier versions
+    NSDate *expirationDate = [aDecoder decodeObjectOfClass:[NSDate class] forKey:kExpiresInKey];
+    if (expirationDate) {
+      [self setAccessTokenLifetime:[expirationDate timeIntervalSinceDate:[OIDMonotonicClock date]]];
+      _accessTokenExpirationDate = expirationDate;
+    }
     _additionalParameters = [aDecoder decodeObjectOfClasses:[OIDFieldMapping JSONTypes]
                                                      forKey:kAdditionalParametersKey];
   }
@@ -168,6 +199,7 @@ static NSString *const kTokenExchangeRequestException =
 - (void)encodeWithCoder:(NSCoder *)aCoder {
   [aCoder encodeObject:_request forKey:kRequestKey];
   [OIDFieldMapping encodeWithCoder:aCoder map:[[self class] fieldMap] instance:self];
+  [aCoder encodeObject:self.accessTokenExpirationDate forKey:kExpiresInKey];
   [aCoder encodeObject:_additionalParameters forKey:kAdditionalParametersKey];
 }
 
@@ -183,7 +215,7 @@ static NSString *const kTokenExchangeRequestException =
                                     _authorizationCode,
                                     _state,
                                     _accessToken,
-                                    _accessTokenExpirationDate,
+                                    self.accessTokenExpirationDate,
                                     _tokenType,
                                     _idToken,
                                     _scope,
@@ -193,6 +225,36 @@ static NSString *const kTokenExchangeRequestException =
 
 #pragma mark -
 
+/*! @fn setAccessTokenLifetime:
+    @brief Sets the expiry of the access token to a lifetime from now.
+    @param lifetime The @c expires_in of the access token.
+ */
+- (void)setAccessTokenLifetime:(NSTimeInterval)lifetime {
+  _accessTokenIssueTime = [OIDMonotonicClock absoluteTime];
+  _accessTokenLifetime = lifetime;
+  _accessTokenExpirationDeadline = [OIDMonotonicClock timeAfterInterval:lifetime];
+}
+
+- (nullable NSDate *)accessTokenExpirationDate {
+  @synchronized(self) {
+    if (!_accessTokenExpirationDate && _accessTokenExpirationDeadline) {
+      _accessTokenExpirationDate = [NSDate dateWithTimeIntervalSinceReferenceDate:
+                                       _accessTokenIssueTime + _accessTokenLifetime];
+    }
+    return _accessTokenExpirationDate;
+  }
+}
+
+- (nullable OIDIDToken *)parsedIDToken {
+  @synchronized(self) {
+    if (!_hasParsedIDToken) {
+      _parsedIDToken = _idToken ? [[OIDIDToken alloc] initWithTokenString:_idToken] : nil;
+      _hasParsedIDToken = YES;
+    }
+    return _parsedIDToken;
+  }
+}
+
 - (OIDTokenRequest *)tokenExchangeRequest {
   return [self tokenExchangeRequestWithAdditionalParameters:nil];
 }
@@ -25,13 +25,22 @@
 # import "OIDWebViewController.h"
 #endif
 
+#import "OIDMetricsObserver.h"
+#import "OIDTokenRequestScheduler.h"
+
 @class OIDAuthorization;
 @class OIDAuthorizationRequest;
 @class OIDAuthorizationResponse;
+@class OIDIntrospectionRequest;
+@class OIDIntrospectionResponse;
+@class OIDRevocationRequest;
 @class OIDServiceConfiguration;
 @class OIDTokenRequest;
 @class OIDTokenResponse;
+@protocol OIDAuthorizationFlowPresenter;
 @protocol OIDAuthorizationFlowSession;
+@protocol OIDCancellableRequest;
+@protocol OIDExecutor;
 
 NS_ASSUME_NONNULL_BEGIN
 
@@ -62,6 +71,71 @@ typedef void (^OIDAuthorizationCallback)(OIDAuthorizationResponse *_Nullable aut
 typedef void (^OIDTokenCallback)(OIDTokenResponse *_Nullable tokenResponse,
                                  NSError *_Nullable error);
 
+/*! @typedef OIDTokenBatchItemCallback
+    @brief Represents the type of block called each time a request in a batch of token requests
+        completes.
+    @param index The index of the completed request in the array of requests passed to
+        @c OIDAuthorizationService.performTokenRequests:itemCallback:completion:.
+    @param tokenResponse The token response, if available.
+    @param error The error if an error occurred.
+ */
+typedef void (^OIDTokenBatchItemCallback)(NSUInteger index,
+                                          OIDTokenResponse *_Nullable tokenResponse,
+                                          NSError *_Nullable error);
+
+/*! @typedef OIDTokenBatchCallback
+    @brief Represents the type of block called once every request in a batch of token requests has
+        completed.
+    @param tokenResponses The token responses, in the same order as the requests. Contains
+        @c NSNull for requests which failed.
+    @param errors The errors, in the same order as the requests. Contains @c NSNull for requests
+        which succeeded.
+ */
+typedef void (^OIDTokenBatchCallback)(NSArray *tokenResponses, NSArray *errors);
+
+/*! @typedef OIDRevocationCallback
+    @brief Represents the type of block used as a callback for revocation requests.
+    @param error The error if the token couldn't be revoked, nil if it was revoked or was already
+        invalid.
+ */
+typedef void (^OIDRevocationCallback)(NSError *_Nullable error);
+
+/*! @typedef OIDRevocationBatchItemCallback
+    @brief Represents the type of block called each time a request in a batch of revocation
+        requests completes.
+    @param index The index of the completed request in the array of requests passed to
+        @c OIDAuthorizationService.performRevocationRequests:itemCallback:completion:.
+    @param error The error if an error occurred.
+ */
+typedef void (^OIDRevocationBatchItemCallback)(NSUInteger index, NSError *_Nullable error);
+
+/*! @typedef OIDRevocationBatchCallback
+    @brief Represents the type of block called once every request in a batch of revocation
+        requests has completed.
+    @param errors The errors, in the same order as the requests. Contains @c NSNull for requests
+        which succeeded.
+ */
+typedef void (^OIDRevocationBatchCallback)(NSArray *errors);
+
+/*! @typedef OIDIntrospectionCallback
+    @brief Represents the type of block used as a callback for introspection requests.
+    @param response The introspection response, if the server answered. An inactive token is a
+        response whose @c active is NO, not an error.
+    @param error The error if an error occurred.
+ */
+typedef void (^OIDIntrospectionCallback)(OIDIntrospectionResponse *_Nullable response,
+                                         NSError *_Nullable error);
+
+/*! @typedef OIDUserInfoResponseCallback
+    @brief Represents the type of block used as a callback for userinfo requests.
+    @param response The HTTP response, whatever its status, if the server answered.
+    @param data The response body, if any.
+    @param error The error if the request failed.
+ */
+typedef void (^OIDUserInfoResponseCallback)(NSHTTPURLResponse *_Nullable response,
+                                            NSData *_Nullable data,
+                                            NSError *_Nullable error);
+
 /*! @typedef OIDTokenEndpointParameters
     @brief Represents the type of dictionary used to specify additional querystring parameters
         when making authorization or token endpoint requests.
@@ -89,16 +163,64 @@ typedef NSDictionary<NSString *, NSString *> *_Nullable OIDTokenEndpointParamete
  */
 - (nullable instancetype)init NS_UNAVAILABLE;
 
+/*! @fn metricsObserver
+    @brief The observer receiving the timings of discovery and token requests, and of
+        @c OIDAuthState.withFreshTokensPerformAction:, if any.
+ */
++ (nullable id<OIDMetricsObserver>)metricsObserver;
+
+/*! @fn setMetricsObserver:
+    @brief Sets the observer receiving the timings of discovery and token requests, and of
+        @c OIDAuthState.withFreshTokensPerformAction:.
+    @param metricsObserver The observer, or nil to stop recording metrics. Retained, and not
+        released once replaced, as it is read without a lock.
+    @discussion Should be set once, typically at launch, before any request is made. Without an
+        observer no timings are taken, and requests are made with the shared \NSURLSession, so
+        recording metrics costs nothing unless enabled.
+ */
++ (void)setMetricsObserver:(nullable id<OIDMetricsObserver>)metricsObserver;
+
+/*! @fn executor
+    @brief The executor running the library's callbacks, the main queue unless another executor
+        is set.
+ */
++ (id<OIDExecutor>)executor;
+
+/*! @fn setExecutor:
+    @brief Replaces the main queue as the queue the library's callbacks and timers run on.
+    @param executor The executor, or nil to restore the main queue. Retained, and not released
+        once replaced, as it is read without a lock.
+    @discussion Meant for simulations and tests, which pair it with a virtual clock set with
+        @c OIDMonotonicClock.setClock:. Should be set before any request is made.
+ */
++ (void)setExecutor:(nullable id<OIDExecutor>)executor;
+
+/*! @fn URLSession
+    @brief The session set with @c setURLSession:, if any.
+ */
++ (nullable NSURLSession *)URLSession;
+
+/*! @fn setURLSession:
+    @brief Sets the session discovery, token, revocation and introspection requests are made with,
+        instead of the shared \NSURLSession.
+    @param URLSession The session, or nil to restore the default. Retained, and not released once
+        replaced, as it is read without a lock.
+    @discussion Lets a simulation answer requests from a simulated provider, in virtual time.
+        Timings of a session without the metrics delegate are reported without task metrics.
+ */
++ (void)setURLSession:(nullable NSURLSession *)URLSession;
+
 /*! @fn discoverServiceConfigurationForIssuer:completion:
     @brief Convenience method for creating an authorization service configuration from an OpenID
         Connect compliant issuer URL.
     @param issuerURL The service provider's OpenID Connect issuer.
     @param completion A block which will be invoked when the authorization service configuration has
         been created, or when an error has occurred.
+    @return A handle which may be used to cancel the request.
     @see https://openid.net/specs/openid-connect-discovery-1_0.html
  */
-+ (void)discoverServiceConfigurationForIssuer:(NSURL *)issuerURL
-                                   completion:(OIDDiscoveryCallback)completion;
++ (id<OIDCancellableRequest>)discoverServiceConfigurationForIssuer:(NSURL *)issuerURL
+                                                        completion:(OIDDiscoveryCallback)completion;
 
 
 /*! @fn discoverServiceConfigurationForDiscoveryURL:completion:
@@ -107,10 +229,29 @@ typedef NSDictionary<NSString *, NSString *> *_Nullable OIDTokenEndpointParamete
     @param discoveryURL The URL of the service provider's OpenID Connect discovery document.
     @param completion A block which will be invoked when the authorization service configuration has
         been created, or when an error has occurred.
+    @return A handle which may be used to cancel the request.
     @see https://openid.net/specs/openid-connect-discovery-1_0.html
  */
-+ (void)discoverServiceConfigurationForDiscoveryURL:(NSURL *)discoveryURL
-                                         completion:(OIDDiscoveryCallback)completion;
++ (id<OIDCancellableRequest>)
+    discoverServiceConfigurationForDiscoveryURL:(NSURL *)discoveryURL
+                                     completion:(OIDDiscoveryCallback)completion;
+
+/*! @fn discoverServiceConfigurationForDiscoveryURL:deadline:completion:
+    @brief Creates an authorization service configuration from an OpenID Connect compliant identity
+        provider's discovery document, failing if it can't be fetched before a deadline.
+    @param discoveryURL The URL of the service provider's OpenID Connect discovery document.
+    @param deadline The time by which the request must complete, or nil for the default
+        \NSURLSession timeouts.
+    @param completion A block which will be invoked when the authorization service configuration has
+        been created, or when an error has occurred. If the deadline passes first, the error has
+        code @c ::OIDErrorCodeTimeout.
+    @return A handle which may be used to cancel the request.
+    @see https://openid.net/specs/openid-connect-discovery-1_0.html
+ */
++ (id<OIDCancellableRequest>)
+    discoverServiceConfigurationForDiscoveryURL:(NSURL *)discoveryURL
+                                       deadline:(nullable NSDate *)deadline
+                                     completion:(OIDDiscoveryCallback)completion;
 
 #if TARGET_OS_IPHONE
 /*! @fn presentAuthorizationRequest:presentingViewController:callback:
@@ -148,12 +289,205 @@ typedef NSDictionary<NSString *, NSString *> *_Nullable OIDTokenEndpointParamete
     completionCallback:(OIDAuthorizationCallback)completion;
 #endif
 
+/*! @fn presentAuthorizationRequest:presenter:responseCallback:callback:
+    @brief Perform an authorization flow using a presenter provided by the app.
+    @param request The authorization request.
+    @param presenter The presenter showing the request to the user.
+    @param responseCallback The method called as soon as the redirect has been parsed, before the
+        presenter is asked to dismiss its UI, or nil.
+    @param callback The method called when the request has completed or failed, once the
+        presenter's UI is gone.
+    @return A @c OIDAuthorizationFlowSession instance which will terminate when it
+        receives a @c OIDAuthorizationFlowSession.cancel message, or after processing a
+        @c OIDAuthorizationFlowSession.resumeAuthorizationFlowWithURL: message.
+    @discussion The response callback lets work that doesn't depend on the UI, such as the code
+        exchange, overlap with the dismissal.
+ */
++ (id<OIDAuthorizationFlowSession>)
+    presentAuthorizationRequest:(OIDAuthorizationRequest *)request
+                      presenter:(id<OIDAuthorizationFlowPresenter>)presenter
+               responseCallback:(nullable OIDAuthorizationCallback)responseCallback
+                       callback:(OIDAuthorizationCallback)callback;
+
+/*! @fn resumeAuthorizationFlowWithURL:
+    @brief Passes a redirect to whichever pending authorization flow is expecting it.
+    @param URL The redirect URL invoked by the authorization server.
+    @return YES if a pending flow consumed the URL, NO otherwise.
+    @discussion Every flow presented by this class is registered under its redirect URL and
+        @c state until it finishes, so the flow is found in constant time however many are
+        pending, and apps needn't keep the sessions to forward URLs to each of them. A redirect
+        without a @c state, such as an error response of a provider which drops it, is passed to
+        the only flow pending for its redirect URL, if there is just one, which then fails.
+ */
++ (BOOL)resumeAuthorizationFlowWithURL:(NSURL *)URL;
+
 /*! @fn performTokenRequest:callback:
     @brief Performs a token request.
     @param request The token request.
     @param callback The method called when the request has completed or failed.
+    @return A handle which may be used to cancel the request.
+    @discussion Authorization code exchanges are performed with
+        @c ::OIDTokenRequestPriorityInteractive priority, all other requests with
+        @c ::OIDTokenRequestPriorityForegroundRefresh priority.
+ */
++ (id<OIDCancellableRequest>)performTokenRequest:(OIDTokenRequest *)request
+                                        callback:(OIDTokenCallback)callback;
+
+/*! @fn performTokenRequest:priority:callback:
+    @brief Performs a token request, scheduled with the given priority by
+        @c OIDTokenRequestScheduler.sharedScheduler.
+    @param request The token request.
+    @param priority The priority of the request.
+    @param callback The method called when the request has completed or failed.
+    @return A handle which may be used to cancel the request.
+ */
++ (id<OIDCancellableRequest>)performTokenRequest:(OIDTokenRequest *)request
+                                        priority:(OIDTokenRequestPriority)priority
+                                        callback:(OIDTokenCallback)callback;
+
+/*! @fn performTokenRequest:priority:deadline:callback:
+    @brief Performs a token request, failing if it doesn't complete before a deadline.
+    @param request The token request.
+    @param priority The priority of the request.
+    @param deadline The time by which the request must complete, or nil for the default
+        \NSURLSession timeouts. Time spent queued behind other requests to the same endpoint
+        counts towards the deadline.
+    @param callback The method called when the request has completed or failed. If the deadline
+        passes first, the error has code @c ::OIDErrorCodeTimeout.
+    @return A handle which may be used to cancel the request.
+ */
++ (id<OIDCancellableRequest>)performTokenRequest:(OIDTokenRequest *)request
+                                        priority:(OIDTokenRequestPriority)priority
+                                        deadline:(nullable NSDate *)deadline
+                                        callback:(OIDTokenCallback)callback;
+
+/*! @fn performTokenRequests:itemCallback:completion:
+    @brief Performs a batch of token requests, such as refreshing the tokens of many
+        @c OIDAuthState%s at once, with a default per-endpoint concurrency limit.
+    @param requests The token requests.
+    @param itemCallback Called on the main thread as each individual request completes or fails.
+    @param completion Called on the main thread once every request has completed or failed.
+    @return A handle which may be used to cancel all requests of the batch which haven't completed.
+    @discussion The requests are performed with @c ::OIDTokenRequestPriorityForegroundRefresh
+        priority.
+    @see performTokenRequests:maxConcurrentRequestsPerEndpoint:priority:itemCallback:completion:
+ */
++ (id<OIDCancellableRequest>)performTokenRequests:(NSArray<OIDTokenRequest *> *)requests
+                itemCallback:(nullable OIDTokenBatchItemCallback)itemCallback
+                  completion:(OIDTokenBatchCallback)completion;
+
+/*! @fn performTokenRequests:maxConcurrentRequestsPerEndpoint:priority:itemCallback:completion:
+    @brief Performs a batch of token requests, such as refreshing the tokens of many
+        @c OIDAuthState%s at once.
+    @param requests The token requests.
+    @param maxConcurrentRequestsPerEndpoint The maximum number of requests in flight at any one time
+        for each distinct token endpoint. Requests beyond that limit are queued, and started in
+        order as earlier ones complete. A value of 0 is treated as 1.
+    @param priority The priority with which each request of the batch is scheduled. The limits of
+        @c OIDTokenRequestScheduler.sharedScheduler apply in addition to
+        @c maxConcurrentRequestsPerEndpoint.
+    @param itemCallback Called on the main thread as each individual request completes or fails.
+    @param completion Called on the main thread once every request has completed or failed.
+    @return A handle which may be used to cancel all requests of the batch which haven't completed.
+    @discussion All requests share the same \NSURLSession, so connections to a token endpoint are
+        reused across the batch rather than each request paying for its own connection setup.
+ */
++ (id<OIDCancellableRequest>)performTokenRequests:(NSArray<OIDTokenRequest *> *)requests
+    maxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+                            priority:(OIDTokenRequestPriority)priority
+                        itemCallback:(nullable OIDTokenBatchItemCallback)itemCallback
+                          completion:(OIDTokenBatchCallback)completion;
+
+/*! @fn performRevocationRequest:callback:
+    @brief Revokes an access or refresh token.
+    @param request The revocation request.
+    @param callback The method called when the request has completed or failed.
+    @return A handle which may be used to cancel the request.
+    @discussion Performed with @c ::OIDTokenRequestPriorityForegroundRefresh priority, over the
+        same \NSURLSession and @c OIDTokenRequestScheduler as token requests.
+    @see https://tools.ietf.org/html/rfc7009
+ */
++ (id<OIDCancellableRequest>)performRevocationRequest:(OIDRevocationRequest *)request
+                                             callback:(OIDRevocationCallback)callback;
+
+/*! @fn performRevocationRequests:itemCallback:completion:
+    @brief Revokes many tokens, such as when signing out of every account at once, with a default
+        per-endpoint concurrency limit.
+    @param requests The revocation requests.
+    @param itemCallback Called on the main thread as each individual request completes or fails.
+    @param completion Called on the main thread once every request has completed or failed.
+    @return A handle which may be used to cancel all requests of the batch which haven't completed.
+    @see performRevocationRequests:maxConcurrentRequestsPerEndpoint:itemCallback:completion:
+ */
++ (id<OIDCancellableRequest>)performRevocationRequests:(NSArray<OIDRevocationRequest *> *)requests
+                itemCallback:(nullable OIDRevocationBatchItemCallback)itemCallback
+                  completion:(OIDRevocationBatchCallback)completion;
+
+/*! @fn performRevocationRequests:maxConcurrentRequestsPerEndpoint:itemCallback:completion:
+    @brief Revokes many tokens, such as when signing out of every account at once.
+    @param requests The revocation requests.
+    @param maxConcurrentRequestsPerEndpoint The maximum number of requests in flight at any one time
+        for each distinct revocation endpoint. Requests beyond that limit are queued, and started
+        in order as earlier ones complete. A value of 0 is treated as 1.
+    @param itemCallback Called on the main thread as each individual request completes or fails.
+    @param completion Called on the main thread once every request has completed or failed.
+    @return A handle which may be used to cancel all requests of the batch which haven't completed.
+    @discussion Like token request batches, all requests share the same \NSURLSession, so
+        connections to a revocation endpoint are reused across the batch.
+ */
++ (id<OIDCancellableRequest>)performRevocationRequests:(NSArray<OIDRevocationRequest *> *)requests
+    maxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+                        itemCallback:(nullable OIDRevocationBatchItemCallback)itemCallback
+                          completion:(OIDRevocationBatchCallback)completion;
+
+/*! @fn performIntrospectionRequest:callback:
+    @brief Asks the authorization server whether a token is active, and what it grants.
+    @param request The introspection request.
+    @param callback The method called when the request has completed or failed.
+    @return A handle which may be used to cancel the request.
+    @discussion Performed with @c ::OIDTokenRequestPriorityForegroundRefresh priority, over the
+        same \NSURLSession and @c OIDTokenRequestScheduler as token requests. Resource servers
+        checking many tokens should go through an @c OIDIntrospectionCache instead.
+    @see https://tools.ietf.org/html/rfc7662
+ */
++ (id<OIDCancellableRequest>)performIntrospectionRequest:(OIDIntrospectionRequest *)request
+                                                callback:(OIDIntrospectionCallback)callback;
+
+/*! @fn performUserInfoRequest:callback:
+    @brief Sends a request to a userinfo endpoint, reporting its timings to the metrics observer.
+    @param URLRequest The request, authorized with an access token.
+    @param callback The method called when the request has completed or failed.
+    @return A handle which may be used to cancel the request.
+    @discussion The response isn't checked, which is left to
+        @c OIDAuthState.performUserInfoRequestWithCallback:.
+ */
++ (id<OIDCancellableRequest>)performUserInfoRequest:(NSURLRequest *)URLRequest
+                                           callback:(OIDUserInfoResponseCallback)callback;
+
+@end
+
+/*! @protocol OIDCancellableRequest
+    @brief Represents an in-flight request which may be cancelled when its result is no longer
+        needed.
+ */
+@protocol OIDCancellableRequest <NSObject>
+
+/*! @brief Cancels the request, freeing the connection it occupies.
+    @remarks Has no effect if called more than once, or after the request completed. Otherwise the
+        request's callback is invoked on the main thread with an error with code
+        @c ::OIDErrorCodeRequestCanceled, and won't be invoked again.
+ */
+- (void)cancel;
+
+@optional
+
+/*! @brief Cancels the request only if it hasn't been sent yet, such as while it is queued behind
+        other requests to the same endpoint.
+    @remarks A request which was already sent completes normally. Used to abandon refreshes, whose
+        responses may carry a rotated refresh token which the provider has already replaced the old
+        one with.
  */
-+ (void)performTokenRequest:(OIDTokenRequest *)request callback:(OIDTokenCallback)callback;
+- (void)cancelIfNotSent;
 
 @end
 
@@ -18,6 +18,10 @@
 
 #import "OIDAuthorizationService.h"
 
+#import <objc/runtime.h>
+
+#include <stdatomic.h>
+
 #if TARGET_OS_IPHONE
 # import <SafariServices/SafariServices.h>
 #else
@@ -25,12 +29,22 @@
 #endif
 
 #import "OIDAuthorizationRequest.h"
+#import "OIDAuthorizationFlowPresenter.h"
 #import "OIDAuthorizationResponse.h"
+#import "OIDClockSkewEstimator.h"
 #import "OIDDefines.h"
 #import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
+#import "OIDIDToken.h"
+#import "OIDIntrospectionRequest.h"
+#import "OIDIntrospectionResponse.h"
+#import "OIDMonotonicClock.h"
+#import "OIDRevocationRequest.h"
+#import "OIDRedirectURLMatcher.h"
 #import "OIDServiceConfiguration.h"
 #import "OIDServiceDiscovery.h"
 #import "OIDTokenRequest.h"
+#import "OIDTokenRequestScheduler.h"
 #import "OIDTokenResponse.h"
 #import "OIDURLQueryComponent.h"
 #import "OIDWebViewController.h"
@@ -41,8 +55,88 @@
  */
 static NSString *const kOpenIDConfigurationWellKnownPath = @".well-known/openid-configuration";
 
+/*! @var kStateKey
+    @brief The authorization response parameter echoing the state of the request.
+ */
+static NSString *const kStateKey = @"state";
+
+/*! @var kHTTPDateHeader
+    @brief The header in which servers report their time.
+ */
+static NSString *const kHTTPDateHeader = @"Date";
+
+/*! @var kHTTPDateResolution
+    @brief The resolution of HTTP dates and JWT times, in seconds.
+ */
+static const NSTimeInterval kHTTPDateResolution = 1;
+
+/*! @var kDefaultMaxConcurrentRequestsPerEndpoint
+    @brief The default number of requests of a batch allowed in flight to a single endpoint.
+ */
+static const NSUInteger kDefaultMaxConcurrentRequestsPerEndpoint = 4;
+
+/*! @var kMetricsGracePeriod
+    @brief How long to wait for the task metrics of a completed request before reporting its event
+        without them, in seconds.
+ */
+static const NSTimeInterval kMetricsGracePeriod = 1;
+
+/*! @var kMetricsTaskRecorderKey
+    @brief The key under which a @c OIDMetricsTaskRecorder is associated with its task.
+ */
+static char kMetricsTaskRecorderKey;
+
+/*! @var gMetricsObserver
+    @brief The observer set with @c OIDAuthorizationService.setMetricsObserver:, if any. Accessed
+        with @c OIDLoadGlobal and @c OIDStoreGlobal.
+ */
+static _Atomic(void *) gMetricsObserver;
+
+/*! @var gExecutor
+    @brief The executor set with @c OIDAuthorizationService.setExecutor:, if any. Accessed with
+        @c OIDLoadGlobal and @c OIDStoreGlobal.
+ */
+static _Atomic(void *) gExecutor;
+
+/*! @var gURLSession
+    @brief The session set with @c OIDAuthorizationService.setURLSession:, if any. Accessed with
+        @c OIDLoadGlobal and @c OIDStoreGlobal.
+ */
+static _Atomic(void *) gURLSession;
+
 NS_ASSUME_NONNULL_BEGIN
 
+/*! @fn OIDLoadGlobal
+    @brief Reads an object set with @c OIDStoreGlobal, without taking a lock, as the globals are
+        read on every request and callback.
+ */
+static id _Nullable OIDLoadGlobal(_Atomic(void *) *global) {
+  return (__bridge id)atomic_load_explicit(global, memory_order_acquire);
+}
+
+/*! @fn OIDStoreGlobal
+    @brief Replaces an object read with @c OIDLoadGlobal.
+    @discussion The replaced object is never released, since a reader may have loaded it without
+        having retained it yet. The globals are only set a handful of times, at launch or by tests.
+ */
+static void OIDStoreGlobal(_Atomic(void *) *global, id _Nullable object) {
+  atomic_store_explicit(global, (__bridge_retained void *)object, memory_order_release);
+}
+
+/*! @fn OIDTimeoutIntervalForDeadline
+    @brief Returns the timeout interval to give an \NSURLRequest which must complete by a deadline.
+    @param deadline The deadline.
+    @param defaultTimeoutInterval The request's timeout interval without a deadline, which is never
+        exceeded.
+ */
+static NSTimeInterval OIDTimeoutIntervalForDeadline(NSDate *deadline,
+                                                    NSTimeInterval defaultTimeoutInterval) {
+  // the interval must be positive, a request past its deadline is cancelled by its handle anyway
+  NSTimeInterval remaining =
+      MAX(deadline.timeIntervalSinceReferenceDate - [OIDMonotonicClock absoluteTime], 0.001);
+  return MIN(remaining, defaultTimeoutInterval);
+}
+
 @interface OIDAuthorizationFlowSessionImplementation : NSObject <OIDAuthorizationFlowSession,
 #if TARGET_OS_IPHONE
                                                                  SFSafariViewControllerDelegate
@@ -66,6 +160,31 @@ presentationCallback:(OIDWebViewControllerPresentationCallback)presentation
   completionCallback:(OIDAuthorizationCallback)completion;
 #endif
 
+- (void)presentWithPresenter:(id<OIDAuthorizationFlowPresenter>)presenter
+            responseCallback:(nullable OIDAuthorizationCallback)responseCallback
+                    callback:(OIDAuthorizationCallback)callback;
+
+/*! @fn registerSession:
+    @brief Adds a session to the sessions dispatched to by
+        @c OIDAuthorizationService.resumeAuthorizationFlowWithURL:, until it finishes.
+ */
++ (void)registerSession:(OIDAuthorizationFlowSessionImplementation *)session;
+
+/*! @fn sessionForRedirectKey:state:
+    @brief Returns the registered session expecting a redirect, if any.
+    @discussion Without a @c state, returns the only session registered for the redirect key, if
+        there is just one.
+ */
++ (nullable OIDAuthorizationFlowSessionImplementation *)
+    sessionForRedirectKey:(NSString *)redirectKey
+                    state:(nullable NSString *)state;
+
+/*! @fn resumeAuthorizationFlowWithParameters:
+    @brief Completes the flow with the parameters of a redirect already known to be for it.
+ */
+- (void)resumeAuthorizationFlowWithParameters:
+    (NSDictionary<NSString *, NSObject<NSCopying> *> *)parameters;
+
 @end
 
 @implementation OIDAuthorizationFlowSessionImplementation {
@@ -75,14 +194,88 @@ presentationCallback:(OIDWebViewControllerPresentationCallback)presentation
   __weak OIDWebViewController *_webVC;
   OIDWebViewControllerDismissalCallback _webCVDismissalCallback;
 #endif
+  id<OIDAuthorizationFlowPresenter> _presenter;
   OIDAuthorizationRequest *_request;
   OIDAuthorizationCallback _pendingauthorizationFlowCallback;
+  OIDAuthorizationCallback _pendingResponseCallback;
+  OIDRedirectURLMatcher *_redirectURLMatcher;
+  NSString *_registryKey;
+}
+
+/*! @fn registeredSessions
+    @brief The sessions awaiting a redirect, keyed by @c registryKeyForRedirectKey:state:.
+ */
++ (NSMutableDictionary<NSString *, OIDAuthorizationFlowSessionImplementation *> *)
+    registeredSessions {
+  static NSMutableDictionary<NSString *, OIDAuthorizationFlowSessionImplementation *> *sessions;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sessions = [NSMutableDictionary dictionary];
+  });
+  return sessions;
+}
+
+/*! @fn registryKeyForRedirectKey:state:
+    @brief The key of a session in @c registeredSessions.
+ */
++ (NSString *)registryKeyForRedirectKey:(NSString *)redirectKey state:(nullable NSString *)state {
+  return [NSString stringWithFormat:@"%@\n%@", redirectKey, state ?: @""];
+}
+
++ (void)registerSession:(OIDAuthorizationFlowSessionImplementation *)session {
+  NSMutableDictionary<NSString *, OIDAuthorizationFlowSessionImplementation *> *sessions =
+      [self registeredSessions];
+  @synchronized(sessions) {
+    sessions[session->_registryKey] = session;
+  }
+}
+
+/*! @fn unregister
+    @brief Removes the session from @c registeredSessions, if it is still registered.
+ */
+- (void)unregister {
+  NSMutableDictionary<NSString *, OIDAuthorizationFlowSessionImplementation *> *sessions =
+      [[self class] registeredSessions];
+  @synchronized(sessions) {
+    // a later flow with the same state may have replaced this one
+    if (sessions[_registryKey] == self) {
+      [sessions removeObjectForKey:_registryKey];
+    }
+  }
+}
+
++ (nullable OIDAuthorizationFlowSessionImplementation *)
+    sessionForRedirectKey:(NSString *)redirectKey
+                    state:(nullable NSString *)state {
+  NSMutableDictionary<NSString *, OIDAuthorizationFlowSessionImplementation *> *sessions =
+      [self registeredSessions];
+  NSString *registryKey = [self registryKeyForRedirectKey:redirectKey state:state];
+  @synchronized(sessions) {
+    OIDAuthorizationFlowSessionImplementation *session = sessions[registryKey];
+    if (session || state) {
+      return session;
+    }
+    // a redirect which lost its state can only be attributed if the redirect URL is unambiguous
+    NSString *prefix = [self registryKeyForRedirectKey:redirectKey state:@""];
+    for (NSString *key in sessions) {
+      if ([key hasPrefix:prefix]) {
+        if (session) {
+          return nil;
+        }
+        session = sessions[key];
+      }
+    }
+    return session;
+  }
 }
 
 - (nullable instancetype)initWithRequest:(OIDAuthorizationRequest *)request {
   self = [super init];
   if (self) {
     _request = [request copy];
+    _redirectURLMatcher = [[OIDRedirectURLMatcher alloc] initWithRedirectURL:_request.redirectURL];
+    _registryKey = [[self class] registryKeyForRedirectKey:_redirectURLMatcher.key
+                                                     state:_request.state];
   }
   return self;
 }
@@ -127,44 +320,74 @@ presentationCallback:(OIDWebViewControllerPresentationCallback)presentation
 }
 #endif
 
+- (void)presentWithPresenter:(id<OIDAuthorizationFlowPresenter>)presenter
+            responseCallback:(nullable OIDAuthorizationCallback)responseCallback
+                    callback:(OIDAuthorizationCallback)callback {
+  // the session is already registered, and so may be resumed at any moment
+  @synchronized(self) {
+    _pendingauthorizationFlowCallback = callback;
+    _pendingResponseCallback = responseCallback;
+  }
+  _presenter = presenter;
+  [presenter presentAuthorizationURL:[_request authorizationRequestURL] session:self];
+}
+
+/*! @fn dismissWithCompletion:
+    @brief Dismisses whatever UI presented the request, then calls the block.
+    @param completion The block to call once the UI is gone, or right away if there is none.
+ */
+- (void)dismissWithCompletion:(void (^)(void))completion {
+  id<OIDAuthorizationFlowPresenter> presenter = _presenter;
+  _presenter = nil;
+  if (presenter) {
+    [presenter dismissWithCompletion:completion];
+    return;
+  }
 #if TARGET_OS_IPHONE
-- (void)cancel {
   SFSafariViewController *safari = _safariVC;
   _safariVC = nil;
-  [safari dismissViewControllerAnimated:YES completion:^{
-    NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeUserCanceledAuthorizationFlow
-                                      underlyingError:nil
-                                          description:nil];
-    [self didFinishWithResponse:nil error:error];
-  }];
-}
+  if (safari) {
+    [safari dismissViewControllerAnimated:YES completion:completion];
+  } else {
+    completion();
+  }
 #else
-- (void)cancel {
   OIDWebViewController *webVC = _webVC;
   OIDWebViewControllerDismissalCallback dismis = _webCVDismissalCallback;
   _webVC = nil;
   _webCVDismissalCallback = nil;
-  
+
   [webVC.webView stopLoading];
-  dismis(webVC, ^{
+  if (dismis) {
+    dismis(webVC, completion);
+  } else {
+    completion();
+  }
+#endif
+}
+
+- (void)cancel {
+  OIDAuthorizationCallback callback;
+  @synchronized(self) {
+    callback = _pendingauthorizationFlowCallback;
+    _pendingauthorizationFlowCallback = nil;
+    _pendingResponseCallback = nil;
+  }
+  [self unregister];
+  // the flow already finished, or was resumed and is being dismissed
+  if (!callback) {
+    return;
+  }
+  [self dismissWithCompletion:^{
     NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeUserCanceledAuthorizationFlow
                                       underlyingError:nil
                                           description:nil];
-    [self didFinishWithResponse:nil error:error];
-  });
+    callback(nil, error);
+  }];
 }
-#endif
 
 - (BOOL)shouldHandleURL:(NSURL *)URL {
-  NSURL *standardizedURL = [URL standardizedURL];
-  NSURL *standardizedRedirectURL = [_request.redirectURL standardizedURL];
-
-  return OIDIsEqualIncludingNil(standardizedURL.scheme, standardizedRedirectURL.scheme) &&
-      OIDIsEqualIncludingNil(standardizedURL.user, standardizedRedirectURL.user) &&
-      OIDIsEqualIncludingNil(standardizedURL.password, standardizedRedirectURL.password) &&
-      OIDIsEqualIncludingNil(standardizedURL.host, standardizedRedirectURL.host) &&
-      OIDIsEqualIncludingNil(standardizedURL.port, standardizedRedirectURL.port) &&
-      OIDIsEqualIncludingNil(standardizedURL.path, standardizedRedirectURL.path);
+  return [_redirectURLMatcher matchesURL:URL];
 }
 
 - (BOOL)resumeAuthorizationFlowWithURL:(NSURL *)URL {
@@ -178,65 +401,61 @@ presentationCallback:(OIDWebViewControllerPresentationCallback)presentation
                 format:@"%@", OIDOAuthExceptionInvalidAuthorizationFlow, nil];
   }
 
-  OIDURLQueryComponent *query = [[OIDURLQueryComponent alloc] initWithURL:URL];
-
-  NSError *error;
-  OIDAuthorizationResponse *response = nil;
+  // parses the query and fragment once, as implicit grants respond in the fragment
+  [self resumeAuthorizationFlowWithParameters:[OIDURLQueryComponent redirectParametersWithURL:URL]];
+  return YES;
+}
 
-  // checks for an OAuth error response as per RFC6749 Section 4.1.2.1
-  if (query.dictionaryValue[OIDOAuthErrorFieldError]) {
-    error = [OIDErrorUtilities OAuthErrorWithDomain:OIDOAuthAuthorizationErrorDomain
-                                      OAuthResponse:query.dictionaryValue
-                                    underlyingError:nil];
+- (void)resumeAuthorizationFlowWithParameters:
+    (NSDictionary<NSString *, NSObject<NSCopying> *> *)parameters {
+  OIDAuthorizationCallback callback;
+  OIDAuthorizationCallback responseCallback;
+  @synchronized(self) {
+    callback = _pendingauthorizationFlowCallback;
+    responseCallback = _pendingResponseCallback;
+    _pendingauthorizationFlowCallback = nil;
+    _pendingResponseCallback = nil;
   }
-
-  // no errors, must be a valid OAuth 2.0 response
-  if (!error) {
-    response = [[OIDAuthorizationResponse alloc] initWithRequest:_request
-                                                      parameters:query.dictionaryValue];
+  // the flow already finished, such as when the same redirect is delivered twice
+  if (!callback) {
+    return;
   }
+  [self unregister];
+
+  NSError *error;
+  OIDAuthorizationResponse *response = nil;
+  id responseState = parameters[kStateKey];
 
-  // verifies that the state in the response matches the state in the request, or both are nil
-  if (!OIDIsEqualIncludingNil(_request.state, response.state)) {
-    NSMutableDictionary *userInfo = [query.dictionaryValue mutableCopy];
+  if (!OIDIsEqualIncludingNil(_request.state, responseState)) {
+    // verifies that the state in the response matches the state in the request, or both are nil,
+    // before trusting anything else in it, including an error
+    NSMutableDictionary *userInfo = [parameters mutableCopy];
     userInfo[NSLocalizedFailureReasonErrorKey] =
         [NSString stringWithFormat:@"State mismatch, expecting %@ but got %@ in authorization "
                                     "response %@",
                                    _request.state,
-                                   response.state,
-                                   response];
-    response = nil;
+                                   responseState,
+                                   parameters];
     error = [NSError errorWithDomain:OIDOAuthAuthorizationErrorDomain
                                 code:OIDErrorCodeOAuthAuthorizationClientError
                             userInfo:userInfo];
-  }
-
-#if TARGET_OS_IPHONE
-  if (_safariVC) {
-    SFSafariViewController *safari = _safariVC;
-    _safariVC = nil;
-    [safari dismissViewControllerAnimated:YES completion:^{
-      [self didFinishWithResponse:response error:error];
-    }];
-  } else {
-    [self didFinishWithResponse:response error:error];
-  }
-#else
-  OIDWebViewController *webVC = _webVC;
-  OIDWebViewControllerDismissalCallback dismis = _webCVDismissalCallback;
-  _webVC = nil;
-  _webCVDismissalCallback = nil;
-  
-  if (dismis) {
-    dismis(webVC, ^{
-      [self didFinishWithResponse:response error:error];
-    });
+  } else if (parameters[OIDOAuthErrorFieldError]) {
+    // checks for an OAuth error response as per RFC6749 Section 4.1.2.1
+    error = [OIDErrorUtilities OAuthErrorWithDomain:OIDOAuthAuthorizationErrorDomain
+                                      OAuthResponse:parameters
+                                    underlyingError:nil];
   } else {
-    [self didFinishWithResponse:response error:error];
+    // no errors, must be a valid OAuth 2.0 response
+    response = [[OIDAuthorizationResponse alloc] initWithRequest:_request parameters:parameters];
   }
-#endif
 
-  return YES;
+  // lets the response be acted on while the UI is being dismissed
+  if (responseCallback) {
+    responseCallback(response, error);
+  }
+  [self dismissWithCompletion:^{
+    callback(response, error);
+  }];
 }
 
 #if TARGET_OS_IPHONE
@@ -268,14 +487,19 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
  */
 - (void)didFinishWithResponse:(nullable OIDAuthorizationResponse *)response
                         error:(nullable NSError *)error {
-  OIDAuthorizationCallback callback = _pendingauthorizationFlowCallback;
+  OIDAuthorizationCallback callback;
+  @synchronized(self) {
+    callback = _pendingauthorizationFlowCallback;
+    _pendingauthorizationFlowCallback = nil;
+    _pendingResponseCallback = nil;
+  }
 #if TARGET_OS_IPHONE
   _safariVC = nil;
 #else
   _webVC = nil;
   _webCVDismissalCallback = nil;
 #endif
-  _pendingauthorizationFlowCallback = nil;
+  [self unregister];
 
   if (callback) {
     callback(response, error);
@@ -284,10 +508,718 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
 
 @end
 
+/*! @class OIDMainQueueExecutor
+    @brief The executor used unless another is set, which runs blocks on the main queue.
+ */
+@interface OIDMainQueueExecutor : NSObject <OIDExecutor>
+@end
+
+@implementation OIDMainQueueExecutor
+
+- (void)performBlock:(dispatch_block_t)block {
+  dispatch_async(dispatch_get_main_queue(), block);
+}
+
+- (void)performBlock:(dispatch_block_t)block afterDelay:(NSTimeInterval)delay {
+  int64_t delta = (int64_t)(MAX(delay, 0) * NSEC_PER_SEC);
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, delta), dispatch_get_main_queue(), block);
+}
+
+@end
+
+/*! @typedef OIDCancellableRequestCallback
+    @brief The type-erased callback of an @c OIDCancellableRequestImplementation.
+ */
+typedef void (^OIDCancellableRequestCallback)(id _Nullable result, NSError *_Nullable error);
+
+/*! @class OIDCancellableRequestImplementation
+    @brief Ties the callback of a request to the data task performing it, making sure the callback
+        is invoked exactly once, whether the request completes or is cancelled first.
+ */
+@interface OIDCancellableRequestImplementation : NSObject <OIDCancellableRequest>
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithDeadline:callback:
+    @brief Designated initializer.
+    @param deadline The time by which the request must complete, if any. Once it passes, the
+        request is cancelled, and the callback invoked with an error with code
+        @c ::OIDErrorCodeTimeout.
+    @param callback The callback of the request.
+ */
+- (instancetype)initWithDeadline:(nullable NSDate *)deadline
+                        callback:(OIDCancellableRequestCallback)callback
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @property deadline
+    @brief The time by which the request must complete, if any.
+ */
+@property(nonatomic, readonly, nullable) NSDate *deadline;
+
+/*! @fn startTask:
+    @brief Resumes the data task performing the request, unless the request was cancelled first.
+    @param task The data task.
+    @return NO if the request was already cancelled, in which case the task is not resumed.
+ */
+- (BOOL)startTask:(NSURLSessionTask *)task;
+
+/*! @fn finishWithResult:error:
+    @brief Invokes the callback through the executor, unless the request was cancelled first.
+    @param result The result of the request, if any.
+    @param error The error, if any.
+ */
+- (void)finishWithResult:(nullable id)result error:(nullable NSError *)error;
+
+@end
+
+@implementation OIDCancellableRequestImplementation {
+  /*! @var _callback
+      @brief The callback, nil once it has been invoked. Access is synchronized on @c self.
+   */
+  OIDCancellableRequestCallback _Nullable _callback;
+
+  /*! @var _task
+      @brief The task performing the request, once started. Access is synchronized on @c self.
+   */
+  NSURLSessionTask *_Nullable _task;
+
+  /*! @var _cancelled
+      @brief Whether @c cancel was called. Access is synchronized on @c self.
+   */
+  BOOL _cancelled;
+}
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithDeadline:callback:));
+
+- (instancetype)initWithDeadline:(nullable NSDate *)deadline
+                        callback:(OIDCancellableRequestCallback)callback {
+  self = [super init];
+  if (self) {
+    _deadline = [deadline copy];
+    _callback = callback;
+    if (_deadline) {
+      // the timer only holds a weak reference, so that finished requests aren't kept alive
+      __weak OIDCancellableRequestImplementation *weakSelf = self;
+      NSTimeInterval delay =
+          _deadline.timeIntervalSinceReferenceDate - [OIDMonotonicClock absoluteTime];
+      [[OIDAuthorizationService executor] performBlock:^{
+        NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeTimeout
+                                          underlyingError:nil
+                                              description:nil];
+        [weakSelf cancelWithError:error];
+      } afterDelay:delay];
+    }
+  }
+  return self;
+}
+
+- (BOOL)startTask:(NSURLSessionTask *)task {
+  @synchronized(self) {
+    if (_cancelled) {
+      return NO;
+    }
+    _task = task;
+  }
+  [task resume];
+  return YES;
+}
+
+- (void)cancel {
+  NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                                    underlyingError:nil
+                                        description:nil];
+  [self cancelWithError:error];
+}
+
+- (void)cancelIfNotSent {
+  @synchronized(self) {
+    // the task is set once the request is sent, and the callback cleared once it completed
+    if (_cancelled || _task || !_callback) {
+      return;
+    }
+    _cancelled = YES;
+  }
+  NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                                    underlyingError:nil
+                                        description:nil];
+  [self finishWithResult:nil error:error];
+}
+
+/*! @fn cancelWithError:
+    @brief Cancels the request, and invokes the callback with an error unless it was already
+        invoked.
+    @param error The error to invoke the callback with.
+ */
+- (void)cancelWithError:(NSError *)error {
+  NSURLSessionTask *task;
+  @synchronized(self) {
+    if (_cancelled) {
+      return;
+    }
+    _cancelled = YES;
+    task = _task;
+    _task = nil;
+  }
+  [task cancel];
+  [self finishWithResult:nil error:error];
+}
+
+- (void)finishWithResult:(nullable id)result error:(nullable NSError *)error {
+  // a failure racing the deadline, such as the NSURLRequest timing out, is reported as a timeout
+  if (error && _deadline
+      && _deadline.timeIntervalSinceReferenceDate <= [OIDMonotonicClock absoluteTime]
+      && !(error.domain == OIDGeneralErrorDomain && error.code == OIDErrorCodeTimeout)) {
+    error = [OIDErrorUtilities errorWithCode:OIDErrorCodeTimeout
+                             underlyingError:error
+                                 description:nil];
+  }
+  OIDCancellableRequestCallback callback;
+  @synchronized(self) {
+    callback = _callback;
+    _callback = nil;
+    _task = nil;
+  }
+  if (!callback) {
+    return;
+  }
+  [[OIDAuthorizationService executor] performBlock:^{
+    callback(result, error);
+  }];
+}
+
+@end
+
+/*! @fn OIDMetricsIntervalBetweenDates
+    @brief Returns the interval between two dates, or @c ::OIDMetricsTimingUnavailable if either
+        is nil.
+ */
+static NSTimeInterval OIDMetricsIntervalBetweenDates(NSDate *_Nullable start,
+                                                     NSDate *_Nullable end) {
+  if (!start || !end) {
+    return OIDMetricsTimingUnavailable;
+  }
+  return [end timeIntervalSinceDate:start];
+}
+
+/*! @class OIDMetricsTaskRecorder
+    @brief Times a discovery or token request, and reports its event to the metrics observer once
+        both the request has completed and the task metrics were collected.
+ */
+@interface OIDMetricsTaskRecorder : NSObject
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithEvent:observer:
+    @brief Designated initializer, starts timing the request.
+    @param event The event to fill in and report.
+    @param observer The observer to report the event to.
+ */
+- (instancetype)initWithEvent:(OIDMetricsEvent *)event
+                     observer:(id<OIDMetricsObserver>)observer NS_DESIGNATED_INITIALIZER;
+
+/*! @fn session
+    @brief The session used for requests while metrics are recorded, whose delegate collects the
+        task metrics.
+ */
++ (NSURLSession *)session;
+
+/*! @fn observeTask:
+    @brief Associates the recorder with the task performing the request, so that it receives the
+        task's metrics.
+    @param task The task.
+ */
+- (void)observeTask:(nullable NSURLSessionTask *)task;
+
+/*! @fn beginParsing
+    @brief Marks the start of parsing the response.
+ */
+- (void)beginParsing;
+
+/*! @fn finishWithError:
+    @brief Marks the completion of the request.
+    @param error The error the request failed with, if any.
+ */
+- (void)finishWithError:(nullable NSError *)error;
+
+/*! @fn collectMetrics:
+    @brief Fills in the network timings from the task's metrics.
+    @param metrics The task's metrics.
+ */
+- (void)collectMetrics:(NSURLSessionTaskMetrics *)metrics NS_AVAILABLE(10_12, 10_0);
+
+@end
+
+/*! @class OIDMetricsSessionDelegate
+    @brief The delegate of @c OIDMetricsTaskRecorder.session, forwarding task metrics to the
+        recorder associated with the task.
+ */
+@interface OIDMetricsSessionDelegate : NSObject <NSURLSessionTaskDelegate>
+@end
+
+@implementation OIDMetricsSessionDelegate
+
+- (void)URLSession:(NSURLSession *)session
+                          task:(NSURLSessionTask *)task
+    didFinishCollectingMetrics:(NSURLSessionTaskMetrics *)metrics NS_AVAILABLE(10_12, 10_0) {
+  OIDMetricsTaskRecorder *recorder = objc_getAssociatedObject(task, &kMetricsTaskRecorderKey);
+  [recorder collectMetrics:metrics];
+}
+
+@end
+
+@implementation OIDMetricsTaskRecorder {
+  OIDMetricsEvent *_event;
+  id<OIDMetricsObserver> _observer;
+  CFAbsoluteTime _startTime;
+
+  /*! @var _parseStartTime
+      @brief When parsing the response started, or 0. Access is synchronized on @c self.
+   */
+  CFAbsoluteTime _parseStartTime;
+
+  /*! @var _finished
+      @brief Whether the request completed. Access is synchronized on @c self.
+   */
+  BOOL _finished;
+
+  /*! @var _metricsCollected
+      @brief Whether the task metrics were collected. Access is synchronized on @c self.
+   */
+  BOOL _metricsCollected;
+
+  /*! @var _reported
+      @brief Whether the event was reported. Access is synchronized on @c self.
+   */
+  BOOL _reported;
+}
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithEvent:observer:));
+
+- (instancetype)initWithEvent:(OIDMetricsEvent *)event
+                     observer:(id<OIDMetricsObserver>)observer {
+  self = [super init];
+  if (self) {
+    _event = event;
+    _observer = observer;
+    _startTime = [OIDMonotonicClock absoluteTime];
+  }
+  return self;
+}
+
++ (NSURLSession *)session {
+  static NSURLSession *session;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    NSURLSessionConfiguration *configuration =
+        [NSURLSessionConfiguration defaultSessionConfiguration];
+    session = [NSURLSession sessionWithConfiguration:configuration
+                                            delegate:[[OIDMetricsSessionDelegate alloc] init]
+                                       delegateQueue:nil];
+  });
+  return session;
+}
+
+- (void)observeTask:(nullable NSURLSessionTask *)task {
+  if (task) {
+    objc_setAssociatedObject(task, &kMetricsTaskRecorderKey, self,
+                             OBJC_ASSOCIATION_RETAIN_NONATOMIC);
+  }
+}
+
+- (void)beginParsing {
+  @synchronized(self) {
+    _parseStartTime = [OIDMonotonicClock absoluteTime];
+  }
+}
+
+- (void)finishWithError:(nullable NSError *)error {
+  BOOL report;
+  @synchronized(self) {
+    CFAbsoluteTime now = [OIDMonotonicClock absoluteTime];
+    _event.duration = now - _startTime;
+    if (_parseStartTime) {
+      _event.parseDuration = now - _parseStartTime;
+    }
+    _event.error = error;
+    _finished = YES;
+    report = _metricsCollected;
+  }
+  if (report) {
+    [self report];
+    return;
+  }
+  // task metrics are normally delivered around the same time as the response, but aren't
+  // available at all on older OS versions
+  [[OIDAuthorizationService executor] performBlock:^{
+    [self report];
+  } afterDelay:kMetricsGracePeriod];
+}
+
+- (void)collectMetrics:(NSURLSessionTaskMetrics *)metrics {
+  BOOL report;
+  @synchronized(self) {
+    NSURLSessionTaskTransactionMetrics *transaction = metrics.transactionMetrics.lastObject;
+    _event.domainLookupDuration =
+        OIDMetricsIntervalBetweenDates(transaction.domainLookupStartDate,
+                                       transaction.domainLookupEndDate);
+    _event.connectDuration =
+        OIDMetricsIntervalBetweenDates(transaction.connectStartDate, transaction.connectEndDate);
+    _event.secureConnectionDuration =
+        OIDMetricsIntervalBetweenDates(transaction.secureConnectionStartDate,
+                                       transaction.secureConnectionEndDate);
+    _event.timeToFirstByte =
+        OIDMetricsIntervalBetweenDates(transaction.requestStartDate,
+                                       transaction.responseStartDate);
+    _metricsCollected = YES;
+    report = _finished;
+  }
+  if (report) {
+    [self report];
+  }
+}
+
+/*! @fn report
+    @brief Reports the event to the observer, unless it was already reported.
+ */
+- (void)report {
+  @synchronized(self) {
+    if (_reported) {
+      return;
+    }
+    _reported = YES;
+  }
+  [_observer didRecordMetricsEvent:_event];
+}
+
+@end
+
+/*! @typedef OIDRequestBatchOperation
+    @brief Represents the type of block which starts the request at an index of a batch.
+    @param index The index of the request.
+    @param callback Must be called exactly once when the request has completed or failed.
+    @return A handle which may be used to cancel the request.
+ */
+typedef id<OIDCancellableRequest> _Nonnull (^OIDRequestBatchOperation)(
+    NSUInteger index, OIDCancellableRequestCallback callback);
+
+/*! @typedef OIDRequestBatchItemCallback
+    @brief The type-erased item callback of an @c OIDRequestBatch.
+ */
+typedef void (^OIDRequestBatchItemCallback)(NSUInteger index,
+                                            id _Nullable result,
+                                            NSError *_Nullable error);
+
+/*! @typedef OIDRequestBatchCallback
+    @brief The type-erased completion of an @c OIDRequestBatch.
+ */
+typedef void (^OIDRequestBatchCallback)(NSArray *results, NSArray *errors);
+
+/*! @class OIDRequestBatch
+    @brief Tracks a batch of requests, such as token or revocation requests, starting them with a
+        bounded number of requests in flight per endpoint.
+ */
+@interface OIDRequestBatch : NSObject <OIDCancellableRequest>
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithEndpoints:maxConcurrentRequestsPerEndpoint:operation:itemCallback:completion:
+    @brief Designated initializer.
+    @param endpoints The endpoint of each request, which the concurrency limit applies to.
+    @param maxConcurrentRequestsPerEndpoint The maximum number of requests in flight per endpoint.
+    @param operation Starts a request.
+    @param itemCallback Called as each request completes or fails.
+    @param completion Called once every request has completed or failed.
+ */
+- (instancetype)initWithEndpoints:(NSArray<NSURL *> *)endpoints
+    maxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+                           operation:(OIDRequestBatchOperation)operation
+                        itemCallback:(nullable OIDRequestBatchItemCallback)itemCallback
+                          completion:(OIDRequestBatchCallback)completion
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn start
+    @brief Starts as many requests as the concurrency limit allows for each endpoint.
+ */
+- (void)start;
+
+@end
+
+@implementation OIDRequestBatch {
+  NSArray<NSURL *> *_endpoints;
+  NSUInteger _maxConcurrentRequestsPerEndpoint;
+  OIDRequestBatchOperation _operation;
+  OIDRequestBatchItemCallback _itemCallback;
+  OIDRequestBatchCallback _completion;
+
+  /*! @var _queuedIndexes
+      @brief The indexes of requests not yet started, keyed by endpoint. Access is synchronized on
+          @c self.
+   */
+  NSMutableDictionary<NSURL *, NSMutableArray<NSNumber *> *> *_queuedIndexes;
+
+  /*! @var _inFlightCounts
+      @brief The number of started but not yet completed requests, keyed by endpoint. Access is
+          synchronized on @c self.
+   */
+  NSMutableDictionary<NSURL *, NSNumber *> *_inFlightCounts;
+
+  /*! @var _inFlightRequests
+      @brief The cancellation handles of the started but not yet completed requests, keyed by
+          index. Access is synchronized on @c self.
+   */
+  NSMutableDictionary<NSNumber *, id<OIDCancellableRequest>> *_inFlightRequests;
+
+  /*! @var _cancelled
+      @brief Whether @c cancel was called. Access is synchronized on @c self.
+   */
+  BOOL _cancelled;
+
+  NSMutableArray *_results;
+  NSMutableArray *_errors;
+  NSUInteger _remainingCount;
+}
+
+- (instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(
+        @selector(initWithEndpoints:
+            maxConcurrentRequestsPerEndpoint:operation:itemCallback:completion:));
+
+- (instancetype)initWithEndpoints:(NSArray<NSURL *> *)endpoints
+    maxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+                           operation:(OIDRequestBatchOperation)operation
+                        itemCallback:(nullable OIDRequestBatchItemCallback)itemCallback
+                          completion:(OIDRequestBatchCallback)completion {
+  self = [super init];
+  if (self) {
+    _endpoints = [endpoints copy];
+    _maxConcurrentRequestsPerEndpoint = MAX(maxConcurrentRequestsPerEndpoint, 1u);
+    _operation = operation;
+    _itemCallback = itemCallback;
+    _completion = completion;
+    _queuedIndexes = [NSMutableDictionary dictionary];
+    _inFlightCounts = [NSMutableDictionary dictionary];
+    _inFlightRequests = [NSMutableDictionary dictionary];
+    _results = [NSMutableArray arrayWithCapacity:_endpoints.count];
+    _errors = [NSMutableArray arrayWithCapacity:_endpoints.count];
+    _remainingCount = _endpoints.count;
+
+    for (NSUInteger i = 0; i < _endpoints.count; i++) {
+      [_results addObject:[NSNull null]];
+      [_errors addObject:[NSNull null]];
+      NSURL *endpoint = _endpoints[i];
+      NSMutableArray<NSNumber *> *queue = _queuedIndexes[endpoint];
+      if (!queue) {
+        queue = [NSMutableArray array];
+        _queuedIndexes[endpoint] = queue;
+      }
+      [queue addObject:@(i)];
+    }
+  }
+  return self;
+}
+
+- (void)start {
+  if (!_endpoints.count) {
+    OIDRequestBatchCallback completion = _completion;
+    [[OIDAuthorizationService executor] performBlock:^{
+      completion(@[], @[]);
+    }];
+    return;
+  }
+
+  NSMutableArray<NSNumber *> *indexesToStart = [NSMutableArray array];
+  @synchronized(self) {
+    for (NSURL *endpoint in _queuedIndexes.allKeys) {
+      [indexesToStart addObjectsFromArray:[self dequeueIndexesForEndpoint:endpoint]];
+    }
+  }
+  for (NSNumber *index in indexesToStart) {
+    [self performRequestAtIndex:index.unsignedIntegerValue];
+  }
+}
+
+/*! @fn dequeueIndexesForEndpoint:
+    @brief Removes and returns the indexes of the queued requests for an endpoint which can be
+        started without exceeding the concurrency limit, counting them as in flight.
+    @param endpoint The endpoint.
+    @remarks Must be called while synchronized on @c self.
+ */
+- (NSArray<NSNumber *> *)dequeueIndexesForEndpoint:(NSURL *)endpoint {
+  NSMutableArray<NSNumber *> *queue = _queuedIndexes[endpoint];
+  NSUInteger inFlightCount = [_inFlightCounts[endpoint] unsignedIntegerValue];
+  NSMutableArray<NSNumber *> *dequeued = [NSMutableArray array];
+  while (queue.count && inFlightCount < _maxConcurrentRequestsPerEndpoint) {
+    [dequeued addObject:queue.firstObject];
+    [queue removeObjectAtIndex:0];
+    inFlightCount++;
+  }
+  _inFlightCounts[endpoint] = @(inFlightCount);
+  return dequeued;
+}
+
+- (void)cancel {
+  NSArray<NSNumber *> *queuedIndexes;
+  NSArray<id<OIDCancellableRequest>> *inFlightRequests;
+  @synchronized(self) {
+    if (_cancelled) {
+      return;
+    }
+    _cancelled = YES;
+    NSMutableArray<NSNumber *> *indexes = [NSMutableArray array];
+    for (NSMutableArray<NSNumber *> *queue in _queuedIndexes.allValues) {
+      [indexes addObjectsFromArray:queue];
+      [queue removeAllObjects];
+    }
+    queuedIndexes = indexes;
+    inFlightRequests = _inFlightRequests.allValues;
+  }
+
+  // requests which were never started complete right away, the others once their cancellation
+  // has been delivered
+  NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                                    underlyingError:nil
+                                        description:nil];
+  [[OIDAuthorizationService executor] performBlock:^{
+    for (NSNumber *index in queuedIndexes) {
+      [self requestAtIndex:index.unsignedIntegerValue
+          didCompleteWithResult:nil
+                          error:error
+                        started:NO];
+    }
+  }];
+  for (id<OIDCancellableRequest> request in inFlightRequests) {
+    [request cancel];
+  }
+}
+
+- (void)performRequestAtIndex:(NSUInteger)index {
+  id<OIDCancellableRequest> cancellableRequest =
+      _operation(index, ^(id _Nullable result, NSError *_Nullable error) {
+    [self requestAtIndex:index didCompleteWithResult:result error:error started:YES];
+  });
+  BOOL cancelled;
+  @synchronized(self) {
+    cancelled = _cancelled;
+    if (!cancelled) {
+      _inFlightRequests[@(index)] = cancellableRequest;
+    }
+  }
+  // the batch was cancelled while this request was being started
+  if (cancelled) {
+    [cancellableRequest cancel];
+  }
+}
+
+/*! @fn requestAtIndex:didCompleteWithResult:error:started:
+    @brief Records the result of a request, starts queued requests in its place, and invokes the
+        callbacks.
+    @param index The index of the request.
+    @param result The result, if any.
+    @param error The error, if any.
+    @param started Whether the request was started, as opposed to cancelled while still queued.
+ */
+- (void)requestAtIndex:(NSUInteger)index
+    didCompleteWithResult:(nullable id)result
+                    error:(nullable NSError *)error
+                  started:(BOOL)started {
+  NSURL *endpoint = _endpoints[index];
+  NSArray<NSNumber *> *indexesToStart;
+  BOOL finished;
+  @synchronized(self) {
+    if (result) {
+      _results[index] = result;
+    }
+    if (error) {
+      _errors[index] = error;
+    }
+    if (started) {
+      [_inFlightRequests removeObjectForKey:@(index)];
+      _inFlightCounts[endpoint] = @([_inFlightCounts[endpoint] unsignedIntegerValue] - 1);
+    }
+    indexesToStart = [self dequeueIndexesForEndpoint:endpoint];
+    finished = (--_remainingCount == 0);
+  }
+
+  if (_itemCallback) {
+    _itemCallback(index, result, error);
+  }
+  for (NSNumber *indexToStart in indexesToStart) {
+    [self performRequestAtIndex:indexToStart.unsignedIntegerValue];
+  }
+  if (finished) {
+    _completion([_results copy], [_errors copy]);
+  }
+}
+
+@end
+
 @implementation OIDAuthorizationService
 
-+ (void)discoverServiceConfigurationForIssuer:(NSURL *)issuerURL
-                                   completion:(OIDDiscoveryCallback)completion {
++ (nullable id<OIDMetricsObserver>)metricsObserver {
+  return OIDLoadGlobal(&gMetricsObserver);
+}
+
++ (void)setMetricsObserver:(nullable id<OIDMetricsObserver>)metricsObserver {
+  OIDStoreGlobal(&gMetricsObserver, metricsObserver);
+}
+
++ (id<OIDExecutor>)executor {
+  static OIDMainQueueExecutor *mainQueueExecutor;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mainQueueExecutor = [[OIDMainQueueExecutor alloc] init];
+  });
+  return OIDLoadGlobal(&gExecutor) ?: mainQueueExecutor;
+}
+
++ (void)setExecutor:(nullable id<OIDExecutor>)executor {
+  OIDStoreGlobal(&gExecutor, executor);
+}
+
++ (nullable NSURLSession *)URLSession {
+  return OIDLoadGlobal(&gURLSession);
+}
+
++ (void)setURLSession:(nullable NSURLSession *)URLSession {
+  OIDStoreGlobal(&gURLSession, URLSession);
+}
+
+/*! @fn URLSessionForRecorder:
+    @brief The session to make a request with.
+    @param recorder The request's metrics recorder, if metrics are recorded.
+ */
++ (NSURLSession *)URLSessionForRecorder:(nullable OIDMetricsTaskRecorder *)recorder {
+  NSURLSession *session = [self URLSession];
+  if (session) {
+    return session;
+  }
+  return recorder ? [OIDMetricsTaskRecorder session] : [NSURLSession sharedSession];
+}
+
+/*! @fn metricsRecorderWithType:URL:grantType:
+    @brief Creates a recorder for a request, if a metrics observer is set.
+    @param type The type of the request.
+    @param URL The URL of the request.
+    @param grantType The grant type of a token request.
+    @return The recorder, or nil if no metrics observer is set.
+ */
++ (nullable OIDMetricsTaskRecorder *)metricsRecorderWithType:(OIDMetricsEventType)type
+                                                         URL:(NSURL *)URL
+                                                   grantType:(nullable NSString *)grantType {
+  id<OIDMetricsObserver> observer = [self metricsObserver];
+  if (!observer) {
+    return nil;
+  }
+  OIDMetricsEvent *event = [[OIDMetricsEvent alloc] initWithType:type];
+  event.URL = URL;
+  event.grantType = grantType;
+  event.cacheResult = OIDMetricsCacheResultMiss;
+  event.coalescedWaiterCount = 1;
+  return [[OIDMetricsTaskRecorder alloc] initWithEvent:event observer:observer];
+}
+
++ (id<OIDCancellableRequest>)discoverServiceConfigurationForIssuer:(NSURL *)issuerURL
+                                                        completion:(OIDDiscoveryCallback)completion {
   NSURL *fullDiscoveryURL =
       [issuerURL URLByAppendingPathComponent:kOpenIDConfigurationWellKnownPath];
 
@@ -296,21 +1228,64 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
 }
 
 
-+ (void)discoverServiceConfigurationForDiscoveryURL:(NSURL *)discoveryURL
-    completion:(OIDDiscoveryCallback)completion {
++ (id<OIDCancellableRequest>)
+    discoverServiceConfigurationForDiscoveryURL:(NSURL *)discoveryURL
+                                     completion:(OIDDiscoveryCallback)completion {
+  return [self discoverServiceConfigurationForDiscoveryURL:discoveryURL
+                                                  deadline:nil
+                                                completion:completion];
+}
 
-  NSURLSession *session = [NSURLSession sharedSession];
++ (id<OIDCancellableRequest>)
+    discoverServiceConfigurationForDiscoveryURL:(NSURL *)discoveryURL
+                                       deadline:(nullable NSDate *)deadline
+                                     completion:(OIDDiscoveryCallback)completion {
+  OIDCancellableRequestImplementation *cancellableRequest =
+      [[OIDCancellableRequestImplementation alloc]
+          initWithDeadline:deadline
+                  callback:^(id _Nullable result, NSError *_Nullable error) {
+    completion(result, error);
+  }];
   NSURLSessionDataTask *task =
-      [session dataTaskWithURL:discoveryURL
-             completionHandler:^(NSData *data, NSURLResponse *response, NSError *error) {
+      [self discoveryTaskWithURL:discoveryURL
+                        deadline:deadline
+                        callback:^(OIDServiceConfiguration *_Nullable configuration,
+                                   NSError *_Nullable error) {
+    [cancellableRequest finishWithResult:configuration error:error];
+  }];
+  [cancellableRequest startTask:task];
+  return cancellableRequest;
+}
+
+/*! @fn discoveryTaskWithURL:deadline:callback:
+    @brief Creates a data task which fetches and parses a discovery document, without resuming it.
+    @param discoveryURL The URL of the discovery document.
+    @param deadline The time by which the request must complete, if any.
+    @param callback The method called on the session's delegate queue when the request has
+        completed or failed.
+ */
++ (NSURLSessionDataTask *)discoveryTaskWithURL:(NSURL *)discoveryURL
+                                      deadline:(nullable NSDate *)deadline
+                                      callback:(OIDDiscoveryCallback)callback {
+  OIDMetricsTaskRecorder *recorder = [self metricsRecorderWithType:OIDMetricsEventTypeDiscovery
+                                                               URL:discoveryURL
+                                                         grantType:nil];
+  if (recorder) {
+    OIDDiscoveryCallback unrecordedCallback = callback;
+    callback = ^(OIDServiceConfiguration *_Nullable configuration, NSError *_Nullable error) {
+      [recorder finishWithError:error];
+      unrecordedCallback(configuration, error);
+    };
+  }
+
+  void (^completionHandler)(NSData *_Nullable, NSURLResponse *_Nullable, NSError *_Nullable) =
+      ^(NSData *_Nullable data, NSURLResponse *_Nullable response, NSError *_Nullable error) {
     // If we got any sort of error, just report it.
     if (error || !data) {
       error = [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
                                underlyingError:error
                                    description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        completion(nil, error);
-      });
+      callback(nil, error);
       return;
     }
 
@@ -324,33 +1299,40 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
       error = [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
                                underlyingError:URLResponseError
                                    description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        completion(nil, error);
-      });
+      callback(nil, error);
       return;
     }
 
     // Construct an OIDServiceDiscovery with the received JSON.
+    [recorder beginParsing];
     OIDServiceDiscovery *discovery =
         [[OIDServiceDiscovery alloc] initWithJSONData:data error:&error];
     if (error || !discovery) {
       error = [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
                                underlyingError:error
                                    description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        completion(nil, error);
-      });
+      callback(nil, error);
       return;
     }
 
     // Create our service configuration with the discovery document and return it.
     OIDServiceConfiguration *configuration =
         [[OIDServiceConfiguration alloc] initWithDiscoveryDocument:discovery];
-    dispatch_async(dispatch_get_main_queue(), ^{
-      completion(configuration, nil);
-    });
-  }];
-  [task resume];
+    callback(configuration, nil);
+  };
+
+  NSURLSession *session = [self URLSessionForRecorder:recorder];
+  NSURLSessionDataTask *task;
+  if (deadline) {
+    NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:discoveryURL];
+    URLRequest.timeoutInterval =
+        OIDTimeoutIntervalForDeadline(deadline, URLRequest.timeoutInterval);
+    task = [session dataTaskWithRequest:URLRequest completionHandler:completionHandler];
+  } else {
+    task = [session dataTaskWithURL:discoveryURL completionHandler:completionHandler];
+  }
+  [recorder observeTask:task];
+  return task;
 }
 
 #pragma mark - Authorization Endpoint
@@ -362,6 +1344,7 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
                        callback:(OIDAuthorizationCallback)callback {
   OIDAuthorizationFlowSessionImplementation *flow =
       [[OIDAuthorizationFlowSessionImplementation alloc] initWithRequest:request];
+  [OIDAuthorizationFlowSessionImplementation registerSession:flow];
   [flow presentSafariViewControllerWithViewController:presentingViewController
                                              callback:callback];
   return flow;
@@ -375,6 +1358,7 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
              completionCallback:(OIDAuthorizationCallback)completion {
   OIDAuthorizationFlowSessionImplementation *flow =
       [[OIDAuthorizationFlowSessionImplementation alloc] initWithRequest:request];
+  [OIDAuthorizationFlowSessionImplementation registerSession:flow];
   [flow presentWebViewControllerWithConfiguration:configuration ?: [[WKWebViewConfiguration alloc] init]
                              presentationCallback:presentation
                                 dismissalCallback:dismissal
@@ -383,29 +1367,142 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
 }
 #endif
 
++ (id<OIDAuthorizationFlowSession>)
+    presentAuthorizationRequest:(OIDAuthorizationRequest *)request
+                      presenter:(id<OIDAuthorizationFlowPresenter>)presenter
+               responseCallback:(nullable OIDAuthorizationCallback)responseCallback
+                       callback:(OIDAuthorizationCallback)callback {
+  OIDAuthorizationFlowSessionImplementation *flow =
+      [[OIDAuthorizationFlowSessionImplementation alloc] initWithRequest:request];
+  [OIDAuthorizationFlowSessionImplementation registerSession:flow];
+  [flow presentWithPresenter:presenter responseCallback:responseCallback callback:callback];
+  return flow;
+}
+
++ (BOOL)resumeAuthorizationFlowWithURL:(NSURL *)URL {
+  NSDictionary<NSString *, NSObject<NSCopying> *> *parameters =
+      [OIDURLQueryComponent redirectParametersWithURL:URL];
+  id state = parameters[kStateKey];
+  OIDAuthorizationFlowSessionImplementation *session =
+      [OIDAuthorizationFlowSessionImplementation
+          sessionForRedirectKey:[OIDRedirectURLMatcher keyForURL:URL]
+                          state:[state isKindOfClass:[NSString class]] ? state : nil];
+  if (!session) {
+    return NO;
+  }
+  [session resumeAuthorizationFlowWithParameters:parameters];
+  return YES;
+}
+
 #pragma mark - Token Endpoint
 
-+ (void)performTokenRequest:(OIDTokenRequest *)request callback:(OIDTokenCallback)callback {
++ (id<OIDCancellableRequest>)performTokenRequest:(OIDTokenRequest *)request
+                                        callback:(OIDTokenCallback)callback {
+  OIDTokenRequestPriority priority =
+      [request.grantType isEqualToString:OIDGrantTypeAuthorizationCode]
+          ? OIDTokenRequestPriorityInteractive
+          : OIDTokenRequestPriorityForegroundRefresh;
+  return [self performTokenRequest:request priority:priority callback:callback];
+}
+
++ (id<OIDCancellableRequest>)performTokenRequest:(OIDTokenRequest *)request
+                                        priority:(OIDTokenRequestPriority)priority
+                                        callback:(OIDTokenCallback)callback {
+  return [self performTokenRequest:request priority:priority deadline:nil callback:callback];
+}
+
++ (id<OIDCancellableRequest>)performTokenRequest:(OIDTokenRequest *)request
+                                        priority:(OIDTokenRequestPriority)priority
+                                        deadline:(nullable NSDate *)deadline
+                                        callback:(OIDTokenCallback)callback {
+  OIDCancellableRequestImplementation *cancellableRequest =
+      [[OIDCancellableRequestImplementation alloc]
+          initWithDeadline:deadline
+                  callback:^(id _Nullable result, NSError *_Nullable error) {
+    callback(result, error);
+  }];
+  [[OIDTokenRequestScheduler sharedScheduler]
+      scheduleOperationForEndpoint:request.configuration.tokenEndpoint
+                          priority:priority
+                         operation:^(dispatch_block_t completion) {
+    NSURLSessionDataTask *task =
+        [self tokenTaskWithRequest:request
+                          deadline:deadline
+                          callback:^(OIDTokenResponse *_Nullable tokenResponse,
+                                     NSError *_Nullable error) {
+      completion();
+      [cancellableRequest finishWithResult:tokenResponse error:error];
+    }];
+    // a request cancelled or timed out while queued releases its slot without ever being sent
+    if (![cancellableRequest startTask:task]) {
+      completion();
+    }
+  }];
+  return cancellableRequest;
+}
+
+/*! @fn tokenTaskWithRequest:deadline:callback:
+    @brief Creates a data task which sends a token request to the token endpoint and parses the
+        response, without resuming it.
+    @param request The token request.
+    @param deadline The time by which the request must complete, if any.
+    @param callback The method called on the session's delegate queue when the request has
+        completed or failed.
+ */
++ (NSURLSessionDataTask *)tokenTaskWithRequest:(OIDTokenRequest *)request
+                                      deadline:(nullable NSDate *)deadline
+                                      callback:(OIDTokenCallback)callback {
+  OIDMetricsTaskRecorder *recorder =
+      [self metricsRecorderWithType:OIDMetricsEventTypeTokenRequest
+                                URL:request.configuration.tokenEndpoint
+                          grantType:request.grantType];
+  if (recorder) {
+    OIDTokenCallback unrecordedCallback = callback;
+    callback = ^(OIDTokenResponse *_Nullable tokenResponse, NSError *_Nullable error) {
+      [recorder finishWithError:error];
+      unrecordedCallback(tokenResponse, error);
+    };
+  }
+
   NSURLRequest *URLRequest = [request URLRequest];
-  NSURLSession *session = [NSURLSession sharedSession];
-  [[session dataTaskWithRequest:URLRequest
-              completionHandler:^(NSData *_Nullable data,
-                                  NSURLResponse *_Nullable response,
-                                  NSError *_Nullable error) {
+  if (deadline) {
+    NSMutableURLRequest *mutableURLRequest = [URLRequest mutableCopy];
+    mutableURLRequest.timeoutInterval =
+        OIDTimeoutIntervalForDeadline(deadline, mutableURLRequest.timeoutInterval);
+    URLRequest = mutableURLRequest;
+  }
+  NSURLSession *session = [self URLSessionForRecorder:recorder];
+  NSURL *issuer = [OIDClockSkewEstimator issuerForConfiguration:request.configuration];
+  NSDate *requestDate = [OIDMonotonicClock date];
+  NSURLSessionDataTask *task =
+      [session dataTaskWithRequest:URLRequest
+                 completionHandler:^(NSData *_Nullable data,
+                                     NSURLResponse *_Nullable response,
+                                     NSError *_Nullable error) {
     if (error) {
       // A network error or server error occurred.
       NSError *returnedError =
           [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
                            underlyingError:error
                                description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        callback(nil, returnedError);
-      });
+      callback(nil, returnedError);
       return;
     }
 
     NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
 
+    // every response, even an error, tells the time at the issuer
+    NSDate *responseDate = [OIDMonotonicClock date];
+    NSString *HTTPDate = HTTPURLResponse.allHeaderFields[kHTTPDateHeader];
+    NSDate *serverDate = HTTPDate ? [OIDClockSkewEstimator dateFromHTTPDate:HTTPDate] : nil;
+    if (serverDate) {
+      [[OIDClockSkewEstimator sharedEstimator] recordServerDate:serverDate
+                                                     resolution:kHTTPDateResolution
+                                                    requestDate:requestDate
+                                                   responseDate:responseDate
+                                                      forIssuer:issuer];
+    }
+
     if (HTTPURLResponse.statusCode != 200) {
       // A server error occurred.
       NSError *serverError =
@@ -413,6 +1510,7 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
 
       // HTTP 400 may indicate an RFC6749 Section 5.2 error response, checks for that
       if (HTTPURLResponse.statusCode == 400) {
+        [recorder beginParsing];
         NSError *jsonDeserializationError;
         NSDictionary<NSString *, NSObject<NSCopying> *> *json =
             [NSJSONSerialization JSONObjectWithData:data options:0 error:&jsonDeserializationError];
@@ -424,9 +1522,7 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
             [OIDErrorUtilities OAuthErrorWithDomain:OIDOAuthTokenErrorDomain
                                       OAuthResponse:json
                                     underlyingError:serverError];
-          dispatch_async(dispatch_get_main_queue(), ^{
-            callback(nil, oauthError);
-          });
+          callback(nil, oauthError);
           return;
         }
       }
@@ -436,12 +1532,11 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
           [OIDErrorUtilities errorWithCode:OIDErrorCodeServerError
                            underlyingError:serverError
                                description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        callback(nil, returnedError);
-      });
+      callback(nil, returnedError);
       return;
     }
 
+    [recorder beginParsing];
     NSError *jsonDeserializationError;
     NSDictionary<NSString *, NSObject<NSCopying> *> *json =
         [NSJSONSerialization JSONObjectWithData:data options:0 error:&jsonDeserializationError];
@@ -451,9 +1546,7 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
           [OIDErrorUtilities errorWithCode:OIDErrorCodeJSONDeserializationError
                            underlyingError:jsonDeserializationError
                                description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        callback(nil, returnedError);
-      });
+      callback(nil, returnedError);
       return;
     }
 
@@ -465,17 +1558,345 @@ decidePolicyForNavigationAction:(WKNavigationAction *)navigationAction
           [OIDErrorUtilities errorWithCode:OIDErrorCodeTokenResponseConstructionError
                            underlyingError:jsonDeserializationError
                                description:nil];
-      dispatch_async(dispatch_get_main_queue(), ^{
-        callback(nil, returnedError);
-      });
+      callback(nil, returnedError);
       return;
     }
 
     // Success
-    dispatch_async(dispatch_get_main_queue(), ^{
-      callback(tokenResponse, nil);
-    });
-  }] resume];
+    callback(tokenResponse, nil);
+  }];
+  [recorder observeTask:task];
+  return task;
+}
+
++ (id<OIDCancellableRequest>)performTokenRequests:(NSArray<OIDTokenRequest *> *)requests
+                                     itemCallback:(nullable OIDTokenBatchItemCallback)itemCallback
+                                       completion:(OIDTokenBatchCallback)completion {
+  return [self performTokenRequests:requests
+      maxConcurrentRequestsPerEndpoint:kDefaultMaxConcurrentRequestsPerEndpoint
+                              priority:OIDTokenRequestPriorityForegroundRefresh
+                          itemCallback:itemCallback
+                            completion:completion];
+}
+
++ (id<OIDCancellableRequest>)performTokenRequests:(NSArray<OIDTokenRequest *> *)requests
+    maxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+                            priority:(OIDTokenRequestPriority)priority
+                        itemCallback:(nullable OIDTokenBatchItemCallback)itemCallback
+                          completion:(OIDTokenBatchCallback)completion {
+  NSMutableArray<NSURL *> *endpoints = [NSMutableArray arrayWithCapacity:requests.count];
+  for (OIDTokenRequest *request in requests) {
+    [endpoints addObject:request.configuration.tokenEndpoint];
+  }
+  OIDRequestBatchItemCallback batchItemCallback = nil;
+  if (itemCallback) {
+    batchItemCallback = ^(NSUInteger index, id _Nullable result, NSError *_Nullable error) {
+      itemCallback(index, result, error);
+    };
+  }
+  OIDRequestBatch *batch =
+      [[OIDRequestBatch alloc] initWithEndpoints:endpoints
+                maxConcurrentRequestsPerEndpoint:maxConcurrentRequestsPerEndpoint
+                                       operation:^id<OIDCancellableRequest>(
+                                           NSUInteger index,
+                                           OIDCancellableRequestCallback callback) {
+    return [self performTokenRequest:requests[index]
+                            priority:priority
+                            callback:^(OIDTokenResponse *_Nullable tokenResponse,
+                                       NSError *_Nullable error) {
+      callback(tokenResponse, error);
+    }];
+  }
+                                    itemCallback:batchItemCallback
+                                      completion:completion];
+  [batch start];
+  return batch;
+}
+
+#pragma mark - Revocation Endpoint
+
++ (id<OIDCancellableRequest>)performRevocationRequest:(OIDRevocationRequest *)request
+                                             callback:(OIDRevocationCallback)callback {
+  OIDCancellableRequestImplementation *cancellableRequest =
+      [[OIDCancellableRequestImplementation alloc]
+          initWithDeadline:nil
+                  callback:^(id _Nullable result, NSError *_Nullable error) {
+    callback(error);
+  }];
+  [[OIDTokenRequestScheduler sharedScheduler]
+      scheduleOperationForEndpoint:request.revocationEndpoint
+                          priority:OIDTokenRequestPriorityForegroundRefresh
+                         operation:^(dispatch_block_t completion) {
+    NSURLSessionDataTask *task =
+        [self revocationTaskWithRequest:request callback:^(NSError *_Nullable error) {
+      completion();
+      [cancellableRequest finishWithResult:nil error:error];
+    }];
+    // a request cancelled while queued releases its slot without ever being sent
+    if (![cancellableRequest startTask:task]) {
+      completion();
+    }
+  }];
+  return cancellableRequest;
+}
+
+/*! @fn revocationTaskWithRequest:callback:
+    @brief Creates a data task which sends a revocation request to the revocation endpoint and
+        checks the response, without resuming it.
+    @param request The revocation request.
+    @param callback The method called on the session's delegate queue when the request has
+        completed or failed.
+ */
++ (NSURLSessionDataTask *)revocationTaskWithRequest:(OIDRevocationRequest *)request
+                                           callback:(OIDRevocationCallback)callback {
+  OIDMetricsTaskRecorder *recorder = [self metricsRecorderWithType:OIDMetricsEventTypeRevocation
+                                                               URL:request.revocationEndpoint
+                                                         grantType:nil];
+  if (recorder) {
+    OIDRevocationCallback unrecordedCallback = callback;
+    callback = ^(NSError *_Nullable error) {
+      [recorder finishWithError:error];
+      unrecordedCallback(error);
+    };
+  }
+
+  NSURLSession *session = [self URLSessionForRecorder:recorder];
+  NSURLSessionDataTask *task =
+      [session dataTaskWithRequest:[request URLRequest]
+                 completionHandler:^(NSData *_Nullable data,
+                                     NSURLResponse *_Nullable response,
+                                     NSError *_Nullable error) {
+    if (error) {
+      callback([OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
+                                underlyingError:error
+                                    description:nil]);
+      return;
+    }
+
+    // the server responds with 200 both when the token was revoked and when it was already
+    // invalid, and ignores the body
+    // https://tools.ietf.org/html/rfc7009#section-2.2
+    NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
+    if (HTTPURLResponse.statusCode == 200) {
+      callback(nil);
+      return;
+    }
+
+    NSError *serverError =
+        [OIDErrorUtilities HTTPErrorWithHTTPResponse:HTTPURLResponse data:data];
+    // errors such as unsupported_token_type use the token endpoint's error response format
+    // https://tools.ietf.org/html/rfc7009#section-2.2.1
+    if (HTTPURLResponse.statusCode == 400 && data) {
+      [recorder beginParsing];
+      NSDictionary<NSString *, NSObject<NSCopying> *> *json =
+          [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+      if ([json isKindOfClass:[NSDictionary class]] && json[OIDOAuthErrorFieldError]) {
+        callback([OIDErrorUtilities OAuthErrorWithDomain:OIDOAuthTokenErrorDomain
+                                           OAuthResponse:json
+                                         underlyingError:serverError]);
+        return;
+      }
+    }
+    callback([OIDErrorUtilities errorWithCode:OIDErrorCodeServerError
+                              underlyingError:serverError
+                                  description:nil]);
+  }];
+  [recorder observeTask:task];
+  return task;
+}
+
++ (id<OIDCancellableRequest>)performRevocationRequests:(NSArray<OIDRevocationRequest *> *)requests
+                itemCallback:(nullable OIDRevocationBatchItemCallback)itemCallback
+                  completion:(OIDRevocationBatchCallback)completion {
+  return [self performRevocationRequests:requests
+           maxConcurrentRequestsPerEndpoint:kDefaultMaxConcurrentRequestsPerEndpoint
+                               itemCallback:itemCallback
+                                 completion:completion];
+}
+
++ (id<OIDCancellableRequest>)performRevocationRequests:(NSArray<OIDRevocationRequest *> *)requests
+    maxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+                        itemCallback:(nullable OIDRevocationBatchItemCallback)itemCallback
+                          completion:(OIDRevocationBatchCallback)completion {
+  NSMutableArray<NSURL *> *endpoints = [NSMutableArray arrayWithCapacity:requests.count];
+  for (OIDRevocationRequest *request in requests) {
+    [endpoints addObject:request.revocationEndpoint];
+  }
+  OIDRequestBatchItemCallback batchItemCallback = nil;
+  if (itemCallback) {
+    batchItemCallback = ^(NSUInteger index, id _Nullable result, NSError *_Nullable error) {
+      itemCallback(index, error);
+    };
+  }
+  OIDRequestBatch *batch =
+      [[OIDRequestBatch alloc] initWithEndpoints:endpoints
+                maxConcurrentRequestsPerEndpoint:maxConcurrentRequestsPerEndpoint
+                                       operation:^id<OIDCancellableRequest>(
+                                           NSUInteger index,
+                                           OIDCancellableRequestCallback callback) {
+    return [self performRevocationRequest:requests[index] callback:^(NSError *_Nullable error) {
+      callback(nil, error);
+    }];
+  }
+                                    itemCallback:batchItemCallback
+                                      completion:^(NSArray *results, NSArray *errors) {
+    completion(errors);
+  }];
+  [batch start];
+  return batch;
+}
+
+#pragma mark - Introspection Endpoint
+
++ (id<OIDCancellableRequest>)performIntrospectionRequest:(OIDIntrospectionRequest *)request
+                                                callback:(OIDIntrospectionCallback)callback {
+  OIDCancellableRequestImplementation *cancellableRequest =
+      [[OIDCancellableRequestImplementation alloc]
+          initWithDeadline:nil
+                  callback:^(id _Nullable result, NSError *_Nullable error) {
+    callback(result, error);
+  }];
+  [[OIDTokenRequestScheduler sharedScheduler]
+      scheduleOperationForEndpoint:request.introspectionEndpoint
+                          priority:OIDTokenRequestPriorityForegroundRefresh
+                         operation:^(dispatch_block_t completion) {
+    NSURLSessionDataTask *task =
+        [self introspectionTaskWithRequest:request
+                                  callback:^(OIDIntrospectionResponse *_Nullable response,
+                                             NSError *_Nullable error) {
+      completion();
+      [cancellableRequest finishWithResult:response error:error];
+    }];
+    // a request cancelled while queued releases its slot without ever being sent
+    if (![cancellableRequest startTask:task]) {
+      completion();
+    }
+  }];
+  return cancellableRequest;
+}
+
+/*! @fn introspectionTaskWithRequest:callback:
+    @brief Creates a data task which sends an introspection request to the introspection endpoint
+        and parses the response, without resuming it.
+    @param request The introspection request.
+    @param callback The method called on the session's delegate queue when the request has
+        completed or failed.
+ */
++ (NSURLSessionDataTask *)introspectionTaskWithRequest:(OIDIntrospectionRequest *)request
+                                              callback:(OIDIntrospectionCallback)callback {
+  OIDMetricsTaskRecorder *recorder =
+      [self metricsRecorderWithType:OIDMetricsEventTypeIntrospection
+                                URL:request.introspectionEndpoint
+                          grantType:nil];
+  if (recorder) {
+    OIDIntrospectionCallback unrecordedCallback = callback;
+    callback = ^(OIDIntrospectionResponse *_Nullable response, NSError *_Nullable error) {
+      [recorder finishWithError:error];
+      unrecordedCallback(response, error);
+    };
+  }
+
+  NSURLSession *session = [self URLSessionForRecorder:recorder];
+  NSURLSessionDataTask *task =
+      [session dataTaskWithRequest:[request URLRequest]
+                 completionHandler:^(NSData *_Nullable data,
+                                     NSURLResponse *_Nullable response,
+                                     NSError *_Nullable error) {
+    if (error) {
+      callback(nil, [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
+                                     underlyingError:error
+                                         description:nil]);
+      return;
+    }
+
+    NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
+    if (HTTPURLResponse.statusCode != 200) {
+      NSError *serverError =
+          [OIDErrorUtilities HTTPErrorWithHTTPResponse:HTTPURLResponse data:data];
+      // a caller which failed to authenticate gets the token endpoint's error response format
+      // https://tools.ietf.org/html/rfc7662#section-2.3
+      if ((HTTPURLResponse.statusCode == 400 || HTTPURLResponse.statusCode == 401) && data) {
+        [recorder beginParsing];
+        NSDictionary<NSString *, NSObject<NSCopying> *> *json =
+            [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+        if ([json isKindOfClass:[NSDictionary class]] && json[OIDOAuthErrorFieldError]) {
+          callback(nil, [OIDErrorUtilities OAuthErrorWithDomain:OIDOAuthTokenErrorDomain
+                                                  OAuthResponse:json
+                                                underlyingError:serverError]);
+          return;
+        }
+      }
+      callback(nil, [OIDErrorUtilities errorWithCode:OIDErrorCodeServerError
+                                     underlyingError:serverError
+                                         description:nil]);
+      return;
+    }
+
+    [recorder beginParsing];
+    NSError *jsonDeserializationError;
+    NSDictionary<NSString *, NSObject<NSCopying> *> *json =
+        data ? [NSJSONSerialization JSONObjectWithData:data
+                                               options:0
+                                                 error:&jsonDeserializationError]
+             : nil;
+    // active is the only required member of an introspection response
+    if (![json isKindOfClass:[NSDictionary class]]
+        || ![json[@"active"] isKindOfClass:[NSNumber class]]) {
+      callback(nil, [OIDErrorUtilities errorWithCode:OIDErrorCodeJSONDeserializationError
+                                     underlyingError:jsonDeserializationError
+                                         description:@"Not an introspection response."]);
+      return;
+    }
+
+    OIDIntrospectionResponse *introspectionResponse =
+        [[OIDIntrospectionResponse alloc] initWithRequest:request parameters:json];
+    callback(introspectionResponse, nil);
+  }];
+  [recorder observeTask:task];
+  return task;
+}
+
+#pragma mark - UserInfo Endpoint
+
++ (id<OIDCancellableRequest>)performUserInfoRequest:(NSURLRequest *)URLRequest
+                                           callback:(OIDUserInfoResponseCallback)callback {
+  OIDCancellableRequestImplementation *cancellableRequest =
+      [[OIDCancellableRequestImplementation alloc]
+          initWithDeadline:nil
+                  callback:^(id _Nullable result, NSError *_Nullable error) {
+    // the result pairs the response with its body
+    NSArray *responseAndData = result;
+    NSData *data = responseAndData.lastObject;
+    callback(responseAndData.firstObject, data.length ? data : nil, error);
+  }];
+  OIDMetricsTaskRecorder *recorder = [self metricsRecorderWithType:OIDMetricsEventTypeUserInfo
+                                                               URL:URLRequest.URL
+                                                         grantType:nil];
+  NSURLSession *session = [self URLSessionForRecorder:recorder];
+  NSURLSessionDataTask *task =
+      [session dataTaskWithRequest:URLRequest
+                 completionHandler:^(NSData *_Nullable data,
+                                     NSURLResponse *_Nullable response,
+                                     NSError *_Nullable error) {
+    NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
+    if (error || !HTTPURLResponse) {
+      error = [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
+                               underlyingError:error
+                                   description:nil];
+      [recorder finishWithError:error];
+      [cancellableRequest finishWithResult:nil error:error];
+      return;
+    }
+    // a rejected or failed request is reported as such, though the caller judges the response
+    NSInteger statusCode = HTTPURLResponse.statusCode;
+    [recorder finishWithError:(statusCode == 200 || statusCode == 304)
+        ? nil
+        : [OIDErrorUtilities HTTPErrorWithHTTPResponse:HTTPURLResponse data:data]];
+    [cancellableRequest finishWithResult:@[ HTTPURLResponse, data ?: [NSData data] ] error:nil];
+  }];
+  [recorder observeTask:task];
+  [cancellableRequest startTask:task];
+  return cancellableRequest;
 }
 
 @end
@@ -0,0 +1,138 @@
+/*! @file OIDClockSkewEstimator.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDServiceConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDClockSkewEstimate
+    @brief How far a server's clock is ahead of the device's, and how precisely that is known.
+ */
+@interface OIDClockSkewEstimate : NSObject <NSCopying, NSSecureCoding>
+
+/*! @property skew
+    @brief The server's time minus the device's, in seconds.
+ */
+@property(nonatomic, readonly) NSTimeInterval skew;
+
+/*! @property uncertainty
+    @brief How far the actual skew may have been from @c skew when it was measured, in seconds.
+ */
+@property(nonatomic, readonly) NSTimeInterval uncertainty;
+
+/*! @property measurementDate
+    @brief When the skew was measured, by the device's clock.
+ */
+@property(nonatomic, readonly) NSDate *measurementDate;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithSkew:uncertainty:measurementDate:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithSkew:uncertainty:measurementDate:
+    @brief Designated initializer.
+    @param skew The server's time minus the device's, in seconds.
+    @param uncertainty How far the actual skew may be from @c skew, in seconds.
+    @param measurementDate When the skew was measured, by the device's clock.
+ */
+- (instancetype)initWithSkew:(NSTimeInterval)skew
+                 uncertainty:(NSTimeInterval)uncertainty
+             measurementDate:(NSDate *)measurementDate NS_DESIGNATED_INITIALIZER;
+
+/*! @fn uncertaintyAtDate:
+    @brief The uncertainty of the estimate at a later time, allowing for the clocks drifting apart.
+    @param date The time, by the device's clock.
+ */
+- (NSTimeInterval)uncertaintyAtDate:(NSDate *)date;
+
+@end
+
+/*! @class OIDClockSkewEstimator
+    @brief Estimates the skew between the device's clock and that of each issuer, from the times
+        servers report in HTTP @c Date headers.
+    @discussion Each report brackets the skew, as the server's time was read between the device
+        sending the request and receiving the response. Brackets are intersected with the previous
+        estimate while they agree, so the estimate gets more precise over time. One that doesn't
+        agree means a clock was changed, and replaces the estimate. A token's @c iat claim isn't
+        a report, as the token may have been issued long before the response was sent.
+ */
+@interface OIDClockSkewEstimator : NSObject
+
+/*! @fn sharedEstimator
+    @brief The estimator fed by @c OIDAuthorizationService's token requests.
+ */
++ (OIDClockSkewEstimator *)sharedEstimator;
+
+/*! @fn issuerForConfiguration:
+    @brief The issuer whose clock a configuration's endpoints share: the discovered issuer, or else
+        the token endpoint.
+ */
++ (NSURL *)issuerForConfiguration:(OIDServiceConfiguration *)configuration;
+
+/*! @fn dateFromHTTPDate:
+    @brief Parses the value of an HTTP @c Date header.
+    @return The date, or nil if the value isn't in the IMF-fixdate format.
+    @see https://tools.ietf.org/html/rfc7231#section-7.1.1.1
+ */
++ (nullable NSDate *)dateFromHTTPDate:(NSString *)HTTPDate;
+
+/*! @fn recordServerDate:resolution:requestDate:responseDate:forIssuer:
+    @brief Refines the estimate for an issuer with a time reported by its server.
+    @param serverDate The time reported by the server, truncated to @c resolution.
+    @param resolution The resolution of @c serverDate, in seconds.
+    @param requestDate When the request was sent, by the device's clock.
+    @param responseDate When the response was received, by the device's clock.
+    @param issuer The issuer.
+ */
+- (void)recordServerDate:(NSDate *)serverDate
+              resolution:(NSTimeInterval)resolution
+             requestDate:(NSDate *)requestDate
+            responseDate:(NSDate *)responseDate
+               forIssuer:(NSURL *)issuer;
+
+/*! @fn recordEstimate:forIssuer:
+    @brief Refines the estimate for an issuer with a previous estimate, such as a persisted one.
+    @param estimate The previous estimate.
+    @param issuer The issuer.
+ */
+- (void)recordEstimate:(OIDClockSkewEstimate *)estimate forIssuer:(NSURL *)issuer;
+
+/*! @fn estimateForIssuer:
+    @brief The current estimate for an issuer, if its clock was ever reported.
+    @param issuer The issuer.
+ */
+- (nullable OIDClockSkewEstimate *)estimateForIssuer:(NSURL *)issuer;
+
+/*! @fn skewForIssuer:
+    @brief The estimated skew of an issuer's clock, or 0 if it is unknown.
+    @param issuer The issuer.
+ */
+- (NSTimeInterval)skewForIssuer:(nullable NSURL *)issuer;
+
+/*! @fn removeAllEstimates
+    @brief Forgets every estimate.
+ */
+- (void)removeAllEstimates;
+
+@end
+
+NS_ASSUME_NONNULL_END
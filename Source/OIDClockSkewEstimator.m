@@ -0,0 +1,219 @@
+/*! @file OIDClockSkewEstimator.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDClockSkewEstimator.h"
+
+#import "OIDDefines.h"
+#import "OIDServiceConfiguration.h"
+#import "OIDServiceDiscovery.h"
+
+/*! @var kDriftRate
+    @brief How fast two clocks are assumed to drift apart, in seconds per second.
+ */
+static const double kDriftRate = 1e-4;
+
+/*! @var kSkewKey
+    @brief Key used to encode the @c skew property for @c NSSecureCoding.
+ */
+static NSString *const kSkewKey = @"skew";
+
+/*! @var kUncertaintyKey
+    @brief Key used to encode the @c uncertainty property for @c NSSecureCoding.
+ */
+static NSString *const kUncertaintyKey = @"uncertainty";
+
+/*! @var kMeasurementDateKey
+    @brief Key used to encode the @c measurementDate property for @c NSSecureCoding.
+ */
+static NSString *const kMeasurementDateKey = @"measurementDate";
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation OIDClockSkewEstimate
+
+- (nullable instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithSkew:uncertainty:measurementDate:));
+
+- (instancetype)initWithSkew:(NSTimeInterval)skew
+                 uncertainty:(NSTimeInterval)uncertainty
+             measurementDate:(NSDate *)measurementDate {
+  self = [super init];
+  if (self) {
+    _skew = skew;
+    _uncertainty = MAX(uncertainty, 0);
+    _measurementDate = [measurementDate copy];
+  }
+  return self;
+}
+
+- (NSTimeInterval)uncertaintyAtDate:(NSDate *)date {
+  NSTimeInterval age = fabs([date timeIntervalSinceDate:_measurementDate]);
+  return _uncertainty + age * kDriftRate;
+}
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(nullable NSZone *)zone {
+  // immutable
+  return self;
+}
+
+#pragma mark - NSSecureCoding
+
++ (BOOL)supportsSecureCoding {
+  return YES;
+}
+
+- (nullable instancetype)initWithCoder:(NSCoder *)aDecoder {
+  NSDate *measurementDate = [aDecoder decodeObjectOfClass:[NSDate class]
+                                                   forKey:kMeasurementDateKey];
+  if (!measurementDate) {
+    return nil;
+  }
+  return [self initWithSkew:[aDecoder decodeDoubleForKey:kSkewKey]
+                uncertainty:[aDecoder decodeDoubleForKey:kUncertaintyKey]
+            measurementDate:measurementDate];
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+  [aCoder encodeDouble:_skew forKey:kSkewKey];
+  [aCoder encodeDouble:_uncertainty forKey:kUncertaintyKey];
+  [aCoder encodeObject:_measurementDate forKey:kMeasurementDateKey];
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, skew: %.3f, uncertainty: %.3f, measurementDate: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _skew,
+                                    _uncertainty,
+                                    _measurementDate];
+}
+
+@end
+
+@implementation OIDClockSkewEstimator {
+  /*! @var _estimates
+      @brief The estimate for each issuer (use @c self to synchronize access).
+   */
+  NSMutableDictionary<NSURL *, OIDClockSkewEstimate *> *_estimates;
+}
+
++ (OIDClockSkewEstimator *)sharedEstimator {
+  static OIDClockSkewEstimator *estimator;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    estimator = [[OIDClockSkewEstimator alloc] init];
+  });
+  return estimator;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _estimates = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
++ (NSURL *)issuerForConfiguration:(OIDServiceConfiguration *)configuration {
+  return configuration.discoveryDocument.issuer ?: configuration.tokenEndpoint;
+}
+
++ (nullable NSDate *)dateFromHTTPDate:(NSString *)HTTPDate {
+  static NSDateFormatter *formatter;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneForSecondsFromGMT:0];
+    formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss 'GMT'";
+  });
+  @synchronized(formatter) {
+    return [formatter dateFromString:HTTPDate];
+  }
+}
+
+- (void)recordServerDate:(NSDate *)serverDate
+              resolution:(NSTimeInterval)resolution
+             requestDate:(NSDate *)requestDate
+            responseDate:(NSDate *)responseDate
+               forIssuer:(NSURL *)issuer {
+  // the server read its clock between the request and the response, and truncated the time
+  NSTimeInterval earliestSkew = [serverDate timeIntervalSinceDate:responseDate];
+  NSTimeInterval latestSkew = [serverDate timeIntervalSinceDate:requestDate] + resolution;
+  if (latestSkew < earliestSkew) {
+    return;
+  }
+  OIDClockSkewEstimate *estimate =
+      [[OIDClockSkewEstimate alloc] initWithSkew:(earliestSkew + latestSkew) / 2
+                                     uncertainty:(latestSkew - earliestSkew) / 2
+                                 measurementDate:responseDate];
+  [self recordEstimate:estimate forIssuer:issuer];
+}
+
+- (void)recordEstimate:(OIDClockSkewEstimate *)estimate forIssuer:(NSURL *)issuer {
+  @synchronized(self) {
+    OIDClockSkewEstimate *previous = _estimates[issuer];
+    if (!previous) {
+      _estimates[issuer] = estimate;
+      return;
+    }
+    // compares both estimates at the time of the later one
+    BOOL isLater =
+        [estimate.measurementDate compare:previous.measurementDate] != NSOrderedAscending;
+    NSDate *date = isLater ? estimate.measurementDate : previous.measurementDate;
+    NSTimeInterval previousUncertainty = [previous uncertaintyAtDate:date];
+    NSTimeInterval uncertainty = [estimate uncertaintyAtDate:date];
+    NSTimeInterval lower = MAX(previous.skew - previousUncertainty, estimate.skew - uncertainty);
+    NSTimeInterval upper = MIN(previous.skew + previousUncertainty, estimate.skew + uncertainty);
+    if (lower <= upper) {
+      _estimates[issuer] = [[OIDClockSkewEstimate alloc] initWithSkew:(lower + upper) / 2
+                                                         uncertainty:(upper - lower) / 2
+                                                     measurementDate:date];
+    } else if (isLater) {
+      // the estimates disagree, so a clock was changed since the earlier one
+      _estimates[issuer] = estimate;
+    }
+  }
+}
+
+- (nullable OIDClockSkewEstimate *)estimateForIssuer:(NSURL *)issuer {
+  @synchronized(self) {
+    return _estimates[issuer];
+  }
+}
+
+- (NSTimeInterval)skewForIssuer:(nullable NSURL *)issuer {
+  if (!issuer) {
+    return 0;
+  }
+  return [self estimateForIssuer:issuer].skew;
+}
+
+- (void)removeAllEstimates {
+  @synchronized(self) {
+    [_estimates removeAllObjects];
+  }
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
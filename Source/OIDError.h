@@ -121,6 +121,39 @@ typedef NS_ENUM(NSInteger, OIDErrorCode) {
           request in mobile Safari.
    */
   OIDErrorCodeSafariOpenError = -9,
+
+  /*! @brief Indicates a request was cancelled by calling @c OIDCancellableRequest.cancel before it
+          completed.
+   */
+  OIDErrorCodeRequestCanceled = -10,
+
+  /*! @brief Indicates a request did not complete before the deadline it was given.
+   */
+  OIDErrorCodeTimeout = -11,
+
+  /*! @brief Indicates an ID Token's signature or claims failed verification, or the key it was
+          signed with couldn't be found.
+   */
+  OIDErrorCodeIDTokenVerificationError = -12,
+
+  /*! @brief Indicates the provider has no userinfo endpoint, or returned claims about a different
+          user than the one the tokens were issued for.
+   */
+  OIDErrorCodeUserInfoError = -13,
+
+  /*! @brief Indicates requests couldn't be queued to be authorized, as too many were already
+          waiting for fresh tokens.
+   */
+  OIDErrorCodeRequestQueueFull = -14,
+
+  /*! @brief Indicates the file of an @c OIDSharedTokenStore couldn't be opened, mapped or locked.
+   */
+  OIDErrorCodeSharedTokenStoreError = -15,
+
+  /*! @brief Indicates an archive couldn't be restored as an @c OIDAuthState by
+          @c OIDAuthState.restoreAuthStatesFromArchives:completion:.
+   */
+  OIDErrorCodeArchiveError = -16,
 };
 
 /*! @brief Enum of all possible OAuth error codes as defined by RFC6749
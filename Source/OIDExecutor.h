@@ -0,0 +1,49 @@
+/*! @file OIDExecutor.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @protocol OIDExecutor
+    @brief Runs the blocks which @c OIDAuthState and @c OIDAuthorizationService would otherwise
+        dispatch to the main queue, including their callbacks.
+    @discussion Set with @c OIDAuthorizationService.setExecutor:. Together with a clock set with
+        @c OIDMonotonicClock.setClock:, an executor which runs its blocks in order of virtual time
+        makes the library deterministic, such as to simulate the token refreshes of many sessions.
+ */
+@protocol OIDExecutor <NSObject>
+
+/*! @fn performBlock:
+    @brief Runs a block asynchronously, after the blocks already submitted.
+    @param block The block.
+    @discussion May be called on any thread. Blocks must run one at a time, in submission order.
+ */
+- (void)performBlock:(dispatch_block_t)block;
+
+/*! @fn performBlock:afterDelay:
+    @brief Runs a block asynchronously, once a delay has passed.
+    @param block The block.
+    @param delay The delay in seconds. Negative delays are treated as zero.
+    @discussion May be called on any thread. Blocks must run one at a time.
+ */
+- (void)performBlock:(dispatch_block_t)block afterDelay:(NSTimeInterval)delay;
+
+@end
+
+NS_ASSUME_NONNULL_END
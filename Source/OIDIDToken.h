@@ -0,0 +1,139 @@
+/*! @file OIDIDToken.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDIDToken
+    @brief A parsed OpenID Connect ID Token.
+    @discussion The header and claims are decoded once, when the token is created, and the standard
+        claims are available as typed properties. The token's signature is not verified.
+    @see http://openid.net/specs/openid-connect-core-1_0.html#IDToken
+    @see https://tools.ietf.org/html/rfc7519
+ */
+@interface OIDIDToken : NSObject
+
+/*! @property tokenString
+    @brief The compact serialization of the token.
+ */
+@property(nonatomic, readonly) NSString *tokenString;
+
+/*! @property headerRange
+    @brief The range of the base64url encoded header in @c tokenString.
+ */
+@property(nonatomic, readonly) NSRange headerRange;
+
+/*! @property claimsRange
+    @brief The range of the base64url encoded claims in @c tokenString.
+ */
+@property(nonatomic, readonly) NSRange claimsRange;
+
+/*! @property signatureRange
+    @brief The range of the base64url encoded signature in @c tokenString.
+ */
+@property(nonatomic, readonly) NSRange signatureRange;
+
+/*! @property header
+    @brief The decoded JOSE header.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, id> *header;
+
+/*! @property claims
+    @brief The decoded claims, including any which don't have a typed property.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, id> *claims;
+
+/*! @property algorithm
+    @brief The algorithm the token was signed with, such as @c "RS256".
+    @remarks alg
+ */
+@property(nonatomic, readonly, nullable) NSString *algorithm;
+
+/*! @property keyID
+    @brief The ID of the key the token was signed with.
+    @remarks kid
+ */
+@property(nonatomic, readonly, nullable) NSString *keyID;
+
+/*! @property issuer
+    @brief The issuer of the token.
+    @remarks iss
+ */
+@property(nonatomic, readonly, nullable) NSURL *issuer;
+
+/*! @property subject
+    @brief The identifier of the end-user.
+    @remarks sub
+ */
+@property(nonatomic, readonly, nullable) NSString *subject;
+
+/*! @property audience
+    @brief The audiences the token is intended for. A single audience is returned as an array of
+        one.
+    @remarks aud
+ */
+@property(nonatomic, readonly, nullable) NSArray<NSString *> *audience;
+
+/*! @property expiresAt
+    @brief The time after which the token must not be accepted.
+    @remarks exp
+ */
+@property(nonatomic, readonly, nullable) NSDate *expiresAt;
+
+/*! @property issuedAt
+    @brief The time at which the token was issued.
+    @remarks iat
+ */
+@property(nonatomic, readonly, nullable) NSDate *issuedAt;
+
+/*! @property authTime
+    @brief The time at which the end-user authenticated.
+    @remarks auth_time
+ */
+@property(nonatomic, readonly, nullable) NSDate *authTime;
+
+/*! @property nonce
+    @brief The nonce of the authentication request.
+    @remarks nonce
+ */
+@property(nonatomic, readonly, nullable) NSString *nonce;
+
+/*! @property authorizedParty
+    @brief The client the token was issued to.
+    @remarks azp
+ */
+@property(nonatomic, readonly, nullable) NSString *authorizedParty;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithTokenString:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithTokenString:
+    @brief Parses an ID Token.
+    @param tokenString The compact serialization of a signed JWT.
+    @return The token, or nil if @c tokenString isn't a JWS with a JSON object for its header and
+        claims.
+ */
+- (nullable instancetype)initWithTokenString:(NSString *)tokenString NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
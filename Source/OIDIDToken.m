@@ -0,0 +1,146 @@
+/*! @file OIDIDToken.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDIDToken.h"
+
+#import "OIDDefines.h"
+#import "OIDTokenUtilities.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @fn OIDStringValue
+    @brief Returns @c value if it's a string, otherwise nil.
+ */
+static NSString *_Nullable OIDStringValue(id _Nullable value) {
+  return [value isKindOfClass:[NSString class]] ? value : nil;
+}
+
+/*! @fn OIDDateValue
+    @brief Returns the date of a JWT NumericDate, or nil if @c value isn't a number.
+ */
+static NSDate *_Nullable OIDDateValue(id _Nullable value) {
+  if (![value isKindOfClass:[NSNumber class]]) {
+    return nil;
+  }
+  return [NSDate dateWithTimeIntervalSince1970:[value doubleValue]];
+}
+
+@implementation OIDIDToken
+
+- (nullable instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithTokenString:));
+
+- (nullable instancetype)initWithTokenString:(NSString *)tokenString {
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+
+  // a JWS has exactly three segments; a JWE has five, and isn't supported
+  NSUInteger length = tokenString.length;
+  NSRange firstDot = [tokenString rangeOfString:@"."];
+  if (firstDot.location == NSNotFound) {
+    return nil;
+  }
+  NSRange secondDot = [tokenString rangeOfString:@"."
+                                         options:NSLiteralSearch
+                                           range:NSMakeRange(NSMaxRange(firstDot),
+                                                             length - NSMaxRange(firstDot))];
+  if (secondDot.location == NSNotFound) {
+    return nil;
+  }
+  NSRange signatureRange = NSMakeRange(NSMaxRange(secondDot), length - NSMaxRange(secondDot));
+  if ([tokenString rangeOfString:@"." options:NSLiteralSearch range:signatureRange].location
+      != NSNotFound) {
+    return nil;
+  }
+
+  _tokenString = [tokenString copy];
+  _headerRange = NSMakeRange(0, firstDot.location);
+  _claimsRange = NSMakeRange(NSMaxRange(firstDot), secondDot.location - NSMaxRange(firstDot));
+  _signatureRange = signatureRange;
+
+  NSDictionary<NSString *, id> *header = [self JSONObjectInRange:_headerRange];
+  NSDictionary<NSString *, id> *claims = [self JSONObjectInRange:_claimsRange];
+  if (!header || !claims) {
+    return nil;
+  }
+  _header = header;
+  _claims = claims;
+
+  _algorithm = OIDStringValue(header[@"alg"]);
+  _keyID = OIDStringValue(header[@"kid"]);
+
+  NSString *issuer = OIDStringValue(claims[@"iss"]);
+  _issuer = issuer ? [NSURL URLWithString:issuer] : nil;
+  _subject = OIDStringValue(claims[@"sub"]);
+  _audience = [[self class] audienceWithClaim:claims[@"aud"]];
+  _expiresAt = OIDDateValue(claims[@"exp"]);
+  _issuedAt = OIDDateValue(claims[@"iat"]);
+  _authTime = OIDDateValue(claims[@"auth_time"]);
+  _nonce = OIDStringValue(claims[@"nonce"]);
+  _authorizedParty = OIDStringValue(claims[@"azp"]);
+  return self;
+}
+
+/*! @fn JSONObjectInRange:
+    @brief Decodes a base64url encoded JSON object from a segment of the token.
+    @param range The range of the segment in @c tokenString.
+    @return The object, or nil if the segment isn't a base64url encoded JSON object.
+ */
+- (nullable NSDictionary<NSString *, id> *)JSONObjectInRange:(NSRange)range {
+  NSData *data =
+      [OIDTokenUtilities decodeBase64urlNoPadding:[_tokenString substringWithRange:range]];
+  if (!data) {
+    return nil;
+  }
+  id object = [NSJSONSerialization JSONObjectWithData:data options:0 error:NULL];
+  return [object isKindOfClass:[NSDictionary class]] ? object : nil;
+}
+
+/*! @fn audienceWithClaim:
+    @brief Normalizes the @c aud claim, which may be a string or an array of strings.
+ */
++ (nullable NSArray<NSString *> *)audienceWithClaim:(id _Nullable)claim {
+  if ([claim isKindOfClass:[NSString class]]) {
+    return @[ claim ];
+  }
+  if (![claim isKindOfClass:[NSArray class]]) {
+    return nil;
+  }
+  NSMutableArray<NSString *> *audience = [NSMutableArray array];
+  for (id value in claim) {
+    if ([value isKindOfClass:[NSString class]]) {
+      [audience addObject:value];
+    }
+  }
+  return audience;
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, header: %@, claims: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _header,
+                                    _claims];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,112 @@
+/*! @file OIDIDTokenVerifier.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDIDToken;
+@class OIDJSONWebKeySetCache;
+@class OIDServiceConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @typedef OIDIDTokenVerificationCallback
+    @brief The method called when an ID Token has been verified.
+    @param valid Whether the token's claims and signature are valid.
+    @param error The reason the token is invalid, if it is.
+ */
+typedef void (^OIDIDTokenVerificationCallback)(BOOL valid, NSError *_Nullable error);
+
+/*! @class OIDIDTokenVerifier
+    @brief Verifies ID Tokens locally, against the provider's cached JSON Web Key Set.
+    @discussion Checks the issuer, audience, authorized party, expiry, issue time and nonce as
+        described in OpenID Connect Core section 3.1.3.7, and the @c RS256 or @c ES256 signature.
+        Tokens with other algorithms, including @c none, are rejected.
+    @see http://openid.net/specs/openid-connect-core-1_0.html#IDTokenValidation
+ */
+@interface OIDIDTokenVerifier : NSObject
+
+/*! @property issuer
+    @brief The issuer which tokens must be from.
+ */
+@property(nonatomic, readonly) NSURL *issuer;
+
+/*! @property clientID
+    @brief The client which tokens must be intended for.
+ */
+@property(nonatomic, readonly) NSString *clientID;
+
+/*! @property keySetCache
+    @brief The provider's key set.
+ */
+@property(nonatomic, readonly) OIDJSONWebKeySetCache *keySetCache;
+
+/*! @property allowedClockSkew
+    @brief How far the device's clock may differ from the provider's when checking @c exp and
+        @c iat, beyond the skew estimated by @c OIDClockSkewEstimator. Defaults to 60 seconds.
+ */
+@property(atomic) NSTimeInterval allowedClockSkew;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithIssuer:clientID:keySetCache:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithIssuer:clientID:keySetCache:
+    @brief Designated initializer.
+    @param issuer The issuer which tokens must be from.
+    @param clientID The client which tokens must be intended for.
+    @param keySetCache The provider's key set.
+ */
+- (instancetype)initWithIssuer:(NSURL *)issuer
+                      clientID:(NSString *)clientID
+                   keySetCache:(OIDJSONWebKeySetCache *)keySetCache NS_DESIGNATED_INITIALIZER;
+
+/*! @fn initWithConfiguration:clientID:
+    @brief Creates a verifier using the shared key set cache of a discovered provider.
+    @param configuration A configuration with a discovery document.
+    @param clientID The client which tokens must be intended for.
+    @return The verifier, or nil if @c configuration has no discovery document.
+ */
+- (nullable instancetype)initWithConfiguration:(OIDServiceConfiguration *)configuration
+                                      clientID:(NSString *)clientID;
+
+/*! @fn verifyClaimsOfIDToken:nonce:error:
+    @brief Verifies the claims of a token, without its signature.
+    @param idToken The token.
+    @param nonce The nonce of the authorization request, if it had one.
+    @param error Set to an @c OIDErrorCodeIDTokenVerificationError if a claim is invalid.
+    @return YES if the claims are valid.
+ */
+- (BOOL)verifyClaimsOfIDToken:(OIDIDToken *)idToken
+                        nonce:(nullable NSString *)nonce
+                        error:(NSError **_Nullable)error;
+
+/*! @fn verifyIDToken:nonce:callback:
+    @brief Verifies the claims and signature of a token, fetching the key set if needed.
+    @param idToken The token.
+    @param nonce The nonce of the authorization request, if it had one.
+    @param callback The method called on the main queue with the result.
+ */
+- (void)verifyIDToken:(OIDIDToken *)idToken
+                nonce:(nullable NSString *)nonce
+             callback:(OIDIDTokenVerificationCallback)callback;
+
+@end
+
+NS_ASSUME_NONNULL_END
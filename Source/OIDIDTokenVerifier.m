@@ -0,0 +1,159 @@
+/*! @file OIDIDTokenVerifier.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDIDTokenVerifier.h"
+
+#import "OIDAuthorizationService.h"
+#import "OIDClockSkewEstimator.h"
+#import "OIDDefines.h"
+#import "OIDError.h"
+#import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
+#import "OIDIDToken.h"
+#import "OIDJSONWebKey.h"
+#import "OIDJSONWebKeySetCache.h"
+#import "OIDMonotonicClock.h"
+#import "OIDServiceConfiguration.h"
+#import "OIDServiceDiscovery.h"
+#import "OIDTokenUtilities.h"
+
+/*! @var kDefaultAllowedClockSkew
+    @brief The default of @c OIDIDTokenVerifier.allowedClockSkew.
+ */
+static const NSTimeInterval kDefaultAllowedClockSkew = 60;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation OIDIDTokenVerifier
+
+- (nullable instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithIssuer:clientID:keySetCache:));
+
+- (instancetype)initWithIssuer:(NSURL *)issuer
+                      clientID:(NSString *)clientID
+                   keySetCache:(OIDJSONWebKeySetCache *)keySetCache {
+  self = [super init];
+  if (self) {
+    _issuer = [issuer copy];
+    _clientID = [clientID copy];
+    _keySetCache = keySetCache;
+    _allowedClockSkew = kDefaultAllowedClockSkew;
+  }
+  return self;
+}
+
+- (nullable instancetype)initWithConfiguration:(OIDServiceConfiguration *)configuration
+                                      clientID:(NSString *)clientID {
+  OIDServiceDiscovery *discoveryDocument = configuration.discoveryDocument;
+  if (!discoveryDocument) {
+    return nil;
+  }
+  return [self initWithIssuer:discoveryDocument.issuer
+                     clientID:clientID
+                  keySetCache:[OIDJSONWebKeySetCache cacheForJWKSURL:discoveryDocument.jwksURL]];
+}
+
+- (BOOL)verifyClaimsOfIDToken:(OIDIDToken *)idToken
+                        nonce:(nullable NSString *)nonce
+                        error:(NSError **_Nullable)error {
+  NSString *failure = nil;
+  NSTimeInterval allowedClockSkew = self.allowedClockSkew;
+  // compares the claims with the issuer's clock, as far as it is known
+  NSTimeInterval skew = [[OIDClockSkewEstimator sharedEstimator] skewForIssuer:_issuer];
+  NSDate *now = [OIDMonotonicClock date];
+  if (![idToken.issuer.absoluteString isEqualToString:_issuer.absoluteString]) {
+    failure = @"Issuer doesn't match.";
+  } else if (![idToken.audience containsObject:_clientID]) {
+    failure = @"Audience doesn't include the client.";
+  } else if (idToken.audience.count > 1 && idToken.authorizedParty
+             && ![idToken.authorizedParty isEqualToString:_clientID]) {
+    failure = @"Authorized party isn't the client.";
+  } else if (!idToken.expiresAt
+             || [idToken.expiresAt timeIntervalSinceDate:now] - skew < -allowedClockSkew) {
+    failure = @"Token has expired.";
+  } else if (!idToken.issuedAt
+             || [idToken.issuedAt timeIntervalSinceDate:now] - skew > allowedClockSkew) {
+    failure = @"Token was issued in the future.";
+  } else if (nonce && ![idToken.nonce isEqualToString:nonce]) {
+    failure = @"Nonce doesn't match.";
+  }
+  if (failure && error) {
+    *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeIDTokenVerificationError
+                              underlyingError:nil
+                                  description:failure];
+  }
+  return !failure;
+}
+
+- (void)verifyIDToken:(OIDIDToken *)idToken
+                nonce:(nullable NSString *)nonce
+             callback:(OIDIDTokenVerificationCallback)callback {
+  NSError *claimsError;
+  if (![self verifyClaimsOfIDToken:idToken nonce:nonce error:&claimsError]) {
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(NO, claimsError);
+    }];
+    return;
+  }
+
+  NSString *algorithm = idToken.algorithm;
+  if (![algorithm isEqualToString:OIDJSONWebAlgorithmRS256]
+      && ![algorithm isEqualToString:OIDJSONWebAlgorithmES256]) {
+    NSError *error =
+        [OIDErrorUtilities errorWithCode:OIDErrorCodeIDTokenVerificationError
+                         underlyingError:nil
+                             description:[NSString stringWithFormat:@"Unsupported algorithm %@.",
+                                                                    algorithm]];
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(NO, error);
+    }];
+    return;
+  }
+
+  // the signature covers the encoded header and claims as they appear in the token
+  NSString *tokenString = idToken.tokenString;
+  NSData *signingInput =
+      [[tokenString substringToIndex:NSMaxRange(idToken.claimsRange)]
+          dataUsingEncoding:NSASCIIStringEncoding];
+  NSData *signature = [OIDTokenUtilities decodeBase64urlNoPadding:
+                          [tokenString substringWithRange:idToken.signatureRange]];
+  [_keySetCache keyWithID:idToken.keyID
+                algorithm:algorithm
+                 callback:^(OIDJSONWebKey *_Nullable key, NSError *_Nullable keyError) {
+    if (!key) {
+      callback(NO, keyError);
+      return;
+    }
+    NSError *signatureError;
+    BOOL valid = signature && signingInput
+        && [key verifySignature:signature
+                   signingInput:signingInput
+                      algorithm:algorithm
+                          error:&signatureError];
+    if (!valid && !signatureError) {
+      signatureError = [OIDErrorUtilities errorWithCode:OIDErrorCodeIDTokenVerificationError
+                                        underlyingError:nil
+                                            description:@"Signature isn't valid base64url."];
+    }
+    callback(valid, valid ? nil : signatureError);
+  }];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,99 @@
+/*! @file OIDIntrospectionCache.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "OIDAuthorizationService.h"
+
+@class OIDIntrospectionRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDIntrospectionCache
+    @brief Caches the results of token introspection, for resource servers which check every
+        incoming token.
+    @discussion Results are kept for at most @c timeToLive, and never past the token's @c exp, so a
+        revoked token is reported as active for no longer than that. Inactive results are kept
+        for the shorter @c negativeTimeToLive, so a flood of bad tokens doesn't reach the server
+        while a token which only just became valid is soon seen. Failed requests aren't cached.
+
+        Concurrent lookups of the same token share a single request. Once @c capacity results
+        are cached, the least recently used one is evicted. Results are keyed by a SHA-256 hash of
+        the endpoint, client and token, so the cache holds no tokens.
+ */
+@interface OIDIntrospectionCache : NSObject
+
+/*! @property capacity
+    @brief The maximum number of cached results.
+ */
+@property(nonatomic, readonly) NSUInteger capacity;
+
+/*! @property timeToLive
+    @brief The maximum time an active result is cached for.
+ */
+@property(nonatomic, readonly) NSTimeInterval timeToLive;
+
+/*! @property negativeTimeToLive
+    @brief The time an inactive result is cached for.
+ */
+@property(nonatomic, readonly) NSTimeInterval negativeTimeToLive;
+
+/*! @property count
+    @brief The number of cached results, including expired ones not yet evicted.
+ */
+@property(atomic, readonly) NSUInteger count;
+
+/*! @fn init
+    @brief Creates a cache of 1000 results, caching active results for 5 minutes and inactive
+        ones for 10 seconds.
+ */
+- (instancetype)init;
+
+/*! @fn initWithCapacity:timeToLive:negativeTimeToLive:
+    @brief Designated initializer.
+    @param capacity The maximum number of cached results.
+    @param timeToLive The maximum time an active result is cached for.
+    @param negativeTimeToLive The time an inactive result is cached for.
+ */
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                      timeToLive:(NSTimeInterval)timeToLive
+              negativeTimeToLive:(NSTimeInterval)negativeTimeToLive NS_DESIGNATED_INITIALIZER;
+
+/*! @fn performIntrospectionRequest:callback:
+    @brief Returns the cached result of an introspection request, or performs it.
+    @param request The introspection request.
+    @param callback The method called on the main queue with the result.
+    @see OIDAuthorizationService.performIntrospectionRequest:callback:
+ */
+- (void)performIntrospectionRequest:(OIDIntrospectionRequest *)request
+                           callback:(OIDIntrospectionCallback)callback;
+
+/*! @fn removeResultForRequest:
+    @brief Discards the cached result of a request, such as after revoking its token.
+    @param request The introspection request.
+ */
+- (void)removeResultForRequest:(OIDIntrospectionRequest *)request;
+
+/*! @fn removeAllResults
+    @brief Discards every cached result.
+ */
+- (void)removeAllResults;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,302 @@
+/*! @file OIDIntrospectionCache.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDIntrospectionCache.h"
+
+#import "OIDAuthorizationService.h"
+#import "OIDExecutor.h"
+#import "OIDIntrospectionRequest.h"
+#import "OIDIntrospectionResponse.h"
+#import "OIDMonotonicClock.h"
+#import "OIDTokenUtilities.h"
+
+/*! @var kDefaultCapacity
+    @brief The default of @c OIDIntrospectionCache.capacity.
+ */
+static const NSUInteger kDefaultCapacity = 1000;
+
+/*! @var kDefaultTimeToLive
+    @brief The default of @c OIDIntrospectionCache.timeToLive.
+ */
+static const NSTimeInterval kDefaultTimeToLive = 5 * 60;
+
+/*! @var kDefaultNegativeTimeToLive
+    @brief The default of @c OIDIntrospectionCache.negativeTimeToLive.
+ */
+static const NSTimeInterval kDefaultNegativeTimeToLive = 10;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDIntrospectionCacheEntry
+    @brief A cached result, linked into the cache's recency list.
+ */
+@interface OIDIntrospectionCacheEntry : NSObject
+
+/*! @property key
+    @brief The key of the entry in the cache.
+ */
+@property(nonatomic, strong) NSData *key;
+
+/*! @property response
+    @brief The cached response.
+ */
+@property(nonatomic, strong) OIDIntrospectionResponse *response;
+
+/*! @property deadline
+    @brief When the entry expires.
+ */
+@property(nonatomic) OIDMonotonicTime deadline;
+
+/*! @property previous
+    @brief The more recently used entry, or nil if this is the most recently used.
+ */
+@property(nonatomic, weak, nullable) OIDIntrospectionCacheEntry *previous;
+
+/*! @property next
+    @brief The less recently used entry, or nil if this is the least recently used.
+ */
+@property(nonatomic, strong, nullable) OIDIntrospectionCacheEntry *next;
+
+@end
+
+@implementation OIDIntrospectionCacheEntry
+@end
+
+@implementation OIDIntrospectionCache {
+  /*! @var _entries
+      @brief The cached entries by key. Access is synchronized on @c self.
+   */
+  NSMutableDictionary<NSData *, OIDIntrospectionCacheEntry *> *_entries;
+
+  /*! @var _mostRecentlyUsed
+      @brief The head of the recency list. Access is synchronized on @c self.
+   */
+  OIDIntrospectionCacheEntry *_Nullable _mostRecentlyUsed;
+
+  /*! @var _leastRecentlyUsed
+      @brief The tail of the recency list, which is evicted first. Access is synchronized on
+          @c self.
+   */
+  OIDIntrospectionCacheEntry *_Nullable _leastRecentlyUsed;
+
+  /*! @var _pendingCallbacks
+      @brief The callbacks waiting for each request in flight, by key. Access is synchronized on
+          @c self.
+   */
+  NSMutableDictionary<NSData *, NSMutableArray<OIDIntrospectionCallback> *> *_pendingCallbacks;
+}
+
+- (instancetype)init {
+  return [self initWithCapacity:kDefaultCapacity
+                     timeToLive:kDefaultTimeToLive
+             negativeTimeToLive:kDefaultNegativeTimeToLive];
+}
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity
+                      timeToLive:(NSTimeInterval)timeToLive
+              negativeTimeToLive:(NSTimeInterval)negativeTimeToLive {
+  self = [super init];
+  if (self) {
+    _capacity = capacity;
+    _timeToLive = timeToLive;
+    _negativeTimeToLive = negativeTimeToLive;
+    _entries = [NSMutableDictionary dictionary];
+    _pendingCallbacks = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (NSUInteger)count {
+  @synchronized(self) {
+    return _entries.count;
+  }
+}
+
+/*! @fn keyForRequest:
+    @brief Returns the cache key of a request.
+    @discussion The client is part of the key, as the server may answer differently depending on
+        who asks.
+ */
++ (NSData *)keyForRequest:(OIDIntrospectionRequest *)request {
+  NSString *input = [NSString stringWithFormat:@"%@ %@ %@",
+                                               request.introspectionEndpoint.absoluteString,
+                                               request.clientID,
+                                               request.token];
+  return [OIDTokenUtilities sha265:input];
+}
+
+- (void)performIntrospectionRequest:(OIDIntrospectionRequest *)request
+                           callback:(OIDIntrospectionCallback)callback {
+  NSData *key = [[self class] keyForRequest:request];
+  OIDIntrospectionResponse *cachedResponse = nil;
+  BOOL startsRequest = NO;
+  @synchronized(self) {
+    OIDIntrospectionCacheEntry *entry = _entries[key];
+    if (entry && [OIDMonotonicClock now] < entry.deadline) {
+      [self unlinkEntry:entry];
+      [self linkEntry:entry];
+      cachedResponse = entry.response;
+    } else {
+      if (entry) {
+        [self removeEntry:entry];
+      }
+      NSMutableArray<OIDIntrospectionCallback> *callbacks = _pendingCallbacks[key];
+      if (callbacks) {
+        [callbacks addObject:callback];
+      } else {
+        _pendingCallbacks[key] = [NSMutableArray arrayWithObject:callback];
+        startsRequest = YES;
+      }
+    }
+  }
+
+  if (cachedResponse) {
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(cachedResponse, nil);
+    }];
+    return;
+  }
+  if (!startsRequest) {
+    return;
+  }
+  [OIDAuthorizationService
+      performIntrospectionRequest:request
+                         callback:^(OIDIntrospectionResponse *_Nullable response,
+                                    NSError *_Nullable error) {
+    NSArray<OIDIntrospectionCallback> *callbacks;
+    @synchronized(self) {
+      if (response) {
+        [self storeResponse:response forKey:key];
+      }
+      callbacks = self->_pendingCallbacks[key];
+      [self->_pendingCallbacks removeObjectForKey:key];
+    }
+    [[OIDAuthorizationService executor] performBlock:^() {
+      for (OIDIntrospectionCallback pendingCallback in callbacks) {
+        pendingCallback(response, error);
+      }
+    }];
+  }];
+}
+
+- (void)removeResultForRequest:(OIDIntrospectionRequest *)request {
+  NSData *key = [[self class] keyForRequest:request];
+  @synchronized(self) {
+    OIDIntrospectionCacheEntry *entry = _entries[key];
+    if (entry) {
+      [self removeEntry:entry];
+    }
+  }
+}
+
+- (void)removeAllResults {
+  @synchronized(self) {
+    [_entries removeAllObjects];
+    _mostRecentlyUsed = nil;
+    _leastRecentlyUsed = nil;
+  }
+}
+
+#pragma mark - Recency list
+
+/*! @fn storeResponse:forKey:
+    @brief Caches a response as the most recently used, evicting the least recently used entry if
+        the cache is full. Must be called synchronized on @c self.
+    @discussion Responses whose token has already expired aren't cached.
+ */
+- (void)storeResponse:(OIDIntrospectionResponse *)response forKey:(NSData *)key {
+  NSTimeInterval lifetime = response.active ? _timeToLive : _negativeTimeToLive;
+  if (response.active && response.expiresAt) {
+    lifetime = MIN(lifetime, [response.expiresAt timeIntervalSinceDate:[OIDMonotonicClock date]]);
+  }
+  if (lifetime <= 0 || _capacity == 0) {
+    return;
+  }
+
+  OIDIntrospectionCacheEntry *entry = _entries[key];
+  if (entry) {
+    [self unlinkEntry:entry];
+  } else {
+    entry = [[OIDIntrospectionCacheEntry alloc] init];
+    entry.key = key;
+    _entries[key] = entry;
+  }
+  entry.response = response;
+  entry.deadline = [OIDMonotonicClock timeAfterInterval:lifetime];
+  [self linkEntry:entry];
+
+  while (_entries.count > _capacity) {
+    [self removeEntry:_leastRecentlyUsed];
+  }
+}
+
+/*! @fn removeEntry:
+    @brief Removes an entry from the cache. Must be called synchronized on @c self.
+ */
+- (void)removeEntry:(OIDIntrospectionCacheEntry *)entry {
+  [self unlinkEntry:entry];
+  [_entries removeObjectForKey:entry.key];
+}
+
+/*! @fn linkEntry:
+    @brief Inserts an entry at the head of the recency list. Must be called synchronized on
+        @c self.
+ */
+- (void)linkEntry:(OIDIntrospectionCacheEntry *)entry {
+  entry.previous = nil;
+  entry.next = _mostRecentlyUsed;
+  _mostRecentlyUsed.previous = entry;
+  _mostRecentlyUsed = entry;
+  if (!_leastRecentlyUsed) {
+    _leastRecentlyUsed = entry;
+  }
+}
+
+/*! @fn unlinkEntry:
+    @brief Removes an entry from the recency list. Must be called synchronized on @c self.
+ */
+- (void)unlinkEntry:(OIDIntrospectionCacheEntry *)entry {
+  OIDIntrospectionCacheEntry *previous = entry.previous;
+  OIDIntrospectionCacheEntry *next = entry.next;
+  if (previous) {
+    previous.next = next;
+  } else {
+    _mostRecentlyUsed = next;
+  }
+  if (next) {
+    next.previous = previous;
+  } else {
+    _leastRecentlyUsed = previous;
+  }
+  entry.previous = nil;
+  entry.next = nil;
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, capacity: %lu, count: %lu>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    (unsigned long)_capacity,
+                                    (unsigned long)self.count];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
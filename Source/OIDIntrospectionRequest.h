@@ -0,0 +1,110 @@
+/*! @file OIDIntrospectionRequest.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDServiceConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDIntrospectionRequest
+    @brief Represents a token introspection request, made by a resource server to check a token it
+        received.
+    @see https://tools.ietf.org/html/rfc7662
+ */
+@interface OIDIntrospectionRequest : NSObject <NSCopying, NSSecureCoding>
+
+/*! @property introspectionEndpoint
+    @brief The introspection endpoint URI.
+ */
+@property(nonatomic, readonly) NSURL *introspectionEndpoint;
+
+/*! @property token
+    @brief The token to introspect.
+    @remarks token
+ */
+@property(nonatomic, readonly) NSString *token;
+
+/*! @property tokenTypeHint
+    @brief The type of @c token, which may help the server find it.
+    @remarks token_type_hint
+    @see OIDTokenTypeHintAccessToken
+    @see OIDTokenTypeHintRefreshToken
+ */
+@property(nonatomic, readonly, nullable) NSString *tokenTypeHint;
+
+/*! @property clientID
+    @brief The identifier of the resource server or client making the request.
+    @remarks client_id
+ */
+@property(nonatomic, readonly) NSString *clientID;
+
+/*! @property additionalParameters
+    @brief The client's additional introspection request parameters.
+    @discussion Introspection endpoints require the caller to authenticate, which servers commonly
+        accept as form parameters such as @c client_secret.
+ */
+@property(nonatomic, readonly, nullable) NSDictionary<NSString *, NSString *> *additionalParameters;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use
+        @c initWithIntrospectionEndpoint:token:tokenTypeHint:clientID:additionalParameters:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithConfiguration:token:tokenTypeHint:clientID:additionalParameters:
+    @brief Creates a request to the introspection endpoint of a discovered provider.
+    @param configuration The service's configuration.
+    @param token The token to introspect.
+    @param tokenTypeHint The type of @c token, if known.
+    @param clientID The client identifier.
+    @param additionalParameters The client's additional introspection request parameters.
+    @return The request, or nil if the configuration's discovery document has no
+        @c introspection_endpoint.
+ */
+- (nullable instancetype)initWithConfiguration:(OIDServiceConfiguration *)configuration
+                                         token:(NSString *)token
+                                 tokenTypeHint:(nullable NSString *)tokenTypeHint
+                                      clientID:(NSString *)clientID
+    additionalParameters:(nullable NSDictionary<NSString *, NSString *> *)additionalParameters;
+
+/*! @fn initWithIntrospectionEndpoint:token:tokenTypeHint:clientID:additionalParameters:
+    @brief Designated initializer.
+    @param introspectionEndpoint The introspection endpoint URI.
+    @param token The token to introspect.
+    @param tokenTypeHint The type of @c token, if known.
+    @param clientID The client identifier.
+    @param additionalParameters The client's additional introspection request parameters.
+ */
+- (instancetype)initWithIntrospectionEndpoint:(NSURL *)introspectionEndpoint
+                                        token:(NSString *)token
+                                tokenTypeHint:(nullable NSString *)tokenTypeHint
+                                     clientID:(NSString *)clientID
+    additionalParameters:(nullable NSDictionary<NSString *, NSString *> *)additionalParameters
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn URLRequest
+    @brief Constructs an @c NSURLRequest representing the introspection request.
+    @return An @c NSURLRequest representing the introspection request.
+ */
+- (NSURLRequest *)URLRequest;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,190 @@
+/*! @file OIDIntrospectionRequest.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDIntrospectionRequest.h"
+
+#import "OIDDefines.h"
+#import "OIDServiceConfiguration.h"
+#import "OIDServiceDiscovery.h"
+#import "OIDURLQueryComponent.h"
+
+/*! @var kIntrospectionEndpointKey
+    @brief Key used to encode the @c introspectionEndpoint property for @c NSSecureCoding
+ */
+static NSString *const kIntrospectionEndpointKey = @"introspection_endpoint";
+
+/*! @var kTokenKey
+    @brief Key used to encode the @c token property for @c NSSecureCoding and to build the request
+        body.
+ */
+static NSString *const kTokenKey = @"token";
+
+/*! @var kTokenTypeHintKey
+    @brief Key used to encode the @c tokenTypeHint property for @c NSSecureCoding and to build the
+        request body.
+ */
+static NSString *const kTokenTypeHintKey = @"token_type_hint";
+
+/*! @var kClientIDKey
+    @brief Key used to encode the @c clientID property for @c NSSecureCoding and to build the
+        request body.
+ */
+static NSString *const kClientIDKey = @"client_id";
+
+/*! @var kAdditionalParametersKey
+    @brief Key used to encode the @c additionalParameters property for @c NSSecureCoding
+ */
+static NSString *const kAdditionalParametersKey = @"additionalParameters";
+
+@implementation OIDIntrospectionRequest
+
+- (nullable instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(@selector(
+        initWithIntrospectionEndpoint:token:tokenTypeHint:clientID:additionalParameters:));
+
+- (nullable instancetype)initWithConfiguration:(OIDServiceConfiguration *)configuration
+                                         token:(NSString *)token
+                                 tokenTypeHint:(nullable NSString *)tokenTypeHint
+                                      clientID:(NSString *)clientID
+    additionalParameters:(nullable NSDictionary<NSString *, NSString *> *)additionalParameters {
+  NSURL *introspectionEndpoint = configuration.discoveryDocument.introspectionEndpoint;
+  if (!introspectionEndpoint) {
+    return nil;
+  }
+  return [self initWithIntrospectionEndpoint:introspectionEndpoint
+                                       token:token
+                               tokenTypeHint:tokenTypeHint
+                                    clientID:clientID
+                        additionalParameters:additionalParameters];
+}
+
+- (instancetype)initWithIntrospectionEndpoint:(NSURL *)introspectionEndpoint
+                                        token:(NSString *)token
+                                tokenTypeHint:(nullable NSString *)tokenTypeHint
+                                     clientID:(NSString *)clientID
+    additionalParameters:(nullable NSDictionary<NSString *, NSString *> *)additionalParameters {
+  self = [super init];
+  if (self) {
+    _introspectionEndpoint = [introspectionEndpoint copy];
+    _token = [token copy];
+    _tokenTypeHint = [tokenTypeHint copy];
+    _clientID = [clientID copy];
+    _additionalParameters =
+        [[NSDictionary alloc] initWithDictionary:additionalParameters copyItems:YES];
+  }
+  return self;
+}
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(nullable NSZone *)zone {
+  // The documentation for NSCopying specifically advises us to return a reference to the original
+  // instance in the case where instances are immutable (as ours is):
+  // "Implement NSCopying by retaining the original instead of creating a new copy when the class
+  // and its contents are immutable."
+  return self;
+}
+
+#pragma mark - NSSecureCoding
+
++ (BOOL)supportsSecureCoding {
+  return YES;
+}
+
+- (instancetype)initWithCoder:(NSCoder *)aDecoder {
+  NSURL *introspectionEndpoint = [aDecoder decodeObjectOfClass:[NSURL class]
+                                                     forKey:kIntrospectionEndpointKey];
+  NSString *token = [aDecoder decodeObjectOfClass:[NSString class] forKey:kTokenKey];
+  NSString *tokenTypeHint = [aDecoder decodeObjectOfClass:[NSString class]
+                                                   forKey:kTokenTypeHintKey];
+  NSString *clientID = [aDecoder decodeObjectOfClass:[NSString class] forKey:kClientIDKey];
+  NSSet *additionalParameterCodingClasses = [NSSet setWithArray:@[
+    [NSDictionary class],
+    [NSString class]
+  ]];
+  NSDictionary *additionalParameters =
+      [aDecoder decodeObjectOfClasses:additionalParameterCodingClasses
+                               forKey:kAdditionalParametersKey];
+  self = [self initWithIntrospectionEndpoint:introspectionEndpoint
+                                       token:token
+                               tokenTypeHint:tokenTypeHint
+                                    clientID:clientID
+                        additionalParameters:additionalParameters];
+  return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+  [aCoder encodeObject:_introspectionEndpoint forKey:kIntrospectionEndpointKey];
+  [aCoder encodeObject:_token forKey:kTokenKey];
+  [aCoder encodeObject:_tokenTypeHint forKey:kTokenTypeHintKey];
+  [aCoder encodeObject:_clientID forKey:kClientIDKey];
+  [aCoder encodeObject:_additionalParameters forKey:kAdditionalParametersKey];
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  // omits the token, which may still be valid
+  return [NSString stringWithFormat:@"<%@: %p, introspectionEndpoint: %@, tokenTypeHint: %@, "
+                                     "clientID: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _introspectionEndpoint,
+                                    _tokenTypeHint,
+                                    _clientID];
+}
+
+#pragma mark -
+
+/*! @fn introspectionRequestBody
+    @brief Constructs the request body data by combining the request parameters using the
+        "application/x-www-form-urlencoded" format.
+    @return The data to pass to the introspection endpoint.
+    @see https://tools.ietf.org/html/rfc7662#section-2.1
+ */
+- (NSData *)introspectionRequestBody {
+  OIDURLQueryComponent *query = [[OIDURLQueryComponent alloc] init];
+  [query addParameter:kTokenKey value:_token];
+  if (_tokenTypeHint) {
+    [query addParameter:kTokenTypeHintKey value:_tokenTypeHint];
+  }
+  if (_clientID) {
+    [query addParameter:kClientIDKey value:_clientID];
+  }
+
+  // Add any additional parameters the client has specified.
+  [query addParameters:_additionalParameters];
+
+  NSString *bodyString = [query URLEncodedParameters];
+  return [bodyString dataUsingEncoding:NSUTF8StringEncoding];
+}
+
+- (NSURLRequest *)URLRequest {
+  static NSString *const kHTTPPost = @"POST";
+  static NSString *const kHTTPContentTypeHeaderKey = @"Content-Type";
+  static NSString *const kHTTPContentTypeHeaderValue =
+      @"application/x-www-form-urlencoded; charset=UTF-8";
+
+  NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:_introspectionEndpoint];
+  URLRequest.HTTPMethod = kHTTPPost;
+  [URLRequest setValue:kHTTPContentTypeHeaderValue forHTTPHeaderField:kHTTPContentTypeHeaderKey];
+  URLRequest.HTTPBody = [self introspectionRequestBody];
+  return URLRequest;
+}
+
+@end
@@ -0,0 +1,116 @@
+/*! @file OIDIntrospectionResponse.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDIntrospectionRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDIntrospectionResponse
+    @brief Represents the response to a token introspection request.
+    @see https://tools.ietf.org/html/rfc7662#section-2.2
+ */
+@interface OIDIntrospectionResponse : NSObject <NSCopying, NSSecureCoding>
+
+/*! @property request
+    @brief The request which was serviced.
+ */
+@property(nonatomic, readonly) OIDIntrospectionRequest *request;
+
+/*! @property active
+    @brief Whether the token is currently active. Other properties are only set if it is.
+    @remarks active
+ */
+@property(nonatomic, readonly, getter=isActive) BOOL active;
+
+/*! @property scope
+    @brief The space-separated scopes of the token.
+    @remarks scope
+ */
+@property(nonatomic, readonly, nullable) NSString *scope;
+
+/*! @property clientID
+    @brief The client the token was issued to.
+    @remarks client_id
+ */
+@property(nonatomic, readonly, nullable) NSString *clientID;
+
+/*! @property username
+    @brief A human-readable identifier of the resource owner who authorized the token.
+    @remarks username
+ */
+@property(nonatomic, readonly, nullable) NSString *username;
+
+/*! @property tokenType
+    @brief The type of the token, such as "Bearer".
+    @remarks token_type
+ */
+@property(nonatomic, readonly, nullable) NSString *tokenType;
+
+/*! @property expiresAt
+    @brief When the token expires.
+    @remarks exp
+ */
+@property(nonatomic, readonly, nullable) NSDate *expiresAt;
+
+/*! @property issuedAt
+    @brief When the token was issued.
+    @remarks iat
+ */
+@property(nonatomic, readonly, nullable) NSDate *issuedAt;
+
+/*! @property subject
+    @brief The resource owner who authorized the token.
+    @remarks sub
+ */
+@property(nonatomic, readonly, nullable) NSString *subject;
+
+/*! @property issuer
+    @brief The issuer of the token.
+    @remarks iss
+ */
+@property(nonatomic, readonly, nullable) NSString *issuer;
+
+/*! @property additionalParameters
+    @brief Additional parameters returned from the introspection endpoint, such as @c aud.
+ */
+@property(nonatomic, readonly, nullable)
+    NSDictionary<NSString *, NSObject<NSCopying> *> *additionalParameters;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use initWithRequest:parameters:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithRequest:parameters:
+    @brief Designated initializer.
+    @param request The serviced request.
+    @param parameters The decoded parameters returned from the introspection endpoint.
+    @remarks Known parameters are extracted from the @c parameters parameter and the normative
+        properties are populated. Non-normative parameters are placed in the
+        @c #additionalParameters dictionary.
+ */
+- (nullable instancetype)initWithRequest:(OIDIntrospectionRequest *)request
+    parameters:(NSDictionary<NSString *, NSObject<NSCopying> *> *)parameters
+    NS_DESIGNATED_INITIALIZER;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,216 @@
+/*! @file OIDIntrospectionResponse.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDIntrospectionResponse.h"
+
+#import "OIDDefines.h"
+#import "OIDFieldMapping.h"
+#import "OIDIntrospectionRequest.h"
+
+/*! @var kRequestKey
+    @brief Key used to encode the @c request property for @c NSSecureCoding
+ */
+static NSString *const kRequestKey = @"request";
+
+/*! @var kActiveKey
+    @brief The key for the @c active property in the incoming parameters and for
+        @c NSSecureCoding.
+    @discussion Not in the @c fieldMap, as it is a @c BOOL.
+ */
+static NSString *const kActiveKey = @"active";
+
+/*! @var kScopeKey
+    @brief The key for the @c scope property in the incoming parameters and for @c NSSecureCoding.
+ */
+static NSString *const kScopeKey = @"scope";
+
+/*! @var kClientIDKey
+    @brief The key for the @c clientID property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kClientIDKey = @"client_id";
+
+/*! @var kUsernameKey
+    @brief The key for the @c username property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kUsernameKey = @"username";
+
+/*! @var kTokenTypeKey
+    @brief The key for the @c tokenType property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kTokenTypeKey = @"token_type";
+
+/*! @var kExpiresAtKey
+    @brief The key for the @c expiresAt property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kExpiresAtKey = @"exp";
+
+/*! @var kIssuedAtKey
+    @brief The key for the @c issuedAt property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kIssuedAtKey = @"iat";
+
+/*! @var kSubjectKey
+    @brief The key for the @c subject property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kSubjectKey = @"sub";
+
+/*! @var kIssuerKey
+    @brief The key for the @c issuer property in the incoming parameters and for
+        @c NSSecureCoding.
+ */
+static NSString *const kIssuerKey = @"iss";
+
+/*! @var kAdditionalParametersKey
+    @brief Key used to encode the @c additionalParameters property for @c NSSecureCoding
+ */
+static NSString *const kAdditionalParametersKey = @"additionalParameters";
+
+@implementation OIDIntrospectionResponse
+
+/*! @fn fieldMap
+    @brief Returns a mapping of incoming parameters to instance variables.
+    @return A mapping of incoming parameters to instance variables.
+ */
++ (NSDictionary<NSString *, OIDFieldMapping *> *)fieldMap {
+  static NSMutableDictionary<NSString *, OIDFieldMapping *> *fieldMap;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    fieldMap = [NSMutableDictionary dictionary];
+    fieldMap[kScopeKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_scope" type:[NSString class]];
+    fieldMap[kClientIDKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_clientID" type:[NSString class]];
+    fieldMap[kUsernameKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_username" type:[NSString class]];
+    fieldMap[kTokenTypeKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_tokenType" type:[NSString class]];
+    fieldMap[kSubjectKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_subject" type:[NSString class]];
+    fieldMap[kIssuerKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_issuer" type:[NSString class]];
+    // exp and iat are seconds since the epoch
+    OIDFieldMappingConversionFunction dateSince1970 = ^id _Nullable(NSObject *_Nullable value) {
+      if (![value isKindOfClass:[NSNumber class]]) {
+        return value;
+      }
+      return [NSDate dateWithTimeIntervalSince1970:[(NSNumber *)value doubleValue]];
+    };
+    fieldMap[kExpiresAtKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_expiresAt"
+                                         type:[NSDate class]
+                                   conversion:dateSince1970];
+    fieldMap[kIssuedAtKey] =
+        [[OIDFieldMapping alloc] initWithName:@"_issuedAt"
+                                         type:[NSDate class]
+                                   conversion:dateSince1970];
+  });
+  return fieldMap;
+}
+
+#pragma mark - Initializers
+
+- (nullable instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithRequest:parameters:));
+
+- (nullable instancetype)initWithRequest:(OIDIntrospectionRequest *)request
+    parameters:(NSDictionary<NSString *, NSObject<NSCopying> *> *)parameters {
+  self = [super init];
+  if (self) {
+    _request = [request copy];
+    NSDictionary<NSString *, NSObject<NSCopying> *> *additionalParameters =
+        [OIDFieldMapping remainingParametersWithMap:[[self class] fieldMap]
+                                         parameters:parameters
+                                           instance:self];
+    NSObject *active = additionalParameters[kActiveKey];
+    if ([active isKindOfClass:[NSNumber class]]) {
+      _active = [(NSNumber *)active boolValue];
+      NSMutableDictionary<NSString *, NSObject<NSCopying> *> *remainingParameters =
+          [additionalParameters mutableCopy];
+      [remainingParameters removeObjectForKey:kActiveKey];
+      additionalParameters = remainingParameters;
+    }
+    _additionalParameters = additionalParameters;
+  }
+  return self;
+}
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(nullable NSZone *)zone {
+  // The documentation for NSCopying specifically advises us to return a reference to the original
+  // instance in the case where instances are immutable (as ours is):
+  // "Implement NSCopying by retaining the original instead of creating a new copy when the class
+  // and its contents are immutable."
+  return self;
+}
+
+#pragma mark - NSSecureCoding
+
++ (BOOL)supportsSecureCoding {
+  return YES;
+}
+
+- (nullable instancetype)initWithCoder:(NSCoder *)aDecoder {
+  OIDIntrospectionRequest *request =
+      [aDecoder decodeObjectOfClass:[OIDIntrospectionRequest class] forKey:kRequestKey];
+  self = [self initWithRequest:request parameters:@{ }];
+  if (self) {
+    [OIDFieldMapping decodeWithCoder:aDecoder map:[[self class] fieldMap] instance:self];
+    _active = [aDecoder decodeBoolForKey:kActiveKey];
+    _additionalParameters = [aDecoder decodeObjectOfClasses:[OIDFieldMapping JSONTypes]
+                                                     forKey:kAdditionalParametersKey];
+  }
+  return self;
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+  [OIDFieldMapping encodeWithCoder:aCoder map:[[self class] fieldMap] instance:self];
+  [aCoder encodeBool:_active forKey:kActiveKey];
+  [aCoder encodeObject:_request forKey:kRequestKey];
+  [aCoder encodeObject:_additionalParameters forKey:kAdditionalParametersKey];
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, active: %@, scope: \"%@\", clientID: %@, "
+                                     "username: %@, tokenType: %@, expiresAt: %@, issuedAt: %@, "
+                                     "subject: %@, issuer: %@, additionalParameters: %@, "
+                                     "request: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _active ? @"YES" : @"NO",
+                                    _scope,
+                                    _clientID,
+                                    _username,
+                                    _tokenType,
+                                    _expiresAt,
+                                    _issuedAt,
+                                    _subject,
+                                    _issuer,
+                                    _additionalParameters,
+                                    _request];
+}
+
+@end
@@ -0,0 +1,138 @@
+/*! @file OIDJSONWebKey.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @var OIDJSONWebAlgorithmRS256
+    @brief RSASSA-PKCS1-v1_5 using SHA-256.
+    @see https://tools.ietf.org/html/rfc7518#section-3.3
+ */
+extern NSString *const OIDJSONWebAlgorithmRS256;
+
+/*! @var OIDJSONWebAlgorithmES256
+    @brief ECDSA using P-256 and SHA-256.
+    @see https://tools.ietf.org/html/rfc7518#section-3.4
+ */
+extern NSString *const OIDJSONWebAlgorithmES256;
+
+/*! @class OIDJSONWebKey
+    @brief A public key from a JSON Web Key Set, which verifies JWS signatures.
+    @discussion RSA keys (for @c RS256) and P-256 EC keys (for @c ES256) are supported. Verifying
+        signatures requires iOS 10 or macOS 10.12; on earlier versions verification fails with an
+        error.
+    @see https://tools.ietf.org/html/rfc7517
+ */
+@interface OIDJSONWebKey : NSObject
+
+/*! @property keyType
+    @brief The key type, @c "RSA" or @c "EC".
+    @remarks kty
+ */
+@property(nonatomic, readonly) NSString *keyType;
+
+/*! @property keyID
+    @brief The ID of the key, which JWS headers refer to.
+    @remarks kid
+ */
+@property(nonatomic, readonly, nullable) NSString *keyID;
+
+/*! @property algorithm
+    @brief The only algorithm the key may be used with, if restricted.
+    @remarks alg
+ */
+@property(nonatomic, readonly, nullable) NSString *algorithm;
+
+/*! @property use
+    @brief The intended use of the key, such as @c "sig".
+    @remarks use
+ */
+@property(nonatomic, readonly, nullable) NSString *use;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithJSON:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithJSON:
+    @brief Creates a key from its JSON representation.
+    @param JSON A JSON Web Key.
+    @return The key, or nil if it isn't a supported public key.
+ */
+- (nullable instancetype)initWithJSON:(NSDictionary<NSString *, id> *)JSON
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn supportsAlgorithm:
+    @brief Whether the key can verify signatures made with a JWS algorithm.
+    @param algorithm The JWS algorithm, such as @c OIDJSONWebAlgorithmRS256.
+ */
+- (BOOL)supportsAlgorithm:(NSString *)algorithm;
+
+/*! @fn verifySignature:signingInput:algorithm:error:
+    @brief Verifies a JWS signature.
+    @param signature The decoded signature.
+    @param signingInput The ASCII bytes of the encoded header and payload, joined by a period.
+    @param algorithm The algorithm of the signature.
+    @param error Set if the signature is invalid or couldn't be verified.
+    @return YES if the signature is valid.
+ */
+- (BOOL)verifySignature:(NSData *)signature
+           signingInput:(NSData *)signingInput
+              algorithm:(NSString *)algorithm
+                  error:(NSError **_Nullable)error;
+
+@end
+
+/*! @class OIDJSONWebKeySet
+    @brief An immutable JSON Web Key Set, indexed by key ID.
+ */
+@interface OIDJSONWebKeySet : NSObject
+
+/*! @property keys
+    @brief The supported keys of the set. Unsupported keys are skipped.
+ */
+@property(nonatomic, readonly) NSArray<OIDJSONWebKey *> *keys;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithJSON:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithJSON:
+    @brief Creates a key set from its JSON representation.
+    @param JSON A JSON Web Key Set, whose @c keys member is an array.
+    @return The key set, or nil if @c JSON isn't a key set.
+ */
+- (nullable instancetype)initWithJSON:(NSDictionary<NSString *, id> *)JSON
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn keyWithID:algorithm:
+    @brief Looks up the key which verifies a signature.
+    @param keyID The @c kid of the JWS header. When nil, the key is only found if it's the set's
+        only key supporting @c algorithm.
+    @param algorithm The @c alg of the JWS header.
+    @return The key, or nil if there is no key with that ID which supports @c algorithm.
+ */
+- (nullable OIDJSONWebKey *)keyWithID:(nullable NSString *)keyID algorithm:(NSString *)algorithm;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,377 @@
+/*! @file OIDJSONWebKey.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDJSONWebKey.h"
+
+#import <Security/Security.h>
+
+#import "OIDDefines.h"
+#import "OIDError.h"
+#import "OIDErrorUtilities.h"
+#import "OIDTokenUtilities.h"
+
+NSString *const OIDJSONWebAlgorithmRS256 = @"RS256";
+
+NSString *const OIDJSONWebAlgorithmES256 = @"ES256";
+
+/*! @var kKeyTypeRSA
+    @brief The @c kty of RSA keys.
+ */
+static NSString *const kKeyTypeRSA = @"RSA";
+
+/*! @var kKeyTypeEC
+    @brief The @c kty of elliptic curve keys.
+ */
+static NSString *const kKeyTypeEC = @"EC";
+
+/*! @var kCurveP256
+    @brief The @c crv of P-256 keys.
+ */
+static NSString *const kCurveP256 = @"P-256";
+
+/*! @var kP256CoordinateLength
+    @brief The length of a P-256 coordinate, and of each half of an @c ES256 signature.
+ */
+static const NSUInteger kP256CoordinateLength = 32;
+
+#pragma mark - DER encoding
+
+/*! @fn OIDDERAppendLength
+    @brief Appends a DER length.
+ */
+static void OIDDERAppendLength(NSMutableData *data, NSUInteger length) {
+  if (length < 0x80) {
+    uint8_t byte = (uint8_t)length;
+    [data appendBytes:&byte length:1];
+    return;
+  }
+  uint8_t bytes[sizeof(NSUInteger)];
+  uint8_t count = 0;
+  for (NSUInteger remaining = length; remaining; remaining >>= 8) {
+    bytes[sizeof(bytes) - ++count] = remaining & 0xff;
+  }
+  uint8_t prefix = 0x80 | count;
+  [data appendBytes:&prefix length:1];
+  [data appendBytes:bytes + sizeof(bytes) - count length:count];
+}
+
+/*! @fn OIDDERAppendInteger
+    @brief Appends a DER INTEGER with the unsigned big-endian value of @c bytes.
+ */
+static void OIDDERAppendInteger(NSMutableData *data, NSData *bytes) {
+  const uint8_t *value = bytes.bytes;
+  NSUInteger length = bytes.length;
+  // strips leading zeros, keeping one byte
+  while (length > 1 && value[0] == 0) {
+    value++;
+    length--;
+  }
+  // a leading zero keeps values with the high bit set positive
+  BOOL needsPadding = length == 0 || (value[0] & 0x80);
+  uint8_t tag = 0x02;
+  [data appendBytes:&tag length:1];
+  OIDDERAppendLength(data, length + (needsPadding ? 1 : 0));
+  if (needsPadding) {
+    uint8_t zero = 0;
+    [data appendBytes:&zero length:1];
+  }
+  [data appendBytes:value length:length];
+}
+
+/*! @fn OIDDERSequence
+    @brief Wraps DER encoded values in a SEQUENCE.
+ */
+static NSData *OIDDERSequence(NSData *contents) {
+  NSMutableData *data = [NSMutableData data];
+  uint8_t tag = 0x30;
+  [data appendBytes:&tag length:1];
+  OIDDERAppendLength(data, contents.length);
+  [data appendData:contents];
+  return data;
+}
+
+/*! @fn OIDStringValue
+    @brief Returns @c value if it's a string, otherwise nil.
+ */
+static NSString *_Nullable OIDStringValue(id _Nullable value) {
+  return [value isKindOfClass:[NSString class]] ? value : nil;
+}
+
+/*! @fn OIDDecodedMember
+    @brief Decodes a base64url encoded member of a JSON Web Key.
+ */
+static NSData *_Nullable OIDDecodedMember(NSDictionary<NSString *, id> *JSON, NSString *name) {
+  NSString *value = OIDStringValue(JSON[name]);
+  return value ? [OIDTokenUtilities decodeBase64urlNoPadding:value] : nil;
+}
+
+#pragma mark - OIDJSONWebKey
+
+@implementation OIDJSONWebKey {
+  /*! @var _keyData
+      @brief The external representation of the key: a PKCS #1 RSAPublicKey for RSA keys, or an
+          uncompressed ANSI X9.63 point for EC keys.
+   */
+  NSData *_keyData;
+
+  /*! @var _keySizeInBits
+      @brief The size of the key.
+   */
+  NSUInteger _keySizeInBits;
+
+  /*! @var _secKey
+      @brief The Security framework key, created when first needed.
+   */
+  SecKeyRef _secKey;
+}
+
+- (nullable instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithJSON:));
+
+- (nullable instancetype)initWithJSON:(NSDictionary<NSString *, id> *)JSON {
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+  _keyType = OIDStringValue(JSON[@"kty"]);
+  _keyID = OIDStringValue(JSON[@"kid"]);
+  _algorithm = OIDStringValue(JSON[@"alg"]);
+  _use = OIDStringValue(JSON[@"use"]);
+
+  if ([_keyType isEqualToString:kKeyTypeRSA]) {
+    NSData *modulus = OIDDecodedMember(JSON, @"n");
+    NSData *exponent = OIDDecodedMember(JSON, @"e");
+    if (!modulus.length || !exponent.length) {
+      return nil;
+    }
+    NSMutableData *integers = [NSMutableData data];
+    OIDDERAppendInteger(integers, modulus);
+    OIDDERAppendInteger(integers, exponent);
+    _keyData = OIDDERSequence(integers);
+    _keySizeInBits = modulus.length * 8;
+  } else if ([_keyType isEqualToString:kKeyTypeEC]) {
+    NSData *x = OIDDecodedMember(JSON, @"x");
+    NSData *y = OIDDecodedMember(JSON, @"y");
+    if (![OIDStringValue(JSON[@"crv"]) isEqualToString:kCurveP256]
+        || x.length != kP256CoordinateLength || y.length != kP256CoordinateLength) {
+      return nil;
+    }
+    NSMutableData *point = [NSMutableData dataWithBytes:"\x04" length:1];
+    [point appendData:x];
+    [point appendData:y];
+    _keyData = point;
+    _keySizeInBits = kP256CoordinateLength * 8;
+  } else {
+    return nil;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  if (_secKey) {
+    CFRelease(_secKey);
+  }
+}
+
+- (BOOL)supportsAlgorithm:(NSString *)algorithm {
+  if (_algorithm && ![_algorithm isEqualToString:algorithm]) {
+    return NO;
+  }
+  if ([algorithm isEqualToString:OIDJSONWebAlgorithmRS256]) {
+    return [_keyType isEqualToString:kKeyTypeRSA];
+  }
+  if ([algorithm isEqualToString:OIDJSONWebAlgorithmES256]) {
+    return [_keyType isEqualToString:kKeyTypeEC];
+  }
+  return NO;
+}
+
+- (BOOL)verifySignature:(NSData *)signature
+           signingInput:(NSData *)signingInput
+              algorithm:(NSString *)algorithm
+                  error:(NSError **_Nullable)error {
+  if (![self supportsAlgorithm:algorithm]) {
+    [self setVerificationError:error
+                   description:[NSString stringWithFormat:@"Key %@ doesn't support %@.",
+                                                          _keyID, algorithm]
+               underlyingError:nil];
+    return NO;
+  }
+  if (&SecKeyCreateWithData == NULL) {
+    [self setVerificationError:error
+                   description:@"Verifying signatures requires iOS 10 or macOS 10.12."
+               underlyingError:nil];
+    return NO;
+  }
+
+  SecKeyAlgorithm keyAlgorithm = kSecKeyAlgorithmRSASignatureMessagePKCS1v15SHA256;
+  if ([algorithm isEqualToString:OIDJSONWebAlgorithmES256]) {
+    // JWS carries ECDSA signatures as R || S, the Security framework as a DER sequence
+    if (signature.length != 2 * kP256CoordinateLength) {
+      [self setVerificationError:error
+                     description:@"ES256 signature has the wrong length."
+                 underlyingError:nil];
+      return NO;
+    }
+    NSMutableData *integers = [NSMutableData data];
+    OIDDERAppendInteger(integers,
+        [signature subdataWithRange:NSMakeRange(0, kP256CoordinateLength)]);
+    OIDDERAppendInteger(integers,
+        [signature subdataWithRange:NSMakeRange(kP256CoordinateLength, kP256CoordinateLength)]);
+    signature = OIDDERSequence(integers);
+    keyAlgorithm = kSecKeyAlgorithmECDSASignatureMessageX962SHA256;
+  }
+
+  CFErrorRef keyError = NULL;
+  SecKeyRef key = [self secKeyWithError:&keyError];
+  if (!key) {
+    [self setVerificationError:error
+                   description:@"Key couldn't be created."
+               underlyingError:(__bridge_transfer NSError *)keyError];
+    return NO;
+  }
+  CFErrorRef verifyError = NULL;
+  BOOL valid = SecKeyVerifySignature(key,
+                                     keyAlgorithm,
+                                     (__bridge CFDataRef)signingInput,
+                                     (__bridge CFDataRef)signature,
+                                     &verifyError);
+  if (!valid) {
+    [self setVerificationError:error
+                   description:@"Signature is invalid."
+               underlyingError:(__bridge_transfer NSError *)verifyError];
+  }
+  return valid;
+}
+
+/*! @fn secKeyWithError:
+    @brief Returns the Security framework key, creating it on first use.
+    @param error Set if the key couldn't be created. Owned by the caller.
+ */
+- (nullable SecKeyRef)secKeyWithError:(CFErrorRef *)error {
+  @synchronized(self) {
+    if (!_secKey) {
+      NSDictionary *attributes = @{
+        (__bridge id)kSecAttrKeyType : [_keyType isEqualToString:kKeyTypeRSA]
+            ? (__bridge id)kSecAttrKeyTypeRSA
+            : (__bridge id)kSecAttrKeyTypeECSECPrimeRandom,
+        (__bridge id)kSecAttrKeyClass : (__bridge id)kSecAttrKeyClassPublic,
+        (__bridge id)kSecAttrKeySizeInBits : @(_keySizeInBits),
+      };
+      _secKey = SecKeyCreateWithData((__bridge CFDataRef)_keyData,
+                                     (__bridge CFDictionaryRef)attributes,
+                                     error);
+    }
+    return _secKey;
+  }
+}
+
+/*! @fn setVerificationError:description:underlyingError:
+    @brief Sets @c error to an @c OIDErrorCodeIDTokenVerificationError, if it isn't NULL.
+ */
+- (void)setVerificationError:(NSError **_Nullable)error
+                 description:(NSString *)description
+             underlyingError:(nullable NSError *)underlyingError {
+  if (error) {
+    *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeIDTokenVerificationError
+                              underlyingError:underlyingError
+                                  description:description];
+  }
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, keyType: %@, keyID: %@, algorithm: %@, use: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _keyType,
+                                    _keyID,
+                                    _algorithm,
+                                    _use];
+}
+
+@end
+
+#pragma mark - OIDJSONWebKeySet
+
+@implementation OIDJSONWebKeySet {
+  /*! @var _keysByID
+      @brief The keys which have an ID, by ID.
+   */
+  NSDictionary<NSString *, OIDJSONWebKey *> *_keysByID;
+}
+
+- (nullable instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithJSON:));
+
+- (nullable instancetype)initWithJSON:(NSDictionary<NSString *, id> *)JSON {
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+  NSArray *keysJSON = JSON[@"keys"];
+  if (![keysJSON isKindOfClass:[NSArray class]]) {
+    return nil;
+  }
+  NSMutableArray<OIDJSONWebKey *> *keys = [NSMutableArray array];
+  NSMutableDictionary<NSString *, OIDJSONWebKey *> *keysByID = [NSMutableDictionary dictionary];
+  for (id keyJSON in keysJSON) {
+    if (![keyJSON isKindOfClass:[NSDictionary class]]) {
+      continue;
+    }
+    OIDJSONWebKey *key = [[OIDJSONWebKey alloc] initWithJSON:keyJSON];
+    // keys for encryption can't verify signatures
+    if (!key || (key.use && ![key.use isEqualToString:@"sig"])) {
+      continue;
+    }
+    [keys addObject:key];
+    if (key.keyID) {
+      keysByID[key.keyID] = key;
+    }
+  }
+  _keys = keys;
+  _keysByID = keysByID;
+  return self;
+}
+
+- (nullable OIDJSONWebKey *)keyWithID:(nullable NSString *)keyID algorithm:(NSString *)algorithm {
+  if (keyID) {
+    OIDJSONWebKey *key = _keysByID[keyID];
+    return [key supportsAlgorithm:algorithm] ? key : nil;
+  }
+  OIDJSONWebKey *onlyKey;
+  for (OIDJSONWebKey *key in _keys) {
+    if ([key supportsAlgorithm:algorithm]) {
+      if (onlyKey) {
+        return nil;
+      }
+      onlyKey = key;
+    }
+  }
+  return onlyKey;
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, keys: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _keys];
+}
+
+@end
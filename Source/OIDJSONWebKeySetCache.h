@@ -0,0 +1,99 @@
+/*! @file OIDJSONWebKeySetCache.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDJSONWebKey;
+@class OIDJSONWebKeySet;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @typedef OIDJSONWebKeyCallback
+    @brief The method called when a key lookup has completed.
+    @param key The key, or nil if it wasn't found.
+    @param error The error if the key wasn't found.
+ */
+typedef void (^OIDJSONWebKeyCallback)(OIDJSONWebKey *_Nullable key, NSError *_Nullable error);
+
+/*! @class OIDJSONWebKeySetCache
+    @brief Fetches and caches the JSON Web Key Set of a provider.
+    @discussion The key set is fetched on first use and refetched once it is older than
+        @c timeToLive, or when a signature refers to a key ID it doesn't contain, which is how
+        providers roll their keys. Refetches for unknown key IDs happen at most once per
+        @c minimumRefetchInterval, so tokens with made-up key IDs can't cause a fetch each, and
+        neither are failed fetches retried sooner. Concurrent lookups share a single fetch.
+ */
+@interface OIDJSONWebKeySetCache : NSObject
+
+/*! @property JWKSURL
+    @brief The URL of the key set.
+ */
+@property(nonatomic, readonly) NSURL *JWKSURL;
+
+/*! @property timeToLive
+    @brief How long a fetched key set is used before it is refetched. Defaults to one day.
+ */
+@property(atomic) NSTimeInterval timeToLive;
+
+/*! @property minimumRefetchInterval
+    @brief The minimum time between fetches caused by unknown key IDs, and between a failed fetch
+        and the next. Defaults to 60 seconds.
+ */
+@property(atomic) NSTimeInterval minimumRefetchInterval;
+
+/*! @property keySet
+    @brief The most recently fetched key set, if any.
+ */
+@property(atomic, readonly, nullable) OIDJSONWebKeySet *keySet;
+
+/*! @fn cacheForJWKSURL:
+    @brief Returns the shared cache of a key set.
+    @param JWKSURL The URL of the key set, such as @c OIDServiceDiscovery.jwksURL.
+ */
++ (instancetype)cacheForJWKSURL:(NSURL *)JWKSURL;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithJWKSURL:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithJWKSURL:
+    @brief Creates a cache which isn't shared.
+    @param JWKSURL The URL of the key set.
+ */
+- (instancetype)initWithJWKSURL:(NSURL *)JWKSURL NS_DESIGNATED_INITIALIZER;
+
+/*! @fn keyWithID:algorithm:callback:
+    @brief Looks up a key, fetching the key set if needed.
+    @param keyID The @c kid of the JWS header, if any.
+    @param algorithm The @c alg of the JWS header.
+    @param callback The method called on the main queue with the key, or an error.
+ */
+- (void)keyWithID:(nullable NSString *)keyID
+        algorithm:(NSString *)algorithm
+         callback:(OIDJSONWebKeyCallback)callback;
+
+/*! @fn invalidate
+    @brief Discards the cached key set, so the next lookup fetches it.
+ */
+- (void)invalidate;
+
+@end
+
+NS_ASSUME_NONNULL_END
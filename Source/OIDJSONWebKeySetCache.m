@@ -0,0 +1,241 @@
+/*! @file OIDJSONWebKeySetCache.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDJSONWebKeySetCache.h"
+
+#import "OIDAuthorizationService.h"
+#import "OIDDefines.h"
+#import "OIDError.h"
+#import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
+#import "OIDJSONWebKey.h"
+#import "OIDMonotonicClock.h"
+
+/*! @var kDefaultTimeToLive
+    @brief The default of @c OIDJSONWebKeySetCache.timeToLive.
+ */
+static const NSTimeInterval kDefaultTimeToLive = 24 * 60 * 60;
+
+/*! @var kDefaultMinimumRefetchInterval
+    @brief The default of @c OIDJSONWebKeySetCache.minimumRefetchInterval.
+ */
+static const NSTimeInterval kDefaultMinimumRefetchInterval = 60;
+
+/*! @typedef OIDJSONWebKeySetLookup
+    @brief A lookup waiting for a fetch of the key set.
+    @param keySet The key set to look the key up in, if any.
+    @param fetchError The error of the fetch, if it failed.
+ */
+typedef void (^OIDJSONWebKeySetLookup)(OIDJSONWebKeySet *_Nullable keySet,
+                                       NSError *_Nullable fetchError);
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation OIDJSONWebKeySetCache {
+  /*! @var _fetchDate
+      @brief When @c keySet was fetched.
+   */
+  NSDate *_fetchDate;
+
+  /*! @var _fetchAttemptDate
+      @brief When the last fetch completed, whether or not it succeeded.
+   */
+  NSDate *_fetchAttemptDate;
+
+  /*! @var _fetchAttemptError
+      @brief The error of the last fetch, or nil if it succeeded.
+   */
+  NSError *_fetchAttemptError;
+
+  /*! @var _pendingLookups
+      @brief The lookups waiting for the fetch in flight, or nil if there is none.
+   */
+  NSMutableArray<OIDJSONWebKeySetLookup> *_pendingLookups;
+}
+
+@synthesize keySet = _keySet;
+
++ (instancetype)cacheForJWKSURL:(NSURL *)JWKSURL {
+  static NSMutableDictionary<NSURL *, OIDJSONWebKeySetCache *> *caches;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    caches = [NSMutableDictionary dictionary];
+  });
+  @synchronized(caches) {
+    OIDJSONWebKeySetCache *cache = caches[JWKSURL];
+    if (!cache) {
+      cache = [[self alloc] initWithJWKSURL:JWKSURL];
+      caches[JWKSURL] = cache;
+    }
+    return cache;
+  }
+}
+
+- (nullable instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithJWKSURL:));
+
+- (instancetype)initWithJWKSURL:(NSURL *)JWKSURL {
+  self = [super init];
+  if (self) {
+    _JWKSURL = [JWKSURL copy];
+    _timeToLive = kDefaultTimeToLive;
+    _minimumRefetchInterval = kDefaultMinimumRefetchInterval;
+  }
+  return self;
+}
+
+- (nullable OIDJSONWebKeySet *)keySet {
+  @synchronized(self) {
+    return _keySet;
+  }
+}
+
+- (void)invalidate {
+  @synchronized(self) {
+    _keySet = nil;
+    _fetchDate = nil;
+    _fetchAttemptDate = nil;
+    _fetchAttemptError = nil;
+  }
+}
+
+- (void)keyWithID:(nullable NSString *)keyID
+        algorithm:(NSString *)algorithm
+         callback:(OIDJSONWebKeyCallback)callback {
+  OIDJSONWebKeySetLookup lookup = ^(OIDJSONWebKeySet *_Nullable keySet,
+                                    NSError *_Nullable fetchError) {
+    OIDJSONWebKey *key = [keySet keyWithID:keyID algorithm:algorithm];
+    NSError *error = nil;
+    if (!key) {
+      error = fetchError;
+      if (!error) {
+        NSString *description =
+            [NSString stringWithFormat:@"No key with ID %@ for %@ in %@.",
+                                       keyID, algorithm, self->_JWKSURL];
+        error = [OIDErrorUtilities errorWithCode:OIDErrorCodeIDTokenVerificationError
+                                 underlyingError:nil
+                                     description:description];
+      }
+    }
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(key, error);
+    }];
+  };
+
+  OIDJSONWebKeySet *cachedKeySet;
+  NSError *cachedFetchError;
+  BOOL answersFromCache = NO;
+  BOOL startsFetch = NO;
+  @synchronized(self) {
+    NSDate *now = [OIDMonotonicClock date];
+    NSTimeInterval age = _fetchDate ? [now timeIntervalSinceDate:_fetchDate] : DBL_MAX;
+    NSTimeInterval attemptAge =
+        _fetchAttemptDate ? [now timeIntervalSinceDate:_fetchAttemptDate] : DBL_MAX;
+    BOOL fresh = _keySet && age < self.timeToLive;
+    if (fresh && [_keySet keyWithID:keyID algorithm:algorithm]) {
+      cachedKeySet = _keySet;
+      answersFromCache = YES;
+    } else if (_pendingLookups) {
+      [_pendingLookups addObject:lookup];
+    } else if (attemptAge < self.minimumRefetchInterval && (fresh || _fetchAttemptError)) {
+      // the key set was just fetched, so the key ID is unknown rather than new, or the fetch just
+      // failed, and retrying right away would likely fail too
+      cachedKeySet = _keySet;
+      cachedFetchError = _fetchAttemptError;
+      answersFromCache = YES;
+    } else {
+      _pendingLookups = [NSMutableArray arrayWithObject:lookup];
+      startsFetch = YES;
+    }
+  }
+
+  if (startsFetch) {
+    [self fetchKeySet];
+  } else if (answersFromCache) {
+    lookup(cachedKeySet, cachedFetchError);
+  }
+}
+
+/*! @fn fetchKeySet
+    @brief Fetches the key set, and completes the pending lookups.
+ */
+- (void)fetchKeySet {
+  NSURLSession *session = [OIDAuthorizationService URLSession] ?: [NSURLSession sharedSession];
+  [[session dataTaskWithURL:_JWKSURL
+          completionHandler:^(NSData *_Nullable data,
+                              NSURLResponse *_Nullable response,
+                              NSError *_Nullable error) {
+    OIDJSONWebKeySet *keySet = nil;
+    NSError *fetchError = nil;
+    NSHTTPURLResponse *HTTPURLResponse = (NSHTTPURLResponse *)response;
+    if (error || !data) {
+      fetchError = [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
+                                    underlyingError:error
+                                        description:nil];
+    } else if (HTTPURLResponse.statusCode != 200) {
+      NSError *URLResponseError = [OIDErrorUtilities HTTPErrorWithHTTPResponse:HTTPURLResponse
+                                                                          data:data];
+      fetchError = [OIDErrorUtilities errorWithCode:OIDErrorCodeNetworkError
+                                    underlyingError:URLResponseError
+                                        description:nil];
+    } else {
+      NSError *JSONError;
+      id JSON = [NSJSONSerialization JSONObjectWithData:data options:0 error:&JSONError];
+      keySet = [JSON isKindOfClass:[NSDictionary class]]
+          ? [[OIDJSONWebKeySet alloc] initWithJSON:JSON]
+          : nil;
+      if (!keySet) {
+        fetchError = [OIDErrorUtilities errorWithCode:OIDErrorCodeJSONDeserializationError
+                                      underlyingError:JSONError
+                                          description:@"Not a JSON Web Key Set."];
+      }
+    }
+
+    NSArray<OIDJSONWebKeySetLookup> *lookups;
+    @synchronized(self) {
+      NSDate *now = [OIDMonotonicClock date];
+      if (keySet) {
+        self->_keySet = keySet;
+        self->_fetchDate = now;
+      }
+      // failed fetches count towards minimumRefetchInterval too
+      self->_fetchAttemptDate = now;
+      self->_fetchAttemptError = fetchError;
+      // if the fetch failed, lookups fall back to the previous key set
+      keySet = self->_keySet;
+      lookups = self->_pendingLookups;
+      self->_pendingLookups = nil;
+    }
+    for (OIDJSONWebKeySetLookup lookup in lookups) {
+      lookup(keySet, fetchError);
+    }
+  }] resume];
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, JWKSURL: %@, keySet: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _JWKSURL,
+                                    self.keySet];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
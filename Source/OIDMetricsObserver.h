@@ -0,0 +1,189 @@
+/*! @file OIDMetricsObserver.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDMetricsEvent;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @var OIDMetricsTimingUnavailable
+    @brief The value of the timing properties of @c OIDMetricsEvent which couldn't be measured,
+        such as the DNS lookup time of a request which reused an open connection.
+ */
+extern const NSTimeInterval OIDMetricsTimingUnavailable;
+
+/*! @brief The operations reported to an @c OIDMetricsObserver.
+ */
+typedef NS_ENUM(NSInteger, OIDMetricsEventType) {
+  /*! @brief Fetching and parsing an OpenID Connect discovery document.
+   */
+  OIDMetricsEventTypeDiscovery = 0,
+
+  /*! @brief A request to the token endpoint, such as an authorization code exchange or a token
+          refresh. @c OIDMetricsEvent.grantType tells them apart.
+   */
+  OIDMetricsEventTypeTokenRequest = 1,
+
+  /*! @brief A call to @c OIDAuthState.withFreshTokensPerformAction:, reported once the action
+          can be called. Cache hits are served from the current tokens, misses waited on a refresh.
+   */
+  OIDMetricsEventTypeFreshTokens = 2,
+
+  /*! @brief A request to the revocation endpoint.
+   */
+  OIDMetricsEventTypeRevocation = 3,
+
+  /*! @brief A request to the introspection endpoint.
+   */
+  OIDMetricsEventTypeIntrospection = 4,
+
+  /*! @brief A batch of requests authorized by an @c OIDAuthStateAuthorizer. The duration is the
+          time the batch was queued waiting for fresh tokens.
+   */
+  OIDMetricsEventTypeRequestAuthorization = 5,
+
+  /*! @brief A request to the userinfo endpoint, made by
+          @c OIDAuthState.performUserInfoRequestWithCallback:.
+   */
+  OIDMetricsEventTypeUserInfo = 6,
+};
+
+/*! @brief Whether an operation could be served from cached state.
+ */
+typedef NS_ENUM(NSInteger, OIDMetricsCacheResult) {
+  /*! @brief The operation doesn't involve a cache.
+   */
+  OIDMetricsCacheResultNotApplicable = 0,
+
+  /*! @brief The operation was served from cached state.
+   */
+  OIDMetricsCacheResultHit = 1,
+
+  /*! @brief The operation had to make a request.
+   */
+  OIDMetricsCacheResultMiss = 2,
+};
+
+/*! @protocol OIDMetricsObserver
+    @brief Receives timings of the operations performed by @c OIDAuthorizationService and
+        @c OIDAuthState, for example to export latency percentiles to a telemetry service.
+    @see OIDAuthorizationService.setMetricsObserver:
+ */
+@protocol OIDMetricsObserver <NSObject>
+
+/*! @brief Called each time an operation completes.
+    @param event The timings and outcome of the operation.
+    @discussion Called on an arbitrary queue, possibly concurrently, so implementations must be
+        thread safe. They should also return quickly, as they may be called on the queue delivering
+        network responses.
+ */
+- (void)didRecordMetricsEvent:(OIDMetricsEvent *)event;
+
+@end
+
+/*! @class OIDMetricsEvent
+    @brief The timings and outcome of a single operation, reported to an @c OIDMetricsObserver.
+    @discussion Network timings are taken from \NSURLSession task metrics where available (iOS 10
+        and macOS 10.12 or later), and are @c ::OIDMetricsTimingUnavailable otherwise. All
+        durations are in seconds.
+ */
+@interface OIDMetricsEvent : NSObject
+
+/*! @property type
+    @brief The operation.
+ */
+@property(nonatomic) OIDMetricsEventType type;
+
+/*! @property URL
+    @brief The URL of the endpoint the operation made its request to, if any.
+ */
+@property(nonatomic, copy, nullable) NSURL *URL;
+
+/*! @property grantType
+    @brief The grant type of a token request.
+ */
+@property(nonatomic, copy, nullable) NSString *grantType;
+
+/*! @property duration
+    @brief The total duration of the operation.
+ */
+@property(nonatomic) NSTimeInterval duration;
+
+/*! @property domainLookupDuration
+    @brief The time spent resolving the endpoint's host name.
+ */
+@property(nonatomic) NSTimeInterval domainLookupDuration;
+
+/*! @property connectDuration
+    @brief The time spent establishing the connection, including the TLS handshake.
+ */
+@property(nonatomic) NSTimeInterval connectDuration;
+
+/*! @property secureConnectionDuration
+    @brief The time spent on the TLS handshake.
+ */
+@property(nonatomic) NSTimeInterval secureConnectionDuration;
+
+/*! @property timeToFirstByte
+    @brief The time from sending the request until the first byte of the response was received.
+ */
+@property(nonatomic) NSTimeInterval timeToFirstByte;
+
+/*! @property parseDuration
+    @brief The time spent parsing the response.
+ */
+@property(nonatomic) NSTimeInterval parseDuration;
+
+/*! @property retryCount
+    @brief The number of times the request was retried before it completed.
+ */
+@property(nonatomic) NSUInteger retryCount;
+
+/*! @property coalescedWaiterCount
+    @brief The number of callers served by a single request, such as the actions waiting on one
+        token refresh.
+ */
+@property(nonatomic) NSUInteger coalescedWaiterCount;
+
+/*! @property cacheResult
+    @brief Whether the operation could be served from cached state.
+ */
+@property(nonatomic) OIDMetricsCacheResult cacheResult;
+
+/*! @property error
+    @brief The error the operation failed with, if any.
+ */
+@property(nonatomic, nullable) NSError *error;
+
+/*! @fn initWithType:
+    @brief Designated initializer.
+    @param type The operation.
+    @discussion Every timing is initialized to @c ::OIDMetricsTimingUnavailable.
+ */
+- (instancetype)initWithType:(OIDMetricsEventType)type NS_DESIGNATED_INITIALIZER;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithType:.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,72 @@
+/*! @file OIDMetricsObserver.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDMetricsObserver.h"
+
+#import "OIDDefines.h"
+
+const NSTimeInterval OIDMetricsTimingUnavailable = -1;
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation OIDMetricsEvent
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithType:));
+
+- (instancetype)initWithType:(OIDMetricsEventType)type {
+  self = [super init];
+  if (self) {
+    _type = type;
+    _duration = OIDMetricsTimingUnavailable;
+    _domainLookupDuration = OIDMetricsTimingUnavailable;
+    _connectDuration = OIDMetricsTimingUnavailable;
+    _secureConnectionDuration = OIDMetricsTimingUnavailable;
+    _timeToFirstByte = OIDMetricsTimingUnavailable;
+    _parseDuration = OIDMetricsTimingUnavailable;
+  }
+  return self;
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, type: %ld, URL: %@, grantType: %@, duration: %f, "
+                                     "domainLookupDuration: %f, connectDuration: %f, "
+                                     "secureConnectionDuration: %f, timeToFirstByte: %f, "
+                                     "parseDuration: %f, retryCount: %lu, "
+                                     "coalescedWaiterCount: %lu, cacheResult: %ld, error: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    (long)_type,
+                                    _URL,
+                                    _grantType,
+                                    _duration,
+                                    _domainLookupDuration,
+                                    _connectDuration,
+                                    _secureConnectionDuration,
+                                    _timeToFirstByte,
+                                    _parseDuration,
+                                    (unsigned long)_retryCount,
+                                    (unsigned long)_coalescedWaiterCount,
+                                    (long)_cacheResult,
+                                    _error];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
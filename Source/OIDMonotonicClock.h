@@ -0,0 +1,111 @@
+/*! @file OIDMonotonicClock.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @typedef OIDMonotonicTime
+    @brief A point in time on the monotonic clock, in nanoseconds.
+ */
+typedef uint64_t OIDMonotonicTime;
+
+/*! @protocol OIDClock
+    @brief A source of time for the library, which can be set with @c OIDMonotonicClock.setClock:
+        to run it in virtual time, such as in a simulation.
+ */
+@protocol OIDClock <NSObject>
+
+/*! @fn now
+    @brief The current time on the monotonic clock, which must never go backwards.
+ */
+- (OIDMonotonicTime)now;
+
+/*! @fn absoluteTime
+    @brief The current wall-clock time, in seconds since the reference date of @c NSDate.
+ */
+- (CFAbsoluteTime)absoluteTime;
+
+@end
+
+/*! @class OIDMonotonicClock
+    @brief Reads a clock which, unlike @c NSDate, isn't affected by changes to the device's time.
+    @discussion Counts time spent asleep, so deadlines on it pass while the device is suspended.
+        Uses @c mach_continuous_time, which needs iOS 10 or macOS 10.12. On older systems it falls
+        back to the wall clock. All times the library reads come from here, so a clock set with
+        @c setClock: replaces both the monotonic and the wall clock.
+ */
+@interface OIDMonotonicClock : NSObject
+
+/*! @fn init
+    @internal
+    @brief Unavailable. This class should not be initialized.
+ */
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn now
+    @brief The current time.
+ */
++ (OIDMonotonicTime)now;
+
+/*! @fn absoluteTime
+    @brief The current wall-clock time, in seconds since the reference date of @c NSDate.
+ */
++ (CFAbsoluteTime)absoluteTime;
+
+/*! @fn date
+    @brief The current wall-clock time as a date.
+ */
++ (NSDate *)date;
+
+/*! @fn clock
+    @brief The clock set with @c setClock:, or the system's clocks if none is set.
+ */
++ (id<OIDClock>)clock;
+
+/*! @fn setClock:
+    @brief Replaces the system's clocks, such as with a virtual clock to simulate hours of token
+        refreshes in moments.
+    @param clock The clock, or nil to restore the system's clocks. Retained, and not released once
+        replaced, as it is read without a lock.
+    @discussion Should be set before any token is received, as deadlines taken on one clock are
+        meaningless on another.
+ */
++ (void)setClock:(nullable id<OIDClock>)clock;
+
+/*! @fn timeAfterInterval:
+    @brief The time an interval from now.
+    @param interval The interval in seconds. Negative intervals are treated as zero.
+ */
++ (OIDMonotonicTime)timeAfterInterval:(NSTimeInterval)interval;
+
+/*! @fn intervalUntilTime:
+    @brief The seconds from now until a time, which are negative if it has passed.
+    @param time The time.
+ */
++ (NSTimeInterval)intervalUntilTime:(OIDMonotonicTime)time;
+
+/*! @fn durationForInterval:
+    @brief Converts an interval in seconds to nanoseconds.
+    @param interval The interval in seconds. Negative intervals are treated as zero.
+ */
++ (OIDMonotonicTime)durationForInterval:(NSTimeInterval)interval;
+
+@end
+
+NS_ASSUME_NONNULL_END
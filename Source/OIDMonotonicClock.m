@@ -0,0 +1,134 @@
+/*! @file OIDMonotonicClock.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDMonotonicClock.h"
+
+#import <mach/mach_time.h>
+
+#include <stdatomic.h>
+
+/*! @var kMaximumInterval
+    @brief The longest interval converted to nanoseconds, beyond which times saturate.
+ */
+static const NSTimeInterval kMaximumInterval = 100 * 365 * 24 * 60 * 60;
+
+/*! @var gClock
+    @brief The clock set with @c OIDMonotonicClock.setClock:, if any, retained and never released
+        so that it can be read without a lock.
+ */
+static _Atomic(void *) gClock;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @fn OIDSystemMonotonicTime
+    @brief Reads the system's monotonic clock.
+ */
+static OIDMonotonicTime OIDSystemMonotonicTime(void) {
+  static mach_timebase_info_data_t timebase;
+  static BOOL continuous;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    mach_timebase_info(&timebase);
+    continuous = (&mach_continuous_time != NULL);
+  });
+  if (!continuous) {
+    return (OIDMonotonicTime)(CFAbsoluteTimeGetCurrent() * NSEC_PER_SEC);
+  }
+  uint64_t ticks = mach_continuous_time();
+  // splits the conversion so the multiplication can't overflow
+  return ticks / timebase.denom * timebase.numer
+      + ticks % timebase.denom * timebase.numer / timebase.denom;
+}
+
+/*! @fn OIDInstalledClock
+    @brief The clock set with @c OIDMonotonicClock.setClock:, if any.
+ */
+static id<OIDClock> _Nullable OIDInstalledClock(void) {
+  // read on every freshness check, so a lock would serialize them
+  return (__bridge id<OIDClock>)atomic_load_explicit(&gClock, memory_order_acquire);
+}
+
+/*! @class OIDSystemClock
+    @brief The system's clocks, used unless another clock is set.
+ */
+@interface OIDSystemClock : NSObject <OIDClock>
+@end
+
+@implementation OIDSystemClock
+
+- (OIDMonotonicTime)now {
+  return OIDSystemMonotonicTime();
+}
+
+- (CFAbsoluteTime)absoluteTime {
+  return CFAbsoluteTimeGetCurrent();
+}
+
+@end
+
+@implementation OIDMonotonicClock
+
++ (OIDMonotonicTime)now {
+  // the system clock is read directly, sparing the common case a message send
+  id<OIDClock> clock = OIDInstalledClock();
+  return clock ? [clock now] : OIDSystemMonotonicTime();
+}
+
++ (CFAbsoluteTime)absoluteTime {
+  id<OIDClock> clock = OIDInstalledClock();
+  return clock ? [clock absoluteTime] : CFAbsoluteTimeGetCurrent();
+}
+
++ (NSDate *)date {
+  return [NSDate dateWithTimeIntervalSinceReferenceDate:[self absoluteTime]];
+}
+
++ (id<OIDClock>)clock {
+  static OIDSystemClock *systemClock;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    systemClock = [[OIDSystemClock alloc] init];
+  });
+  return OIDInstalledClock() ?: systemClock;
+}
+
++ (void)setClock:(nullable id<OIDClock>)clock {
+  // a replaced clock is never released, since a reader may have loaded it without retaining it yet
+  atomic_store_explicit(&gClock, (__bridge_retained void *)clock, memory_order_release);
+}
+
++ (OIDMonotonicTime)timeAfterInterval:(NSTimeInterval)interval {
+  return [self now] + [self durationForInterval:interval];
+}
+
++ (NSTimeInterval)intervalUntilTime:(OIDMonotonicTime)time {
+  OIDMonotonicTime now = [self now];
+  return time >= now ? (NSTimeInterval)(time - now) / NSEC_PER_SEC
+                     : -(NSTimeInterval)(now - time) / NSEC_PER_SEC;
+}
+
++ (OIDMonotonicTime)durationForInterval:(NSTimeInterval)interval {
+  if (!(interval > 0)) {
+    return 0;
+  }
+  return (OIDMonotonicTime)(MIN(interval, kMaximumInterval) * NSEC_PER_SEC);
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,70 @@
+/*! @file OIDRedirectURLMatcher.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDRedirectURLMatcher
+    @brief Matches URLs against a redirect URL by their scheme, user, password, host, port and
+        path, ignoring the query and fragment.
+    @discussion The redirect URL is standardized once, and its components kept as bytes. Incoming
+        URLs are then compared byte by byte in place, without creating any intermediate
+        \NSURL or string, unless their path has dot segments to remove first. Components are
+        compared as they are percent encoded.
+ */
+@interface OIDRedirectURLMatcher : NSObject
+
+/*! @property redirectURL
+    @brief The redirect URL matched against.
+ */
+@property(nonatomic, readonly) NSURL *redirectURL;
+
+/*! @property key
+    @brief The key of the redirect URL, which @c keyForURL: returns for every matching URL.
+ */
+@property(nonatomic, readonly) NSString *key;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithRedirectURL:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithRedirectURL:
+    @brief Designated initializer.
+    @param redirectURL The redirect URL to match against.
+ */
+- (instancetype)initWithRedirectURL:(NSURL *)redirectURL NS_DESIGNATED_INITIALIZER;
+
+/*! @fn matchesURL:
+    @brief Whether a URL is a redirect to @c redirectURL.
+    @param URL The incoming URL.
+ */
+- (BOOL)matchesURL:(NSURL *)URL;
+
+/*! @fn keyForURL:
+    @brief The key under which to look up the matcher of a URL.
+    @param URL The incoming URL.
+    @return A string which is equal for all URLs matching the same redirect URL.
+ */
++ (NSString *)keyForURL:(NSURL *)URL;
+
+@end
+
+NS_ASSUME_NONNULL_END
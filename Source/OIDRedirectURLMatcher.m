@@ -0,0 +1,214 @@
+/*! @file OIDRedirectURLMatcher.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDRedirectURLMatcher.h"
+
+#import "OIDDefines.h"
+
+enum {
+  /*! @brief The number of URL components compared.
+   */
+  kMatchedComponentCount = 6,
+
+  /*! @brief The length of URL up to which its bytes are read into a buffer on the stack.
+   */
+  kStackBufferLength = 512,
+};
+
+/*! @var kMatchedComponents
+    @brief The URL components compared, in key order.
+ */
+static const CFURLComponentType kMatchedComponents[kMatchedComponentCount] = {
+  kCFURLComponentScheme,
+  kCFURLComponentUser,
+  kCFURLComponentPassword,
+  kCFURLComponentHost,
+  kCFURLComponentPort,
+  kCFURLComponentPath,
+};
+
+/*! @struct OIDURLBytes
+    @brief The bytes of a URL, and the ranges of the compared components in them.
+ */
+typedef struct {
+  /*! @brief The bytes of short URLs.
+   */
+  UInt8 stackBuffer[kStackBufferLength];
+
+  /*! @brief The bytes of the URL, in @c stackBuffer or on the heap.
+   */
+  UInt8 *bytes;
+
+  /*! @brief The ranges of the compared components, with a length of 0 when they are absent.
+   */
+  CFRange ranges[kMatchedComponentCount];
+} OIDURLBytes;
+
+/*! @fn OIDPathHasDotSegments
+    @brief Whether a path has "." or ".." segments, which standardizing the URL would remove.
+ */
+static BOOL OIDPathHasDotSegments(const UInt8 *path, CFIndex length) {
+  for (CFIndex i = 0; i < length; i++) {
+    if (path[i] != '.' || (i > 0 && path[i - 1] != '/')) {
+      continue;
+    }
+    CFIndex end = (i + 1 < length && path[i + 1] == '.') ? i + 2 : i + 1;
+    if (end == length || path[end] == '/') {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+/*! @fn OIDURLBytesRead
+    @brief Reads the bytes of an absolute URL, and locates its compared components.
+    @return NO if the URL must be standardized first, in which case nothing needs to be freed.
+ */
+static BOOL OIDURLBytesRead(OIDURLBytes *URLBytes, NSURL *URL) {
+  if (URL.baseURL) {
+    return NO;
+  }
+  CFURLRef cfURL = (__bridge CFURLRef)URL;
+  CFIndex length = CFURLGetBytes(cfURL, NULL, 0);
+  URLBytes->bytes = length <= kStackBufferLength ? URLBytes->stackBuffer : malloc(length);
+  CFURLGetBytes(cfURL, URLBytes->bytes, length);
+  for (NSUInteger i = 0; i < kMatchedComponentCount; i++) {
+    CFRange range = CFURLGetByteRangeForComponent(cfURL, kMatchedComponents[i], NULL);
+    URLBytes->ranges[i] = range.location == kCFNotFound ? CFRangeMake(0, 0) : range;
+  }
+  CFRange path = URLBytes->ranges[kMatchedComponentCount - 1];
+  if (OIDPathHasDotSegments(URLBytes->bytes + path.location, path.length)) {
+    if (URLBytes->bytes != URLBytes->stackBuffer) {
+      free(URLBytes->bytes);
+    }
+    return NO;
+  }
+  return YES;
+}
+
+/*! @fn OIDURLBytesFree
+    @brief Frees the bytes read by @c OIDURLBytesRead, if they were on the heap.
+ */
+static void OIDURLBytesFree(OIDURLBytes *URLBytes) {
+  if (URLBytes->bytes != URLBytes->stackBuffer) {
+    free(URLBytes->bytes);
+  }
+}
+
+/*! @fn OIDURLBytesReadStandardizing
+    @brief Reads the bytes of a URL, standardizing it first only if needed.
+ */
+static void OIDURLBytesReadStandardizing(OIDURLBytes *URLBytes, NSURL *URL) {
+  if (!OIDURLBytesRead(URLBytes, URL)) {
+    NSURL *standardizedURL = [URL.absoluteURL standardizedURL];
+    if (!OIDURLBytesRead(URLBytes, standardizedURL)) {
+      // only a path like "a/.." standardizes to one that still has dot segments, so matches as is
+      URLBytes->bytes = URLBytes->stackBuffer;
+      memset(URLBytes->ranges, 0, sizeof(URLBytes->ranges));
+    }
+  }
+}
+
+/*! @fn OIDURLBytesKey
+    @brief The compared components of a URL, separated by newlines which they can't contain.
+ */
+static NSString *OIDURLBytesKey(const OIDURLBytes *URLBytes) {
+  NSMutableData *key = [NSMutableData data];
+  for (NSUInteger i = 0; i < kMatchedComponentCount; i++) {
+    if (i > 0) {
+      [key appendBytes:"\n" length:1];
+    }
+    [key appendBytes:URLBytes->bytes + URLBytes->ranges[i].location
+              length:URLBytes->ranges[i].length];
+  }
+  return [[NSString alloc] initWithData:key encoding:NSUTF8StringEncoding] ?: @"";
+}
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation OIDRedirectURLMatcher {
+  /*! @var _bytes
+      @brief The compared components of the standardized redirect URL, back to back.
+   */
+  NSData *_bytes;
+
+  /*! @var _ranges
+      @brief The range of each compared component in @c _bytes.
+   */
+  CFRange _ranges[kMatchedComponentCount];
+}
+
+- (nullable instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithRedirectURL:));
+
+- (instancetype)initWithRedirectURL:(NSURL *)redirectURL {
+  self = [super init];
+  if (self) {
+    _redirectURL = [redirectURL copy];
+
+    OIDURLBytes URLBytes;
+    OIDURLBytesReadStandardizing(&URLBytes, _redirectURL);
+    NSMutableData *bytes = [NSMutableData data];
+    for (NSUInteger i = 0; i < kMatchedComponentCount; i++) {
+      CFRange range = URLBytes.ranges[i];
+      _ranges[i] = CFRangeMake(bytes.length, range.length);
+      [bytes appendBytes:URLBytes.bytes + range.location length:range.length];
+    }
+    _bytes = [bytes copy];
+    _key = OIDURLBytesKey(&URLBytes);
+    OIDURLBytesFree(&URLBytes);
+  }
+  return self;
+}
+
+- (BOOL)matchesURL:(NSURL *)URL {
+  OIDURLBytes URLBytes;
+  OIDURLBytesReadStandardizing(&URLBytes, URL);
+  const UInt8 *expectedBytes = _bytes.bytes;
+  BOOL matches = YES;
+  // compares the path first, as it is the component most likely to differ
+  for (NSInteger i = kMatchedComponentCount - 1; matches && i >= 0; i--) {
+    CFRange range = URLBytes.ranges[i];
+    matches = range.length == _ranges[i].length
+        && memcmp(URLBytes.bytes + range.location,
+                  expectedBytes + _ranges[i].location,
+                  range.length) == 0;
+  }
+  OIDURLBytesFree(&URLBytes);
+  return matches;
+}
+
++ (NSString *)keyForURL:(NSURL *)URL {
+  OIDURLBytes URLBytes;
+  OIDURLBytesReadStandardizing(&URLBytes, URL);
+  NSString *key = OIDURLBytesKey(&URLBytes);
+  OIDURLBytesFree(&URLBytes);
+  return key;
+}
+
+#pragma mark - NSObject overrides
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, redirectURL: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _redirectURL];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
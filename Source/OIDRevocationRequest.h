@@ -0,0 +1,119 @@
+/*! @file OIDRevocationRequest.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+@class OIDServiceConfiguration;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @var OIDTokenTypeHintAccessToken
+    @brief The @c token_type_hint of an access token.
+    @see https://tools.ietf.org/html/rfc7009#section-2.1
+ */
+extern NSString *const OIDTokenTypeHintAccessToken;
+
+/*! @var OIDTokenTypeHintRefreshToken
+    @brief The @c token_type_hint of a refresh token.
+    @see https://tools.ietf.org/html/rfc7009#section-2.1
+ */
+extern NSString *const OIDTokenTypeHintRefreshToken;
+
+/*! @class OIDRevocationRequest
+    @brief Represents a token revocation request.
+    @see https://tools.ietf.org/html/rfc7009
+ */
+@interface OIDRevocationRequest : NSObject <NSCopying, NSSecureCoding>
+
+/*! @property revocationEndpoint
+    @brief The revocation endpoint URI.
+ */
+@property(nonatomic, readonly) NSURL *revocationEndpoint;
+
+/*! @property token
+    @brief The access or refresh token to revoke.
+    @remarks token
+ */
+@property(nonatomic, readonly) NSString *token;
+
+/*! @property tokenTypeHint
+    @brief The type of @c token, which may help the server find it.
+    @remarks token_type_hint
+    @see OIDTokenTypeHintAccessToken
+    @see OIDTokenTypeHintRefreshToken
+ */
+@property(nonatomic, readonly, nullable) NSString *tokenTypeHint;
+
+/*! @property clientID
+    @brief The client identifier.
+    @remarks client_id
+ */
+@property(nonatomic, readonly) NSString *clientID;
+
+/*! @property additionalParameters
+    @brief The client's additional revocation request parameters.
+ */
+@property(nonatomic, readonly, nullable) NSDictionary<NSString *, NSString *> *additionalParameters;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use
+        @c initWithRevocationEndpoint:token:tokenTypeHint:clientID:additionalParameters:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithConfiguration:token:tokenTypeHint:clientID:additionalParameters:
+    @brief Creates a request to the revocation endpoint of a discovered provider.
+    @param configuration The service's configuration.
+    @param token The access or refresh token to revoke.
+    @param tokenTypeHint The type of @c token, if known.
+    @param clientID The client identifier.
+    @param additionalParameters The client's additional revocation request parameters.
+    @return The request, or nil if the configuration's discovery document has no
+        @c revocation_endpoint.
+ */
+- (nullable instancetype)initWithConfiguration:(OIDServiceConfiguration *)configuration
+                                         token:(NSString *)token
+                                 tokenTypeHint:(nullable NSString *)tokenTypeHint
+                                      clientID:(NSString *)clientID
+    additionalParameters:(nullable NSDictionary<NSString *, NSString *> *)additionalParameters;
+
+/*! @fn initWithRevocationEndpoint:token:tokenTypeHint:clientID:additionalParameters:
+    @brief Designated initializer.
+    @param revocationEndpoint The revocation endpoint URI.
+    @param token The access or refresh token to revoke.
+    @param tokenTypeHint The type of @c token, if known.
+    @param clientID The client identifier.
+    @param additionalParameters The client's additional revocation request parameters.
+ */
+- (instancetype)initWithRevocationEndpoint:(NSURL *)revocationEndpoint
+                                     token:(NSString *)token
+                             tokenTypeHint:(nullable NSString *)tokenTypeHint
+                                  clientID:(NSString *)clientID
+    additionalParameters:(nullable NSDictionary<NSString *, NSString *> *)additionalParameters
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn URLRequest
+    @brief Constructs an @c NSURLRequest representing the revocation request.
+    @return An @c NSURLRequest representing the revocation request.
+ */
+- (NSURLRequest *)URLRequest;
+
+@end
+
+NS_ASSUME_NONNULL_END
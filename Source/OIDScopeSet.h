@@ -0,0 +1,95 @@
+/*! @file OIDScopeSet.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDScopeSet
+    @brief An immutable set of OAuth 2 scopes, for checking cheaply whether a grant covers the
+        scopes an operation needs.
+    @discussion Each distinct scope is interned once per process as a small integer atom, and a set
+        is a bitset of atoms. Testing for a scope is a single bit test once the scope is interned,
+        while subset tests, unions and equality take one machine word per 64 distinct scopes seen
+        by the process, rather than splitting and comparing strings. Only the first thousand or so
+        distinct scopes are interned, so that a process seeing ever new scopes doesn't grow the
+        table without bound, and sets hold any others as strings.
+    @see https://tools.ietf.org/html/rfc6749#section-3.3
+ */
+@interface OIDScopeSet : NSObject <NSCopying, NSSecureCoding>
+
+/*! @property count
+    @brief The number of scopes in the set.
+ */
+@property(nonatomic, readonly) NSUInteger count;
+
+/*! @property scopes
+    @brief The scopes in the set, sorted.
+ */
+@property(nonatomic, readonly) NSArray<NSString *> *scopes;
+
+/*! @property scopeString
+    @brief The sorted scopes as a space-delimited scope string.
+ */
+@property(nonatomic, readonly) NSString *scopeString;
+
+/*! @fn scopeSetWithString:
+    @brief Returns the set of scopes in a space-delimited scope string.
+    @param scopeString A scope string per the OAuth 2 spec, or nil for an empty set.
+ */
++ (instancetype)scopeSetWithString:(nullable NSString *)scopeString;
+
+/*! @fn scopeSetWithArray:
+    @brief Returns the set of scopes in an array.
+    @param scopes An array of scope strings.
+ */
++ (instancetype)scopeSetWithArray:(NSArray<NSString *> *)scopes;
+
+/*! @fn init
+    @brief Creates an empty scope set.
+ */
+- (instancetype)init;
+
+/*! @fn containsScope:
+    @brief Returns whether the set contains a scope.
+    @param scope A single scope.
+ */
+- (BOOL)containsScope:(NSString *)scope;
+
+/*! @fn containsScopeSet:
+    @brief Returns whether the set contains every scope of another set, such as whether a grant
+        covers the scopes an operation needs.
+    @param scopeSet The other set.
+ */
+- (BOOL)containsScopeSet:(OIDScopeSet *)scopeSet;
+
+/*! @fn scopeSetByAddingScopeSet:
+    @brief Returns the union of the set and another.
+    @param scopeSet The other set.
+ */
+- (OIDScopeSet *)scopeSetByAddingScopeSet:(OIDScopeSet *)scopeSet;
+
+/*! @fn isEqualToScopeSet:
+    @brief Returns whether the set has the same scopes as another, in any order.
+    @param scopeSet The other set.
+ */
+- (BOOL)isEqualToScopeSet:(OIDScopeSet *)scopeSet;
+
+@end
+
+NS_ASSUME_NONNULL_END
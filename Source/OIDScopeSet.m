@@ -0,0 +1,331 @@
+/*! @file OIDScopeSet.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDScopeSet.h"
+
+#include <pthread.h>
+
+/*! @var kScopeStringKey
+    @brief Key used to encode the set for @c NSSecureCoding, as atoms are only valid in the process
+        which interned them.
+ */
+static NSString *const kScopeStringKey = @"scope";
+
+/*! @var kBitsPerWord
+    @brief The number of atoms per word of a bitset.
+ */
+static const NSUInteger kBitsPerWord = 64;
+
+/*! @var kMaxAtomCount
+    @brief The most scopes interned per process, bounding the atom table and the size of bitsets
+        however many distinct scopes, such as per-resource ones, a process sees.
+ */
+static const NSUInteger kMaxAtomCount = 1024;
+
+/*! @var gAtomTableLock
+    @brief Guards @c gAtomsByScope and @c gScopesByAtom. Read-mostly, as scopes are only interned
+        the first time they are seen.
+ */
+static pthread_rwlock_t gAtomTableLock = PTHREAD_RWLOCK_INITIALIZER;
+
+/*! @var gAtomsByScope
+    @brief The atom of every scope interned so far. Access is guarded by @c gAtomTableLock.
+ */
+static NSMutableDictionary<NSString *, NSNumber *> *gAtomsByScope;
+
+/*! @var gScopesByAtom
+    @brief The scope of every atom, indexed by atom. Access is guarded by @c gAtomTableLock.
+ */
+static NSMutableArray<NSString *> *gScopesByAtom;
+
+/*! @fn OIDScopeSetInitializeAtomTable
+    @brief Creates the atom table, once.
+ */
+static void OIDScopeSetInitializeAtomTable(void) {
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    gAtomsByScope = [NSMutableDictionary dictionary];
+    gScopesByAtom = [NSMutableArray array];
+  });
+}
+
+NS_ASSUME_NONNULL_BEGIN
+
+@implementation OIDScopeSet {
+  /*! @var _words
+      @brief The bitset, with bit @c atom % 64 of word @c atom / 64 set for each scope in the set.
+          Has no trailing zero words, so that equal sets have the same words.
+   */
+  uint64_t *_words;
+
+  /*! @var _wordCount
+      @brief The number of words of @c _words.
+   */
+  NSUInteger _wordCount;
+
+  /*! @var _uninternedScopes
+      @brief The scopes of the set seen after the atom table filled up, which are never interned,
+          or nil if there are none.
+   */
+  NSSet<NSString *> *_uninternedScopes;
+
+  /*! @var _scopes
+      @brief The cached value of @c scopes, created on first use. Access is synchronized on
+          @c self.
+   */
+  NSArray<NSString *> *_scopes;
+}
+
++ (instancetype)scopeSetWithString:(nullable NSString *)scopeString {
+  if (!scopeString.length) {
+    return [[self alloc] init];
+  }
+  return [self scopeSetWithArray:[scopeString componentsSeparatedByString:@" "]];
+}
+
++ (instancetype)scopeSetWithArray:(NSArray<NSString *> *)scopes {
+  OIDScopeSetInitializeAtomTable();
+  NSUInteger atomCount = scopes.count;
+  NSUInteger *atoms = malloc(MAX(atomCount, 1) * sizeof(NSUInteger));
+  NSUInteger maxAtom = 0;
+  NSUInteger count = 0;
+  NSMutableArray<NSString *> *newScopes;
+  pthread_rwlock_rdlock(&gAtomTableLock);
+  for (NSString *scope in scopes) {
+    // tolerates the empty strings of repeated spaces, which servers sometimes send
+    if (!scope.length) {
+      continue;
+    }
+    NSNumber *atom = gAtomsByScope[scope];
+    if (!atom) {
+      newScopes = newScopes ?: [NSMutableArray array];
+      [newScopes addObject:scope];
+      continue;
+    }
+    atoms[count] = atom.unsignedIntegerValue;
+    maxAtom = MAX(maxAtom, atoms[count]);
+    count++;
+  }
+  pthread_rwlock_unlock(&gAtomTableLock);
+
+  NSMutableSet<NSString *> *uninternedScopes;
+  if (newScopes) {
+    pthread_rwlock_wrlock(&gAtomTableLock);
+    for (NSString *scope in newScopes) {
+      // another thread may have interned the scope in the meantime
+      NSNumber *atom = gAtomsByScope[scope];
+      if (!atom && gScopesByAtom.count < kMaxAtomCount) {
+        atom = @(gScopesByAtom.count);
+        NSString *internedScope = [scope copy];
+        gAtomsByScope[internedScope] = atom;
+        [gScopesByAtom addObject:internedScope];
+      }
+      if (!atom) {
+        uninternedScopes = uninternedScopes ?: [NSMutableSet set];
+        [uninternedScopes addObject:[scope copy]];
+        continue;
+      }
+      atoms[count] = atom.unsignedIntegerValue;
+      maxAtom = MAX(maxAtom, atoms[count]);
+      count++;
+    }
+    pthread_rwlock_unlock(&gAtomTableLock);
+  }
+
+  NSUInteger wordCount = count ? maxAtom / kBitsPerWord + 1 : 0;
+  uint64_t *words = calloc(MAX(wordCount, 1), sizeof(uint64_t));
+  for (NSUInteger i = 0; i < count; i++) {
+    words[atoms[i] / kBitsPerWord] |= (uint64_t)1 << (atoms[i] % kBitsPerWord);
+  }
+  free(atoms);
+  return [[self alloc] initWithWords:words
+                           wordCount:wordCount
+                    uninternedScopes:[uninternedScopes copy]];
+}
+
+- (instancetype)init {
+  return [self initWithWords:calloc(1, sizeof(uint64_t)) wordCount:0 uninternedScopes:nil];
+}
+
+/*! @fn initWithWords:wordCount:uninternedScopes:
+    @brief Designated initializer.
+    @param words A bitset of atoms allocated with @c malloc, which the set takes ownership of.
+    @param wordCount The number of words of @c words, with no trailing zero words.
+    @param uninternedScopes The scopes which aren't interned, or nil if there are none.
+ */
+- (instancetype)initWithWords:(uint64_t *)words
+                    wordCount:(NSUInteger)wordCount
+             uninternedScopes:(nullable NSSet<NSString *> *)uninternedScopes {
+  self = [super init];
+  if (self) {
+    _words = words;
+    _wordCount = wordCount;
+    _uninternedScopes = uninternedScopes.count ? uninternedScopes : nil;
+  }
+  return self;
+}
+
+- (void)dealloc {
+  free(_words);
+}
+
+- (NSUInteger)count {
+  NSUInteger count = 0;
+  for (NSUInteger i = 0; i < _wordCount; i++) {
+    count += __builtin_popcountll(_words[i]);
+  }
+  return count + _uninternedScopes.count;
+}
+
+- (NSArray<NSString *> *)scopes {
+  @synchronized(self) {
+    if (!_scopes) {
+      NSMutableArray<NSString *> *scopes = [NSMutableArray array];
+      pthread_rwlock_rdlock(&gAtomTableLock);
+      for (NSUInteger i = 0; i < _wordCount; i++) {
+        for (uint64_t word = _words[i]; word; word &= word - 1) {
+          [scopes addObject:gScopesByAtom[i * kBitsPerWord + __builtin_ctzll(word)]];
+        }
+      }
+      pthread_rwlock_unlock(&gAtomTableLock);
+      if (_uninternedScopes) {
+        [scopes addObjectsFromArray:_uninternedScopes.allObjects];
+      }
+      [scopes sortUsingSelector:@selector(compare:)];
+      _scopes = [scopes copy];
+    }
+    return _scopes;
+  }
+}
+
+- (NSString *)scopeString {
+  return [self.scopes componentsJoinedByString:@" "];
+}
+
+- (BOOL)containsScope:(NSString *)scope {
+  OIDScopeSetInitializeAtomTable();
+  // only looks the scope up, so that testing for scopes doesn't grow the table
+  pthread_rwlock_rdlock(&gAtomTableLock);
+  NSNumber *atom = gAtomsByScope[scope];
+  pthread_rwlock_unlock(&gAtomTableLock);
+  if (!atom) {
+    // a scope which was never interned is only in sets which hold it uninterned
+    return [_uninternedScopes containsObject:scope];
+  }
+  NSUInteger word = atom.unsignedIntegerValue / kBitsPerWord;
+  return word < _wordCount
+      && (_words[word] & ((uint64_t)1 << (atom.unsignedIntegerValue % kBitsPerWord)));
+}
+
+- (BOOL)containsScopeSet:(OIDScopeSet *)scopeSet {
+  if (scopeSet->_wordCount > _wordCount) {
+    return NO;
+  }
+  if (scopeSet->_uninternedScopes
+      && ![scopeSet->_uninternedScopes isSubsetOfSet:_uninternedScopes ?: [NSSet set]]) {
+    return NO;
+  }
+  for (NSUInteger i = 0; i < scopeSet->_wordCount; i++) {
+    if (scopeSet->_words[i] & ~_words[i]) {
+      return NO;
+    }
+  }
+  return YES;
+}
+
+- (OIDScopeSet *)scopeSetByAddingScopeSet:(OIDScopeSet *)scopeSet {
+  if ([self containsScopeSet:scopeSet]) {
+    return self;
+  }
+  if ([scopeSet containsScopeSet:self]) {
+    return scopeSet;
+  }
+  NSUInteger wordCount = MAX(_wordCount, scopeSet->_wordCount);
+  uint64_t *words = calloc(wordCount, sizeof(uint64_t));
+  for (NSUInteger i = 0; i < wordCount; i++) {
+    words[i] = (i < _wordCount ? _words[i] : 0)
+        | (i < scopeSet->_wordCount ? scopeSet->_words[i] : 0);
+  }
+  NSSet<NSString *> *uninternedScopes = _uninternedScopes ?: scopeSet->_uninternedScopes;
+  if (_uninternedScopes && scopeSet->_uninternedScopes) {
+    uninternedScopes = [_uninternedScopes setByAddingObjectsFromSet:scopeSet->_uninternedScopes];
+  }
+  return [[OIDScopeSet alloc] initWithWords:words
+                                  wordCount:wordCount
+                           uninternedScopes:uninternedScopes];
+}
+
+- (BOOL)isEqualToScopeSet:(OIDScopeSet *)scopeSet {
+  return _wordCount == scopeSet->_wordCount
+      && memcmp(_words, scopeSet->_words, _wordCount * sizeof(uint64_t)) == 0
+      && (_uninternedScopes == scopeSet->_uninternedScopes
+          || [_uninternedScopes isEqualToSet:scopeSet->_uninternedScopes]);
+}
+
+#pragma mark - NSObject overrides
+
+- (BOOL)isEqual:(id)object {
+  if (object == self) {
+    return YES;
+  }
+  return [object isKindOfClass:[OIDScopeSet class]] && [self isEqualToScopeSet:object];
+}
+
+- (NSUInteger)hash {
+  uint64_t hash = _wordCount;
+  for (NSUInteger i = 0; i < _wordCount; i++) {
+    hash = hash * 31 + _words[i];
+  }
+  return (NSUInteger)(hash * 31 + _uninternedScopes.count);
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, scopes: \"%@\">",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    self.scopeString];
+}
+
+#pragma mark - NSCopying
+
+- (instancetype)copyWithZone:(nullable NSZone *)zone {
+  // The documentation for NSCopying specifically advises us to return a reference to the original
+  // instance in the case where instances are immutable (as ours is):
+  // "Implement NSCopying by retaining the original instead of creating a new copy when the class
+  // and its contents are immutable."
+  return self;
+}
+
+#pragma mark - NSSecureCoding
+
++ (BOOL)supportsSecureCoding {
+  return YES;
+}
+
+- (nullable instancetype)initWithCoder:(NSCoder *)aDecoder {
+  NSString *scopeString = [aDecoder decodeObjectOfClass:[NSString class] forKey:kScopeStringKey];
+  return [[self class] scopeSetWithString:scopeString];
+}
+
+- (void)encodeWithCoder:(NSCoder *)aCoder {
+  [aCoder encodeObject:self.scopeString forKey:kScopeStringKey];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
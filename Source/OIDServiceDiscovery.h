@@ -86,6 +86,20 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, readonly, nullable) NSURL *registrationEndpoint;
 
+/*! @property revocationEndpoint
+    @brief OPTIONAL. URL of the authorization server's OAuth 2.0 revocation endpoint.
+    @remarks revocation_endpoint
+    @seealso https://tools.ietf.org/html/rfc7009
+ */
+@property(nonatomic, readonly, nullable) NSURL *revocationEndpoint;
+
+/*! @property introspectionEndpoint
+    @brief OPTIONAL. URL of the authorization server's OAuth 2.0 introspection endpoint.
+    @remarks introspection_endpoint
+    @seealso https://tools.ietf.org/html/rfc7662
+ */
+@property(nonatomic, readonly, nullable) NSURL *introspectionEndpoint;
+
 /*! @property scopesSupported
     @brief RECOMMENDED. JSON array containing a list of the OAuth 2.0 [RFC6749] scope values that
         this server supports. The server MUST support the openid scope value. Servers MAY choose not
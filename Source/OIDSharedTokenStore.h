@@ -0,0 +1,93 @@
+/*! @file OIDSharedTokenStore.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "OIDAuthorizationService.h"
+
+@class OIDTokenRequest;
+@class OIDTokenResponse;
+@protocol OIDCancellableRequest;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDSharedTokenStore
+    @brief Shares the tokens of one authorization between processes, such as an app and its
+        extensions, so that only one of them refreshes the tokens at a time and all use the result.
+    @discussion The tokens are published in a memory-mapped file, which should be in a location all
+        the processes can access, such as an app group container, and hold the tokens of a single
+        authorization. Readers never block: they copy the tokens optimistically and retry if a
+        writer was active, as told by a sequence number (a seqlock). Refreshes are serialized
+        across and within processes by a lease on the refresh token kept in the file, so a refresh
+        which waited for another uses its result rather than refreshing again with a refresh token
+        which may since have been rotated. The file is only locked, with @c flock, to claim or
+        release the lease and to publish tokens, never during the token request, as a suspended
+        process must not hold a lock on a file in a shared container.
+    @see OIDAuthState.sharedTokenStore
+ */
+@interface OIDSharedTokenStore : NSObject
+
+/*! @property fileURL
+    @brief The file the tokens are published in.
+ */
+@property(nonatomic, readonly) NSURL *fileURL;
+
+/*! @fn init
+    @internal
+    @brief Unavailable. Please use @c initWithFileURL:error:.
+ */
+- (nullable instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithFileURL:error:
+    @brief Designated initializer.
+    @param fileURL The file the tokens are published in, which is created if it doesn't exist.
+    @param error Set to an @c ::OIDErrorCodeSharedTokenStoreError if the file couldn't be opened
+        or mapped.
+    @return The store, or nil if the file couldn't be opened or mapped.
+ */
+- (nullable instancetype)initWithFileURL:(NSURL *)fileURL
+                                   error:(NSError **_Nullable)error NS_DESIGNATED_INITIALIZER;
+
+/*! @fn tokenResponseForRequest:newerThanTokenResponse:
+    @brief The published tokens, if they are fresh and newer than a process's own, without
+        blocking or touching the network.
+    @param request The refresh request the tokens stand in the response to.
+    @param tokenResponse The process's own tokens, if any.
+    @return A response with the published tokens, or nil if they are missing, about to expire, or
+        no newer than @c tokenResponse.
+ */
+- (nullable OIDTokenResponse *)tokenResponseForRequest:(OIDTokenRequest *)request
+                                newerThanTokenResponse:(nullable OIDTokenResponse *)tokenResponse;
+
+/*! @fn performTokenRefreshRequest:replacingTokenResponse:callback:
+    @brief Refreshes the tokens, unless another process published fresh ones first.
+    @param request The refresh request. Its refresh token is replaced by the published one if that
+        is newer.
+    @param tokenResponse The tokens being replaced, if any.
+    @param callback The method called with the refreshed or published tokens, or an error.
+    @discussion Waits for any refresh in progress in this or another process, for at most as long
+        as its lease lasts, then uses the tokens it published if they are fresh, and otherwise
+        performs the request and publishes the response.
+ */
+- (id<OIDCancellableRequest>)performTokenRefreshRequest:(OIDTokenRequest *)request
+                                 replacingTokenResponse:(nullable OIDTokenResponse *)tokenResponse
+                                               callback:(OIDTokenCallback)callback;
+
+@end
+
+NS_ASSUME_NONNULL_END
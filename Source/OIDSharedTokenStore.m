@@ -0,0 +1,761 @@
+/*! @file OIDSharedTokenStore.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDSharedTokenStore.h"
+
+#include <fcntl.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <sys/file.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#import "OIDDefines.h"
+#import "OIDError.h"
+#import "OIDErrorUtilities.h"
+#import "OIDExecutor.h"
+#import "OIDMonotonicClock.h"
+#import "OIDTokenRequest.h"
+#import "OIDTokenRequestScheduler.h"
+#import "OIDTokenResponse.h"
+
+/*! @brief The layout of the shared file.
+ */
+enum {
+  /*! @brief The size of the shared file, which bounds the total length of the tokens.
+   */
+  kSharedFileSize = 16384,
+
+  /*! @brief The number of token fields published.
+   */
+  kSharedFieldCount = 5,
+
+  /*! @brief How many times a reader retries while writers keep changing the tokens.
+   */
+  kMaxReadAttempts = 100,
+
+  /*! @brief How many times locking the file is tried before giving up.
+   */
+  kMaxLockAttempts = 200,
+
+  /*! @brief How long to wait between attempts to lock the file, in microseconds.
+   */
+  kLockRetryInterval = 5000,
+};
+
+/*! @var kSharedFieldKeys
+    @brief The token response parameters published, in the order of their lengths in the header.
+ */
+static NSString *const kSharedFieldKeys[kSharedFieldCount] = {
+  @"access_token", @"token_type", @"refresh_token", @"id_token", @"scope",
+};
+
+/*! @var kAccessTokenFieldIndex
+    @brief The index of the access token in @c kSharedFieldKeys.
+ */
+static const NSUInteger kAccessTokenFieldIndex = 0;
+
+/*! @var kRefreshTokenFieldIndex
+    @brief The index of the refresh token in @c kSharedFieldKeys.
+ */
+static const NSUInteger kRefreshTokenFieldIndex = 2;
+
+/*! @var kSharedFileMagic
+    @brief Identifies a shared file of this format.
+ */
+static const uint32_t kSharedFileMagic = 0x4F494454;
+
+/*! @var kSharedFileVersion
+    @brief The version of the format. Version 3 narrowed the sequence to 32 bits.
+ */
+static const uint32_t kSharedFileVersion = 3;
+
+/*! @var kFreshnessTolerance
+    @brief How long published access tokens must still be valid for to be used, in seconds.
+ */
+static const NSTimeInterval kFreshnessTolerance = 60;
+
+/*! @var kLeaseDuration
+    @brief How long a refresh may use the refresh token before others may claim it, in seconds.
+        Also the deadline of the refresh's token request, so that it can't outlive its lease.
+ */
+static const NSTimeInterval kLeaseDuration = 30;
+
+/*! @var kLeasePollInterval
+    @brief How often a refresh waiting on another's lease checks whether it has ended, in seconds.
+ */
+static const NSTimeInterval kLeasePollInterval = 0.05;
+
+/*! @var kExpiresInKey
+    @brief The token response parameter of the access token's lifetime.
+ */
+static NSString *const kExpiresInKey = @"expires_in";
+
+/*! @struct OIDSharedTokensHeader
+    @brief The start of the shared file, followed by the published fields' UTF-8 bytes.
+ */
+typedef struct {
+  /*! @brief @c kSharedFileMagic once tokens were published.
+   */
+  uint32_t magic;
+
+  /*! @brief @c kSharedFileVersion once tokens were published.
+   */
+  uint32_t version;
+
+  /*! @brief Odd while a writer is changing the tokens, and incremented before and after each
+          change. 32 bits wide, as only atomics as wide as an @c int are lock-free on every
+          architecture, and an atomic which takes a lock isn't atomic across processes.
+   */
+  _Atomic uint32_t sequence;
+
+  /*! @brief Unused, keeping the following fields aligned.
+   */
+  uint32_t reserved;
+
+  /*! @brief When the access token expires, as a @c CFAbsoluteTime, or 0 if it has no known expiry.
+   */
+  double expirationTime;
+
+  /*! @brief The refresh which claimed the refresh token, or 0 if none did. Only accessed with the
+          file locked.
+   */
+  uint64_t leaseOwner;
+
+  /*! @brief When the claim of @c leaseOwner lapses, as a @c CFAbsoluteTime. Only accessed with
+          the file locked.
+   */
+  double leaseExpirationTime;
+
+  /*! @brief The length of each field in bytes, in the order of @c kSharedFieldKeys.
+   */
+  uint32_t lengths[kSharedFieldCount];
+} OIDSharedTokensHeader;
+
+_Static_assert(ATOMIC_INT_LOCK_FREE == 2,
+               "The sequence of the shared file must be lock-free to be atomic across processes.");
+
+/*! @var kSharedDataCapacity
+    @brief The space for fields after the header.
+ */
+static const size_t kSharedDataCapacity = kSharedFileSize - sizeof(OIDSharedTokensHeader);
+
+/*! @fn OIDSharedTokensRead
+    @brief Copies the shared file without locking, retrying while a writer is active.
+    @param shared The mapped file.
+    @param snapshot Receives @c kSharedFileSize bytes.
+    @return NO if writers kept the tokens changing, or a writer died while changing them.
+ */
+static BOOL OIDSharedTokensRead(OIDSharedTokensHeader *shared, uint8_t *snapshot) {
+  for (NSUInteger attempt = 0; attempt < kMaxReadAttempts; attempt++) {
+    uint32_t before = atomic_load_explicit(&shared->sequence, memory_order_acquire);
+    if (before & 1) {
+      sched_yield();
+      continue;
+    }
+    memcpy(snapshot, (const void *)shared, kSharedFileSize);
+    atomic_thread_fence(memory_order_acquire);
+    uint32_t after = atomic_load_explicit(&shared->sequence, memory_order_relaxed);
+    if (before == after) {
+      return YES;
+    }
+  }
+  return NO;
+}
+
+/*! @fn OIDSharedTokensWrite
+    @brief Replaces the shared tokens. Must be called with the file locked.
+    @param shared The mapped file.
+    @param expirationTime When the access token expires, or 0.
+    @param fields The UTF-8 bytes of the fields, in the order of @c kSharedFieldKeys.
+ */
+static void OIDSharedTokensWrite(OIDSharedTokensHeader *shared,
+                                 double expirationTime,
+                                 NSArray<NSData *> *fields) {
+  uint32_t sequence = atomic_load_explicit(&shared->sequence, memory_order_relaxed);
+  // a writer which died mid-write left the sequence odd
+  sequence += (sequence & 1) ? 2 : 1;
+  atomic_store_explicit(&shared->sequence, sequence, memory_order_relaxed);
+  atomic_thread_fence(memory_order_release);
+
+  shared->magic = kSharedFileMagic;
+  shared->version = kSharedFileVersion;
+  shared->expirationTime = expirationTime;
+  uint8_t *data = (uint8_t *)shared + sizeof(OIDSharedTokensHeader);
+  for (NSUInteger i = 0; i < kSharedFieldCount; i++) {
+    NSData *field = fields[i];
+    shared->lengths[i] = (uint32_t)field.length;
+    memcpy(data, field.bytes, field.length);
+    data += field.length;
+  }
+
+  atomic_store_explicit(&shared->sequence, sequence + 1, memory_order_release);
+}
+
+/*! @fn OIDSharedTokensLeaseIsHeld
+    @brief Whether a refresh holds the lease on the refresh token. Must be called with the file
+        locked.
+    @param shared The mapped file.
+    @param now The current time, as a @c CFAbsoluteTime.
+    @return NO if the lease lapsed, or lapses further in the future than a lease can, such as one
+        left in a file of an earlier version.
+ */
+static BOOL OIDSharedTokensLeaseIsHeld(OIDSharedTokensHeader *shared, CFAbsoluteTime now) {
+  return shared->leaseOwner
+      && shared->leaseExpirationTime > now
+      && shared->leaseExpirationTime <= now + kLeaseDuration;
+}
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDSharedTokens
+    @brief A snapshot of the published tokens.
+ */
+@interface OIDSharedTokens : NSObject
+
+/*! @property parameters
+    @brief The published token response parameters, without @c expires_in.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, NSString *> *parameters;
+
+/*! @property expirationTime
+    @brief When the access token expires, as a @c CFAbsoluteTime, or 0 if it has no known expiry.
+ */
+@property(nonatomic, readonly) CFAbsoluteTime expirationTime;
+
+/*! @property accessToken
+    @brief The published access token.
+ */
+@property(nonatomic, readonly, nullable) NSString *accessToken;
+
+/*! @property refreshToken
+    @brief The published refresh token.
+ */
+@property(nonatomic, readonly, nullable) NSString *refreshToken;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithParameters:expirationTime:
+    @brief Designated initializer.
+ */
+- (instancetype)initWithParameters:(NSDictionary<NSString *, NSString *> *)parameters
+                    expirationTime:(CFAbsoluteTime)expirationTime NS_DESIGNATED_INITIALIZER;
+
+/*! @fn isNewerThanTokenResponse:
+    @brief Whether the tokens replaced those of a response: the access token differs and expires
+        later.
+ */
+- (BOOL)isNewerThanTokenResponse:(nullable OIDTokenResponse *)tokenResponse;
+
+/*! @fn isFresh
+    @brief Whether the access token is valid for longer than @c kFreshnessTolerance.
+ */
+- (BOOL)isFresh;
+
+@end
+
+@implementation OIDSharedTokens
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithParameters:expirationTime:));
+
+- (instancetype)initWithParameters:(NSDictionary<NSString *, NSString *> *)parameters
+                    expirationTime:(CFAbsoluteTime)expirationTime {
+  self = [super init];
+  if (self) {
+    _parameters = [parameters copy];
+    _expirationTime = expirationTime;
+  }
+  return self;
+}
+
+- (nullable NSString *)accessToken {
+  return _parameters[kSharedFieldKeys[kAccessTokenFieldIndex]];
+}
+
+- (nullable NSString *)refreshToken {
+  return _parameters[kSharedFieldKeys[kRefreshTokenFieldIndex]];
+}
+
+- (BOOL)isNewerThanTokenResponse:(nullable OIDTokenResponse *)tokenResponse {
+  if ([self.accessToken isEqualToString:tokenResponse.accessToken]) {
+    return NO;
+  }
+  NSDate *expirationDate = tokenResponse.accessTokenExpirationDate;
+  return !expirationDate || _expirationTime > expirationDate.timeIntervalSinceReferenceDate;
+}
+
+- (BOOL)isFresh {
+  return self.accessToken
+      && _expirationTime > [OIDMonotonicClock absoluteTime] + kFreshnessTolerance;
+}
+
+@end
+
+/*! @class OIDSharedTokenRefresh
+    @brief A refresh waiting on, or performed by, an @c OIDSharedTokenStore.
+ */
+@interface OIDSharedTokenRefresh : NSObject <OIDCancellableRequest>
+
+/*! @property cancelled
+    @brief Whether the refresh was cancelled.
+ */
+@property(atomic, readonly, getter=isCancelled) BOOL cancelled;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithCallback:
+    @brief Designated initializer.
+ */
+- (instancetype)initWithCallback:(OIDTokenCallback)callback NS_DESIGNATED_INITIALIZER;
+
+/*! @property cancelsIfNotSent
+    @brief Whether the refresh is to be cancelled unless its token request was already sent.
+ */
+@property(atomic, readonly) BOOL cancelsIfNotSent;
+
+/*! @fn setNetworkRequest:
+    @brief Sets the token request performed, which is cancelled with the refresh.
+ */
+- (void)setNetworkRequest:(id<OIDCancellableRequest>)networkRequest;
+
+/*! @fn finishWithResponse:error:
+    @brief Calls the callback, unless it was already called.
+ */
+- (void)finishWithResponse:(nullable OIDTokenResponse *)response error:(nullable NSError *)error;
+
+@end
+
+@implementation OIDSharedTokenRefresh {
+  /*! @var _callback
+      @brief The callback, until it is called (use @c self to synchronize access).
+   */
+  OIDTokenCallback _callback;
+
+  /*! @var _networkRequest
+      @brief The token request performed, if any.
+   */
+  id<OIDCancellableRequest> _networkRequest;
+
+  /*! @var _cancelsIfNotSent
+      @brief Whether @c cancelIfNotSent was called (use @c self to synchronize access).
+   */
+  BOOL _cancelsIfNotSent;
+}
+
+@synthesize cancelled = _cancelled;
+
+- (instancetype)init OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithCallback:));
+
+- (instancetype)initWithCallback:(OIDTokenCallback)callback {
+  self = [super init];
+  if (self) {
+    _callback = [callback copy];
+  }
+  return self;
+}
+
+- (void)setNetworkRequest:(id<OIDCancellableRequest>)networkRequest {
+  BOOL cancelled;
+  BOOL cancelsIfNotSent;
+  @synchronized(self) {
+    cancelled = _cancelled;
+    cancelsIfNotSent = _cancelsIfNotSent;
+    _networkRequest = networkRequest;
+  }
+  if (cancelled) {
+    [networkRequest cancel];
+  } else if (cancelsIfNotSent) {
+    [networkRequest cancelIfNotSent];
+  }
+}
+
+- (BOOL)cancelsIfNotSent {
+  @synchronized(self) {
+    return _cancelsIfNotSent;
+  }
+}
+
+- (void)cancelIfNotSent {
+  id<OIDCancellableRequest> networkRequest;
+  @synchronized(self) {
+    if (!_callback) {
+      return;
+    }
+    _cancelsIfNotSent = YES;
+    networkRequest = _networkRequest;
+  }
+  // a refresh waiting for the lease is cancelled when it next attempts to claim it
+  [networkRequest cancelIfNotSent];
+}
+
+- (void)finishWithResponse:(nullable OIDTokenResponse *)response error:(nullable NSError *)error {
+  OIDTokenCallback callback;
+  @synchronized(self) {
+    callback = _callback;
+    _callback = nil;
+    _networkRequest = nil;
+  }
+  if (callback) {
+    callback(response, error);
+  }
+}
+
+- (void)cancel {
+  OIDTokenCallback callback;
+  id<OIDCancellableRequest> networkRequest;
+  @synchronized(self) {
+    _cancelled = YES;
+    callback = _callback;
+    _callback = nil;
+    networkRequest = _networkRequest;
+    _networkRequest = nil;
+  }
+  [networkRequest cancel];
+  if (callback) {
+    NSError *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeRequestCanceled
+                                      underlyingError:nil
+                                          description:nil];
+    [[OIDAuthorizationService executor] performBlock:^() {
+      callback(nil, error);
+    }];
+  }
+}
+
+@end
+
+@implementation OIDSharedTokenStore {
+  /*! @var _fileDescriptor
+      @brief The open shared file, which refreshes lock.
+   */
+  int _fileDescriptor;
+
+  /*! @var _shared
+      @brief The mapped shared file.
+   */
+  OIDSharedTokensHeader *_shared;
+
+  /*! @var _queue
+      @brief The queue the file is locked on.
+   */
+  dispatch_queue_t _queue;
+}
+
+- (nullable instancetype)init
+    OID_UNAVAILABLE_USE_INITIALIZER(@selector(initWithFileURL:error:));
+
+- (nullable instancetype)initWithFileURL:(NSURL *)fileURL error:(NSError **_Nullable)error {
+  self = [super init];
+  if (!self) {
+    return nil;
+  }
+  _fileURL = [fileURL copy];
+  _fileDescriptor = open(fileURL.fileSystemRepresentation, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+  struct stat status;
+  BOOL mapped = _fileDescriptor >= 0
+      && fstat(_fileDescriptor, &status) == 0
+      && (status.st_size >= kSharedFileSize || ftruncate(_fileDescriptor, kSharedFileSize) == 0);
+  if (mapped) {
+    void *shared = mmap(NULL, kSharedFileSize, PROT_READ | PROT_WRITE, MAP_SHARED,
+                        _fileDescriptor, 0);
+    mapped = shared != MAP_FAILED;
+    _shared = mapped ? shared : NULL;
+  }
+  if (!mapped) {
+    NSError *POSIXError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+    if (_fileDescriptor >= 0) {
+      close(_fileDescriptor);
+    }
+    if (error) {
+      *error = [OIDErrorUtilities errorWithCode:OIDErrorCodeSharedTokenStoreError
+                                underlyingError:POSIXError
+                                    description:@"The shared token file couldn't be mapped."];
+    }
+    return nil;
+  }
+  _queue = dispatch_queue_create("net.openid.appauth.OIDSharedTokenStore", DISPATCH_QUEUE_SERIAL);
+  return self;
+}
+
+- (void)dealloc {
+  if (_shared) {
+    munmap(_shared, kSharedFileSize);
+    close(_fileDescriptor);
+  }
+}
+
+#pragma mark - Reading and writing
+
+/*! @fn sharedTokens
+    @brief Reads the published tokens without locking.
+    @return The tokens, or nil if none were published or they couldn't be read consistently.
+ */
+- (nullable OIDSharedTokens *)sharedTokens {
+  NSMutableData *snapshotData = [NSMutableData dataWithLength:kSharedFileSize];
+  uint8_t *snapshot = snapshotData.mutableBytes;
+  if (!OIDSharedTokensRead(_shared, snapshot)) {
+    return nil;
+  }
+  const OIDSharedTokensHeader *header = (const OIDSharedTokensHeader *)snapshot;
+  if (header->magic != kSharedFileMagic || header->version != kSharedFileVersion) {
+    return nil;
+  }
+
+  NSMutableDictionary<NSString *, NSString *> *parameters = [NSMutableDictionary dictionary];
+  size_t offset = sizeof(OIDSharedTokensHeader);
+  for (NSUInteger i = 0; i < kSharedFieldCount; i++) {
+    size_t length = header->lengths[i];
+    if (length > kSharedFileSize - offset) {
+      return nil;
+    }
+    if (length) {
+      NSString *value = [[NSString alloc] initWithBytes:snapshot + offset
+                                                 length:length
+                                               encoding:NSUTF8StringEncoding];
+      if (!value) {
+        return nil;
+      }
+      parameters[kSharedFieldKeys[i]] = value;
+    }
+    offset += length;
+  }
+  return [[OIDSharedTokens alloc] initWithParameters:parameters
+                                      expirationTime:header->expirationTime];
+}
+
+/*! @fn publishTokenResponse:refreshToken:
+    @brief Replaces the published tokens. Must be called with the file locked.
+    @param tokenResponse The response of a refresh.
+    @param refreshToken The refresh token to publish with it.
+    @return NO if the tokens are too long to publish.
+ */
+- (BOOL)publishTokenResponse:(OIDTokenResponse *)tokenResponse
+                refreshToken:(nullable NSString *)refreshToken {
+  NSString *values[kSharedFieldCount] = {
+    tokenResponse.accessToken,
+    tokenResponse.tokenType,
+    refreshToken,
+    tokenResponse.idToken,
+    tokenResponse.scope ?: tokenResponse.request.scope,
+  };
+  NSMutableArray<NSData *> *fields = [NSMutableArray arrayWithCapacity:kSharedFieldCount];
+  size_t length = 0;
+  for (NSUInteger i = 0; i < kSharedFieldCount; i++) {
+    NSData *field = [values[i] dataUsingEncoding:NSUTF8StringEncoding] ?: [NSData data];
+    [fields addObject:field];
+    length += field.length;
+  }
+  if (length > kSharedDataCapacity) {
+    return NO;
+  }
+  NSDate *expirationDate = tokenResponse.accessTokenExpirationDate;
+  OIDSharedTokensWrite(_shared, expirationDate.timeIntervalSinceReferenceDate, fields);
+  return YES;
+}
+
+/*! @fn tokenResponseWithSharedTokens:request:
+    @brief A response to a refresh request made of published tokens.
+ */
++ (nullable OIDTokenResponse *)tokenResponseWithSharedTokens:(OIDSharedTokens *)sharedTokens
+                                                     request:(OIDTokenRequest *)request {
+  NSMutableDictionary<NSString *, NSObject<NSCopying> *> *parameters =
+      [sharedTokens.parameters mutableCopy];
+  NSTimeInterval expiresIn = sharedTokens.expirationTime - [OIDMonotonicClock absoluteTime];
+  parameters[kExpiresInKey] = @((long long)expiresIn);
+  return [[OIDTokenResponse alloc] initWithRequest:request parameters:parameters];
+}
+
+- (nullable OIDTokenResponse *)tokenResponseForRequest:(OIDTokenRequest *)request
+                                newerThanTokenResponse:(nullable OIDTokenResponse *)tokenResponse {
+  OIDSharedTokens *sharedTokens = [self sharedTokens];
+  if (![sharedTokens isFresh] || ![sharedTokens isNewerThanTokenResponse:tokenResponse]) {
+    return nil;
+  }
+  return [[self class] tokenResponseWithSharedTokens:sharedTokens request:request];
+}
+
+#pragma mark - Refreshing
+
+/*! @fn lock
+    @brief Locks the file, which is only ever held briefly, to read or change the lease.
+    @discussion Doesn't block in @c flock, so that a process suspended while holding the lock
+        can't hold up the others for long.
+    @return An error if the file couldn't be locked.
+ */
+- (nullable NSError *)lock {
+  for (NSUInteger attempt = 0; attempt < kMaxLockAttempts; attempt++) {
+    if (flock(_fileDescriptor, LOCK_EX | LOCK_NB) == 0) {
+      return nil;
+    }
+    if (errno != EWOULDBLOCK && errno != EINTR) {
+      break;
+    }
+    usleep(kLockRetryInterval);
+  }
+  NSError *POSIXError = [NSError errorWithDomain:NSPOSIXErrorDomain code:errno userInfo:nil];
+  return [OIDErrorUtilities errorWithCode:OIDErrorCodeSharedTokenStoreError
+                          underlyingError:POSIXError
+                              description:@"The shared token file couldn't be locked."];
+}
+
+/*! @fn unlock
+    @brief Unlocks the file.
+ */
+- (void)unlock {
+  flock(_fileDescriptor, LOCK_UN);
+}
+
+- (id<OIDCancellableRequest>)performTokenRefreshRequest:(OIDTokenRequest *)request
+                                 replacingTokenResponse:(nullable OIDTokenResponse *)tokenResponse
+                                               callback:(OIDTokenCallback)callback {
+  OIDSharedTokenRefresh *refresh = [[OIDSharedTokenRefresh alloc] initWithCallback:callback];
+  dispatch_async(_queue, ^() {
+    [self attemptRefresh:refresh request:request replacingTokenResponse:tokenResponse];
+  });
+  return refresh;
+}
+
+/*! @fn attemptRefresh:request:replacingTokenResponse:
+    @brief Uses the published tokens if they are fresh, and otherwise claims the lease on the
+        refresh token and performs the request, or waits for the refresh holding the lease.
+    @discussion Called on @c _queue. The file is only locked to read and change the lease and the
+        tokens, never for the duration of the token request.
+ */
+- (void)attemptRefresh:(OIDSharedTokenRefresh *)refresh
+                   request:(OIDTokenRequest *)request
+    replacingTokenResponse:(nullable OIDTokenResponse *)tokenResponse {
+  if (refresh.isCancelled) {
+    return;
+  }
+  if (refresh.cancelsIfNotSent) {
+    [refresh cancel];
+    return;
+  }
+  NSError *lockError = [self lock];
+  if (lockError) {
+    [refresh finishWithResponse:nil error:lockError];
+    return;
+  }
+
+  // the refresh this one waited for, if any, may have published what it needs
+  OIDSharedTokens *sharedTokens = [self sharedTokens];
+  BOOL sharedTokensAreNewer = [sharedTokens isNewerThanTokenResponse:tokenResponse];
+  if (sharedTokensAreNewer && [sharedTokens isFresh]) {
+    [self unlock];
+    [refresh finishWithResponse:[[self class] tokenResponseWithSharedTokens:sharedTokens
+                                                                   request:request]
+                          error:nil];
+    return;
+  }
+
+  // another refresh, in this or another process, is using the refresh token
+  CFAbsoluteTime now = [OIDMonotonicClock absoluteTime];
+  if (OIDSharedTokensLeaseIsHeld(_shared, now)) {
+    [self unlock];
+    [[OIDAuthorizationService executor] performBlock:^() {
+      dispatch_async(self->_queue, ^() {
+        [self attemptRefresh:refresh request:request replacingTokenResponse:tokenResponse];
+      });
+    } afterDelay:kLeasePollInterval];
+    return;
+  }
+  uint64_t leaseOwner = 0;
+  while (!leaseOwner) {
+    leaseOwner = ((uint64_t)arc4random() << 32) | arc4random();
+  }
+  CFAbsoluteTime leaseExpirationTime = now + kLeaseDuration;
+  _shared->leaseOwner = leaseOwner;
+  _shared->leaseExpirationTime = leaseExpirationTime;
+  [self unlock];
+
+  // the published refresh token supersedes the caller's if it was rotated since
+  NSString *publishedRefreshToken = sharedTokens.refreshToken;
+  BOOL rotated = sharedTokensAreNewer && publishedRefreshToken
+      && ![publishedRefreshToken isEqualToString:request.refreshToken];
+  NSString *refreshToken = rotated ? publishedRefreshToken : request.refreshToken;
+  OIDTokenRequest *latestRequest = request;
+  if (rotated) {
+    latestRequest =
+        [[OIDTokenRequest alloc] initWithConfiguration:request.configuration
+                                             grantType:request.grantType
+                                     authorizationCode:nil
+                                           redirectURL:request.redirectURL
+                                              clientID:request.clientID
+                                                 scope:request.scope
+                                          refreshToken:refreshToken
+                                          codeVerifier:nil
+                                  additionalParameters:request.additionalParameters];
+  }
+  NSDate *deadline = [NSDate dateWithTimeIntervalSinceReferenceDate:leaseExpirationTime];
+  id<OIDCancellableRequest> networkRequest =
+      [OIDAuthorizationService performTokenRequest:latestRequest
+                                          priority:OIDTokenRequestPriorityForegroundRefresh
+                                          deadline:deadline
+                                          callback:^(OIDTokenResponse *_Nullable response,
+                                                     NSError *_Nullable error) {
+    dispatch_async(self->_queue, ^() {
+      [self finishRefresh:refresh
+                  request:request
+             refreshToken:refreshToken
+                  rotated:rotated
+               leaseOwner:leaseOwner
+                 response:response
+                    error:error];
+    });
+  }];
+  [refresh setNetworkRequest:networkRequest];
+}
+
+/*! @fn finishRefresh:request:refreshToken:rotated:leaseOwner:response:error:
+    @brief Publishes the response of a refresh and releases its lease, then calls back.
+    @discussion Called on @c _queue. A refresh whose lease lapsed may have been superseded by one
+        which claimed the lease after it, so it neither publishes nor releases the lease.
+ */
+- (void)finishRefresh:(OIDSharedTokenRefresh *)refresh
+              request:(OIDTokenRequest *)request
+         refreshToken:(nullable NSString *)refreshToken
+              rotated:(BOOL)rotated
+           leaseOwner:(uint64_t)leaseOwner
+             response:(nullable OIDTokenResponse *)response
+                error:(nullable NSError *)error {
+  // if the file can't be locked, the lease lapses on its own
+  NSError *lockError = [self lock];
+  if (!lockError) {
+    if (_shared->leaseOwner == leaseOwner) {
+      if (response) {
+        BOOL published =
+            [self publishTokenResponse:response refreshToken:response.refreshToken ?: refreshToken];
+        // hands the caller the rotated refresh token it didn't have, as published
+        if (published && rotated && !response.refreshToken) {
+          OIDSharedTokens *publishedTokens = [self sharedTokens];
+          response = publishedTokens
+              ? [[self class] tokenResponseWithSharedTokens:publishedTokens request:request]
+              : response;
+        }
+      }
+      _shared->leaseOwner = 0;
+      _shared->leaseExpirationTime = 0;
+    }
+    [self unlock];
+  }
+  [refresh finishWithResponse:response error:error];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
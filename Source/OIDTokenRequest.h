@@ -23,6 +23,7 @@
 #import "OIDGrantTypes.h"
 
 @class OIDAuthorizationResponse;
+@class OIDScopeSet;
 @class OIDServiceConfiguration;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -79,6 +80,11 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, readonly, nullable) NSString *scope;
 
+/*! @property scopeSet
+    @brief The scopes of @c scope, for cheap containment checks.
+ */
+@property(nonatomic, readonly, nullable) OIDScopeSet *scopeSet;
+
 /*! @property refreshToken
     @brief The refresh token, which can be used to obtain new access tokens using the same
         authorization grant.
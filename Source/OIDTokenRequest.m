@@ -19,6 +19,7 @@
 #import "OIDTokenRequest.h"
 
 #import "OIDDefines.h"
+#import "OIDScopeSet.h"
 #import "OIDScopeUtilities.h"
 #import "OIDServiceConfiguration.h"
 #import "OIDURLQueryComponent.h"
@@ -70,7 +71,13 @@ static NSString *const kCodeVerifierKey = @"code_verifier";
  */
 static NSString *const kAdditionalParametersKey = @"additionalParameters";
 
-@implementation OIDTokenRequest
+@implementation OIDTokenRequest {
+  /*! @var _scopeSet
+      @brief The cached value of @c scopeSet, created on first use, as most requests never need it.
+          Access is synchronized on @c self.
+   */
+  OIDScopeSet *_scopeSet;
+}
 
 - (instancetype)init
     OID_UNAVAILABLE_USE_INITIALIZER(
@@ -130,6 +137,18 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
   return self;
 }
 
+- (nullable OIDScopeSet *)scopeSet {
+  if (!_scope) {
+    return nil;
+  }
+  @synchronized(self) {
+    if (!_scopeSet) {
+      _scopeSet = [OIDScopeSet scopeSetWithString:_scope];
+    }
+    return _scopeSet;
+  }
+}
+
 #pragma mark - NSCopying
 
 - (instancetype)copyWithZone:(nullable NSZone *)zone {
@@ -0,0 +1,105 @@
+/*! @file OIDTokenRequestScheduler.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @brief The priority classes of requests made to a token endpoint.
+ */
+typedef NS_ENUM(NSInteger, OIDTokenRequestPriority) {
+  /*! @brief A speculative refresh which nobody is currently waiting on. Limited to a subset of the
+          concurrent requests allowed per endpoint, so that it can never starve other requests.
+   */
+  OIDTokenRequestPriorityBackgroundPrefetch = 0,
+
+  /*! @brief A refresh which an action is waiting on, such as the one performed by
+          @c OIDAuthState.withFreshTokensPerformAction:.
+   */
+  OIDTokenRequestPriorityForegroundRefresh = 1,
+
+  /*! @brief A request the user is actively waiting on, such as the authorization code exchange at
+          the end of an authorization flow. Started immediately, regardless of any limit.
+   */
+  OIDTokenRequestPriorityInteractive = 2,
+};
+
+/*! @typedef OIDTokenRequestSchedulerOperation
+    @brief Represents the type of block which performs a scheduled request.
+    @param completion Must be called exactly once when the request has completed or failed, to
+        release its slot and allow queued requests to start.
+ */
+typedef void (^OIDTokenRequestSchedulerOperation)(dispatch_block_t completion);
+
+/*! @class OIDTokenRequestScheduler
+    @brief Queues requests to token endpoints by priority, and limits how many are in flight to a
+        single endpoint at once.
+    @discussion Interactive requests are never queued. Foreground refreshes are started before any
+        queued background prefetch, and background prefetches only ever occupy
+        @c #maxConcurrentBackgroundRequestsPerEndpoint of the available slots, so a burst of
+        background refreshes can't hold up requests someone is waiting on.
+ */
+@interface OIDTokenRequestScheduler : NSObject
+
+/*! @property maxConcurrentRequestsPerEndpoint
+    @brief The maximum number of non-interactive requests in flight to a single endpoint.
+ */
+@property(nonatomic, readonly) NSUInteger maxConcurrentRequestsPerEndpoint;
+
+/*! @property maxConcurrentBackgroundRequestsPerEndpoint
+    @brief The maximum number of background prefetch requests in flight to a single endpoint.
+ */
+@property(nonatomic, readonly) NSUInteger maxConcurrentBackgroundRequestsPerEndpoint;
+
+/*! @fn sharedScheduler
+    @brief The scheduler used by @c OIDAuthorizationService for token requests.
+ */
++ (OIDTokenRequestScheduler *)sharedScheduler;
+
+/*! @fn init
+    @brief Creates a scheduler with the default limits.
+ */
+- (instancetype)init;
+
+/*! @fn initWithMaxConcurrentRequestsPerEndpoint:maxConcurrentBackgroundRequestsPerEndpoint:
+    @brief Designated initializer.
+    @param maxConcurrentRequestsPerEndpoint The maximum number of non-interactive requests in
+        flight to a single endpoint. A value of 0 is treated as 1.
+    @param maxConcurrentBackgroundRequestsPerEndpoint The maximum number of background prefetch
+        requests in flight to a single endpoint. Clamped to between 1 and
+        @c maxConcurrentRequestsPerEndpoint.
+ */
+- (instancetype)initWithMaxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+              maxConcurrentBackgroundRequestsPerEndpoint:
+                  (NSUInteger)maxConcurrentBackgroundRequestsPerEndpoint
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn scheduleOperationForEndpoint:priority:operation:
+    @brief Performs an operation against an endpoint once its priority and the endpoint's limits
+        allow it.
+    @param endpoint The endpoint the operation makes its request to.
+    @param priority The priority of the operation.
+    @param operation The block which performs the request. May be invoked synchronously.
+ */
+- (void)scheduleOperationForEndpoint:(NSURL *)endpoint
+                            priority:(OIDTokenRequestPriority)priority
+                           operation:(OIDTokenRequestSchedulerOperation)operation;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,216 @@
+/*! @file OIDTokenRequestScheduler.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDTokenRequestScheduler.h"
+
+/*! @var kDefaultMaxConcurrentRequestsPerEndpoint
+    @brief The default value of
+        @c OIDTokenRequestScheduler.maxConcurrentRequestsPerEndpoint.
+ */
+static const NSUInteger kDefaultMaxConcurrentRequestsPerEndpoint = 4;
+
+/*! @var kDefaultMaxConcurrentBackgroundRequestsPerEndpoint
+    @brief The default value of
+        @c OIDTokenRequestScheduler.maxConcurrentBackgroundRequestsPerEndpoint.
+ */
+static const NSUInteger kDefaultMaxConcurrentBackgroundRequestsPerEndpoint = 2;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDTokenEndpointQueue
+    @brief The queued operations and in-flight counts for a single endpoint.
+ */
+@interface OIDTokenEndpointQueue : NSObject
+
+/*! @property foregroundOperations
+    @brief Queued foreground refresh operations, in the order they were scheduled.
+ */
+@property(nonatomic, readonly) NSMutableArray<OIDTokenRequestSchedulerOperation> *
+    foregroundOperations;
+
+/*! @property backgroundOperations
+    @brief Queued background prefetch operations, in the order they were scheduled.
+ */
+@property(nonatomic, readonly) NSMutableArray<OIDTokenRequestSchedulerOperation> *
+    backgroundOperations;
+
+/*! @property inFlightCount
+    @brief The number of non-interactive operations started but not yet completed.
+ */
+@property(nonatomic) NSUInteger inFlightCount;
+
+/*! @property backgroundInFlightCount
+    @brief The number of background prefetch operations started but not yet completed.
+ */
+@property(nonatomic) NSUInteger backgroundInFlightCount;
+
+@end
+
+@implementation OIDTokenEndpointQueue
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _foregroundOperations = [NSMutableArray array];
+    _backgroundOperations = [NSMutableArray array];
+  }
+  return self;
+}
+
+@end
+
+@implementation OIDTokenRequestScheduler {
+  /*! @var _queues
+      @brief The state of each endpoint with queued or in-flight operations. Access is synchronized
+          on @c self.
+   */
+  NSMutableDictionary<NSURL *, OIDTokenEndpointQueue *> *_queues;
+}
+
++ (OIDTokenRequestScheduler *)sharedScheduler {
+  static OIDTokenRequestScheduler *sharedScheduler;
+  static dispatch_once_t onceToken;
+  dispatch_once(&onceToken, ^{
+    sharedScheduler = [[OIDTokenRequestScheduler alloc] init];
+  });
+  return sharedScheduler;
+}
+
+- (instancetype)init {
+  return [self initWithMaxConcurrentRequestsPerEndpoint:kDefaultMaxConcurrentRequestsPerEndpoint
+             maxConcurrentBackgroundRequestsPerEndpoint:
+                 kDefaultMaxConcurrentBackgroundRequestsPerEndpoint];
+}
+
+- (instancetype)initWithMaxConcurrentRequestsPerEndpoint:(NSUInteger)maxConcurrentRequestsPerEndpoint
+              maxConcurrentBackgroundRequestsPerEndpoint:
+                  (NSUInteger)maxConcurrentBackgroundRequestsPerEndpoint {
+  self = [super init];
+  if (self) {
+    _maxConcurrentRequestsPerEndpoint = MAX(maxConcurrentRequestsPerEndpoint, 1u);
+    _maxConcurrentBackgroundRequestsPerEndpoint =
+        MIN(MAX(maxConcurrentBackgroundRequestsPerEndpoint, 1u), _maxConcurrentRequestsPerEndpoint);
+    _queues = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (void)scheduleOperationForEndpoint:(NSURL *)endpoint
+                            priority:(OIDTokenRequestPriority)priority
+                           operation:(OIDTokenRequestSchedulerOperation)operation {
+  // interactive requests bypass the queue entirely, and don't count towards the limits
+  if (priority == OIDTokenRequestPriorityInteractive) {
+    operation(^{});
+    return;
+  }
+
+  NSArray<dispatch_block_t> *startBlocks;
+  @synchronized(self) {
+    OIDTokenEndpointQueue *queue = _queues[endpoint];
+    if (!queue) {
+      queue = [[OIDTokenEndpointQueue alloc] init];
+      _queues[endpoint] = queue;
+    }
+    if (priority == OIDTokenRequestPriorityBackgroundPrefetch) {
+      [queue.backgroundOperations addObject:operation];
+    } else {
+      [queue.foregroundOperations addObject:operation];
+    }
+    startBlocks = [self dequeueOperationsForEndpoint:endpoint];
+  }
+  for (dispatch_block_t startBlock in startBlocks) {
+    startBlock();
+  }
+}
+
+/*! @fn dequeueOperationsForEndpoint:
+    @brief Removes the queued operations for an endpoint which may start without exceeding its
+        limits, foreground refreshes first, and counts them as in flight.
+    @param endpoint The endpoint.
+    @return Blocks which start the dequeued operations. Must be invoked after leaving the
+        synchronized section.
+    @remarks Must be called while synchronized on @c self.
+ */
+- (NSArray<dispatch_block_t> *)dequeueOperationsForEndpoint:(NSURL *)endpoint {
+  OIDTokenEndpointQueue *queue = _queues[endpoint];
+  NSMutableArray<dispatch_block_t> *startBlocks = [NSMutableArray array];
+
+  while (queue.foregroundOperations.count
+         && queue.inFlightCount < _maxConcurrentRequestsPerEndpoint) {
+    OIDTokenRequestSchedulerOperation operation = queue.foregroundOperations.firstObject;
+    [queue.foregroundOperations removeObjectAtIndex:0];
+    queue.inFlightCount++;
+    [startBlocks addObject:[self startBlockForOperation:operation
+                                               endpoint:endpoint
+                                             background:NO]];
+  }
+  while (queue.backgroundOperations.count
+         && queue.inFlightCount < _maxConcurrentRequestsPerEndpoint
+         && queue.backgroundInFlightCount < _maxConcurrentBackgroundRequestsPerEndpoint) {
+    OIDTokenRequestSchedulerOperation operation = queue.backgroundOperations.firstObject;
+    [queue.backgroundOperations removeObjectAtIndex:0];
+    queue.inFlightCount++;
+    queue.backgroundInFlightCount++;
+    [startBlocks addObject:[self startBlockForOperation:operation
+                                               endpoint:endpoint
+                                             background:YES]];
+  }
+
+  // forgets about idle endpoints
+  if (!queue.inFlightCount) {
+    [_queues removeObjectForKey:endpoint];
+  }
+  return startBlocks;
+}
+
+/*! @fn startBlockForOperation:endpoint:background:
+    @brief Wraps an operation in a block which starts it with a completion that releases its slot.
+    @param operation The operation.
+    @param endpoint The endpoint of the operation.
+    @param background Whether the operation occupies a background prefetch slot.
+ */
+- (dispatch_block_t)startBlockForOperation:(OIDTokenRequestSchedulerOperation)operation
+                                  endpoint:(NSURL *)endpoint
+                                background:(BOOL)background {
+  return ^{
+    __block BOOL completed = NO;
+    operation(^{
+      NSArray<dispatch_block_t> *startBlocks;
+      @synchronized(self) {
+        NSAssert(!completed, @"Scheduled token request operation completed more than once.");
+        if (completed) {
+          return;
+        }
+        completed = YES;
+        OIDTokenEndpointQueue *queue = _queues[endpoint];
+        queue.inFlightCount--;
+        if (background) {
+          queue.backgroundInFlightCount--;
+        }
+        startBlocks = [self dequeueOperationsForEndpoint:endpoint];
+      }
+      for (dispatch_block_t startBlock in startBlocks) {
+        startBlock();
+      }
+    });
+  };
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -18,6 +18,9 @@
 
 #import <Foundation/Foundation.h>
 
+#import "OIDMonotonicClock.h"
+
+@class OIDIDToken;
 @class OIDTokenRequest;
 
 NS_ASSUME_NONNULL_BEGIN
@@ -50,6 +53,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, readonly, nullable) NSDate *accessTokenExpirationDate;
 
+/*! @property accessTokenExpirationDeadline
+    @brief When the access token expires on the @c OIDMonotonicClock, or 0 if it has no known
+        expiry.
+    @discussion Unlike @c accessTokenExpirationDate, isn't affected by changes to the device's
+        time, and is cheaper to compare against.
+    @remarks expires_in
+ */
+@property(nonatomic, readonly) OIDMonotonicTime accessTokenExpirationDeadline;
+
 /*! @property tokenType
     @brief Typically "Bearer" when present. Otherwise, another token_type value that the Client has
         negotiated with the Authorization Server.
@@ -68,6 +80,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property(nonatomic, readonly, nullable) NSString *idToken;
 
+/*! @property parsedIDToken
+    @brief The @c idToken, parsed when first accessed and cached.
+    @discussion Nil if there is no ID Token or it can't be parsed.
+ */
+@property(nonatomic, readonly, nullable) OIDIDToken *parsedIDToken;
+
 /*! @property refreshToken
     @brief The refresh token, which can be used to obtain new access tokens using the same
         authorization grant
@@ -20,6 +20,7 @@
 
 #import "OIDDefines.h"
 #import "OIDFieldMapping.h"
+#import "OIDIDToken.h"
 #import "OIDTokenRequest.h"
 
 /*! @var kRequestKey
@@ -36,6 +37,7 @@ static NSString *const kAccessTokenKey = @"access_token";
 /*! @var kExpiresInKey
     @brief The key for the @c accessTokenExpirationDate property in the incoming parameters and for
         @c NSSecureCoding.
+    @discussion Not in the @c fieldMap, as the expiry is derived from it lazily.
  */
 static NSString *const kExpiresInKey = @"expires_in";
 
@@ -66,7 +68,32 @@ static NSString *const kScopeKey = @"scope";
  */
 static NSString *const kAdditionalParametersKey = @"additionalParameters";
 
-@implementation OIDTokenResponse
+@implementation OIDTokenResponse {
+  /*! @var _parsedIDToken
+      @brief The cached value of @c parsedIDToken.
+   */
+  OIDIDToken *_parsedIDToken;
+
+  /*! @var _hasParsedIDToken
+      @brief Whether @c idToken was parsed, which it is at most once.
+   */
+  BOOL _hasParsedIDToken;
+
+  /*! @var _accessTokenIssueTime
+      @brief The wall-clock time @c expires_in was received at.
+   */
+  CFAbsoluteTime _accessTokenIssueTime;
+
+  /*! @var _accessTokenLifetime
+      @brief The @c expires_in of the access token.
+   */
+  NSTimeInterval _accessTokenLifetime;
+
+  /*! @var _accessTokenExpirationDate
+      @brief The cached value of @c accessTokenExpirationDate, created on first use.
+   */
+  NSDate *_accessTokenExpirationDate;
+}
 
 /*! @fn fieldMap
     @brief Returns a mapping of incoming parameters to instance variables.
@@ -79,16 +106,6 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
     fieldMap = [NSMutableDictionary dictionary];
     fieldMap[kAccessTokenKey] =
         [[OIDFieldMapping alloc] initWithName:@"_accessToken" type:[NSString class]];
-    fieldMap[kExpiresInKey] =
-        [[OIDFieldMapping alloc] initWithName:@"_accessTokenExpirationDate"
-                                         type:[NSDate class]
-                                   conversion:^id _Nullable(NSObject *_Nullable value) {
-          if (![value isKindOfClass:[NSNumber class]]) {
-            return value;
-          }
-          NSNumber *valueAsNumber = (NSNumber *)value;
-          return [NSDate dateWithTimeIntervalSinceNow:[valueAsNumber longLongValue]];
-        }];
     fieldMap[kTokenTypeKey] =
         [[OIDFieldMapping alloc] initWithName:@"_tokenType" type:[NSString class]];
     fieldMap[kIDTokenKey] =
@@ -115,6 +132,14 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
         [OIDFieldMapping remainingParametersWithMap:[[self class] fieldMap]
                                          parameters:parameters
                                            instance:self];
+    NSObject *expiresIn = additionalParameters[kExpiresInKey];
+    if ([expiresIn isKindOfClass:[NSNumber class]]) {
+      [self setAccessTokenLifetime:[(NSNumber *)expiresIn longLongValue]];
+      NSMutableDictionary<NSString *, NSObject<NSCopying> *> *remainingParameters =
+          [additionalParameters mutableCopy];
+      [remainingParameters removeObjectForKey:kExpiresInKey];
+      additionalParameters = remainingParameters;
+    }
     _additionalParameters = additionalParameters;
   }
   return self;
@@ -142,6 +167,12 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
   self = [self initWithRequest:request parameters:@{ }];
   if (self) {
     [OIDFieldMapping decodeWithCoder:aDecoder map:[[self class] fieldMap] instance:self];
+    // archives keep the expiry as a date, so they stay readable by and from earlier versions
+    NSDate *expirationDate = [aDecoder decodeObjectOfClass:[NSDate class] forKey:kExpiresInKey];
+    if (expirationDate) {
+      [self setAccessTokenLifetime:[expirationDate timeIntervalSinceDate:[OIDMonotonicClock date]]];
+      _accessTokenExpirationDate = expirationDate;
+    }
     _additionalParameters = [aDecoder decodeObjectOfClasses:[OIDFieldMapping JSONTypes]
                                                      forKey:kAdditionalParametersKey];
   }
@@ -150,6 +181,7 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
 
 - (void)encodeWithCoder:(NSCoder *)aCoder {
   [OIDFieldMapping encodeWithCoder:aCoder map:[[self class] fieldMap] instance:self];
+  [aCoder encodeObject:self.accessTokenExpirationDate forKey:kExpiresInKey];
   [aCoder encodeObject:_request forKey:kRequestKey];
   [aCoder encodeObject:_additionalParameters forKey:kAdditionalParametersKey];
 }
@@ -163,7 +195,7 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
                                     NSStringFromClass([self class]),
                                     self,
                                     _accessToken,
-                                    _accessTokenExpirationDate,
+                                    self.accessTokenExpirationDate,
                                     _tokenType,
                                     _idToken,
                                     _refreshToken,
@@ -174,4 +206,34 @@ static NSString *const kAdditionalParametersKey = @"additionalParameters";
 
 #pragma mark -
 
+/*! @fn setAccessTokenLifetime:
+    @brief Sets the expiry of the access token to a lifetime from now.
+    @param lifetime The @c expires_in of the access token.
+ */
+- (void)setAccessTokenLifetime:(NSTimeInterval)lifetime {
+  _accessTokenIssueTime = [OIDMonotonicClock absoluteTime];
+  _accessTokenLifetime = lifetime;
+  _accessTokenExpirationDeadline = [OIDMonotonicClock timeAfterInterval:lifetime];
+}
+
+- (nullable NSDate *)accessTokenExpirationDate {
+  @synchronized(self) {
+    if (!_accessTokenExpirationDate && _accessTokenExpirationDeadline) {
+      _accessTokenExpirationDate = [NSDate dateWithTimeIntervalSinceReferenceDate:
+                                       _accessTokenIssueTime + _accessTokenLifetime];
+    }
+    return _accessTokenExpirationDate;
+  }
+}
+
+- (nullable OIDIDToken *)parsedIDToken {
+  @synchronized(self) {
+    if (!_hasParsedIDToken) {
+      _parsedIDToken = _idToken ? [[OIDIDToken alloc] initWithTokenString:_idToken] : nil;
+      _hasParsedIDToken = YES;
+    }
+    return _parsedIDToken;
+  }
+}
+
 @end
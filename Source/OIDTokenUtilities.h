@@ -40,6 +40,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 + (NSString *)encodeBase64urlNoPadding:(NSData *)data;
 
+/*! @fn decodeBase64urlNoPadding:
+    @brief Decodes base64url-nopadding encoded data.
+    @param string The base64url encoded data, with or without padding.
+    @return The decoded data, or nil if @c string isn't valid base64url.
+ */
++ (nullable NSData *)decodeBase64urlNoPadding:(NSString *)string;
+
 /*! @fn randomURLSafeStringWithSize:
     @brief Generates a URL-safe string of random data.
     @param size The number of random bytes to encode. NB. the length of the output string will be
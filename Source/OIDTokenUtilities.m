@@ -32,6 +32,28 @@
   return base64string;
 }
 
++ (nullable NSData *)decodeBase64urlNoPadding:(NSString *)string {
+  NSMutableString *base64string = [string mutableCopy];
+  // converts base64url to base64
+  [base64string replaceOccurrencesOfString:@"-"
+                                withString:@"+"
+                                   options:0
+                                     range:NSMakeRange(0, base64string.length)];
+  [base64string replaceOccurrencesOfString:@"_"
+                                withString:@"/"
+                                   options:0
+                                     range:NSMakeRange(0, base64string.length)];
+  // restores padding
+  NSUInteger remainder = base64string.length % 4;
+  if (remainder == 1) {
+    return nil;
+  }
+  if (remainder) {
+    [base64string appendString:[@"==" substringToIndex:4 - remainder]];
+  }
+  return [[NSData alloc] initWithBase64EncodedString:base64string options:0];
+}
+
 + (nullable NSString *)randomURLSafeStringWithSize:(NSUInteger)size {
   NSMutableData *randomData = [NSMutableData dataWithLength:size];
   int result = SecRandomCopyBytes(kSecRandomDefault, randomData.length, randomData.mutableBytes);
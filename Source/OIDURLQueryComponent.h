@@ -52,6 +52,16 @@ extern BOOL gOIDURLQueryComponentForceIOS7Handling;
  */
 - (nullable instancetype)initWithURL:(NSURL *)URL;
 
+/*! @fn redirectParametersWithURL:
+    @brief Parses the parameters of a redirect, in a single pass over its query and fragment.
+    @param URL The redirect URL, with the response in its query, its fragment, or both.
+    @return The parameters, with the same representation as @c dictionaryValue. Where a parameter
+        is in both the query and the fragment, its values are combined.
+    @discussion Unlike @c initWithURL: followed by @c dictionaryValue, values are only percent
+        decoded when they contain escapes, and only repeated parameters are wrapped in arrays.
+ */
++ (NSDictionary<NSString *, NSObject<NSCopying> *> *)redirectParametersWithURL:(NSURL *)URL;
+
 /*! @fn valuesForParameter:
     @brief The value (or values) for a named parameter in the query.
     @param parameter The parameter name. Case sensitive.
@@ -91,6 +91,64 @@ static NSString *const kQueryStringParamAdditionalDisallowedCharacters = @"=&";
   return values;
 }
 
+/*! @fn addRedirectParametersFromString:toDictionary:
+    @brief Adds the parameters of a percent encoded query or fragment to a dictionary.
+    @param encodedString The percent encoded parameters, if any.
+    @param parameters The dictionary to add them to, in the representation of @c dictionaryValue.
+ */
++ (void)addRedirectParametersFromString:(nullable NSString *)encodedString
+                           toDictionary:(NSMutableDictionary<NSString *, id> *)parameters {
+  NSUInteger length = encodedString.length;
+  NSUInteger start = 0;
+  while (start < length) {
+    NSRange remaining = NSMakeRange(start, length - start);
+    NSUInteger end = [encodedString rangeOfString:@"&" options:NSLiteralSearch range:remaining]
+        .location;
+    if (end == NSNotFound) {
+      end = length;
+    }
+    NSRange part = NSMakeRange(start, end - start);
+    start = end + 1;
+    NSUInteger equals = [encodedString rangeOfString:@"=" options:NSLiteralSearch range:part]
+        .location;
+    if (equals == NSNotFound) {
+      continue;
+    }
+
+    NSString *name = [encodedString substringWithRange:NSMakeRange(part.location,
+                                                                   equals - part.location)];
+    NSString *value = [encodedString substringWithRange:NSMakeRange(equals + 1,
+                                                                    NSMaxRange(part) - equals - 1)];
+    // most values, such as codes and states, have nothing to decode
+    if ([name rangeOfString:@"%"].location != NSNotFound) {
+      name = name.stringByRemovingPercentEncoding;
+    }
+    if ([value rangeOfString:@"%"].location != NSNotFound) {
+      value = value.stringByRemovingPercentEncoding;
+    }
+    if (!name || !value) {
+      continue;
+    }
+
+    id existingValue = parameters[name];
+    if (!existingValue) {
+      parameters[name] = value;
+    } else if ([existingValue isKindOfClass:[NSMutableArray class]]) {
+      [existingValue addObject:value];
+    } else {
+      parameters[name] = [NSMutableArray arrayWithObjects:existingValue, value, nil];
+    }
+  }
+}
+
++ (NSDictionary<NSString *, NSObject<NSCopying> *> *)redirectParametersWithURL:(NSURL *)URL {
+  NSMutableDictionary<NSString *, id> *parameters = [NSMutableDictionary dictionary];
+  // NSURL returns both components still percent encoded
+  [self addRedirectParametersFromString:URL.query toDictionary:parameters];
+  [self addRedirectParametersFromString:URL.fragment toDictionary:parameters];
+  return parameters;
+}
+
 - (NSArray<NSString *> *)valuesForParameter:(NSString *)parameter {
   return _parameters[parameter];
 }
@@ -21,14 +21,47 @@
 #import "OIDAuthorizationResponseTests.h"
 #import "OIDTokenResponseTests.h"
 #import "Source/OIDAuthState.h"
+#import "Source/OIDAuthorizationRequest.h"
 #import "Source/OIDAuthorizationResponse.h"
+#import "Source/OIDAuthorizationService.h"
 #import "Source/OIDErrorUtilities.h"
+#import "Source/OIDTokenRequest.h"
 #import "Source/OIDTokenResponse.h"
 
+/*! @class OIDUnansweredURLProtocol
+    @brief A URL protocol which never answers, so that refreshes stay in progress without touching
+        the network until they are cancelled.
+ */
+@interface OIDUnansweredURLProtocol : NSURLProtocol
+@end
+
+@implementation OIDUnansweredURLProtocol
+
++ (BOOL)canInitWithRequest:(NSURLRequest *)request {
+  return YES;
+}
+
++ (NSURLRequest *)canonicalRequestForRequest:(NSURLRequest *)request {
+  return request;
+}
+
+- (void)startLoading {
+}
+
+- (void)stopLoading {
+}
+
+@end
+
 @interface OIDAuthStateTests () <OIDAuthStateChangeDelegate, OIDAuthStateErrorDelegate>
 @end
 
 @implementation OIDAuthStateTests {
+  /*! @var _URLSession
+      @brief The session requests are made with, which never answers them.
+   */
+  NSURLSession *_URLSession;
+
   /*! @var didChangeStateExpectation
       @brief An expectation for tests waiting on OIDAuthStateChangeDelegate.didChangeState:.
    */
@@ -109,11 +142,25 @@
   [_didEncounterAuthorizationErrorExpectation fulfill];
 }
 
+- (void)setUp {
+  [super setUp];
+  NSURLSessionConfiguration *configuration =
+      [NSURLSessionConfiguration ephemeralSessionConfiguration];
+  configuration.protocolClasses = @[ [OIDUnansweredURLProtocol class] ];
+  _URLSession = [NSURLSession sessionWithConfiguration:configuration];
+  [OIDAuthorizationService setURLSession:_URLSession];
+}
+
 - (void)tearDown {
   _didChangeStateExpectation = nil;
   _didEncounterAuthorizationErrorExpectation = nil;
   _didEncounterTransientErrorExpectation = nil;
 
+  [OIDAuthorizationService setURLSession:nil];
+  // fails the refreshes still in progress, which releases their slots in the scheduler
+  [_URLSession invalidateAndCancel];
+  _URLSession = nil;
+
   [super tearDown];
 }
 
@@ -340,6 +387,73 @@
   XCTAssertTrue(authState.isAuthorized, @"Should be in an authorized state now");
 }
 
+/*! @fn testCancelPendingAction
+    @brief Tests that abandoning an action waiting on a refresh calls it with a cancellation error.
+ */
+- (void)testCancelPendingAction {
+  OIDAuthState *authState = [[self class] testInstance];
+  [authState setNeedsTokenRefresh];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  id<OIDCancellableRequest> request =
+      [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                                NSString *_Nullable idToken,
+                                                NSError *_Nullable error) {
+    XCTAssertNil(accessToken);
+    XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeRequestCanceled);
+    [expectation fulfill];
+  }];
+  [request cancel];
+  // cancelling twice has no effect, the action is only called once
+  [request cancel];
+
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+/*! @fn testDeadline
+    @brief Tests that an action waiting on a refresh is called with a timeout error once its
+        deadline passes.
+ */
+- (void)testDeadline {
+  OIDAuthState *authState = [[self class] testInstance];
+  [authState setNeedsTokenRefresh];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(accessToken);
+    XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeTimeout);
+    [expectation fulfill];
+  } deadline:[NSDate date]];
+
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
+/*! @fn testInvalidationCallsPendingActions
+    @brief Tests that an authorization error calls the actions waiting on a refresh with that
+        error.
+ */
+- (void)testInvalidationCallsPendingActions {
+  OIDAuthState *authState = [[self class] testInstance];
+  [authState setNeedsTokenRefresh];
+
+  NSError *oauthError = [[self class] OAuthTokenInvalidGrantErrorWithUnderlyingError:nil];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(accessToken);
+    XCTAssertEqualObjects(error, oauthError);
+    [expectation fulfill];
+  }];
+  [authState updateWithAuthorizationError:oauthError];
+
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
 - (void)testSecureCoding {
   XCTAssert([OIDAuthState supportsSecureCoding]);
 
@@ -349,6 +463,7 @@
 
   XCTAssertEqualObjects(authStateCopy.refreshToken, authState.refreshToken);
   XCTAssertEqualObjects(authStateCopy.scope, authState.scope);
+  XCTAssertEqualObjects(authStateCopy.scopeSet, authState.scopeSet);
   XCTAssertEqualObjects(authStateCopy.lastAuthorizationResponse.authorizationCode,
                         authState.lastAuthorizationResponse.authorizationCode);
   XCTAssertEqualObjects(authStateCopy.lastTokenResponse.refreshToken,
@@ -369,5 +484,45 @@
   XCTAssertEqual(authStateCopy.authorizationError.code, authState.authorizationError.code);
 }
 
+/*! @fn testRestoreAuthStates
+    @brief Tests that archives are restored in order, with shared configurations, and that an
+        invalid archive fails on its own.
+ */
+- (void)testRestoreAuthStates {
+  NSMutableArray<NSData *> *archives = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 3; i++) {
+    [archives addObject:[NSKeyedArchiver archivedDataWithRootObject:[[self class] testInstance]]];
+  }
+  [archives insertObject:[@"not an archive" dataUsingEncoding:NSUTF8StringEncoding] atIndex:1];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Restore should complete."];
+  [OIDAuthState restoreAuthStatesFromArchives:archives
+                                   completion:^(NSArray *authStates, NSArray *errors) {
+    XCTAssert([NSThread isMainThread]);
+    XCTAssertEqual(authStates.count, archives.count);
+    XCTAssertEqual(errors.count, archives.count);
+
+    XCTAssertEqualObjects(authStates[1], [NSNull null]);
+    XCTAssertEqualObjects([errors[1] domain], OIDGeneralErrorDomain);
+    XCTAssertEqual([errors[1] code], OIDErrorCodeArchiveError);
+
+    OIDAuthState *first = authStates[0];
+    XCTAssertEqualObjects(errors[0], [NSNull null]);
+    XCTAssertEqualObjects(first.refreshToken, [[self class] testInstance].refreshToken);
+    OIDServiceConfiguration *configuration =
+        first.lastAuthorizationResponse.request.configuration;
+    XCTAssertNotNil(configuration);
+    XCTAssertEqual(first.lastTokenResponse.request.configuration, configuration);
+    for (NSUInteger i = 2; i < archives.count; i++) {
+      OIDAuthState *authState = authStates[i];
+      XCTAssertEqualObjects(errors[i], [NSNull null]);
+      XCTAssertEqual(authState.lastAuthorizationResponse.request.configuration, configuration);
+      XCTAssertEqual(authState.lastTokenResponse.request.configuration, configuration);
+    }
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+}
+
 @end
 
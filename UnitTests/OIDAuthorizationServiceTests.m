@@ -0,0 +1,1360 @@
+/*! @file OIDAuthorizationServiceTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "OIDLoopbackServer.h"
+#import "Source/OIDAuthState.h"
+#import "Source/OIDAuthStateAuthorizer.h"
+#import "Source/OIDAuthorizationFlowPresenter.h"
+#import "Source/OIDAuthorizationRequest.h"
+#import "Source/OIDAuthorizationResponse.h"
+#import "Source/OIDAuthorizationService.h"
+#import "Source/OIDClockSkewEstimator.h"
+#import "Source/OIDError.h"
+#import "Source/OIDResponseTypes.h"
+#import "Source/OIDRevocationRequest.h"
+#import "Source/OIDScopeSet.h"
+#import "Source/OIDServiceConfiguration.h"
+#import "Source/OIDTokenRequest.h"
+#import "Source/OIDTokenResponse.h"
+#import "Source/OIDTokenUtilities.h"
+
+/*! @var kTestTimeout
+    @brief How long to wait for a request to the loopback server.
+ */
+static const NSTimeInterval kTestTimeout = 5;
+
+/*! @class OIDTestAuthorizationFlowPresenter
+    @brief A presenter without UI, whose dismissal completes only when the test says so.
+ */
+@interface OIDTestAuthorizationFlowPresenter : NSObject <OIDAuthorizationFlowPresenter>
+
+/*! @property presentedURL
+    @brief The authorization request URL presented, if any.
+ */
+@property(nonatomic, strong, nullable) NSURL *presentedURL;
+
+/*! @property dismissalCompletion
+    @brief The completion of the dismissal in progress, if any.
+ */
+@property(nonatomic, copy, nullable) void (^dismissalCompletion)(void);
+
+@end
+
+@implementation OIDTestAuthorizationFlowPresenter
+
+- (void)presentAuthorizationURL:(NSURL *)URL session:(id<OIDAuthorizationFlowSession>)session {
+  _presentedURL = URL;
+}
+
+- (void)dismissWithCompletion:(void (^)(void))completion {
+  _dismissalCompletion = completion;
+}
+
+@end
+
+/*! @class OIDAuthorizationServiceTests
+    @brief Tests of the network paths of @c OIDAuthorizationService against an
+        @c OIDLoopbackServer.
+ */
+@interface OIDAuthorizationServiceTests : XCTestCase
+@end
+
+@implementation OIDAuthorizationServiceTests {
+  /*! @var _server
+      @brief The stand-in provider.
+   */
+  OIDLoopbackServer *_server;
+}
+
+- (void)setUp {
+  [super setUp];
+  _server = [[OIDLoopbackServer alloc] init];
+  XCTAssert([_server start]);
+}
+
+- (void)tearDown {
+  [_server stop];
+  _server = nil;
+  // the next test's server may reuse the port, and so the issuer
+  [[OIDClockSkewEstimator sharedEstimator] removeAllEstimates];
+  [super tearDown];
+}
+
+/*! @fn authorizationRequest
+    @brief An authorization request of the code flow for the loopback server.
+ */
+- (OIDAuthorizationRequest *)authorizationRequest {
+  OIDServiceConfiguration *configuration =
+      [[OIDServiceConfiguration alloc]
+          initWithAuthorizationEndpoint:[_server URLForPath:OIDLoopbackServerAuthorizationPath]
+                          tokenEndpoint:[_server URLForPath:OIDLoopbackServerTokenPath]];
+  return [[OIDAuthorizationRequest alloc] initWithConfiguration:configuration
+                                                       clientId:@"client"
+                                                         scopes:@[ @"openid" ]
+                                                    redirectURL:[NSURL URLWithString:@"app:/cb"]
+                                                   responseType:OIDResponseTypeCode
+                                           additionalParameters:nil];
+}
+
+/*! @fn authorizationResponseWithCode:
+    @brief An authorization response of the code flow for the loopback server.
+    @param code The authorization code.
+ */
+- (OIDAuthorizationResponse *)authorizationResponseWithCode:(NSString *)code {
+  OIDAuthorizationRequest *request = [self authorizationRequest];
+  return [[OIDAuthorizationResponse alloc] initWithRequest:request
+                                                parameters:@{ @"code" : code,
+                                                              @"state" : request.state }];
+}
+
+/*! @fn performTokenRequest:
+    @brief Performs a token request and waits for its result.
+    @param request The token request.
+    @param error Set to the error of the request, if any.
+ */
+- (nullable OIDTokenResponse *)performTokenRequest:(OIDTokenRequest *)request
+                                             error:(NSError **)error {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block OIDTokenResponse *tokenResponse;
+  __block NSError *tokenError;
+  [OIDAuthorizationService performTokenRequest:request
+                                      callback:^(OIDTokenResponse *_Nullable response,
+                                                 NSError *_Nullable callbackError) {
+    XCTAssert([NSThread isMainThread]);
+    tokenResponse = response;
+    tokenError = callbackError;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  *error = tokenError;
+  return tokenResponse;
+}
+
+/*! @fn testDiscovery
+    @brief Tests discovering the configuration of an issuer.
+ */
+- (void)testDiscovery {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [OIDAuthorizationService discoverServiceConfigurationForIssuer:_server.baseURL
+      completion:^(OIDServiceConfiguration *_Nullable configuration, NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(configuration.tokenEndpoint,
+                          [self->_server URLForPath:OIDLoopbackServerTokenPath]);
+    XCTAssertEqualObjects(configuration.authorizationEndpoint,
+                          [self->_server URLForPath:OIDLoopbackServerAuthorizationPath]);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+}
+
+/*! @fn testDiscoveryServerError
+    @brief Tests that a 5xx response to discovery is reported as a network error.
+ */
+- (void)testDiscoveryServerError {
+  [_server enqueueResponse:[OIDLoopbackResponse serverErrorResponseWithStatusCode:503]
+                   forPath:OIDLoopbackServerDiscoveryPath];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [OIDAuthorizationService discoverServiceConfigurationForIssuer:_server.baseURL
+      completion:^(OIDServiceConfiguration *_Nullable configuration, NSError *_Nullable error) {
+    XCTAssertNil(configuration);
+    XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeNetworkError);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+}
+
+/*! @fn testCodeExchange
+    @brief Tests exchanging an authorization code for tokens.
+ */
+- (void)testCodeExchange {
+  OIDTokenRequest *request = [[self authorizationResponseWithCode:@"code"] tokenExchangeRequest];
+  NSError *error;
+  OIDTokenResponse *tokenResponse = [self performTokenRequest:request error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(tokenResponse.accessToken, @"access-1");
+  XCTAssertEqualObjects(tokenResponse.refreshToken, @"refresh-1");
+
+  OIDLoopbackRequest *received = [_server requestsForPath:OIDLoopbackServerTokenPath].firstObject;
+  XCTAssertEqualObjects(received.method, @"POST");
+  XCTAssertEqualObjects(received.formParameters[@"grant_type"], @"authorization_code");
+  XCTAssertEqualObjects(received.formParameters[@"code"], @"code");
+  XCTAssertEqualObjects(received.formParameters[@"redirect_uri"], @"app:/cb");
+}
+
+/*! @fn testCodeExchangeInvalidGrant
+    @brief Tests that an HTTP 400 OAuth error is reported in the OAuth token error domain.
+ */
+- (void)testCodeExchangeInvalidGrant {
+  OIDTokenRequest *request =
+      [[self authorizationResponseWithCode:OIDLoopbackServerInvalidCode] tokenExchangeRequest];
+  NSError *error;
+  OIDTokenResponse *tokenResponse = [self performTokenRequest:request error:&error];
+  XCTAssertNil(tokenResponse);
+  XCTAssertEqualObjects(error.domain, OIDOAuthTokenErrorDomain);
+  XCTAssertEqual(error.code, OIDErrorCodeOAuthInvalidGrant);
+}
+
+/*! @fn testClockSkew
+    @brief Tests that the skew of the issuer's clock is estimated from its @c Date header.
+ */
+- (void)testClockSkew {
+  _server.clockOffset = 300;
+  OIDAuthorizationResponse *authorizationResponse = [self authorizationResponseWithCode:@"code"];
+  NSError *error;
+  OIDTokenResponse *tokenResponse =
+      [self performTokenRequest:[authorizationResponse tokenExchangeRequest] error:&error];
+  XCTAssertNotNil(tokenResponse);
+
+  OIDAuthState *authState =
+      [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                            tokenResponse:tokenResponse];
+  OIDClockSkewEstimate *estimate = authState.clockSkewEstimate;
+  XCTAssertNotNil(estimate);
+  // the header is truncated to the second, so the estimate is at most a second off, plus latency
+  XCTAssertEqualWithAccuracy(estimate.skew, 300, 2);
+  XCTAssertLessThanOrEqual(estimate.uncertainty, 1);
+
+  // the estimate is archived with the state
+  NSData *data = [NSKeyedArchiver archivedDataWithRootObject:authState];
+  [[OIDClockSkewEstimator sharedEstimator] removeAllEstimates];
+  OIDAuthState *unarchivedAuthState = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  XCTAssertEqualWithAccuracy(unarchivedAuthState.clockSkewEstimate.skew, estimate.skew, 0.001);
+  // but isn't shared with other states, as the archive may be stale
+  NSURL *issuer =
+      [OIDClockSkewEstimator issuerForConfiguration:authorizationResponse.request.configuration];
+  XCTAssertNil([[OIDClockSkewEstimator sharedEstimator] estimateForIssuer:issuer]);
+}
+
+/*! @fn IDTokenIssuedAt:
+    @brief An unsigned ID Token with an @c iat claim.
+    @param issuedAt When the token was issued.
+ */
++ (NSString *)IDTokenIssuedAt:(NSDate *)issuedAt {
+  NSData *header = [NSJSONSerialization dataWithJSONObject:@{ @"alg" : @"none" }
+                                                   options:0
+                                                     error:NULL];
+  NSData *claims = [NSJSONSerialization dataWithJSONObject:@{
+    @"iss" : @"https://www.example.com",
+    @"sub" : @"subject",
+    @"aud" : @"client",
+    @"iat" : @((long long)issuedAt.timeIntervalSince1970),
+    @"exp" : @((long long)issuedAt.timeIntervalSince1970 + 3600),
+  }
+                                                   options:0
+                                                     error:NULL];
+  return [NSString stringWithFormat:@"%@.%@.",
+                                    [OIDTokenUtilities encodeBase64urlNoPadding:header],
+                                    [OIDTokenUtilities encodeBase64urlNoPadding:claims]];
+}
+
+/*! @fn testAccessTokenIssueAge
+    @brief Tests that an access token's lifetime counts from the @c iat of an ID Token issued with
+        it, but not from that of the original ID Token returned again on refresh.
+ */
+- (void)testAccessTokenIssueAge {
+  // issued so long ago that an access token issued with it is about to expire
+  NSString *oldIDToken = [[self class] IDTokenIssuedAt:[NSDate dateWithTimeIntervalSinceNow:-3580]];
+  OIDAuthorizationResponse *authorizationResponse = [self authorizationResponseWithCode:@"code"];
+  OIDTokenResponse *tokenResponse =
+      [[OIDTokenResponse alloc] initWithRequest:[authorizationResponse tokenExchangeRequest]
+                                     parameters:@{
+        @"access_token" : @"access-0",
+        @"expires_in" : @3600,
+        @"token_type" : @"Bearer",
+        @"refresh_token" : @"refresh",
+        @"id_token" : oldIDToken,
+      }];
+  OIDAuthState *authState =
+      [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                            tokenResponse:tokenResponse];
+  OIDLoopbackResponse *(^refreshResponse)(NSString *, NSString *) =
+      ^(NSString *accessToken, NSString *idToken) {
+    return [OIDLoopbackResponse responseWithStatusCode:200 JSON:@{
+      @"access_token" : accessToken,
+      @"expires_in" : @3600,
+      @"token_type" : @"Bearer",
+      @"id_token" : idToken,
+    }];
+  };
+
+  // the refresh measures the issuer's clock, and returns the original ID Token
+  [_server enqueueResponse:refreshResponse(@"access-1", oldIDToken)
+                   forPath:OIDLoopbackServerTokenPath];
+  [authState setNeedsTokenRefresh];
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-1");
+  XCTAssertNotNil(authState.clockSkewEstimate);
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+
+  // a new ID Token which is that old means the access token is too
+  NSString *newIDToken = [[self class] IDTokenIssuedAt:[NSDate dateWithTimeIntervalSinceNow:-3590]];
+  [_server enqueueResponse:refreshResponse(@"access-2", newIDToken)
+                   forPath:OIDLoopbackServerTokenPath];
+  [authState setNeedsTokenRefresh];
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-2");
+  XCTAssertNotEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                           @"access-2");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 3u);
+}
+
+/*! @fn testTokenServerError
+    @brief Tests that a 5xx response from the token endpoint is reported as a server error.
+ */
+- (void)testTokenServerError {
+  [_server enqueueResponse:[OIDLoopbackResponse serverErrorResponseWithStatusCode:503]
+                   forPath:OIDLoopbackServerTokenPath];
+  OIDTokenRequest *request = [[self authorizationResponseWithCode:@"code"] tokenExchangeRequest];
+  NSError *error;
+  OIDTokenResponse *tokenResponse = [self performTokenRequest:request error:&error];
+  XCTAssertNil(tokenResponse);
+  XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+  XCTAssertEqual(error.code, OIDErrorCodeServerError);
+}
+
+/*! @fn testTokenDroppedConnection
+    @brief Tests that a connection closed without a response is reported as a network error.
+ */
+- (void)testTokenDroppedConnection {
+  // the session retries once on a reused connection, so both attempts are dropped
+  [_server enqueueResponse:[OIDLoopbackResponse droppedConnectionResponse]
+                   forPath:OIDLoopbackServerTokenPath];
+  [_server enqueueResponse:[OIDLoopbackResponse droppedConnectionResponse]
+                   forPath:OIDLoopbackServerTokenPath];
+  OIDTokenRequest *request = [[self authorizationResponseWithCode:@"code"] tokenExchangeRequest];
+  NSError *error;
+  OIDTokenResponse *tokenResponse = [self performTokenRequest:request error:&error];
+  XCTAssertNil(tokenResponse);
+  XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+  XCTAssertEqual(error.code, OIDErrorCodeNetworkError);
+}
+
+/*! @fn testTokenDeadline
+    @brief Tests that a slow token endpoint fails a request with a deadline as timed out.
+ */
+- (void)testTokenDeadline {
+  OIDLoopbackResponse *slowResponse =
+      [OIDLoopbackResponse responseWithStatusCode:200 JSON:@{ @"access_token" : @"slow" }];
+  slowResponse.delay = 2;
+  [_server enqueueResponse:slowResponse forPath:OIDLoopbackServerTokenPath];
+  OIDTokenRequest *request = [[self authorizationResponseWithCode:@"code"] tokenExchangeRequest];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [OIDAuthorizationService performTokenRequest:request
+                                      priority:OIDTokenRequestPriorityInteractive
+                                      deadline:[NSDate dateWithTimeIntervalSinceNow:0.2]
+                                      callback:^(OIDTokenResponse *_Nullable tokenResponse,
+                                                 NSError *_Nullable error) {
+    XCTAssertNil(tokenResponse);
+    XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeTimeout);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:1 handler:nil];
+}
+
+/*! @fn testTokenCancellationOnMainQueue
+    @brief Tests that cancelling a token request from another thread still calls back on the main
+        queue.
+ */
+- (void)testTokenCancellationOnMainQueue {
+  _server.latency = 0.5;
+  OIDTokenRequest *request = [[self authorizationResponseWithCode:@"code"] tokenExchangeRequest];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  id<OIDCancellableRequest> cancellableRequest =
+      [OIDAuthorizationService performTokenRequest:request
+                                          callback:^(OIDTokenResponse *_Nullable tokenResponse,
+                                                     NSError *_Nullable error) {
+    XCTAssert([NSThread isMainThread]);
+    XCTAssertNil(tokenResponse);
+    XCTAssertEqual(error.code, OIDErrorCodeRequestCanceled);
+    [expectation fulfill];
+  }];
+  dispatch_async(dispatch_get_global_queue(DISPATCH_QUEUE_PRIORITY_DEFAULT, 0), ^{
+    [cancellableRequest cancel];
+  });
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+}
+
+/*! @fn testFreshTokensRefresh
+    @brief Tests that an auth state with an expired access token refreshes it, and reports a
+        revoked refresh token as an authorization error.
+ */
+- (void)testFreshTokensRefresh {
+  OIDAuthorizationResponse *authorizationResponse = [self authorizationResponseWithCode:@"code"];
+  OIDTokenResponse *expiredTokenResponse =
+      [[OIDTokenResponse alloc] initWithRequest:[authorizationResponse tokenExchangeRequest]
+                                     parameters:@{
+        @"access_token" : @"expired",
+        @"expires_in" : @0,
+        @"token_type" : @"Bearer",
+        @"refresh_token" : @"refresh",
+      }];
+  OIDAuthState *authState =
+      [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                            tokenResponse:expiredTokenResponse];
+
+  XCTestExpectation *refreshed = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(accessToken, @"access-1");
+    [refreshed fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  OIDLoopbackRequest *received = [_server requestsForPath:OIDLoopbackServerTokenPath].firstObject;
+  XCTAssertEqualObjects(received.formParameters[@"grant_type"], @"refresh_token");
+  XCTAssertEqualObjects(received.formParameters[@"refresh_token"], @"refresh");
+
+  _server.revokedRefreshTokens = [NSSet setWithObject:@"refresh"];
+  [authState setNeedsTokenRefresh];
+  XCTestExpectation *revoked = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(accessToken);
+    XCTAssertEqualObjects(error.domain, OIDOAuthTokenErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeOAuthInvalidGrant);
+    [revoked fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+}
+
+/*! @fn codeExchangeRequestsWithCodes:
+    @brief Code exchange requests to the loopback server.
+    @param codes The authorization code of each request.
+ */
+- (NSArray<OIDTokenRequest *> *)codeExchangeRequestsWithCodes:(NSArray<NSString *> *)codes {
+  NSMutableArray<OIDTokenRequest *> *requests = [NSMutableArray array];
+  for (NSString *code in codes) {
+    [requests addObject:[[self authorizationResponseWithCode:code] tokenExchangeRequest]];
+  }
+  return requests;
+}
+
+/*! @fn testTokenBatch
+    @brief Tests that a batch calls back once per request on the main thread, with a mix of
+        successes and errors, and completes exactly once after every item.
+ */
+- (void)testTokenBatch {
+  NSArray<OIDTokenRequest *> *requests = [self codeExchangeRequestsWithCodes:@[
+    @"code-0", OIDLoopbackServerInvalidCode, @"code-2", OIDLoopbackServerInvalidCode, @"code-4"
+  ]];
+  NSMutableIndexSet *itemIndexes = [NSMutableIndexSet indexSet];
+  __block NSUInteger itemCount = 0;
+  __block NSUInteger completionCount = 0;
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Batch should complete."];
+  [OIDAuthorizationService performTokenRequests:requests
+                                   itemCallback:^(NSUInteger index,
+                                                  OIDTokenResponse *_Nullable tokenResponse,
+                                                  NSError *_Nullable error) {
+    XCTAssert([NSThread isMainThread]);
+    XCTAssertEqual(completionCount, 0u);
+    itemCount++;
+    [itemIndexes addIndex:index];
+    if (index % 2) {
+      XCTAssertNil(tokenResponse);
+      XCTAssertEqualObjects(error.domain, OIDOAuthTokenErrorDomain);
+      XCTAssertEqual(error.code, OIDErrorCodeOAuthInvalidGrant);
+    } else {
+      XCTAssertNil(error);
+      XCTAssertEqual(tokenResponse.request, requests[index]);
+    }
+  }
+                                     completion:^(NSArray *tokenResponses, NSArray *errors) {
+    XCTAssert([NSThread isMainThread]);
+    completionCount++;
+    XCTAssertEqual(itemCount, requests.count);
+    XCTAssertEqual(itemIndexes.count, requests.count);
+    XCTAssertEqual(tokenResponses.count, requests.count);
+    XCTAssertEqual(errors.count, requests.count);
+    for (NSUInteger i = 0; i < requests.count; i++) {
+      if (i % 2) {
+        XCTAssertEqualObjects(tokenResponses[i], [NSNull null]);
+        XCTAssertEqual([errors[i] code], OIDErrorCodeOAuthInvalidGrant);
+      } else {
+        XCTAssertEqual([tokenResponses[i] request], requests[i]);
+        XCTAssertEqualObjects(errors[i], [NSNull null]);
+      }
+    }
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  // a second completion would be delivered through the main queue too
+  [[NSRunLoop mainRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  XCTAssertEqual(completionCount, 1u);
+  XCTAssertEqual(itemCount, requests.count);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, requests.count);
+}
+
+/*! @fn testTokenBatchItemOrder
+    @brief Tests that with one request in flight at a time, the items are called back in the
+        order of the requests.
+ */
+- (void)testTokenBatchItemOrder {
+  NSArray<OIDTokenRequest *> *requests =
+      [self codeExchangeRequestsWithCodes:@[ @"code-0", @"code-1", @"code-2", @"code-3" ]];
+  _server.latency = 0.02;
+  NSMutableArray<NSNumber *> *itemIndexes = [NSMutableArray array];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Batch should complete."];
+  [OIDAuthorizationService performTokenRequests:requests
+               maxConcurrentRequestsPerEndpoint:1
+                                       priority:OIDTokenRequestPriorityForegroundRefresh
+                                   itemCallback:^(NSUInteger index,
+                                                  OIDTokenResponse *_Nullable tokenResponse,
+                                                  NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqual(tokenResponse.request, requests[index]);
+    [itemIndexes addObject:@(index)];
+  }
+                                     completion:^(NSArray *tokenResponses, NSArray *errors) {
+    XCTAssertEqualObjects(itemIndexes, (@[ @0, @1, @2, @3 ]));
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  NSArray<OIDLoopbackRequest *> *received = [_server requestsForPath:OIDLoopbackServerTokenPath];
+  XCTAssertEqual(received.count, requests.count);
+  for (NSUInteger i = 0; i < received.count; i++) {
+    XCTAssertEqualObjects(received[i].formParameters[@"code"],
+                          ([NSString stringWithFormat:@"code-%lu", (unsigned long)i]));
+  }
+}
+
+/*! @fn testEmptyTokenBatch
+    @brief Tests that an empty batch completes on the main thread without calling back any items.
+ */
+- (void)testEmptyTokenBatch {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Batch should complete."];
+  [OIDAuthorizationService performTokenRequests:@[]
+                                   itemCallback:^(NSUInteger index,
+                                                  OIDTokenResponse *_Nullable tokenResponse,
+                                                  NSError *_Nullable error) {
+    XCTFail(@"An empty batch has no items.");
+  }
+                                     completion:^(NSArray *tokenResponses, NSArray *errors) {
+    XCTAssert([NSThread isMainThread]);
+    XCTAssertEqualObjects(tokenResponses, @[]);
+    XCTAssertEqualObjects(errors, @[]);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 0u);
+}
+
+/*! @fn revocationRequestForToken:tokenTypeHint:
+    @brief A request to the loopback server's revocation endpoint.
+ */
+- (OIDRevocationRequest *)revocationRequestForToken:(NSString *)token
+                                      tokenTypeHint:(nullable NSString *)tokenTypeHint {
+  return [[OIDRevocationRequest alloc]
+      initWithRevocationEndpoint:[_server URLForPath:OIDLoopbackServerRevocationPath]
+                           token:token
+                   tokenTypeHint:tokenTypeHint
+                        clientID:@"client"
+            additionalParameters:nil];
+}
+
+/*! @fn testRevocation
+    @brief Tests revoking a refresh token, which the token endpoint then rejects.
+ */
+- (void)testRevocation {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  OIDRevocationRequest *request =
+      [self revocationRequestForToken:@"refresh" tokenTypeHint:OIDTokenTypeHintRefreshToken];
+  [OIDAuthorizationService performRevocationRequest:request callback:^(NSError *_Nullable error) {
+    XCTAssertNil(error);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  OIDLoopbackRequest *received =
+      [_server requestsForPath:OIDLoopbackServerRevocationPath].firstObject;
+  XCTAssertEqualObjects(received.method, @"POST");
+  XCTAssertEqualObjects(received.formParameters[@"token"], @"refresh");
+  XCTAssertEqualObjects(received.formParameters[@"token_type_hint"], @"refresh_token");
+  XCTAssertEqualObjects(received.formParameters[@"client_id"], @"client");
+  XCTAssert([_server.revokedRefreshTokens containsObject:@"refresh"]);
+}
+
+/*! @fn testRevocationUnsupportedTokenType
+    @brief Tests that an RFC 7009 error response is reported in the OAuth token error domain.
+ */
+- (void)testRevocationUnsupportedTokenType {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  OIDRevocationRequest *request = [self revocationRequestForToken:@"token" tokenTypeHint:@"saml"];
+  [OIDAuthorizationService performRevocationRequest:request callback:^(NSError *_Nullable error) {
+    XCTAssertEqualObjects(error.domain, OIDOAuthTokenErrorDomain);
+    XCTAssertEqualObjects(error.userInfo[OIDOAuthErrorResponseErrorKey][OIDOAuthErrorFieldError],
+                          @"unsupported_token_type");
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+}
+
+/*! @fn testRevocationFromDiscovery
+    @brief Tests that the revocation endpoint is taken from the discovery document.
+ */
+- (void)testRevocationFromDiscovery {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block OIDServiceConfiguration *configuration;
+  [OIDAuthorizationService
+      discoverServiceConfigurationForIssuer:_server.baseURL
+                                 completion:^(OIDServiceConfiguration *_Nullable discovered,
+                                              NSError *_Nullable error) {
+    configuration = discovered;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  OIDRevocationRequest *request =
+      [[OIDRevocationRequest alloc] initWithConfiguration:configuration
+                                                    token:@"token"
+                                            tokenTypeHint:nil
+                                                 clientID:@"client"
+                                     additionalParameters:nil];
+  XCTAssertEqualObjects(request.revocationEndpoint,
+                        [_server URLForPath:OIDLoopbackServerRevocationPath]);
+
+  OIDServiceConfiguration *manualConfiguration =
+      [[OIDServiceConfiguration alloc]
+          initWithAuthorizationEndpoint:[_server URLForPath:OIDLoopbackServerAuthorizationPath]
+                          tokenEndpoint:[_server URLForPath:OIDLoopbackServerTokenPath]];
+  XCTAssertNil([[OIDRevocationRequest alloc] initWithConfiguration:manualConfiguration
+                                                             token:@"token"
+                                                     tokenTypeHint:nil
+                                                          clientID:@"client"
+                                              additionalParameters:nil]);
+}
+
+/*! @fn testRevocationBatch
+    @brief Tests that a batch revokes every token, with no more requests in flight than the limit.
+ */
+- (void)testRevocationBatch {
+  static const NSUInteger kTokenCount = 12;
+  static const NSUInteger kMaxConcurrentRequests = 3;
+  _server.latency = 0.05;
+  NSMutableArray<OIDRevocationRequest *> *requests = [NSMutableArray array];
+  for (NSUInteger i = 0; i < kTokenCount; i++) {
+    NSString *token = [NSString stringWithFormat:@"refresh-%lu", (unsigned long)i];
+    [requests addObject:[self revocationRequestForToken:token
+                                          tokenTypeHint:OIDTokenTypeHintRefreshToken]];
+  }
+
+  // a request can only arrive once fewer than the limit are outstanding, and completions are
+  // counted before the batch starts the next request
+  __block NSUInteger arrivedCount = 0;
+  __block NSUInteger completedCount = 0;
+  __block NSUInteger maxInFlightCount = 0;
+  _server.faultInjector = ^OIDLoopbackResponse *_Nullable(OIDLoopbackRequest *request) {
+    @synchronized(self) {
+      arrivedCount++;
+      maxInFlightCount = MAX(maxInFlightCount, arrivedCount - completedCount);
+    }
+    return nil;
+  };
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Completion should be called."];
+  [OIDAuthorizationService performRevocationRequests:requests
+      maxConcurrentRequestsPerEndpoint:kMaxConcurrentRequests
+                          itemCallback:^(NSUInteger index, NSError *_Nullable error) {
+    @synchronized(self) {
+      completedCount++;
+    }
+  }
+                            completion:^(NSArray *errors) {
+    XCTAssertEqual(errors.count, kTokenCount);
+    for (id error in errors) {
+      XCTAssertEqualObjects(error, [NSNull null]);
+    }
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual(completedCount, kTokenCount);
+  XCTAssertLessThanOrEqual(maxInFlightCount, kMaxConcurrentRequests);
+  XCTAssertEqual(_server.revokedRefreshTokens.count, kTokenCount);
+}
+
+/*! @fn authStateWithAccessToken:
+    @brief An auth state for the loopback server's discovered configuration.
+    @param accessToken The current access token, which is fresh for an hour.
+ */
+- (OIDAuthState *)authStateWithAccessToken:(NSString *)accessToken {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block OIDServiceConfiguration *configuration;
+  [OIDAuthorizationService
+      discoverServiceConfigurationForIssuer:_server.baseURL
+                                 completion:^(OIDServiceConfiguration *_Nullable discovered,
+                                              NSError *_Nullable error) {
+    configuration = discovered;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  OIDAuthorizationRequest *request =
+      [[OIDAuthorizationRequest alloc] initWithConfiguration:configuration
+                                                    clientId:@"client"
+                                                      scopes:@[ @"openid" ]
+                                                 redirectURL:[NSURL URLWithString:@"app:/cb"]
+                                                responseType:OIDResponseTypeCode
+                                        additionalParameters:nil];
+  OIDAuthorizationResponse *authorizationResponse =
+      [[OIDAuthorizationResponse alloc] initWithRequest:request
+                                             parameters:@{ @"code" : @"code",
+                                                           @"state" : request.state }];
+  OIDTokenResponse *tokenResponse =
+      [[OIDTokenResponse alloc] initWithRequest:[authorizationResponse tokenExchangeRequest]
+                                     parameters:@{
+        @"access_token" : accessToken,
+        @"expires_in" : @3600,
+        @"token_type" : @"Bearer",
+        @"refresh_token" : @"refresh",
+      }];
+  return [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                               tokenResponse:tokenResponse];
+}
+
+/*! @fn userInfoOfAuthState:error:
+    @brief Performs a userinfo request and waits for its result.
+ */
+- (nullable NSDictionary<NSString *, id> *)userInfoOfAuthState:(OIDAuthState *)authState
+                                                         error:(NSError **)error {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block NSDictionary<NSString *, id> *userInfoClaims;
+  __block NSError *userInfoError;
+  [authState performUserInfoRequestWithCallback:^(NSDictionary<NSString *, id> *_Nullable claims,
+                                                  NSError *_Nullable callbackError) {
+    XCTAssert([NSThread isMainThread]);
+    userInfoClaims = claims;
+    userInfoError = callbackError;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  if (error) {
+    *error = userInfoError;
+  }
+  return userInfoClaims;
+}
+
+/*! @fn accessTokenOfAuthState:scopes:audience:
+    @brief Obtains a fresh access token, downscoped if @c scopes or @c audience is given, and
+        waits for it.
+ */
+- (nullable NSString *)accessTokenOfAuthState:(OIDAuthState *)authState
+                                       scopes:(nullable OIDScopeSet *)scopes
+                                     audience:(nullable NSString *)audience {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block NSString *token;
+  [authState withFreshTokensForScopes:scopes
+                             audience:audience
+                        performAction:^(NSString *_Nullable accessToken,
+                                        NSString *_Nullable idToken,
+                                        NSError *_Nullable error) {
+    XCTAssert([NSThread isMainThread]);
+    token = accessToken;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  return token;
+}
+
+/*! @fn testDownscopedTokens
+    @brief Tests that downscoped access tokens are cached per scope set and audience.
+ */
+- (void)testDownscopedTokens {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  OIDScopeSet *scopes = [OIDScopeSet scopeSetWithString:@"read"];
+  NSString *audienceA = @"https://a.example.com";
+  NSString *audienceB = @"https://b.example.com";
+
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:scopes audience:audienceA],
+                        @"access-1");
+  OIDLoopbackRequest *request = [_server requestsForPath:OIDLoopbackServerTokenPath].lastObject;
+  XCTAssertEqualObjects(request.formParameters[@"grant_type"], @"refresh_token");
+  XCTAssertEqualObjects(request.formParameters[@"scope"], @"read");
+  XCTAssertEqualObjects(request.formParameters[@"resource"], audienceA);
+
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:scopes audience:audienceA],
+                        @"access-1");
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:scopes audience:audienceB],
+                        @"access-2");
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:scopes audience:audienceA],
+                        @"access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 2u);
+
+  // concurrent requests for a new combination share a single refresh
+  OIDScopeSet *writeScopes = [OIDScopeSet scopeSetWithString:@"write"];
+  static const NSUInteger kWaiterCount = 5;
+  NSMutableArray<NSString *> *tokens = [NSMutableArray array];
+  for (NSUInteger i = 0; i < kWaiterCount; i++) {
+    XCTestExpectation *expectation =
+        [self expectationWithDescription:@"Callback should be called."];
+    [authState withFreshTokensForScopes:writeScopes
+                               audience:audienceA
+                          performAction:^(NSString *_Nullable accessToken,
+                                          NSString *_Nullable idToken,
+                                          NSError *_Nullable error) {
+      [tokens addObject:accessToken ?: @""];
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqualObjects([NSSet setWithArray:tokens], [NSSet setWithObject:@"access-3"]);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 3u);
+
+  // the state's own token is unaffected
+  XCTAssertEqualObjects(authState.lastTokenResponse.accessToken, @"access-100");
+}
+
+/*! @fn testDownscopedRefreshWaitsForRotation
+    @brief Tests that a downscoped refresh waits for the grant's own refresh in flight, and uses
+        the refresh token it rotated rather than the revoked one.
+ */
+- (void)testDownscopedRefreshWaitsForRotation {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  _server.rotatesRefreshTokens = YES;
+  _server.latency = 0.2;
+  [authState setNeedsTokenRefresh];
+
+  XCTestExpectation *refreshed = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(accessToken, @"access-1");
+    [refreshed fulfill];
+  }];
+  XCTestExpectation *downscoped = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensForScopes:[OIDScopeSet scopeSetWithString:@"read"]
+                             audience:nil
+                        performAction:^(NSString *_Nullable accessToken,
+                                        NSString *_Nullable idToken,
+                                        NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(accessToken, @"access-2");
+    [downscoped fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  NSArray<OIDLoopbackRequest *> *received = [_server requestsForPath:OIDLoopbackServerTokenPath];
+  XCTAssertEqual(received.count, 2u);
+  XCTAssertEqualObjects(received.firstObject.formParameters[@"refresh_token"], @"refresh");
+  XCTAssertEqualObjects(received.lastObject.formParameters[@"refresh_token"], @"refresh-1");
+  XCTAssertNil(authState.authorizationError);
+  XCTAssertEqualObjects(authState.refreshToken, @"refresh-2");
+}
+
+/*! @fn testAbandonedRefreshKeepsRotatedToken
+    @brief Tests that abandoning the only action waiting on a refresh which was already sent still
+        applies the refresh token it rotated, rather than keeping the revoked one.
+ */
+- (void)testAbandonedRefreshKeepsRotatedToken {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  _server.rotatesRefreshTokens = YES;
+  _server.latency = 0.3;
+  [authState setNeedsTokenRefresh];
+
+  XCTestExpectation *cancelled = [self expectationWithDescription:@"Action should be called."];
+  id<OIDCancellableRequest> pendingAction =
+      [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                                NSString *_Nullable idToken,
+                                                NSError *_Nullable error) {
+    XCTAssertNil(accessToken);
+    XCTAssertEqual(error.code, OIDErrorCodeRequestCanceled);
+    [cancelled fulfill];
+  }];
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(0.1 * NSEC_PER_SEC)),
+                 dispatch_get_main_queue(), ^{
+    [pendingAction cancel];
+  });
+  [self expectationForPredicate:[NSPredicate predicateWithFormat:@"refreshToken == 'refresh-1'"]
+            evaluatedWithObject:authState
+                        handler:nil];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  [authState setNeedsTokenRefresh];
+  XCTestExpectation *refreshed = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqualObjects(accessToken, @"access-2");
+    [refreshed fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  NSArray<OIDLoopbackRequest *> *received = [_server requestsForPath:OIDLoopbackServerTokenPath];
+  XCTAssertEqual(received.count, 2u);
+  XCTAssertEqualObjects(received.lastObject.formParameters[@"refresh_token"], @"refresh-1");
+  XCTAssertNil(authState.authorizationError);
+}
+
+/*! @fn testTimedOutRefreshKeepsRotatedToken
+    @brief Tests that an action whose deadline passes while its refresh is in flight gets a timeout
+        error, while the refresh still completes and applies the refresh token it rotated.
+ */
+- (void)testTimedOutRefreshKeepsRotatedToken {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  _server.rotatesRefreshTokens = YES;
+  _server.latency = 0.3;
+  [authState setNeedsTokenRefresh];
+
+  XCTestExpectation *timedOut = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertNil(accessToken);
+    XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeTimeout);
+    [timedOut fulfill];
+  } deadline:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  [self expectationForPredicate:[NSPredicate predicateWithFormat:@"refreshToken == 'refresh-1'"]
+            evaluatedWithObject:authState
+                        handler:nil];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+  XCTAssertEqualObjects(authState.accessToken, @"access-1");
+  XCTAssertNil(authState.authorizationError);
+}
+
+/*! @fn testSetNeedsTokenRefreshForAccessToken
+    @brief Tests that rejections of replaced access tokens don't force refreshes, and that forced
+        refreshes are rate limited.
+ */
+- (void)testSetNeedsTokenRefreshForAccessToken {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  XCTAssertFalse([authState setNeedsTokenRefreshForAccessToken:@"access-99"]);
+  XCTAssert([authState setNeedsTokenRefreshForAccessToken:@"access-100"]);
+  // a burst of rejections of the same token forces a single refresh
+  XCTAssert([authState setNeedsTokenRefreshForAccessToken:@"access-100"]);
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+
+  // a late rejection of the replaced token is ignored
+  XCTAssertFalse([authState setNeedsTokenRefreshForAccessToken:@"access-100"]);
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+
+  // the third forced refresh in quick succession is the last one allowed
+  XCTAssert([authState setNeedsTokenRefreshForAccessToken:@"access-1"]);
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-2");
+  XCTAssert([authState setNeedsTokenRefreshForAccessToken:@"access-2"]);
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-3");
+  XCTAssertFalse([authState setNeedsTokenRefreshForAccessToken:@"access-3"]);
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authState scopes:nil audience:nil],
+                        @"access-3");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 3u);
+}
+
+/*! @fn testUserInfo
+    @brief Tests that userinfo claims are cached, and revalidated with their @c ETag.
+ */
+- (void)testUserInfo {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  XCTAssertNil(authState.cachedUserInfoClaims);
+  NSError *error;
+  NSDictionary<NSString *, id> *claims = [self userInfoOfAuthState:authState error:&error];
+  XCTAssertNil(error);
+  XCTAssertEqualObjects(claims, _server.userInfoClaims);
+  XCTAssertEqualObjects(authState.cachedUserInfoClaims, _server.userInfoClaims);
+  OIDLoopbackRequest *first = [_server requestsForPath:OIDLoopbackServerUserInfoPath].firstObject;
+  XCTAssertEqualObjects(first.headers[@"authorization"], @"Bearer access-100");
+  XCTAssertNil(first.headers[@"if-none-match"]);
+
+  // unchanged claims are revalidated rather than downloaded again
+  XCTAssertEqualObjects([self userInfoOfAuthState:authState error:NULL], claims);
+  OIDLoopbackRequest *second = [_server requestsForPath:OIDLoopbackServerUserInfoPath].lastObject;
+  XCTAssertNotNil(second.headers[@"if-none-match"]);
+
+  _server.userInfoClaims = @{ @"sub" : @"248289761001", @"name" : @"Jane Roe" };
+  XCTAssertEqualObjects([self userInfoOfAuthState:authState error:NULL][@"name"], @"Jane Roe");
+  XCTAssertEqualObjects(authState.cachedUserInfoClaims[@"name"], @"Jane Roe");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerUserInfoPath].count, 3u);
+}
+
+/*! @fn testUserInfoRetriesUnauthorized
+    @brief Tests that a rejected access token is refreshed once, and a second rejection reported.
+ */
+- (void)testUserInfoRetriesUnauthorized {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"stale"];
+  NSError *error;
+  XCTAssertNotNil([self userInfoOfAuthState:authState error:&error]);
+  XCTAssertNil(error);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+  OIDLoopbackRequest *retry = [_server requestsForPath:OIDLoopbackServerUserInfoPath].lastObject;
+  XCTAssertEqualObjects(retry.headers[@"authorization"], @"Bearer access-1");
+
+  _server.revokedRefreshTokens = [NSSet setWithObjects:@"access-1", @"access-2", nil];
+  XCTAssertNil([self userInfoOfAuthState:authState error:&error]);
+  XCTAssertEqualObjects(error.domain, OIDResourceServerAuthorizationErrorDomain);
+  XCTAssertEqual(error.code, 401);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 2u);
+}
+
+/*! @fn testUserInfoUnauthorizedWhileRateLimited
+    @brief Tests that a rejected access token isn't retried while forced refreshes are rate
+        limited, since the retry would send the same token.
+ */
+- (void)testUserInfoUnauthorizedWhileRateLimited {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  // uses up the burst of forced refreshes
+  for (NSString *accessToken in @[ @"access-100", @"access-1", @"access-2" ]) {
+    XCTAssert([authState setNeedsTokenRefreshForAccessToken:accessToken]);
+    [self accessTokenOfAuthState:authState scopes:nil audience:nil];
+  }
+  _server.revokedRefreshTokens = [NSSet setWithObject:@"access-3"];
+
+  NSError *error;
+  XCTAssertNil([self userInfoOfAuthState:authState error:&error]);
+  XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+  XCTAssertEqual(error.code, OIDErrorCodeUserInfoError);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerUserInfoPath].count, 1u);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 3u);
+}
+
+/*! @fn testUserInfoCancellation
+    @brief Tests that a cancelled userinfo request calls back with a cancellation error.
+ */
+- (void)testUserInfoCancellation {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  _server.latency = 0.3;
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  OIDUserInfoCallback callback = ^(NSDictionary<NSString *, id> *_Nullable claims,
+                                   NSError *_Nullable error) {
+    XCTAssertNil(claims);
+    XCTAssertEqual(error.code, OIDErrorCodeRequestCanceled);
+    [expectation fulfill];
+  };
+  [[authState performUserInfoRequestWithCallback:callback] cancel];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertNil(authState.cachedUserInfoClaims);
+}
+
+/*! @fn testAuthorizerQueuesDuringRefresh
+    @brief Tests that requests authorized during a refresh are all signed with the new token.
+ */
+- (void)testAuthorizerQueuesDuringRefresh {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  [authState setNeedsTokenRefresh];
+  OIDAuthStateAuthorizer *authorizer = [[OIDAuthStateAuthorizer alloc] initWithAuthState:authState];
+  NSURL *URL = [_server URLForPath:OIDLoopbackServerUserInfoPath];
+  NSMutableArray<NSMutableURLRequest *> *requests = [NSMutableArray array];
+  for (NSUInteger batch = 0; batch < 3; batch++) {
+    NSArray<NSMutableURLRequest *> *batchRequests =
+        @[ [NSMutableURLRequest requestWithURL:URL], [NSMutableURLRequest requestWithURL:URL] ];
+    [requests addObjectsFromArray:batchRequests];
+    XCTestExpectation *expectation =
+        [self expectationWithDescription:@"Callback should be called."];
+    [authorizer authorizeRequests:batchRequests callback:^(NSError *_Nullable error) {
+      XCTAssertNil(error);
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  for (NSMutableURLRequest *request in requests) {
+    XCTAssertEqualObjects([request valueForHTTPHeaderField:@"Authorization"], @"Bearer access-1");
+  }
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+}
+
+/*! @fn testAuthorizerQueueLimit
+    @brief Tests that requests beyond the queue's capacity are rejected while waiting for a
+        refresh, and left unchanged, but that a fresh access token authorizes any number.
+ */
+- (void)testAuthorizerQueueLimit {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  OIDAuthStateAuthorizer *authorizer =
+      [[OIDAuthStateAuthorizer alloc] initWithAuthState:authState maxQueuedRequests:2];
+  NSURL *URL = [_server URLForPath:OIDLoopbackServerUserInfoPath];
+  NSMutableURLRequest *request = [NSMutableURLRequest requestWithURL:URL];
+  NSArray<NSMutableURLRequest *> *requests =
+      @[ request, [request mutableCopy], [request mutableCopy] ];
+  XCTestExpectation *authorized = [self expectationWithDescription:@"Callback should be called."];
+  [authorizer authorizeRequests:requests callback:^(NSError *_Nullable error) {
+    XCTAssertNil(error);
+    [authorized fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  for (NSMutableURLRequest *authorizedRequest in requests) {
+    XCTAssertEqualObjects([authorizedRequest valueForHTTPHeaderField:@"Authorization"],
+                          @"Bearer access-100");
+  }
+
+  _server.latency = 0.2;
+  [authState setNeedsTokenRefresh];
+  NSMutableURLRequest *queuedRequest = [NSMutableURLRequest requestWithURL:URL];
+  NSMutableURLRequest *rejectedRequest = [NSMutableURLRequest requestWithURL:URL];
+  XCTestExpectation *queued = [self expectationWithDescription:@"Callback should be called."];
+  [authorizer authorizeRequests:@[ queuedRequest, [queuedRequest mutableCopy] ]
+                       callback:^(NSError *_Nullable error) {
+    XCTAssertNil(error);
+    [queued fulfill];
+  }];
+  XCTestExpectation *rejected = [self expectationWithDescription:@"Callback should be called."];
+  [authorizer authorizeRequests:@[ rejectedRequest ] callback:^(NSError *_Nullable error) {
+    XCTAssertEqualObjects(error.domain, OIDGeneralErrorDomain);
+    XCTAssertEqual(error.code, OIDErrorCodeRequestQueueFull);
+    [rejected fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqualObjects([queuedRequest valueForHTTPHeaderField:@"Authorization"],
+                        @"Bearer access-1");
+  XCTAssertNil([rejectedRequest valueForHTTPHeaderField:@"Authorization"]);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+}
+
+/*! @fn testAuthorizerReplaysUnauthorized
+    @brief Tests that a request rejected with HTTP 401 is replayed once with a fresh token.
+ */
+- (void)testAuthorizerReplaysUnauthorized {
+  OIDAuthState *authState = [self authStateWithAccessToken:@"stale"];
+  OIDAuthStateAuthorizer *authorizer = [[OIDAuthStateAuthorizer alloc] initWithAuthState:authState];
+  NSURLRequest *request =
+      [NSURLRequest requestWithURL:[_server URLForPath:OIDLoopbackServerUserInfoPath]];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [authorizer performRequest:request
+                     session:[NSURLSession sharedSession]
+           completionHandler:^(NSData *_Nullable data,
+                               NSURLResponse *_Nullable response,
+                               NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqual(((NSHTTPURLResponse *)response).statusCode, 200);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  NSArray<OIDLoopbackRequest *> *received =
+      [_server requestsForPath:OIDLoopbackServerUserInfoPath];
+  XCTAssertEqual(received.count, 2u);
+  XCTAssertEqualObjects(received.firstObject.headers[@"authorization"], @"Bearer stale");
+  XCTAssertEqualObjects(received.lastObject.headers[@"authorization"], @"Bearer access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+}
+
+/*! @fn testUserInfoWithoutEndpoint
+    @brief Tests that a provider without a discovery document has no userinfo endpoint.
+ */
+- (void)testUserInfoWithoutEndpoint {
+  OIDAuthorizationResponse *authorizationResponse = [self authorizationResponseWithCode:@"code"];
+  OIDAuthState *authState =
+      [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse];
+  NSError *error;
+  XCTAssertNil([self userInfoOfAuthState:authState error:&error]);
+  XCTAssertEqual(error.code, OIDErrorCodeUserInfoError);
+}
+
+/*! @fn presentAuthorizationRequestPipeliningCodeExchange:
+    @brief Presents an authorization request with a test presenter, redirects back with a code, and
+        returns the number of token requests made before the presenter's UI was gone.
+ */
+- (NSUInteger)presentAuthorizationRequestPipeliningCodeExchange:(BOOL)pipelinesCodeExchange {
+  OIDAuthorizationRequest *request = [self authorizationRequest];
+  OIDTestAuthorizationFlowPresenter *presenter = [[OIDTestAuthorizationFlowPresenter alloc] init];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block OIDAuthState *authState;
+  id<OIDAuthorizationFlowSession> session =
+      [OIDAuthState authStateByPresentingAuthorizationRequest:request
+                                                    presenter:presenter
+                                        pipelinesCodeExchange:pipelinesCodeExchange
+                                                     callback:^(OIDAuthState *_Nullable result,
+                                                                NSError *_Nullable error) {
+    XCTAssert([NSThread isMainThread]);
+    XCTAssertNil(presenter.dismissalCompletion);
+    authState = result;
+    [expectation fulfill];
+  }];
+  XCTAssertNotNil(presenter.presentedURL);
+
+  NSString *redirect = [NSString stringWithFormat:@"app:/cb?code=code&state=%@", request.state];
+  XCTAssert([session resumeAuthorizationFlowWithURL:[NSURL URLWithString:redirect]]);
+  XCTAssertNotNil(presenter.dismissalCompletion);
+
+  // gives a pipelined exchange the time to complete while the UI is still up
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.5]];
+  NSUInteger tokenRequestCount = [_server requestsForPath:OIDLoopbackServerTokenPath].count;
+  void (^dismissalCompletion)(void) = presenter.dismissalCompletion;
+  presenter.dismissalCompletion = nil;
+  dismissalCompletion();
+
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqualObjects(authState.lastTokenResponse.accessToken, @"access-1");
+  XCTAssertEqualObjects(authState.refreshToken, @"refresh-1");
+  return tokenRequestCount;
+}
+
+/*! @fn testPipelinedCodeExchange
+    @brief Tests that a pipelined code exchange starts before the UI is dismissed.
+ */
+- (void)testPipelinedCodeExchange {
+  XCTAssertEqual([self presentAuthorizationRequestPipeliningCodeExchange:YES], 1u);
+}
+
+/*! @fn testPipelinedCodeExchangeFinishingLast
+    @brief Tests that a pipelined code exchange which completes after the UI is dismissed calls
+        back on the main queue.
+ */
+- (void)testPipelinedCodeExchangeFinishingLast {
+  _server.latency = 0.5;
+  OIDAuthorizationRequest *request = [self authorizationRequest];
+  OIDTestAuthorizationFlowPresenter *presenter = [[OIDTestAuthorizationFlowPresenter alloc] init];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block OIDAuthState *authState;
+  id<OIDAuthorizationFlowSession> session =
+      [OIDAuthState authStateByPresentingAuthorizationRequest:request
+                                                    presenter:presenter
+                                        pipelinesCodeExchange:YES
+                                                     callback:^(OIDAuthState *_Nullable result,
+                                                                NSError *_Nullable error) {
+    XCTAssert([NSThread isMainThread]);
+    authState = result;
+    [expectation fulfill];
+  }];
+  NSString *redirect = [NSString stringWithFormat:@"app:/cb?code=code&state=%@", request.state];
+  XCTAssert([session resumeAuthorizationFlowWithURL:[NSURL URLWithString:redirect]]);
+
+  // the UI is gone long before the slow token endpoint answers
+  void (^dismissalCompletion)(void) = presenter.dismissalCompletion;
+  presenter.dismissalCompletion = nil;
+  dismissalCompletion();
+  XCTAssertNil(authState);
+
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqualObjects(authState.lastTokenResponse.accessToken, @"access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+}
+
+/*! @fn testCodeExchangeAfterDismissal
+    @brief Tests that without pipelining, the code is only exchanged once the UI is dismissed.
+ */
+- (void)testCodeExchangeAfterDismissal {
+  XCTAssertEqual([self presentAuthorizationRequestPipeliningCodeExchange:NO], 0u);
+}
+
+/*! @fn testResumeAuthorizationFlowByState
+    @brief Tests that redirects are dispatched to the pending flow with the same state.
+ */
+- (void)testResumeAuthorizationFlowByState {
+  OIDAuthorizationRequest *firstRequest = [self authorizationRequest];
+  OIDAuthorizationRequest *secondRequest = [self authorizationRequest];
+  OIDTestAuthorizationFlowPresenter *presenter = [[OIDTestAuthorizationFlowPresenter alloc] init];
+  __block NSString *firstCode;
+  __block NSString *secondCode;
+  [OIDAuthorizationService
+      presentAuthorizationRequest:firstRequest
+                        presenter:presenter
+                 responseCallback:nil
+                         callback:^(OIDAuthorizationResponse *_Nullable response,
+                                    NSError *_Nullable error) {
+    firstCode = response.authorizationCode;
+  }];
+  [OIDAuthorizationService
+      presentAuthorizationRequest:secondRequest
+                        presenter:presenter
+                 responseCallback:nil
+                         callback:^(OIDAuthorizationResponse *_Nullable response,
+                                    NSError *_Nullable error) {
+    secondCode = response.authorizationCode;
+  }];
+  NSURL *(^redirect)(NSString *, NSString *, NSString *) =
+      ^(NSString *path, NSString *code, NSString *state) {
+    NSString *URL = [NSString stringWithFormat:@"app:%@?code=%@&state=%@", path, code, state];
+    return [NSURL URLWithString:URL];
+  };
+
+  NSURL *secondRedirect = redirect(@"/cb", @"two", secondRequest.state);
+  XCTAssert([OIDAuthorizationService resumeAuthorizationFlowWithURL:secondRedirect]);
+  presenter.dismissalCompletion();
+  XCTAssertNil(firstCode);
+  XCTAssertEqualObjects(secondCode, @"two");
+  // a finished flow no longer receives redirects
+  XCTAssertFalse([OIDAuthorizationService resumeAuthorizationFlowWithURL:secondRedirect]);
+
+  NSURL *otherRedirect = redirect(@"/other", @"one", firstRequest.state);
+  XCTAssertFalse([OIDAuthorizationService resumeAuthorizationFlowWithURL:otherRedirect]);
+  NSURL *firstRedirect = redirect(@"/cb", @"one", firstRequest.state);
+  XCTAssert([OIDAuthorizationService resumeAuthorizationFlowWithURL:firstRedirect]);
+  presenter.dismissalCompletion();
+  XCTAssertEqualObjects(firstCode, @"one");
+}
+
+/*! @fn testResumeAuthorizationFlowWithoutState
+    @brief Tests that a redirect without a state is dispatched to the only pending flow for its
+        redirect URL, and that a flow only ever calls back once.
+ */
+- (void)testResumeAuthorizationFlowWithoutState {
+  OIDTestAuthorizationFlowPresenter *presenter = [[OIDTestAuthorizationFlowPresenter alloc] init];
+  __block NSUInteger callbackCount = 0;
+  __block NSError *flowError;
+  id<OIDAuthorizationFlowSession> session =
+      [OIDAuthorizationService
+          presentAuthorizationRequest:[self authorizationRequest]
+                            presenter:presenter
+                     responseCallback:nil
+                             callback:^(OIDAuthorizationResponse *_Nullable response,
+                                        NSError *_Nullable error) {
+    XCTAssertNil(response);
+    flowError = error;
+    callbackCount++;
+  }];
+  NSURL *redirect = [NSURL URLWithString:@"app:/cb?error=access_denied"];
+  XCTAssert([OIDAuthorizationService resumeAuthorizationFlowWithURL:redirect]);
+  presenter.dismissalCompletion();
+  XCTAssertEqual(callbackCount, 1u);
+  // the missing state doesn't match that of the request
+  XCTAssertEqualObjects(flowError.domain, OIDOAuthAuthorizationErrorDomain);
+  XCTAssertEqual(flowError.code, OIDErrorCodeOAuthAuthorizationClientError);
+  XCTAssertFalse([OIDAuthorizationService resumeAuthorizationFlowWithURL:redirect]);
+  [session cancel];
+  XCTAssertEqual(callbackCount, 1u);
+
+  // with several flows pending, the redirect can't be attributed
+  OIDAuthorizationCallback ignored = ^(OIDAuthorizationResponse *_Nullable response,
+                                       NSError *_Nullable error) {
+  };
+  id<OIDAuthorizationFlowSession> firstSession =
+      [OIDAuthorizationService presentAuthorizationRequest:[self authorizationRequest]
+                                                 presenter:presenter
+                                          responseCallback:nil
+                                                  callback:ignored];
+  id<OIDAuthorizationFlowSession> secondSession =
+      [OIDAuthorizationService presentAuthorizationRequest:[self authorizationRequest]
+                                                 presenter:presenter
+                                          responseCallback:nil
+                                                  callback:ignored];
+  XCTAssertFalse([OIDAuthorizationService resumeAuthorizationFlowWithURL:redirect]);
+  [firstSession cancel];
+  presenter.dismissalCompletion();
+  [secondSession cancel];
+  presenter.dismissalCompletion();
+}
+
+@end
@@ -0,0 +1,146 @@
+/*! @file OIDClockSkewEstimatorTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "Source/OIDClockSkewEstimator.h"
+
+/*! @class OIDClockSkewEstimatorTests
+    @brief Unit tests for @c OIDClockSkewEstimator.
+ */
+@interface OIDClockSkewEstimatorTests : XCTestCase
+@end
+
+@implementation OIDClockSkewEstimatorTests {
+  /*! @var _estimator
+      @brief The estimator under test.
+   */
+  OIDClockSkewEstimator *_estimator;
+
+  /*! @var _issuer
+      @brief The issuer whose clock is estimated.
+   */
+  NSURL *_issuer;
+
+  /*! @var _referenceDate
+      @brief The device time the samples are relative to.
+   */
+  NSDate *_referenceDate;
+}
+
+- (void)setUp {
+  [super setUp];
+  _estimator = [[OIDClockSkewEstimator alloc] init];
+  _issuer = [NSURL URLWithString:@"https://issuer.example.com"];
+  _referenceDate = [NSDate dateWithTimeIntervalSinceReferenceDate:500000000];
+}
+
+/*! @fn recordServerTime:requestTime:responseTime:
+    @brief Records a sample with a one second resolution, with times relative to
+        @c _referenceDate.
+ */
+- (void)recordServerTime:(NSTimeInterval)serverTime
+             requestTime:(NSTimeInterval)requestTime
+            responseTime:(NSTimeInterval)responseTime {
+  [_estimator recordServerDate:[_referenceDate dateByAddingTimeInterval:serverTime]
+                    resolution:1
+                   requestDate:[_referenceDate dateByAddingTimeInterval:requestTime]
+                  responseDate:[_referenceDate dateByAddingTimeInterval:responseTime]
+                     forIssuer:_issuer];
+}
+
+/*! @fn testSample
+    @brief Tests that a sample brackets the skew between the request and the response.
+ */
+- (void)testSample {
+  XCTAssertNil([_estimator estimateForIssuer:_issuer]);
+  XCTAssertEqual([_estimator skewForIssuer:_issuer], 0);
+
+  // the server read 100 (so 100 to 101) between 0 and 0.5: the skew is 99.5 to 101
+  [self recordServerTime:100 requestTime:0 responseTime:0.5];
+  OIDClockSkewEstimate *estimate = [_estimator estimateForIssuer:_issuer];
+  XCTAssertEqualWithAccuracy(estimate.skew, 100.25, 0.001);
+  XCTAssertEqualWithAccuracy(estimate.uncertainty, 0.75, 0.001);
+  XCTAssertEqualObjects(estimate.measurementDate, [_referenceDate dateByAddingTimeInterval:0.5]);
+  XCTAssertEqualWithAccuracy([_estimator skewForIssuer:_issuer], 100.25, 0.001);
+}
+
+/*! @fn testSamplesRefineEstimate
+    @brief Tests that agreeing samples narrow the estimate to their intersection.
+ */
+- (void)testSamplesRefineEstimate {
+  // skew 99.5 to 101
+  [self recordServerTime:100 requestTime:0 responseTime:0.5];
+  // skew 99 to 100.5, 10 seconds later
+  [self recordServerTime:110 requestTime:10.5 responseTime:11];
+  OIDClockSkewEstimate *estimate = [_estimator estimateForIssuer:_issuer];
+  XCTAssertEqualWithAccuracy(estimate.skew, 100, 0.01);
+  XCTAssertEqualWithAccuracy(estimate.uncertainty, 0.5, 0.01);
+}
+
+/*! @fn testDisagreeingSampleReplacesEstimate
+    @brief Tests that a sample which doesn't agree with the estimate, because a clock was changed,
+        replaces it.
+ */
+- (void)testDisagreeingSampleReplacesEstimate {
+  [self recordServerTime:100 requestTime:0 responseTime:0.5];
+  [self recordServerTime:-40 requestTime:60 responseTime:60.5];
+  XCTAssertEqualWithAccuracy([_estimator skewForIssuer:_issuer], -99.75, 0.001);
+
+  // an older estimate which disagrees is ignored
+  OIDClockSkewEstimate *stale =
+      [[OIDClockSkewEstimate alloc] initWithSkew:100 uncertainty:1 measurementDate:_referenceDate];
+  [_estimator recordEstimate:stale forIssuer:_issuer];
+  XCTAssertEqualWithAccuracy([_estimator skewForIssuer:_issuer], -99.75, 0.001);
+}
+
+/*! @fn testUncertaintyGrows
+    @brief Tests that the uncertainty of an estimate grows as the clocks may drift apart.
+ */
+- (void)testUncertaintyGrows {
+  OIDClockSkewEstimate *estimate =
+      [[OIDClockSkewEstimate alloc] initWithSkew:0 uncertainty:1 measurementDate:_referenceDate];
+  XCTAssertEqualWithAccuracy([estimate uncertaintyAtDate:_referenceDate], 1, 0.001);
+  NSDate *dayLater = [_referenceDate dateByAddingTimeInterval:86400];
+  XCTAssertGreaterThan([estimate uncertaintyAtDate:dayLater], 1);
+}
+
+/*! @fn testHTTPDate
+    @brief Tests parsing the value of a @c Date header.
+ */
+- (void)testHTTPDate {
+  NSDate *date = [OIDClockSkewEstimator dateFromHTTPDate:@"Sun, 06 Nov 1994 08:49:37 GMT"];
+  XCTAssertEqualObjects(date, [NSDate dateWithTimeIntervalSince1970:784111777]);
+  XCTAssertNil([OIDClockSkewEstimator dateFromHTTPDate:@"Sunday, 06-Nov-94 08:49:37 GMT"]);
+}
+
+/*! @fn testSecureCoding
+    @brief Tests archiving an estimate.
+ */
+- (void)testSecureCoding {
+  OIDClockSkewEstimate *estimate = [[OIDClockSkewEstimate alloc] initWithSkew:12.5
+                                                                  uncertainty:0.5
+                                                              measurementDate:_referenceDate];
+  NSData *data = [NSKeyedArchiver archivedDataWithRootObject:estimate];
+  OIDClockSkewEstimate *unarchived = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  XCTAssertEqual(unarchived.skew, estimate.skew);
+  XCTAssertEqual(unarchived.uncertainty, estimate.uncertainty);
+  XCTAssertEqualObjects(unarchived.measurementDate, estimate.measurementDate);
+}
+
+@end
@@ -0,0 +1,149 @@
+/*! @file OIDIDTokenTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "OIDTokenRequestTests.h"
+#import "Source/OIDIDToken.h"
+#import "Source/OIDTokenResponse.h"
+#import "Source/OIDTokenUtilities.h"
+
+/*! @class OIDIDTokenTests
+    @brief Unit tests for @c OIDIDToken.
+ */
+@interface OIDIDTokenTests : XCTestCase
+@end
+
+@implementation OIDIDTokenTests
+
+/*! @fn segmentWithJSON:
+    @brief Encodes a JSON object as a base64url token segment.
+ */
++ (NSString *)segmentWithJSON:(id)JSON {
+  NSData *data = [NSJSONSerialization dataWithJSONObject:JSON options:0 error:NULL];
+  return [OIDTokenUtilities encodeBase64urlNoPadding:data];
+}
+
+/*! @fn tokenStringWithClaims:
+    @brief Creates the compact serialization of a token with the given claims.
+ */
++ (NSString *)tokenStringWithClaims:(NSDictionary<NSString *, id> *)claims {
+  return [NSString stringWithFormat:@"%@.%@.c2lnbmF0dXJl",
+                                    [self segmentWithJSON:@{ @"alg" : @"RS256", @"kid" : @"k1" }],
+                                    [self segmentWithJSON:claims]];
+}
+
+/*! @fn testParse
+    @brief Tests that the header and standard claims are decoded into typed properties.
+ */
+- (void)testParse {
+  NSString *tokenString = [[self class] tokenStringWithClaims:@{
+    @"iss" : @"https://accounts.example.com",
+    @"sub" : @"248289761001",
+    @"aud" : @"client",
+    @"exp" : @1311281970,
+    @"iat" : @1311280970,
+    @"nonce" : @"n-0S6_WzA2Mj",
+    @"email" : @"jane@example.com",
+  }];
+  OIDIDToken *token = [[OIDIDToken alloc] initWithTokenString:tokenString];
+  XCTAssertNotNil(token);
+  XCTAssertEqualObjects(token.algorithm, @"RS256");
+  XCTAssertEqualObjects(token.keyID, @"k1");
+  XCTAssertEqualObjects(token.issuer, [NSURL URLWithString:@"https://accounts.example.com"]);
+  XCTAssertEqualObjects(token.subject, @"248289761001");
+  XCTAssertEqualObjects(token.audience, @[ @"client" ]);
+  XCTAssertEqualObjects(token.expiresAt, [NSDate dateWithTimeIntervalSince1970:1311281970]);
+  XCTAssertEqualObjects(token.issuedAt, [NSDate dateWithTimeIntervalSince1970:1311280970]);
+  XCTAssertEqualObjects(token.nonce, @"n-0S6_WzA2Mj");
+  XCTAssertNil(token.authTime);
+  XCTAssertEqualObjects(token.claims[@"email"], @"jane@example.com");
+}
+
+/*! @fn testSegmentRanges
+    @brief Tests that the ranges of the segments address the original token string.
+ */
+- (void)testSegmentRanges {
+  NSString *tokenString = [[self class] tokenStringWithClaims:@{ @"sub" : @"user" }];
+  NSArray<NSString *> *segments = [tokenString componentsSeparatedByString:@"."];
+  OIDIDToken *token = [[OIDIDToken alloc] initWithTokenString:tokenString];
+  XCTAssertEqualObjects([token.tokenString substringWithRange:token.headerRange], segments[0]);
+  XCTAssertEqualObjects([token.tokenString substringWithRange:token.claimsRange], segments[1]);
+  XCTAssertEqualObjects([token.tokenString substringWithRange:token.signatureRange], segments[2]);
+}
+
+/*! @fn testAudienceArray
+    @brief Tests that an array of audiences is kept, ignoring values which aren't strings.
+ */
+- (void)testAudienceArray {
+  NSString *tokenString =
+      [[self class] tokenStringWithClaims:@{ @"aud" : @[ @"client", @"api", @3 ] }];
+  OIDIDToken *token = [[OIDIDToken alloc] initWithTokenString:tokenString];
+  XCTAssertEqualObjects(token.audience, (@[ @"client", @"api" ]));
+}
+
+/*! @fn testMalformed
+    @brief Tests that strings which aren't a JWS with JSON object segments aren't parsed.
+ */
+- (void)testMalformed {
+  NSString *header = [[self class] segmentWithJSON:@{ @"alg" : @"none" }];
+  NSString *claims = [[self class] segmentWithJSON:@{ @"sub" : @"user" }];
+  XCTAssertNil([[OIDIDToken alloc] initWithTokenString:@"opaque"]);
+  XCTAssertNil([[OIDIDToken alloc] initWithTokenString:
+                   [NSString stringWithFormat:@"%@.%@", header, claims]]);
+  XCTAssertNil([[OIDIDToken alloc] initWithTokenString:
+                   [NSString stringWithFormat:@"%@.%@.a.b.c", header, claims]]);
+  XCTAssertNil([[OIDIDToken alloc] initWithTokenString:
+                   [NSString stringWithFormat:@"%@.!!!.sig", header]]);
+  XCTAssertNil([[OIDIDToken alloc] initWithTokenString:
+                   [NSString stringWithFormat:@"%@.%@.sig", header,
+                       [[self class] segmentWithJSON:@[ @"sub" ]]]]);
+}
+
+/*! @fn testDecodeBase64url
+    @brief Tests decoding base64url with and without padding.
+ */
+- (void)testDecodeBase64url {
+  NSData *data = [NSData dataWithBytes:"\xfb\xff\xfe" length:3];
+  XCTAssertEqualObjects([OIDTokenUtilities decodeBase64urlNoPadding:@"-__-"], data);
+  XCTAssertEqualObjects([OIDTokenUtilities decodeBase64urlNoPadding:@"YQ"],
+                        [@"a" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertEqualObjects([OIDTokenUtilities decodeBase64urlNoPadding:@"YQ=="],
+                        [@"a" dataUsingEncoding:NSUTF8StringEncoding]);
+  XCTAssertNil([OIDTokenUtilities decodeBase64urlNoPadding:@"Y"]);
+}
+
+/*! @fn testTokenResponseCachesParsedIDToken
+    @brief Tests that a token response parses its ID Token once.
+ */
+- (void)testTokenResponseCachesParsedIDToken {
+  NSString *tokenString = [[self class] tokenStringWithClaims:@{ @"sub" : @"user" }];
+  OIDTokenResponse *response =
+      [[OIDTokenResponse alloc] initWithRequest:[OIDTokenRequestTests testInstance]
+                                     parameters:@{ @"id_token" : tokenString }];
+  OIDIDToken *token = response.parsedIDToken;
+  XCTAssertEqualObjects(token.subject, @"user");
+  XCTAssertEqual(response.parsedIDToken, token);
+
+  OIDTokenResponse *responseWithoutIDToken =
+      [[OIDTokenResponse alloc] initWithRequest:[OIDTokenRequestTests testInstance]
+                                     parameters:@{ }];
+  XCTAssertNil(responseWithoutIDToken.parsedIDToken);
+}
+
+@end
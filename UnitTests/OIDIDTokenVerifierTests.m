@@ -0,0 +1,400 @@
+/*! @file OIDIDTokenVerifierTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "OIDLoopbackServer.h"
+#import "Source/OIDError.h"
+#import "Source/OIDIDToken.h"
+#import "Source/OIDIDTokenVerifier.h"
+#import "Source/OIDJSONWebKey.h"
+#import "Source/OIDJSONWebKeySetCache.h"
+#import "Source/OIDTokenUtilities.h"
+
+/*! @var kTestTimeout
+    @brief How long to wait for a verification.
+ */
+static const NSTimeInterval kTestTimeout = 5;
+
+/*! @var kIssuer
+    @brief The issuer of the fixture tokens.
+ */
+static NSString *const kIssuer = @"https://accounts.example.com";
+
+/*! @var kClientID
+    @brief The audience of the fixture tokens.
+ */
+static NSString *const kClientID = @"client";
+
+/*! @var kNonce
+    @brief The nonce of the fixture tokens.
+ */
+static NSString *const kNonce = @"n-0S6_WzA2Mj";
+
+/*! @var kRS256Token
+    @brief A token signed with the private key of the @c rsa1 fixture key, expiring in 2100.
+ */
+static NSString *const kRS256Token =
+    @"eyJhbGciOiJSUzI1NiIsImtpZCI6InJzYTEifQ."
+     "eyJpc3MiOiJodHRwczovL2FjY291bnRzLmV4YW1wbGUuY29tIiwic3ViIjoiMjQ4Mjg5NzYxMDAxIiwiYXVkIjoiY2"
+     "xpZW50IiwiZXhwIjo0MTAyNDQ0ODAwLCJpYXQiOjE0NzUyODAwMDAsIm5vbmNlIjoibi0wUzZfV3pBMk1qIn0."
+     "TGMojPtH4aIBVmKZ711GTXZEtOB5MRSbf3tCViy4KRhbXSHyddch_r12MvzkJ9vF4XWhwnK4e9-oG70yZDpVrxf3SP"
+     "AWytpCxLvS7yaDaWtZuFI_fXOTY4sUK4_0TDyTJ-KMJnmD3QRxkDScyQd35JeyN5ER6-lS6LSNI52PHzrXrV3oI2WY"
+     "2S4WDXmVvjUFQ-yIec82yjJtxevHKTgbQskrqCZL5pe10-_RcR6nZRrpOOP5RVdaHNRg5rwHq8FL04nh_DcruuV7NX"
+     "4odRlSNI-JVBMkRePVWYeeFYO0sHz3jrlrN7FY7BJwknwvywjPJGYUsjBdxlLpvrg28gsndA";
+
+/*! @var kES256Token
+    @brief A token signed with the private key of the @c ec1 fixture key, expiring in 2100.
+ */
+static NSString *const kES256Token =
+    @"eyJhbGciOiJFUzI1NiIsImtpZCI6ImVjMSJ9."
+     "eyJpc3MiOiJodHRwczovL2FjY291bnRzLmV4YW1wbGUuY29tIiwic3ViIjoiMjQ4Mjg5NzYxMDAxIiwiYXVkIjoiY2"
+     "xpZW50IiwiZXhwIjo0MTAyNDQ0ODAwLCJpYXQiOjE0NzUyODAwMDAsIm5vbmNlIjoibi0wUzZfV3pBMk1qIn0."
+     "gGaTSIlv5MNNf540Kr-PNNQyT0_6RaQPV297eJEfIL2MHvEcnHDIE0voyVg-jjozsNc3MpkYlmbtrFeHHKfPQg";
+
+/*! @class OIDIDTokenVerifierTests
+    @brief Unit tests for @c OIDIDTokenVerifier, @c OIDJSONWebKey and @c OIDJSONWebKeySetCache.
+ */
+@interface OIDIDTokenVerifierTests : XCTestCase
+@end
+
+@implementation OIDIDTokenVerifierTests {
+  /*! @var _server
+      @brief Serves the fixture key set.
+   */
+  OIDLoopbackServer *_server;
+}
+
+- (void)setUp {
+  [super setUp];
+  _server = [[OIDLoopbackServer alloc] init];
+  _server.JWKS = [[self class] JWKS];
+  XCTAssert([_server start]);
+}
+
+- (void)tearDown {
+  [_server stop];
+  _server = nil;
+  [super tearDown];
+}
+
+/*! @fn JWKS
+    @brief The public halves of the fixture keys, plus an encryption key which is skipped.
+ */
++ (NSDictionary<NSString *, id> *)JWKS {
+  return @{ @"keys" : @[
+    @{
+      @"kty" : @"RSA",
+      @"kid" : @"rsa1",
+      @"use" : @"sig",
+      @"n" : @"tA7umn5GsPnnpapFmlGRiEbAva32CRLSpuC83HpQUC9VMyOSy_dOQ62Gg4kLk0KdUaU6j597vNNNPEAr73e8"
+              "NrfjD9jvFWcZUIlDbxgYtJgtrgiUIGKcv6UHjMzL3bijVFpvGZJ105GUd-Pq6iHwaSndVReT8YuE-U-14y9P"
+              "u1YFzjaOZScPs-YLTUd-9VFPjbznBJDbzd5apBRUvHpxO1dLp2m7DikpJaK4ouKDV6NQHHWW3iOWlR6rWOfC"
+              "E6r44-yJL2RLq29aa9CKqjDrnQcVuqvZPzEJmsFgp4eA1zjo8yk4N2lJxigG9bJPJEPQjXr3SwVGCaDT55FL"
+              "gx_COw",
+      @"e" : @"AQAB",
+    },
+    @{
+      @"kty" : @"EC",
+      @"kid" : @"ec1",
+      @"crv" : @"P-256",
+      @"x" : @"fG3zyT_HYWZgVqdVo5xm2Xj8dQ5n8_w1PXOzWCus_fg",
+      @"y" : @"UEJXOPMRq7zBqDu5h0Oqb72mBTlg7Irxj6G2b64nhXw",
+    },
+    @{
+      @"kty" : @"RSA",
+      @"kid" : @"enc1",
+      @"use" : @"enc",
+      @"n" : @"AQAB",
+      @"e" : @"AQAB",
+    },
+  ] };
+}
+
+/*! @fn verifier
+    @brief A verifier using the loopback server's key set.
+ */
+- (OIDIDTokenVerifier *)verifier {
+  OIDJSONWebKeySetCache *cache =
+      [[OIDJSONWebKeySetCache alloc] initWithJWKSURL:[_server URLForPath:OIDLoopbackServerJWKSPath]];
+  return [[OIDIDTokenVerifier alloc] initWithIssuer:[NSURL URLWithString:kIssuer]
+                                           clientID:kClientID
+                                        keySetCache:cache];
+}
+
+/*! @fn verifyTokenString:withVerifier:error:
+    @brief Verifies a token and waits for the result.
+ */
+- (BOOL)verifyTokenString:(NSString *)tokenString
+             withVerifier:(OIDIDTokenVerifier *)verifier
+                    error:(NSError **)error {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block BOOL valid = NO;
+  __block NSError *verificationError;
+  [verifier verifyIDToken:[[OIDIDToken alloc] initWithTokenString:tokenString]
+                    nonce:kNonce
+                 callback:^(BOOL callbackValid, NSError *_Nullable callbackError) {
+    valid = callbackValid;
+    verificationError = callbackError;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  if (error) {
+    *error = verificationError;
+  }
+  return valid;
+}
+
+/*! @fn unsignedTokenWithClaims:
+    @brief Creates a token with the given claims and a bogus signature.
+ */
++ (OIDIDToken *)unsignedTokenWithClaims:(NSDictionary<NSString *, id> *)claims {
+  NSData *header = [NSJSONSerialization dataWithJSONObject:@{ @"alg" : @"RS256" }
+                                                   options:0
+                                                     error:NULL];
+  NSData *payload = [NSJSONSerialization dataWithJSONObject:claims options:0 error:NULL];
+  NSString *tokenString =
+      [NSString stringWithFormat:@"%@.%@.c2ln",
+                                 [OIDTokenUtilities encodeBase64urlNoPadding:header],
+                                 [OIDTokenUtilities encodeBase64urlNoPadding:payload]];
+  return [[OIDIDToken alloc] initWithTokenString:tokenString];
+}
+
+#pragma mark - Keys
+
+/*! @fn testKeySetIndexesByID
+    @brief Tests that keys are found by ID and algorithm, and encryption keys are skipped.
+ */
+- (void)testKeySetIndexesByID {
+  OIDJSONWebKeySet *keySet = [[OIDJSONWebKeySet alloc] initWithJSON:[[self class] JWKS]];
+  XCTAssertEqual(keySet.keys.count, 2u);
+  XCTAssertEqualObjects([keySet keyWithID:@"rsa1" algorithm:OIDJSONWebAlgorithmRS256].keyID,
+                        @"rsa1");
+  XCTAssertEqualObjects([keySet keyWithID:@"ec1" algorithm:OIDJSONWebAlgorithmES256].keyID,
+                        @"ec1");
+  XCTAssertNil([keySet keyWithID:@"rsa1" algorithm:OIDJSONWebAlgorithmES256]);
+  XCTAssertNil([keySet keyWithID:@"enc1" algorithm:OIDJSONWebAlgorithmRS256]);
+  // without a key ID, the only key for the algorithm is used
+  XCTAssertEqualObjects([keySet keyWithID:nil algorithm:OIDJSONWebAlgorithmES256].keyID, @"ec1");
+}
+
+/*! @fn testUnsupportedKeys
+    @brief Tests that keys which can't verify signatures aren't created.
+ */
+- (void)testUnsupportedKeys {
+  XCTAssertNil([[OIDJSONWebKey alloc] initWithJSON:@{ @"kty" : @"oct", @"k" : @"AQAB" }]);
+  XCTAssertNil([[OIDJSONWebKey alloc] initWithJSON:@{ @"kty" : @"RSA", @"e" : @"AQAB" }]);
+  XCTAssertNil([[OIDJSONWebKey alloc] initWithJSON:@{
+    @"kty" : @"EC", @"crv" : @"P-384", @"x" : @"AQAB", @"y" : @"AQAB"
+  }]);
+}
+
+#pragma mark - Claims
+
+/*! @fn testClaims
+    @brief Tests each claim check.
+ */
+- (void)testClaims {
+  OIDIDTokenVerifier *verifier = [self verifier];
+  NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+  NSDictionary<NSString *, id> *valid = @{
+    @"iss" : kIssuer,
+    @"aud" : kClientID,
+    @"exp" : @(now + 3600),
+    @"iat" : @(now),
+    @"nonce" : kNonce,
+  };
+  NSError *error;
+  XCTAssert([verifier verifyClaimsOfIDToken:[[self class] unsignedTokenWithClaims:valid]
+                                      nonce:kNonce
+                                      error:&error]);
+  XCTAssertNil(error);
+
+  NSArray<NSDictionary<NSString *, id> *> *invalidChanges = @[
+    @{ @"iss" : @"https://evil.example.com" },
+    @{ @"aud" : @"other" },
+    @{ @"aud" : @[ kClientID, @"other" ], @"azp" : @"other" },
+    @{ @"exp" : @(now - 3600) },
+    @{ @"iat" : @(now + 3600) },
+    @{ @"nonce" : @"replayed" },
+  ];
+  for (NSDictionary<NSString *, id> *changes in invalidChanges) {
+    NSMutableDictionary<NSString *, id> *claims = [valid mutableCopy];
+    [claims addEntriesFromDictionary:changes];
+    error = nil;
+    XCTAssertFalse([verifier verifyClaimsOfIDToken:[[self class] unsignedTokenWithClaims:claims]
+                                             nonce:kNonce
+                                             error:&error], @"%@", changes);
+    XCTAssertEqual(error.code, OIDErrorCodeIDTokenVerificationError);
+  }
+}
+
+#pragma mark - Signatures
+
+/*! @fn testRS256
+    @brief Tests verifying an RS256 token.
+ */
+- (void)testRS256 {
+  NSError *error;
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:[self verifier] error:&error]);
+  XCTAssertNil(error);
+}
+
+/*! @fn testES256
+    @brief Tests verifying an ES256 token.
+ */
+- (void)testES256 {
+  NSError *error;
+  XCTAssert([self verifyTokenString:kES256Token withVerifier:[self verifier] error:&error]);
+  XCTAssertNil(error);
+}
+
+/*! @fn testForeignSignature
+    @brief Tests that a token carrying a signature made with another key is rejected.
+ */
+- (void)testForeignSignature {
+  NSArray<NSString *> *rs256 = [kRS256Token componentsSeparatedByString:@"."];
+  NSArray<NSString *> *es256 = [kES256Token componentsSeparatedByString:@"."];
+  NSString *tampered = [@[ rs256[0], rs256[1], es256[2] ] componentsJoinedByString:@"."];
+  NSError *error;
+  XCTAssertFalse([self verifyTokenString:tampered withVerifier:[self verifier] error:&error]);
+  XCTAssertEqual(error.code, OIDErrorCodeIDTokenVerificationError);
+}
+
+/*! @fn testAlgorithmNone
+    @brief Tests that unsigned tokens are rejected.
+ */
+- (void)testAlgorithmNone {
+  NSArray<NSString *> *segments = [kRS256Token componentsSeparatedByString:@"."];
+  NSData *header = [NSJSONSerialization dataWithJSONObject:@{ @"alg" : @"none" }
+                                                   options:0
+                                                     error:NULL];
+  NSString *unsignedToken =
+      [NSString stringWithFormat:@"%@.%@.",
+                                 [OIDTokenUtilities encodeBase64urlNoPadding:header],
+                                 segments[1]];
+  NSError *error;
+  XCTAssertFalse([self verifyTokenString:unsignedToken withVerifier:[self verifier] error:&error]);
+  XCTAssertEqual(error.code, OIDErrorCodeIDTokenVerificationError);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 0u);
+}
+
+#pragma mark - Cache
+
+/*! @fn testKeySetIsCached
+    @brief Tests that the key set is fetched once for tokens signed with known keys.
+ */
+- (void)testKeySetIsCached {
+  OIDIDTokenVerifier *verifier = [self verifier];
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  XCTAssert([self verifyTokenString:kES256Token withVerifier:verifier error:NULL]);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 1u);
+}
+
+/*! @fn testUnknownKeyIDRefetchesOnce
+    @brief Tests that concurrent lookups of an unknown key ID share one refetch, and that another
+        unknown key ID right after doesn't refetch.
+ */
+- (void)testUnknownKeyIDRefetchesOnce {
+  OIDJSONWebKeySetCache *cache = [self verifier].keySetCache;
+  cache.minimumRefetchInterval = 0;
+
+  // the provider rolls its keys after the first fetch
+  XCTestExpectation *warm = [self expectationWithDescription:@"Callback should be called."];
+  [cache keyWithID:@"rsa1"
+         algorithm:OIDJSONWebAlgorithmRS256
+          callback:^(OIDJSONWebKey *_Nullable key, NSError *_Nullable error) {
+    XCTAssertNotNil(key);
+    [warm fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  NSMutableDictionary *rolledRSAKey = [[[self class] JWKS][@"keys"][0] mutableCopy];
+  rolledRSAKey[@"kid"] = @"rsa2";
+  _server.JWKS = @{ @"keys" : @[ rolledRSAKey ] };
+
+  for (NSUInteger i = 0; i < 3; i++) {
+    XCTestExpectation *expectation =
+        [self expectationWithDescription:@"Callback should be called."];
+    [cache keyWithID:@"rsa2"
+           algorithm:OIDJSONWebAlgorithmRS256
+            callback:^(OIDJSONWebKey *_Nullable key, NSError *_Nullable error) {
+      XCTAssertEqualObjects(key.keyID, @"rsa2");
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 2u);
+
+  cache.minimumRefetchInterval = 60;
+  XCTestExpectation *unknown = [self expectationWithDescription:@"Callback should be called."];
+  [cache keyWithID:@"forged"
+         algorithm:OIDJSONWebAlgorithmRS256
+          callback:^(OIDJSONWebKey *_Nullable key, NSError *_Nullable error) {
+    XCTAssertNil(key);
+    XCTAssertEqual(error.code, OIDErrorCodeIDTokenVerificationError);
+    [unknown fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 2u);
+}
+
+/*! @fn testFetchFailureFallsBackToCachedKeys
+    @brief Tests that an expired key set is still used when refetching it fails.
+ */
+- (void)testFetchFailureFallsBackToCachedKeys {
+  OIDIDTokenVerifier *verifier = [self verifier];
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  verifier.keySetCache.timeToLive = 0;
+  [_server enqueueResponse:[OIDLoopbackResponse serverErrorResponseWithStatusCode:503]
+                   forPath:OIDLoopbackServerJWKSPath];
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 2u);
+}
+
+/*! @fn testFailedFetchIsNotRetriedRightAway
+    @brief Tests that after a failed fetch, lookups use the cached keys or report the failure
+        until @c minimumRefetchInterval has passed.
+ */
+- (void)testFailedFetchIsNotRetriedRightAway {
+  OIDIDTokenVerifier *verifier = [self verifier];
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  OIDJSONWebKeySetCache *cache = verifier.keySetCache;
+  cache.timeToLive = 0;
+  [_server enqueueResponse:[OIDLoopbackResponse serverErrorResponseWithStatusCode:503]
+                   forPath:OIDLoopbackServerJWKSPath];
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 2u);
+
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [cache keyWithID:@"forged"
+         algorithm:OIDJSONWebAlgorithmRS256
+          callback:^(OIDJSONWebKey *_Nullable key, NSError *_Nullable error) {
+    XCTAssertNil(key);
+    XCTAssertEqual(error.code, OIDErrorCodeNetworkError);
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 2u);
+
+  cache.minimumRefetchInterval = 0;
+  XCTAssert([self verifyTokenString:kRS256Token withVerifier:verifier error:NULL]);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerJWKSPath].count, 3u);
+}
+
+@end
@@ -0,0 +1,238 @@
+/*! @file OIDIntrospectionCacheTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "OIDLoopbackServer.h"
+#import "Source/OIDError.h"
+#import "Source/OIDIntrospectionCache.h"
+#import "Source/OIDIntrospectionRequest.h"
+#import "Source/OIDIntrospectionResponse.h"
+
+/*! @var kTestTimeout
+    @brief How long to wait for an introspection.
+ */
+static const NSTimeInterval kTestTimeout = 5;
+
+/*! @class OIDIntrospectionCacheTests
+    @brief Unit tests for @c OIDIntrospectionCache and @c OIDIntrospectionResponse.
+ */
+@interface OIDIntrospectionCacheTests : XCTestCase
+@end
+
+@implementation OIDIntrospectionCacheTests {
+  /*! @var _server
+      @brief Serves the introspection endpoint.
+   */
+  OIDLoopbackServer *_server;
+}
+
+- (void)setUp {
+  [super setUp];
+  _server = [[OIDLoopbackServer alloc] init];
+  XCTAssert([_server start]);
+}
+
+- (void)tearDown {
+  [_server stop];
+  _server = nil;
+  [super tearDown];
+}
+
+/*! @fn requestForToken:
+    @brief An introspection request to the loopback server.
+ */
+- (OIDIntrospectionRequest *)requestForToken:(NSString *)token {
+  return [[OIDIntrospectionRequest alloc]
+      initWithIntrospectionEndpoint:[_server URLForPath:OIDLoopbackServerIntrospectionPath]
+                              token:token
+                      tokenTypeHint:nil
+                           clientID:@"resource-server"
+               additionalParameters:nil];
+}
+
+/*! @fn introspectToken:withCache:error:
+    @brief Introspects a token through a cache and waits for the result.
+ */
+- (nullable OIDIntrospectionResponse *)introspectToken:(NSString *)token
+                                             withCache:(OIDIntrospectionCache *)cache
+                                                 error:(NSError **)error {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  __block OIDIntrospectionResponse *introspectionResponse;
+  __block NSError *introspectionError;
+  [cache performIntrospectionRequest:[self requestForToken:token]
+                            callback:^(OIDIntrospectionResponse *_Nullable response,
+                                       NSError *_Nullable callbackError) {
+    XCTAssert([NSThread isMainThread]);
+    introspectionResponse = response;
+    introspectionError = callbackError;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  if (error) {
+    *error = introspectionError;
+  }
+  return introspectionResponse;
+}
+
+/*! @fn introspectionRequestCount
+    @brief The number of requests the introspection endpoint received.
+ */
+- (NSUInteger)introspectionRequestCount {
+  return [_server requestsForPath:OIDLoopbackServerIntrospectionPath].count;
+}
+
+/*! @fn testResponse
+    @brief Tests that the members of an introspection response are parsed.
+ */
+- (void)testResponse {
+  NSDictionary *parameters = @{
+    @"active" : @YES,
+    @"scope" : @"read write",
+    @"client_id" : @"client",
+    @"username" : @"jdoe",
+    @"token_type" : @"Bearer",
+    @"exp" : @1419356238,
+    @"iat" : @1419350238,
+    @"sub" : @"Z5O3upPC88QrAjx00dis",
+    @"iss" : @"https://server.example.com/",
+    @"aud" : @"https://protected.example.net/resource",
+  };
+  OIDIntrospectionResponse *response =
+      [[OIDIntrospectionResponse alloc] initWithRequest:[self requestForToken:@"access-1"]
+                                             parameters:parameters];
+  XCTAssert(response.active);
+  XCTAssertEqualObjects(response.scope, @"read write");
+  XCTAssertEqualObjects(response.clientID, @"client");
+  XCTAssertEqualObjects(response.username, @"jdoe");
+  XCTAssertEqualObjects(response.tokenType, @"Bearer");
+  XCTAssertEqualObjects(response.expiresAt, [NSDate dateWithTimeIntervalSince1970:1419356238]);
+  XCTAssertEqualObjects(response.issuedAt, [NSDate dateWithTimeIntervalSince1970:1419350238]);
+  XCTAssertEqualObjects(response.subject, @"Z5O3upPC88QrAjx00dis");
+  XCTAssertEqualObjects(response.issuer, @"https://server.example.com/");
+  XCTAssertEqualObjects(response.additionalParameters,
+                        @{ @"aud" : @"https://protected.example.net/resource" });
+
+  NSData *data = [NSKeyedArchiver archivedDataWithRootObject:response];
+  OIDIntrospectionResponse *unarchived = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  XCTAssert(unarchived.active);
+  XCTAssertEqualObjects(unarchived.expiresAt, response.expiresAt);
+  XCTAssertEqualObjects(unarchived.request.token, @"access-1");
+}
+
+/*! @fn testHitIsServedFromCache
+    @brief Tests that an active token is only introspected once.
+ */
+- (void)testHitIsServedFromCache {
+  OIDIntrospectionCache *cache = [[OIDIntrospectionCache alloc] init];
+  OIDIntrospectionResponse *response = [self introspectToken:@"access-1" withCache:cache error:NULL];
+  XCTAssert(response.active);
+  XCTAssertNotNil(response.expiresAt);
+  XCTAssert([self introspectToken:@"access-1" withCache:cache error:NULL].active);
+  XCTAssertEqual([self introspectionRequestCount], 1u);
+  XCTAssertEqual(cache.count, 1u);
+
+  [cache removeResultForRequest:[self requestForToken:@"access-1"]];
+  XCTAssert([self introspectToken:@"access-1" withCache:cache error:NULL].active);
+  XCTAssertEqual([self introspectionRequestCount], 2u);
+}
+
+/*! @fn testConcurrentLookupsShareRequest
+    @brief Tests that concurrent lookups of a token share one request.
+ */
+- (void)testConcurrentLookupsShareRequest {
+  OIDIntrospectionCache *cache = [[OIDIntrospectionCache alloc] init];
+  _server.latency = 0.2;
+  for (NSUInteger i = 0; i < 5; i++) {
+    XCTestExpectation *expectation =
+        [self expectationWithDescription:@"Callback should be called."];
+    [cache performIntrospectionRequest:[self requestForToken:@"access-1"]
+                              callback:^(OIDIntrospectionResponse *_Nullable response,
+                                         NSError *_Nullable error) {
+      XCTAssert(response.active);
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual([self introspectionRequestCount], 1u);
+}
+
+/*! @fn testInactiveResultIsCachedBriefly
+    @brief Tests that inactive results are cached for the negative time to live only.
+ */
+- (void)testInactiveResultIsCachedBriefly {
+  OIDIntrospectionCache *cache =
+      [[OIDIntrospectionCache alloc] initWithCapacity:10 timeToLive:60 negativeTimeToLive:60];
+  XCTAssertFalse([self introspectToken:@"forged" withCache:cache error:NULL].active);
+  XCTAssertFalse([self introspectToken:@"forged" withCache:cache error:NULL].active);
+  XCTAssertEqual([self introspectionRequestCount], 1u);
+
+  OIDIntrospectionCache *uncachedNegatives =
+      [[OIDIntrospectionCache alloc] initWithCapacity:10 timeToLive:60 negativeTimeToLive:0];
+  [self introspectToken:@"forged" withCache:uncachedNegatives error:NULL];
+  [self introspectToken:@"forged" withCache:uncachedNegatives error:NULL];
+  XCTAssertEqual([self introspectionRequestCount], 3u);
+}
+
+/*! @fn testExpiredTokenIsNotCached
+    @brief Tests that an active result isn't cached past the token's expiry.
+ */
+- (void)testExpiredTokenIsNotCached {
+  OIDIntrospectionCache *cache = [[OIDIntrospectionCache alloc] init];
+  _server.accessTokenLifetime = -1;
+  [self introspectToken:@"access-1" withCache:cache error:NULL];
+  [self introspectToken:@"access-1" withCache:cache error:NULL];
+  XCTAssertEqual([self introspectionRequestCount], 2u);
+  XCTAssertEqual(cache.count, 0u);
+}
+
+/*! @fn testFailureIsNotCached
+    @brief Tests that failed requests aren't cached.
+ */
+- (void)testFailureIsNotCached {
+  OIDIntrospectionCache *cache = [[OIDIntrospectionCache alloc] init];
+  [_server enqueueResponse:[OIDLoopbackResponse serverErrorResponseWithStatusCode:503]
+                   forPath:OIDLoopbackServerIntrospectionPath];
+  NSError *error;
+  XCTAssertNil([self introspectToken:@"access-1" withCache:cache error:&error]);
+  XCTAssertEqual(error.code, OIDErrorCodeServerError);
+  XCTAssert([self introspectToken:@"access-1" withCache:cache error:NULL].active);
+  XCTAssertEqual([self introspectionRequestCount], 2u);
+}
+
+/*! @fn testLeastRecentlyUsedIsEvicted
+    @brief Tests that a full cache evicts the least recently used result.
+ */
+- (void)testLeastRecentlyUsedIsEvicted {
+  OIDIntrospectionCache *cache =
+      [[OIDIntrospectionCache alloc] initWithCapacity:2 timeToLive:60 negativeTimeToLive:10];
+  [self introspectToken:@"access-1" withCache:cache error:NULL];
+  [self introspectToken:@"access-2" withCache:cache error:NULL];
+  // using access-1 makes access-2 the least recently used
+  [self introspectToken:@"access-1" withCache:cache error:NULL];
+  [self introspectToken:@"access-3" withCache:cache error:NULL];
+  XCTAssertEqual(cache.count, 2u);
+  XCTAssertEqual([self introspectionRequestCount], 3u);
+
+  [self introspectToken:@"access-1" withCache:cache error:NULL];
+  XCTAssertEqual([self introspectionRequestCount], 3u);
+  [self introspectToken:@"access-2" withCache:cache error:NULL];
+  XCTAssertEqual([self introspectionRequestCount], 4u);
+}
+
+@end
@@ -0,0 +1,261 @@
+/*! @file OIDLoopbackServer.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @var OIDLoopbackServerDiscoveryPath
+    @brief The path of the discovery document.
+ */
+extern NSString *const OIDLoopbackServerDiscoveryPath;
+
+/*! @var OIDLoopbackServerAuthorizationPath
+    @brief The path of the authorization endpoint. Advertised, but not served.
+ */
+extern NSString *const OIDLoopbackServerAuthorizationPath;
+
+/*! @var OIDLoopbackServerTokenPath
+    @brief The path of the token endpoint.
+ */
+extern NSString *const OIDLoopbackServerTokenPath;
+
+/*! @var OIDLoopbackServerRevocationPath
+    @brief The path of the revocation endpoint.
+ */
+extern NSString *const OIDLoopbackServerRevocationPath;
+
+/*! @var OIDLoopbackServerIntrospectionPath
+    @brief The path of the introspection endpoint.
+ */
+extern NSString *const OIDLoopbackServerIntrospectionPath;
+
+/*! @var OIDLoopbackServerUserInfoPath
+    @brief The path of the userinfo endpoint.
+ */
+extern NSString *const OIDLoopbackServerUserInfoPath;
+
+/*! @var OIDLoopbackServerJWKSPath
+    @brief The path of the JSON Web Key Set.
+ */
+extern NSString *const OIDLoopbackServerJWKSPath;
+
+/*! @var OIDLoopbackServerInvalidCode
+    @brief An authorization code the token endpoint rejects with an @c invalid_grant error.
+ */
+extern NSString *const OIDLoopbackServerInvalidCode;
+
+/*! @class OIDLoopbackRequest
+    @brief An HTTP request received by an @c OIDLoopbackServer.
+ */
+@interface OIDLoopbackRequest : NSObject
+
+/*! @property method
+    @brief The request method, such as @c "POST".
+ */
+@property(nonatomic, readonly) NSString *method;
+
+/*! @property path
+    @brief The path of the request target, without its query.
+ */
+@property(nonatomic, readonly) NSString *path;
+
+/*! @property headers
+    @brief The request headers, keyed by lowercase name.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, NSString *> *headers;
+
+/*! @property body
+    @brief The request body.
+ */
+@property(nonatomic, readonly) NSData *body;
+
+/*! @property formParameters
+    @brief The parameters of an @c application/x-www-form-urlencoded body.
+ */
+@property(nonatomic, readonly) NSDictionary<NSString *, NSString *> *formParameters;
+
+@end
+
+/*! @class OIDLoopbackResponse
+    @brief An HTTP response served by an @c OIDLoopbackServer.
+ */
+@interface OIDLoopbackResponse : NSObject
+
+/*! @property statusCode
+    @brief The HTTP status code.
+ */
+@property(nonatomic) NSInteger statusCode;
+
+/*! @property headers
+    @brief Additional response headers. @c Content-Length and @c Date are always set.
+ */
+@property(nonatomic, copy) NSDictionary<NSString *, NSString *> *headers;
+
+/*! @property body
+    @brief The response body.
+ */
+@property(nonatomic, copy) NSData *body;
+
+/*! @property delay
+    @brief How long to wait before responding, in addition to the server's @c latency.
+ */
+@property(nonatomic) NSTimeInterval delay;
+
+/*! @property closesConnection
+    @brief If YES, the connection is closed without responding, as when a server crashes.
+ */
+@property(nonatomic) BOOL closesConnection;
+
+/*! @fn responseWithStatusCode:JSON:
+    @brief Creates a response with a JSON body.
+    @param statusCode The HTTP status code.
+    @param JSON The object serialized as the body.
+ */
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode JSON:(id)JSON;
+
+/*! @fn OAuthErrorResponseWithError:
+    @brief Creates an HTTP 400 response carrying an RFC6749 Section 5.2 error.
+    @param error The value of the @c error field, such as @c "invalid_grant".
+ */
++ (instancetype)OAuthErrorResponseWithError:(NSString *)error;
+
+/*! @fn serverErrorResponseWithStatusCode:
+    @brief Creates a 5xx response with a plain text body.
+    @param statusCode The HTTP status code, such as 503.
+ */
++ (instancetype)serverErrorResponseWithStatusCode:(NSInteger)statusCode;
+
+/*! @fn droppedConnectionResponse
+    @brief Creates a response which closes the connection instead of responding.
+ */
++ (instancetype)droppedConnectionResponse;
+
+@end
+
+/*! @typedef OIDLoopbackFaultInjector
+    @brief Decides whether to replace the response to a request.
+    @param request The request.
+    @return The response to serve instead, or nil to serve the request normally.
+ */
+typedef OIDLoopbackResponse *_Nullable (^OIDLoopbackFaultInjector)(OIDLoopbackRequest *request);
+
+/*! @class OIDLoopbackServer
+    @brief An in-process HTTP server bound to 127.0.0.1 which stands in for an OpenID Connect
+        provider, serving discovery, token, revocation, introspection, userinfo and JWKS endpoints.
+    @discussion The token endpoint supports the @c authorization_code and @c refresh_token grants.
+        Every code except @c OIDLoopbackServerInvalidCode is accepted, as is every refresh token
+        not in @c revokedRefreshTokens. Other grant types get an @c unsupported_grant_type error.
+        Tokens sent to the revocation endpoint are added to @c revokedRefreshTokens. The
+        introspection endpoint reports access tokens of the form @c access-N as active, expiring
+        @c accessTokenLifetime from the request, unless they were revoked. The userinfo endpoint
+        serves @c userInfoClaims to the bearer of such a token, with an @c ETag, and rejects other
+        tokens with HTTP 401.
+
+        Responses can be scripted per path with @c enqueueResponse:forPath:, which are served in
+        order before falling back to the default behavior, or replaced at random with
+        @c faultInjector. Requests on one connection are served in order, so @c latency and
+        @c OIDLoopbackResponse.delay model a slow server rather than a slow network.
+ */
+@interface OIDLoopbackServer : NSObject
+
+/*! @property baseURL
+    @brief The URL of the server, which is also the issuer. Nil until started.
+ */
+@property(nonatomic, readonly, nullable) NSURL *baseURL;
+
+/*! @property latency
+    @brief How long to wait before every response. Defaults to 0.
+ */
+@property(atomic) NSTimeInterval latency;
+
+/*! @property accessTokenLifetime
+    @brief The @c expires_in of issued access tokens. Defaults to 3600.
+ */
+@property(atomic) NSTimeInterval accessTokenLifetime;
+
+/*! @property clockOffset
+    @brief How far the server's clock, as reported in @c Date headers, is ahead of the device's.
+        Defaults to 0.
+ */
+@property(atomic) NSTimeInterval clockOffset;
+
+/*! @property JWKS
+    @brief The JSON Web Key Set served at @c OIDLoopbackServerJWKSPath. Defaults to an empty set.
+ */
+@property(atomic, copy) NSDictionary<NSString *, id> *JWKS;
+
+/*! @property revokedRefreshTokens
+    @brief Refresh tokens which the token endpoint rejects with an @c invalid_grant error,
+        including those revoked at the revocation endpoint.
+ */
+@property(atomic, copy) NSSet<NSString *> *revokedRefreshTokens;
+
+/*! @property rotatesRefreshTokens
+    @brief Whether refreshes issue a new refresh token and revoke the one used. Defaults to NO.
+ */
+@property(atomic) BOOL rotatesRefreshTokens;
+
+/*! @property userInfoClaims
+    @brief The claims served by the userinfo endpoint. Defaults to a subject and a name.
+ */
+@property(atomic, copy) NSDictionary<NSString *, id> *userInfoClaims;
+
+/*! @property faultInjector
+    @brief Called for every request without a scripted response.
+ */
+@property(atomic, nullable) OIDLoopbackFaultInjector faultInjector;
+
+/*! @property requestCount
+    @brief The number of requests received.
+ */
+@property(atomic, readonly) NSUInteger requestCount;
+
+/*! @fn start
+    @brief Binds to a free port on 127.0.0.1 and starts accepting connections.
+    @return YES if the server started.
+ */
+- (BOOL)start;
+
+/*! @fn stop
+    @brief Stops accepting connections and closes the open ones.
+ */
+- (void)stop;
+
+/*! @fn URLForPath:
+    @brief The URL of a path on the server.
+    @param path A path, such as @c OIDLoopbackServerTokenPath.
+ */
+- (NSURL *)URLForPath:(NSString *)path;
+
+/*! @fn enqueueResponse:forPath:
+    @brief Scripts the response to the next request for @c path which doesn't already have one.
+    @param response The response.
+    @param path The path, such as @c OIDLoopbackServerTokenPath.
+ */
+- (void)enqueueResponse:(OIDLoopbackResponse *)response forPath:(NSString *)path;
+
+/*! @fn requestsForPath:
+    @brief The requests received for a path, in order.
+    @param path The path.
+ */
+- (NSArray<OIDLoopbackRequest *> *)requestsForPath:(NSString *)path;
+
+@end
+
+NS_ASSUME_NONNULL_END
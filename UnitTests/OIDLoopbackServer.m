@@ -0,0 +1,823 @@
+/*! @file OIDLoopbackServer.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDLoopbackServer.h"
+
+#import "Source/OIDTokenUtilities.h"
+
+#include <arpa/inet.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+NSString *const OIDLoopbackServerDiscoveryPath = @"/.well-known/openid-configuration";
+
+NSString *const OIDLoopbackServerAuthorizationPath = @"/authorize";
+
+NSString *const OIDLoopbackServerTokenPath = @"/token";
+
+NSString *const OIDLoopbackServerRevocationPath = @"/revoke";
+
+NSString *const OIDLoopbackServerIntrospectionPath = @"/introspect";
+
+NSString *const OIDLoopbackServerUserInfoPath = @"/userinfo";
+
+NSString *const OIDLoopbackServerJWKSPath = @"/jwks";
+
+NSString *const OIDLoopbackServerInvalidCode = @"invalid_code";
+
+/*! @var kReadBufferSize
+    @brief The number of bytes read from a connection at a time.
+ */
+static const size_t kReadBufferSize = 16 * 1024;
+
+/*! @var kMaxRequestSize
+    @brief Connections sending larger requests are closed.
+ */
+static const NSUInteger kMaxRequestSize = 1024 * 1024;
+
+/*! @var kListenBacklog
+    @brief The backlog of the listening socket, which must fit the load tests' connections.
+ */
+static const int kListenBacklog = 128;
+
+/*! @fn OIDLoopbackReasonPhrase
+    @brief The reason phrase of the status line for a status code.
+ */
+static NSString *OIDLoopbackReasonPhrase(NSInteger statusCode) {
+  switch (statusCode) {
+    case 200: return @"OK";
+    case 304: return @"Not Modified";
+    case 400: return @"Bad Request";
+    case 401: return @"Unauthorized";
+    case 404: return @"Not Found";
+    case 500: return @"Internal Server Error";
+    case 502: return @"Bad Gateway";
+    case 503: return @"Service Unavailable";
+    case 504: return @"Gateway Timeout";
+    default: return @"Unknown";
+  }
+}
+
+/*! @fn OIDLoopbackHTTPDate
+    @brief Formats a time for the @c Date header.
+ */
+static NSString *OIDLoopbackHTTPDate(NSDate *date) {
+  static NSDateFormatter *formatter;
+  static dispatch_once_t once;
+  dispatch_once(&once, ^{
+    formatter = [[NSDateFormatter alloc] init];
+    formatter.locale = [NSLocale localeWithLocaleIdentifier:@"en_US_POSIX"];
+    formatter.timeZone = [NSTimeZone timeZoneWithAbbreviation:@"GMT"];
+    formatter.dateFormat = @"EEE, dd MMM yyyy HH:mm:ss 'GMT'";
+  });
+  @synchronized(formatter) {
+    return [formatter stringFromDate:date];
+  }
+}
+
+#pragma mark - OIDLoopbackRequest
+
+@interface OIDLoopbackRequest ()
+
+/*! @fn requestFromBuffer:malformed:
+    @brief Parses and removes the first complete request from a connection's buffer.
+    @param buffer The bytes received on a connection.
+    @param malformed Set to YES if the buffer doesn't begin with an HTTP request.
+    @return The request, or nil if the buffer doesn't hold a complete one yet.
+ */
++ (nullable instancetype)requestFromBuffer:(NSMutableData *)buffer malformed:(BOOL *)malformed;
+
+@end
+
+@implementation OIDLoopbackRequest
+
++ (nullable instancetype)requestFromBuffer:(NSMutableData *)buffer malformed:(BOOL *)malformed {
+  *malformed = NO;
+  NSData *terminator = [NSData dataWithBytes:"\r\n\r\n" length:4];
+  NSRange headerEnd = [buffer rangeOfData:terminator
+                                  options:0
+                                    range:NSMakeRange(0, buffer.length)];
+  if (headerEnd.location == NSNotFound) {
+    *malformed = buffer.length > kMaxRequestSize;
+    return nil;
+  }
+  NSString *head =
+      [[NSString alloc] initWithData:[buffer subdataWithRange:NSMakeRange(0, headerEnd.location)]
+                            encoding:NSUTF8StringEncoding];
+  NSArray<NSString *> *lines = [head componentsSeparatedByString:@"\r\n"];
+  NSArray<NSString *> *requestLine = [lines.firstObject componentsSeparatedByString:@" "];
+  if (requestLine.count != 3) {
+    *malformed = YES;
+    return nil;
+  }
+
+  NSMutableDictionary<NSString *, NSString *> *headers = [NSMutableDictionary dictionary];
+  for (NSString *line in [lines subarrayWithRange:NSMakeRange(1, lines.count - 1)]) {
+    NSRange colon = [line rangeOfString:@":"];
+    if (colon.location == NSNotFound) {
+      continue;
+    }
+    NSString *name = [[line substringToIndex:colon.location] lowercaseString];
+    headers[name] = [[line substringFromIndex:NSMaxRange(colon)]
+        stringByTrimmingCharactersInSet:[NSCharacterSet whitespaceCharacterSet]];
+  }
+
+  NSUInteger bodyStart = NSMaxRange(headerEnd);
+  NSUInteger contentLength = (NSUInteger)[headers[@"content-length"] integerValue];
+  if (contentLength > kMaxRequestSize) {
+    *malformed = YES;
+    return nil;
+  }
+  if (buffer.length < bodyStart + contentLength) {
+    return nil;
+  }
+
+  OIDLoopbackRequest *request = [[self alloc] init];
+  request->_method = requestLine[0];
+  NSString *target = requestLine[1];
+  NSRange query = [target rangeOfString:@"?"];
+  request->_path = query.location == NSNotFound ? target : [target substringToIndex:query.location];
+  request->_headers = [headers copy];
+  request->_body = [buffer subdataWithRange:NSMakeRange(bodyStart, contentLength)];
+  request->_formParameters = [self formParametersWithRequest:request];
+  [buffer replaceBytesInRange:NSMakeRange(0, bodyStart + contentLength) withBytes:NULL length:0];
+  return request;
+}
+
+/*! @fn formParametersWithRequest:
+    @brief Decodes an @c application/x-www-form-urlencoded request body.
+ */
++ (NSDictionary<NSString *, NSString *> *)formParametersWithRequest:(OIDLoopbackRequest *)request {
+  if (![request.headers[@"content-type"] hasPrefix:@"application/x-www-form-urlencoded"]) {
+    return @{ };
+  }
+  NSString *body = [[NSString alloc] initWithData:request.body encoding:NSUTF8StringEncoding];
+  NSMutableDictionary<NSString *, NSString *> *parameters = [NSMutableDictionary dictionary];
+  for (NSString *pair in [body componentsSeparatedByString:@"&"]) {
+    NSRange equals = [pair rangeOfString:@"="];
+    if (equals.location == NSNotFound) {
+      continue;
+    }
+    NSString *(^decode)(NSString *) = ^NSString *(NSString *component) {
+      return [[component stringByReplacingOccurrencesOfString:@"+" withString:@" "]
+          stringByRemovingPercentEncoding];
+    };
+    NSString *name = decode([pair substringToIndex:equals.location]);
+    NSString *value = decode([pair substringFromIndex:NSMaxRange(equals)]);
+    if (name && value) {
+      parameters[name] = value;
+    }
+  }
+  return parameters;
+}
+
+- (NSString *)description {
+  return [NSString stringWithFormat:@"<%@: %p, method: %@, path: %@, formParameters: %@>",
+                                    NSStringFromClass([self class]),
+                                    self,
+                                    _method,
+                                    _path,
+                                    _formParameters];
+}
+
+@end
+
+#pragma mark - OIDLoopbackResponse
+
+@implementation OIDLoopbackResponse
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _statusCode = 200;
+    _headers = @{ };
+    _body = [NSData data];
+  }
+  return self;
+}
+
++ (instancetype)responseWithStatusCode:(NSInteger)statusCode JSON:(id)JSON {
+  OIDLoopbackResponse *response = [[self alloc] init];
+  response.statusCode = statusCode;
+  response.headers = @{ @"Content-Type" : @"application/json" };
+  response.body = [NSJSONSerialization dataWithJSONObject:JSON options:0 error:NULL];
+  return response;
+}
+
++ (instancetype)OAuthErrorResponseWithError:(NSString *)error {
+  return [self responseWithStatusCode:400 JSON:@{ @"error" : error }];
+}
+
++ (instancetype)serverErrorResponseWithStatusCode:(NSInteger)statusCode {
+  OIDLoopbackResponse *response = [[self alloc] init];
+  response.statusCode = statusCode;
+  response.headers = @{ @"Content-Type" : @"text/plain" };
+  response.body = [OIDLoopbackReasonPhrase(statusCode) dataUsingEncoding:NSUTF8StringEncoding];
+  return response;
+}
+
++ (instancetype)droppedConnectionResponse {
+  OIDLoopbackResponse *response = [[self alloc] init];
+  response.closesConnection = YES;
+  return response;
+}
+
+/*! @fn HTTPMessageDataWithDate:
+    @brief Serializes the response.
+    @param date The time reported in the @c Date header.
+ */
+- (NSData *)HTTPMessageDataWithDate:(NSDate *)date {
+  NSMutableString *head =
+      [NSMutableString stringWithFormat:@"HTTP/1.1 %ld %@\r\n",
+                                        (long)_statusCode,
+                                        OIDLoopbackReasonPhrase(_statusCode)];
+  [_headers enumerateKeysAndObjectsUsingBlock:^(NSString *name, NSString *value, BOOL *stop) {
+    [head appendFormat:@"%@: %@\r\n", name, value];
+  }];
+  [head appendFormat:@"Content-Length: %lu\r\n", (unsigned long)_body.length];
+  [head appendFormat:@"Date: %@\r\n", OIDLoopbackHTTPDate(date)];
+  [head appendString:@"Connection: keep-alive\r\n\r\n"];
+  NSMutableData *data = [[head dataUsingEncoding:NSUTF8StringEncoding] mutableCopy];
+  [data appendData:_body];
+  return data;
+}
+
+@end
+
+#pragma mark - OIDLoopbackConnection
+
+@class OIDLoopbackConnection;
+
+@interface OIDLoopbackServer ()
+
+/*! @fn responseToRequest:
+    @brief Records a request and chooses its response. Called on the connection's queue.
+ */
+- (OIDLoopbackResponse *)responseToRequest:(OIDLoopbackRequest *)request;
+
+/*! @fn connectionDidClose:
+    @brief Forgets a closed connection.
+ */
+- (void)connectionDidClose:(OIDLoopbackConnection *)connection;
+
+@end
+
+/*! @class OIDLoopbackConnection
+    @brief A connection accepted by an @c OIDLoopbackServer, which serves its requests in order.
+ */
+@interface OIDLoopbackConnection : NSObject
+
+/*! @fn initWithSocket:server:
+    @brief Takes ownership of an accepted socket and starts reading from it.
+ */
+- (instancetype)initWithSocket:(int)socket server:(OIDLoopbackServer *)server;
+
+/*! @fn close
+    @brief Closes the connection.
+ */
+- (void)close;
+
+@end
+
+@implementation OIDLoopbackConnection {
+  /*! @var _socket
+      @brief The connection's socket, closed by the read source's cancel handler.
+   */
+  int _socket;
+
+  /*! @var _queue
+      @brief The queue on which the connection is read, parsed and written.
+   */
+  dispatch_queue_t _queue;
+
+  /*! @var _readSource
+      @brief Fires when the socket has bytes to read.
+   */
+  dispatch_source_t _readSource;
+
+  /*! @var _buffer
+      @brief Bytes received but not yet parsed into a request.
+   */
+  NSMutableData *_buffer;
+
+  /*! @var _responding
+      @brief Whether a response is pending, in which case parsing waits for it.
+   */
+  BOOL _responding;
+
+  /*! @var _closed
+      @brief Whether the connection was closed.
+   */
+  BOOL _closed;
+
+  /*! @var _server
+      @brief The server which accepted the connection.
+   */
+  __weak OIDLoopbackServer *_server;
+}
+
+- (instancetype)initWithSocket:(int)socket server:(OIDLoopbackServer *)server {
+  self = [super init];
+  if (self) {
+    _socket = socket;
+    _server = server;
+    _buffer = [NSMutableData data];
+    _queue = dispatch_queue_create("net.openid.appauth.OIDLoopbackConnection",
+                                   DISPATCH_QUEUE_SERIAL);
+    _readSource =
+        dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)socket, 0, _queue);
+    __weak OIDLoopbackConnection *weakSelf = self;
+    dispatch_source_set_event_handler(_readSource, ^{
+      [weakSelf readAvailableBytes];
+    });
+    dispatch_source_set_cancel_handler(_readSource, ^{
+      close(socket);
+    });
+    dispatch_resume(_readSource);
+  }
+  return self;
+}
+
+- (void)close {
+  dispatch_async(_queue, ^{
+    [self closeOnQueue];
+  });
+}
+
+/*! @fn closeOnQueue
+    @brief Closes the connection. Called on @c _queue.
+ */
+- (void)closeOnQueue {
+  if (_closed) {
+    return;
+  }
+  _closed = YES;
+  dispatch_source_cancel(_readSource);
+  [_server connectionDidClose:self];
+}
+
+/*! @fn readAvailableBytes
+    @brief Reads from the socket, and serves any request which is now complete.
+ */
+- (void)readAvailableBytes {
+  if (_closed) {
+    return;
+  }
+  uint8_t bytes[kReadBufferSize];
+  ssize_t count = read(_socket, bytes, sizeof(bytes));
+  if (count < 0 && (errno == EAGAIN || errno == EINTR)) {
+    return;
+  }
+  if (count <= 0) {
+    [self closeOnQueue];
+    return;
+  }
+  [_buffer appendBytes:bytes length:(NSUInteger)count];
+  [self serveNextRequest];
+}
+
+/*! @fn serveNextRequest
+    @brief Serves the next buffered request, unless a response is still pending.
+ */
+- (void)serveNextRequest {
+  if (_responding || _closed) {
+    return;
+  }
+  BOOL malformed;
+  OIDLoopbackRequest *request = [OIDLoopbackRequest requestFromBuffer:_buffer malformed:&malformed];
+  if (malformed) {
+    [self closeOnQueue];
+    return;
+  }
+  if (!request) {
+    return;
+  }
+  OIDLoopbackServer *server = _server;
+  if (!server) {
+    [self closeOnQueue];
+    return;
+  }
+
+  _responding = YES;
+  OIDLoopbackResponse *response = [server responseToRequest:request];
+  NSTimeInterval delay = server.latency + response.delay;
+  dispatch_after(dispatch_time(DISPATCH_TIME_NOW, (int64_t)(delay * NSEC_PER_SEC)), _queue, ^{
+    self->_responding = NO;
+    if (response.closesConnection) {
+      [self closeOnQueue];
+      return;
+    }
+    NSDate *date = [NSDate dateWithTimeIntervalSinceNow:server.clockOffset];
+    if (![self writeData:[response HTTPMessageDataWithDate:date]]) {
+      [self closeOnQueue];
+      return;
+    }
+    [self serveNextRequest];
+  });
+}
+
+/*! @fn writeData:
+    @brief Writes all of @c data to the socket, waiting for it to become writable if necessary.
+    @return YES if the data was written.
+ */
+- (BOOL)writeData:(NSData *)data {
+  if (_closed) {
+    return NO;
+  }
+  const uint8_t *bytes = data.bytes;
+  NSUInteger remaining = data.length;
+  while (remaining) {
+    ssize_t written = write(_socket, bytes, remaining);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      struct pollfd pollDescriptor = { .fd = _socket, .events = POLLOUT };
+      if (errno != EAGAIN || poll(&pollDescriptor, 1, 1000) <= 0) {
+        return NO;
+      }
+      continue;
+    }
+    bytes += written;
+    remaining -= (NSUInteger)written;
+  }
+  return YES;
+}
+
+@end
+
+#pragma mark - OIDLoopbackServer
+
+@implementation OIDLoopbackServer {
+  /*! @var _listenSocket
+      @brief The listening socket, or -1 when not started.
+   */
+  int _listenSocket;
+
+  /*! @var _acceptSource
+      @brief Fires when a connection can be accepted.
+   */
+  dispatch_source_t _acceptSource;
+
+  /*! @var _connections
+      @brief The open connections.
+   */
+  NSMutableSet<OIDLoopbackConnection *> *_connections;
+
+  /*! @var _scriptedResponses
+      @brief Responses enqueued with @c enqueueResponse:forPath:, by path.
+   */
+  NSMutableDictionary<NSString *, NSMutableArray<OIDLoopbackResponse *> *> *_scriptedResponses;
+
+  /*! @var _requests
+      @brief The requests received, by path.
+   */
+  NSMutableDictionary<NSString *, NSMutableArray<OIDLoopbackRequest *> *> *_requests;
+
+  /*! @var _issuedTokenCount
+      @brief The number of token responses issued, which makes every token unique.
+   */
+  NSUInteger _issuedTokenCount;
+}
+
+@synthesize requestCount = _requestCount;
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _listenSocket = -1;
+    _accessTokenLifetime = 3600;
+    _JWKS = @{ @"keys" : @[ ] };
+    _revokedRefreshTokens = [NSSet set];
+    _userInfoClaims = @{ @"sub" : @"248289761001", @"name" : @"Jane Doe" };
+    _connections = [NSMutableSet set];
+    _scriptedResponses = [NSMutableDictionary dictionary];
+    _requests = [NSMutableDictionary dictionary];
+  }
+  return self;
+}
+
+- (void)dealloc {
+  [self stop];
+}
+
+- (BOOL)start {
+  int listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+  if (listenSocket < 0) {
+    return NO;
+  }
+  int reuse = 1;
+  setsockopt(listenSocket, SOL_SOCKET, SO_REUSEADDR, &reuse, sizeof(reuse));
+
+  struct sockaddr_in address = {
+    .sin_len = sizeof(struct sockaddr_in),
+    .sin_family = AF_INET,
+    .sin_port = 0,
+    .sin_addr.s_addr = htonl(INADDR_LOOPBACK),
+  };
+  socklen_t addressLength = sizeof(address);
+  if (bind(listenSocket, (struct sockaddr *)&address, sizeof(address)) != 0
+      || listen(listenSocket, kListenBacklog) != 0
+      || getsockname(listenSocket, (struct sockaddr *)&address, &addressLength) != 0) {
+    close(listenSocket);
+    return NO;
+  }
+  fcntl(listenSocket, F_SETFL, O_NONBLOCK);
+
+  _listenSocket = listenSocket;
+  _baseURL = [NSURL URLWithString:
+      [NSString stringWithFormat:@"http://127.0.0.1:%u", ntohs(address.sin_port)]];
+  dispatch_queue_t queue = dispatch_queue_create("net.openid.appauth.OIDLoopbackServer",
+                                                 DISPATCH_QUEUE_SERIAL);
+  _acceptSource =
+      dispatch_source_create(DISPATCH_SOURCE_TYPE_READ, (uintptr_t)listenSocket, 0, queue);
+  __weak OIDLoopbackServer *weakSelf = self;
+  dispatch_source_set_event_handler(_acceptSource, ^{
+    [weakSelf acceptConnections:listenSocket];
+  });
+  dispatch_source_set_cancel_handler(_acceptSource, ^{
+    close(listenSocket);
+  });
+  dispatch_resume(_acceptSource);
+  return YES;
+}
+
+- (void)stop {
+  if (_listenSocket < 0) {
+    return;
+  }
+  dispatch_source_cancel(_acceptSource);
+  _acceptSource = nil;
+  _listenSocket = -1;
+  NSSet<OIDLoopbackConnection *> *connections;
+  @synchronized(self) {
+    connections = [_connections copy];
+  }
+  for (OIDLoopbackConnection *connection in connections) {
+    [connection close];
+  }
+}
+
+/*! @fn acceptConnections:
+    @brief Accepts the pending connections of the listening socket.
+ */
+- (void)acceptConnections:(int)listenSocket {
+  while (YES) {
+    int connectionSocket = accept(listenSocket, NULL, NULL);
+    if (connectionSocket < 0) {
+      return;
+    }
+    int noSIGPIPE = 1;
+    setsockopt(connectionSocket, SOL_SOCKET, SO_NOSIGPIPE, &noSIGPIPE, sizeof(noSIGPIPE));
+    fcntl(connectionSocket, F_SETFL, O_NONBLOCK);
+    OIDLoopbackConnection *connection =
+        [[OIDLoopbackConnection alloc] initWithSocket:connectionSocket server:self];
+    @synchronized(self) {
+      [_connections addObject:connection];
+    }
+  }
+}
+
+- (void)connectionDidClose:(OIDLoopbackConnection *)connection {
+  @synchronized(self) {
+    [_connections removeObject:connection];
+  }
+}
+
+- (NSURL *)URLForPath:(NSString *)path {
+  return [NSURL URLWithString:path relativeToURL:_baseURL].absoluteURL;
+}
+
+- (void)enqueueResponse:(OIDLoopbackResponse *)response forPath:(NSString *)path {
+  @synchronized(self) {
+    NSMutableArray<OIDLoopbackResponse *> *responses = _scriptedResponses[path];
+    if (!responses) {
+      responses = [NSMutableArray array];
+      _scriptedResponses[path] = responses;
+    }
+    [responses addObject:response];
+  }
+}
+
+- (NSArray<OIDLoopbackRequest *> *)requestsForPath:(NSString *)path {
+  @synchronized(self) {
+    return [_requests[path] copy] ?: @[ ];
+  }
+}
+
+- (NSUInteger)requestCount {
+  @synchronized(self) {
+    return _requestCount;
+  }
+}
+
+#pragma mark - Responses
+
+- (OIDLoopbackResponse *)responseToRequest:(OIDLoopbackRequest *)request {
+  OIDLoopbackResponse *response;
+  @synchronized(self) {
+    _requestCount++;
+    NSMutableArray<OIDLoopbackRequest *> *requests = _requests[request.path];
+    if (!requests) {
+      requests = [NSMutableArray array];
+      _requests[request.path] = requests;
+    }
+    [requests addObject:request];
+
+    NSMutableArray<OIDLoopbackResponse *> *responses = _scriptedResponses[request.path];
+    response = responses.firstObject;
+    if (response) {
+      [responses removeObjectAtIndex:0];
+    }
+  }
+  if (!response) {
+    OIDLoopbackFaultInjector faultInjector = self.faultInjector;
+    response = faultInjector ? faultInjector(request) : nil;
+  }
+  return response ?: [self defaultResponseToRequest:request];
+}
+
+/*! @fn defaultResponseToRequest:
+    @brief The response of the stand-in provider.
+ */
+- (OIDLoopbackResponse *)defaultResponseToRequest:(OIDLoopbackRequest *)request {
+  if ([request.path isEqualToString:OIDLoopbackServerDiscoveryPath]) {
+    return [OIDLoopbackResponse responseWithStatusCode:200 JSON:[self discoveryDocument]];
+  }
+  if ([request.path isEqualToString:OIDLoopbackServerJWKSPath]) {
+    return [OIDLoopbackResponse responseWithStatusCode:200 JSON:self.JWKS];
+  }
+  if ([request.path isEqualToString:OIDLoopbackServerTokenPath]
+      && [request.method isEqualToString:@"POST"]) {
+    return [self tokenResponseWithParameters:request.formParameters];
+  }
+  if ([request.path isEqualToString:OIDLoopbackServerRevocationPath]
+      && [request.method isEqualToString:@"POST"]) {
+    return [self revocationResponseWithParameters:request.formParameters];
+  }
+  if ([request.path isEqualToString:OIDLoopbackServerIntrospectionPath]
+      && [request.method isEqualToString:@"POST"]) {
+    return [self introspectionResponseWithParameters:request.formParameters];
+  }
+  if ([request.path isEqualToString:OIDLoopbackServerUserInfoPath]) {
+    return [self userInfoResponseToRequest:request];
+  }
+  return [OIDLoopbackResponse serverErrorResponseWithStatusCode:404];
+}
+
+/*! @fn discoveryDocument
+    @brief The OpenID Connect discovery document of the stand-in provider.
+ */
+- (NSDictionary<NSString *, id> *)discoveryDocument {
+  return @{
+    @"issuer" : _baseURL.absoluteString,
+    @"authorization_endpoint" :
+        [self URLForPath:OIDLoopbackServerAuthorizationPath].absoluteString,
+    @"token_endpoint" : [self URLForPath:OIDLoopbackServerTokenPath].absoluteString,
+    @"jwks_uri" : [self URLForPath:OIDLoopbackServerJWKSPath].absoluteString,
+    @"revocation_endpoint" : [self URLForPath:OIDLoopbackServerRevocationPath].absoluteString,
+    @"introspection_endpoint" :
+        [self URLForPath:OIDLoopbackServerIntrospectionPath].absoluteString,
+    @"userinfo_endpoint" : [self URLForPath:OIDLoopbackServerUserInfoPath].absoluteString,
+    @"response_types_supported" : @[ @"code" ],
+    @"subject_types_supported" : @[ @"public" ],
+    @"id_token_signing_alg_values_supported" : @[ @"RS256", @"ES256" ],
+    @"grant_types_supported" : @[ @"authorization_code", @"refresh_token" ],
+  };
+}
+
+/*! @fn tokenResponseWithParameters:
+    @brief The response of the token endpoint to a request.
+ */
+- (OIDLoopbackResponse *)tokenResponseWithParameters:
+    (NSDictionary<NSString *, NSString *> *)parameters {
+  NSString *grantType = parameters[@"grant_type"];
+  BOOL issuesRefreshToken = NO;
+  if ([grantType isEqualToString:@"authorization_code"]) {
+    NSString *code = parameters[@"code"];
+    if (!code || [code isEqualToString:OIDLoopbackServerInvalidCode]) {
+      return [OIDLoopbackResponse OAuthErrorResponseWithError:@"invalid_grant"];
+    }
+    issuesRefreshToken = YES;
+  } else if ([grantType isEqualToString:@"refresh_token"]) {
+    NSString *refreshToken = parameters[@"refresh_token"];
+    @synchronized(self) {
+      if (!refreshToken || [self.revokedRefreshTokens containsObject:refreshToken]) {
+        return [OIDLoopbackResponse OAuthErrorResponseWithError:@"invalid_grant"];
+      }
+      if (self.rotatesRefreshTokens) {
+        self.revokedRefreshTokens = [self.revokedRefreshTokens setByAddingObject:refreshToken];
+        issuesRefreshToken = YES;
+      }
+    }
+  } else {
+    return [OIDLoopbackResponse OAuthErrorResponseWithError:@"unsupported_grant_type"];
+  }
+
+  NSUInteger tokenNumber;
+  @synchronized(self) {
+    tokenNumber = ++_issuedTokenCount;
+  }
+  NSMutableDictionary<NSString *, id> *JSON = [@{
+    @"access_token" : [NSString stringWithFormat:@"access-%lu", (unsigned long)tokenNumber],
+    @"token_type" : @"Bearer",
+    @"expires_in" : @(self.accessTokenLifetime),
+  } mutableCopy];
+  if (issuesRefreshToken) {
+    JSON[@"refresh_token"] = [NSString stringWithFormat:@"refresh-%lu", (unsigned long)tokenNumber];
+  }
+  return [OIDLoopbackResponse responseWithStatusCode:200 JSON:JSON];
+}
+
+/*! @fn revocationResponseWithParameters:
+    @brief The response of the revocation endpoint to a request.
+ */
+- (OIDLoopbackResponse *)revocationResponseWithParameters:
+    (NSDictionary<NSString *, NSString *> *)parameters {
+  NSString *token = parameters[@"token"];
+  NSString *tokenTypeHint = parameters[@"token_type_hint"];
+  if (!token) {
+    return [OIDLoopbackResponse OAuthErrorResponseWithError:@"invalid_request"];
+  }
+  if (tokenTypeHint && ![tokenTypeHint isEqualToString:@"access_token"]
+      && ![tokenTypeHint isEqualToString:@"refresh_token"]) {
+    return [OIDLoopbackResponse OAuthErrorResponseWithError:@"unsupported_token_type"];
+  }
+  @synchronized(self) {
+    self.revokedRefreshTokens = [self.revokedRefreshTokens setByAddingObject:token];
+  }
+  return [OIDLoopbackResponse responseWithStatusCode:200 JSON:@{ }];
+}
+
+/*! @fn introspectionResponseWithParameters:
+    @brief The response of the introspection endpoint to a request.
+ */
+- (OIDLoopbackResponse *)introspectionResponseWithParameters:
+    (NSDictionary<NSString *, NSString *> *)parameters {
+  NSString *token = parameters[@"token"];
+  if (!token) {
+    return [OIDLoopbackResponse OAuthErrorResponseWithError:@"invalid_request"];
+  }
+  if (![token hasPrefix:@"access-"] || [self.revokedRefreshTokens containsObject:token]) {
+    return [OIDLoopbackResponse responseWithStatusCode:200 JSON:@{ @"active" : @NO }];
+  }
+  NSTimeInterval now = [[NSDate date] timeIntervalSince1970];
+  return [OIDLoopbackResponse responseWithStatusCode:200 JSON:@{
+    @"active" : @YES,
+    @"token_type" : @"Bearer",
+    @"iat" : @((long long)now),
+    @"exp" : @((long long)(now + self.accessTokenLifetime)),
+  }];
+}
+
+/*! @fn userInfoResponseToRequest:
+    @brief The response of the userinfo endpoint to a request.
+ */
+- (OIDLoopbackResponse *)userInfoResponseToRequest:(OIDLoopbackRequest *)request {
+  NSString *authorization = request.headers[@"authorization"];
+  NSString *token = [authorization hasPrefix:@"Bearer "]
+      ? [authorization substringFromIndex:@"Bearer ".length]
+      : nil;
+  if (![token hasPrefix:@"access-"] || [self.revokedRefreshTokens containsObject:token]) {
+    OIDLoopbackResponse *response = [[OIDLoopbackResponse alloc] init];
+    response.statusCode = 401;
+    response.headers = @{ @"WWW-Authenticate" : @"Bearer error=\"invalid_token\"" };
+    return response;
+  }
+
+  OIDLoopbackResponse *response =
+      [OIDLoopbackResponse responseWithStatusCode:200 JSON:self.userInfoClaims];
+  NSString *body = [[NSString alloc] initWithData:response.body encoding:NSUTF8StringEncoding];
+  NSString *ETag = [NSString stringWithFormat:@"\"%@\"",
+      [OIDTokenUtilities encodeBase64urlNoPadding:[OIDTokenUtilities sha265:body]]];
+  if ([request.headers[@"if-none-match"] isEqualToString:ETag]) {
+    response = [[OIDLoopbackResponse alloc] init];
+    response.statusCode = 304;
+  } else {
+    NSMutableDictionary<NSString *, NSString *> *headers = [response.headers mutableCopy];
+    headers[@"ETag"] = ETag;
+    response.headers = headers;
+  }
+  return response;
+}
+
+@end
@@ -0,0 +1,223 @@
+/*! @file OIDMetricsObserverTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "OIDAuthorizationResponseTests.h"
+#import "OIDLoopbackServer.h"
+#import "OIDTokenRequestTests.h"
+#import "Source/OIDAuthState.h"
+#import "Source/OIDAuthorizationRequest.h"
+#import "Source/OIDAuthorizationResponse.h"
+#import "Source/OIDAuthorizationService.h"
+#import "Source/OIDMetricsObserver.h"
+#import "Source/OIDResponseTypes.h"
+#import "Source/OIDServiceConfiguration.h"
+#import "Source/OIDTokenResponse.h"
+
+/*! @class OIDMetricsObserverTests
+    @brief Unit tests for @c OIDMetricsObserver and @c OIDMetricsEvent.
+ */
+@interface OIDMetricsObserverTests : XCTestCase <OIDMetricsObserver>
+@end
+
+@implementation OIDMetricsObserverTests {
+  /*! @var _events
+      @brief The events recorded during the test.
+   */
+  NSMutableArray<OIDMetricsEvent *> *_events;
+}
+
+- (void)setUp {
+  [super setUp];
+  _events = [NSMutableArray array];
+}
+
+- (void)tearDown {
+  [OIDAuthorizationService setMetricsObserver:nil];
+  [super tearDown];
+}
+
+#pragma mark OIDMetricsObserver methods
+
+- (void)didRecordMetricsEvent:(OIDMetricsEvent *)event {
+  @synchronized(_events) {
+    [_events addObject:event];
+  }
+}
+
+#pragma mark Tests
+
+/*! @fn testEventDefaults
+    @brief Tests that timings which weren't measured are reported as unavailable.
+ */
+- (void)testEventDefaults {
+  OIDMetricsEvent *event = [[OIDMetricsEvent alloc] initWithType:OIDMetricsEventTypeDiscovery];
+  XCTAssertEqual(event.type, OIDMetricsEventTypeDiscovery);
+  XCTAssertEqual(event.duration, OIDMetricsTimingUnavailable);
+  XCTAssertEqual(event.domainLookupDuration, OIDMetricsTimingUnavailable);
+  XCTAssertEqual(event.connectDuration, OIDMetricsTimingUnavailable);
+  XCTAssertEqual(event.secureConnectionDuration, OIDMetricsTimingUnavailable);
+  XCTAssertEqual(event.timeToFirstByte, OIDMetricsTimingUnavailable);
+  XCTAssertEqual(event.parseDuration, OIDMetricsTimingUnavailable);
+  XCTAssertEqual(event.cacheResult, OIDMetricsCacheResultNotApplicable);
+}
+
+/*! @fn testFreshTokensCacheHit
+    @brief Tests that an action served from valid tokens is reported as a cache hit.
+ */
+- (void)testFreshTokensCacheHit {
+  OIDTokenResponse *tokenResponse =
+      [[OIDTokenResponse alloc] initWithRequest:[OIDTokenRequestTests testInstance]
+                                     parameters:@{
+        @"access_token" : @"access_token",
+        @"expires_in" : @3600,
+        @"token_type" : @"Bearer",
+        @"refresh_token" : @"refresh_token",
+      }];
+  OIDAuthState *authState =
+      [[OIDAuthState alloc] initWithAuthorizationResponse:
+                                [OIDAuthorizationResponseTests testInstanceCodeFlow]
+                                            tokenResponse:tokenResponse];
+  [OIDAuthorizationService setMetricsObserver:self];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssertEqualObjects(accessToken, @"access_token");
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:2 handler:nil];
+
+  XCTAssertEqual(_events.count, 1u);
+  OIDMetricsEvent *event = _events.firstObject;
+  XCTAssertEqual(event.type, OIDMetricsEventTypeFreshTokens);
+  XCTAssertEqual(event.cacheResult, OIDMetricsCacheResultHit);
+  XCTAssertEqual(event.coalescedWaiterCount, 1u);
+  XCTAssertGreaterThanOrEqual(event.duration, 0);
+  XCTAssertNil(event.error);
+}
+
+/*! @fn testTokenRequest
+    @brief Tests that the observer receives an event for a token request.
+ */
+- (void)testTokenRequest {
+  OIDLoopbackServer *server = [[OIDLoopbackServer alloc] init];
+  XCTAssert([server start]);
+  NSURL *tokenEndpoint = [server URLForPath:OIDLoopbackServerTokenPath];
+  OIDServiceConfiguration *configuration =
+      [[OIDServiceConfiguration alloc]
+          initWithAuthorizationEndpoint:[server URLForPath:OIDLoopbackServerAuthorizationPath]
+                          tokenEndpoint:tokenEndpoint];
+  OIDAuthorizationRequest *request =
+      [[OIDAuthorizationRequest alloc] initWithConfiguration:configuration
+                                                    clientId:@"client"
+                                                      scopes:@[ @"openid" ]
+                                                 redirectURL:[NSURL URLWithString:@"app:/cb"]
+                                                responseType:OIDResponseTypeCode
+                                        additionalParameters:nil];
+  OIDAuthorizationResponse *authorizationResponse =
+      [[OIDAuthorizationResponse alloc] initWithRequest:request
+                                             parameters:@{ @"code" : @"code",
+                                                           @"state" : request.state }];
+  [OIDAuthorizationService setMetricsObserver:self];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [OIDAuthorizationService performTokenRequest:[authorizationResponse tokenExchangeRequest]
+                                      callback:^(OIDTokenResponse *_Nullable tokenResponse,
+                                                 NSError *_Nullable error) {
+    XCTAssertNotNil(tokenResponse);
+    [expectation fulfill];
+  }];
+  // the event may be reported after the callback, once the task metrics are collected
+  NSMutableArray<OIDMetricsEvent *> *events = _events;
+  [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object,
+                                                                      NSDictionary *bindings) {
+    @synchronized(events) {
+      return events.count > 0;
+    }
+  }]
+            evaluatedWithObject:events
+                        handler:nil];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  [server stop];
+
+  XCTAssertEqual(_events.count, 1u);
+  OIDMetricsEvent *event = _events.firstObject;
+  XCTAssertEqual(event.type, OIDMetricsEventTypeTokenRequest);
+  XCTAssertEqualObjects(event.URL, tokenEndpoint);
+  XCTAssertEqualObjects(event.grantType, @"authorization_code");
+  XCTAssertGreaterThanOrEqual(event.duration, 0);
+  XCTAssertNil(event.error);
+}
+
+/*! @fn testUserInfoRequest
+    @brief Tests that the observer receives an event for a userinfo request, with the error of a
+        rejected access token.
+ */
+- (void)testUserInfoRequest {
+  OIDLoopbackServer *server = [[OIDLoopbackServer alloc] init];
+  XCTAssert([server start]);
+  NSURL *userInfoEndpoint = [server URLForPath:OIDLoopbackServerUserInfoPath];
+  NSMutableURLRequest *URLRequest = [NSMutableURLRequest requestWithURL:userInfoEndpoint];
+  [URLRequest setValue:@"Bearer unknown" forHTTPHeaderField:@"Authorization"];
+  [OIDAuthorizationService setMetricsObserver:self];
+
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Callback should be called."];
+  [OIDAuthorizationService performUserInfoRequest:URLRequest
+                                         callback:^(NSHTTPURLResponse *_Nullable response,
+                                                    NSData *_Nullable data,
+                                                    NSError *_Nullable error) {
+    XCTAssertNil(error);
+    XCTAssertEqual(response.statusCode, 401);
+    [expectation fulfill];
+  }];
+  // the event may be reported after the callback, once the task metrics are collected
+  NSMutableArray<OIDMetricsEvent *> *events = _events;
+  [self expectationForPredicate:[NSPredicate predicateWithBlock:^BOOL(id object,
+                                                                      NSDictionary *bindings) {
+    @synchronized(events) {
+      return events.count > 0;
+    }
+  }]
+            evaluatedWithObject:events
+                        handler:nil];
+  [self waitForExpectationsWithTimeout:5 handler:nil];
+  [server stop];
+
+  XCTAssertEqual(_events.count, 1u);
+  OIDMetricsEvent *event = _events.firstObject;
+  XCTAssertEqual(event.type, OIDMetricsEventTypeUserInfo);
+  XCTAssertEqualObjects(event.URL, userInfoEndpoint);
+  XCTAssertGreaterThanOrEqual(event.duration, 0);
+  XCTAssertNotNil(event.error);
+}
+
+/*! @fn testSetMetricsObserver
+    @brief Tests setting and clearing the metrics observer.
+ */
+- (void)testSetMetricsObserver {
+  XCTAssertNil([OIDAuthorizationService metricsObserver]);
+  [OIDAuthorizationService setMetricsObserver:self];
+  XCTAssertEqual([OIDAuthorizationService metricsObserver], self);
+  [OIDAuthorizationService setMetricsObserver:nil];
+  XCTAssertNil([OIDAuthorizationService metricsObserver]);
+}
+
+@end
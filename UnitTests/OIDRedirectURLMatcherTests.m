@@ -0,0 +1,98 @@
+/*! @file OIDRedirectURLMatcherTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "Source/OIDRedirectURLMatcher.h"
+
+/*! @class OIDRedirectURLMatcherTests
+    @brief Unit tests for @c OIDRedirectURLMatcher.
+ */
+@interface OIDRedirectURLMatcherTests : XCTestCase
+@end
+
+@implementation OIDRedirectURLMatcherTests
+
+/*! @fn matcherForURLString:
+    @brief A matcher for a redirect URL.
+ */
+- (OIDRedirectURLMatcher *)matcherForURLString:(NSString *)URLString {
+  return [[OIDRedirectURLMatcher alloc] initWithRedirectURL:[NSURL URLWithString:URLString]];
+}
+
+/*! @fn testMatching
+    @brief Tests that URLs match on their scheme, user, password, host, port and path only.
+ */
+- (void)testMatching {
+  OIDRedirectURLMatcher *matcher = [self matcherForURLString:@"https://app.example.com:8443/cb"];
+  NSArray<NSString *> *matching = @[
+    @"https://app.example.com:8443/cb",
+    @"https://app.example.com:8443/cb?code=abc&state=xyz",
+    @"https://app.example.com:8443/cb#access_token=abc",
+    @"https://app.example.com:8443/x/../cb?code=abc",
+  ];
+  for (NSString *URLString in matching) {
+    XCTAssert([matcher matchesURL:[NSURL URLWithString:URLString]], @"%@", URLString);
+  }
+  NSArray<NSString *> *other = @[
+    @"http://app.example.com:8443/cb",
+    @"https://app.example.com/cb",
+    @"https://user@app.example.com:8443/cb",
+    @"https://other.example.com:8443/cb",
+    @"https://app.example.com:8443/cb/",
+    @"https://app.example.com:8443/c",
+    @"https://app.example.com:8443/cbx?code=abc",
+  ];
+  for (NSString *URLString in other) {
+    XCTAssertFalse([matcher matchesURL:[NSURL URLWithString:URLString]], @"%@", URLString);
+  }
+}
+
+/*! @fn testCustomScheme
+    @brief Tests matching redirects to a custom scheme without a host.
+ */
+- (void)testCustomScheme {
+  OIDRedirectURLMatcher *matcher = [self matcherForURLString:@"com.example.app:/oauth2redirect"];
+  NSURL *redirect = [NSURL URLWithString:@"com.example.app:/oauth2redirect?code=abc"];
+  XCTAssert([matcher matchesURL:redirect]);
+  XCTAssertFalse([matcher matchesURL:[NSURL URLWithString:@"com.example.other:/oauth2redirect"]]);
+  XCTAssertFalse([matcher matchesURL:[NSURL URLWithString:@"com.example.app:/oauth2"]]);
+}
+
+/*! @fn testLongURL
+    @brief Tests matching a URL too long for the stack buffer.
+ */
+- (void)testLongURL {
+  OIDRedirectURLMatcher *matcher = [self matcherForURLString:@"app:/cb"];
+  NSString *longValue = [@"" stringByPaddingToLength:4096 withString:@"a" startingAtIndex:0];
+  NSString *URLString = [NSString stringWithFormat:@"app:/cb?code=%@", longValue];
+  XCTAssert([matcher matchesURL:[NSURL URLWithString:URLString]]);
+}
+
+/*! @fn testKey
+    @brief Tests that matching URLs have the key of the matcher, and others don't.
+ */
+- (void)testKey {
+  OIDRedirectURLMatcher *matcher = [self matcherForURLString:@"https://app.example.com/a/./cb"];
+  NSURL *redirect = [NSURL URLWithString:@"https://app.example.com/a/cb?code=abc"];
+  XCTAssertEqualObjects([OIDRedirectURLMatcher keyForURL:redirect], matcher.key);
+  NSURL *other = [NSURL URLWithString:@"https://app.example.com/b/cb?code=abc"];
+  XCTAssertNotEqualObjects([OIDRedirectURLMatcher keyForURL:other], matcher.key);
+}
+
+@end
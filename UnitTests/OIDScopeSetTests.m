@@ -0,0 +1,127 @@
+/*! @file OIDScopeSetTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "Source/OIDScopeSet.h"
+
+/*! @class OIDScopeSetTests
+    @brief Unit tests for @c OIDScopeSet.
+ */
+@interface OIDScopeSetTests : XCTestCase
+@end
+
+@implementation OIDScopeSetTests
+
+/*! @fn testParsing
+    @brief Tests that scope strings are parsed into sets, ignoring order, duplicates and empty
+        scopes.
+ */
+- (void)testParsing {
+  OIDScopeSet *scopeSet = [OIDScopeSet scopeSetWithString:@"profile openid  email openid"];
+  XCTAssertEqual(scopeSet.count, 3u);
+  XCTAssertEqualObjects(scopeSet.scopes, (@[ @"email", @"openid", @"profile" ]));
+  XCTAssertEqualObjects(scopeSet.scopeString, @"email openid profile");
+  XCTAssertEqualObjects(scopeSet,
+                        [OIDScopeSet scopeSetWithArray:@[ @"openid", @"email", @"profile" ]]);
+  XCTAssertEqual(scopeSet.hash,
+                 [OIDScopeSet scopeSetWithArray:@[ @"openid", @"email", @"profile" ]].hash);
+  XCTAssertEqual([OIDScopeSet scopeSetWithString:nil].count, 0u);
+  XCTAssertEqualObjects([OIDScopeSet scopeSetWithString:@""], [[OIDScopeSet alloc] init]);
+}
+
+/*! @fn testContainment
+    @brief Tests single scope and subset containment.
+ */
+- (void)testContainment {
+  OIDScopeSet *granted = [OIDScopeSet scopeSetWithString:@"openid profile email"];
+  XCTAssert([granted containsScope:@"profile"]);
+  XCTAssertFalse([granted containsScope:@"phone"]);
+  XCTAssertFalse([granted containsScope:@"never-interned-scope"]);
+  XCTAssert([granted containsScopeSet:[OIDScopeSet scopeSetWithString:@"email openid"]]);
+  XCTAssert([granted containsScopeSet:[[OIDScopeSet alloc] init]]);
+  XCTAssertFalse([granted containsScopeSet:[OIDScopeSet scopeSetWithString:@"openid phone"]]);
+  XCTAssertFalse([[[OIDScopeSet alloc] init] containsScopeSet:granted]);
+}
+
+/*! @fn testUnion
+    @brief Tests that unions have the scopes of both sets.
+ */
+- (void)testUnion {
+  OIDScopeSet *openID = [OIDScopeSet scopeSetWithString:@"openid"];
+  OIDScopeSet *combined =
+      [openID scopeSetByAddingScopeSet:[OIDScopeSet scopeSetWithString:@"email openid"]];
+  XCTAssertEqualObjects(combined.scopeString, @"email openid");
+  XCTAssertEqual([combined scopeSetByAddingScopeSet:openID], combined);
+}
+
+/*! @fn testManyScopes
+    @brief Tests sets spanning several words, as once more than 64 scopes have been interned.
+ */
+- (void)testManyScopes {
+  NSMutableArray<NSString *> *scopes = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 200; i++) {
+    [scopes addObject:[NSString stringWithFormat:@"scope-%03lu", (unsigned long)i]];
+  }
+  OIDScopeSet *all = [OIDScopeSet scopeSetWithArray:scopes];
+  OIDScopeSet *last = [OIDScopeSet scopeSetWithArray:@[ scopes.lastObject ]];
+  OIDScopeSet *first = [OIDScopeSet scopeSetWithArray:@[ scopes.firstObject ]];
+  XCTAssertEqual(all.count, 200u);
+  XCTAssertEqualObjects(all.scopes, scopes);
+  XCTAssert([all containsScopeSet:last]);
+  XCTAssertFalse([first containsScopeSet:last]);
+  XCTAssertEqual([first scopeSetByAddingScopeSet:last].count, 2u);
+  XCTAssert([all containsScope:@"scope-150"]);
+}
+
+/*! @fn testUninternedScopes
+    @brief Tests sets of scopes seen after the atom table filled up, which hold them as strings.
+ */
+- (void)testUninternedScopes {
+  // more distinct scopes than are ever interned
+  NSMutableArray<NSString *> *scopes = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 1100; i++) {
+    [scopes addObject:[NSString stringWithFormat:@"uninterned-%04lu", (unsigned long)i]];
+  }
+  OIDScopeSet *all = [OIDScopeSet scopeSetWithArray:scopes];
+  XCTAssertEqual(all.count, 1100u);
+  XCTAssertEqualObjects(all.scopes, scopes);
+  XCTAssert([all containsScope:scopes.lastObject]);
+
+  OIDScopeSet *last = [OIDScopeSet scopeSetWithArray:@[ scopes.lastObject, @"openid" ]];
+  XCTAssertEqual(last.count, 2u);
+  XCTAssert([last containsScope:scopes.lastObject]);
+  XCTAssertFalse([last containsScope:scopes.firstObject]);
+  XCTAssertFalse([all containsScopeSet:last]);
+  XCTAssert([[all scopeSetByAddingScopeSet:last] containsScopeSet:last]);
+  XCTAssertEqual([all scopeSetByAddingScopeSet:last].count, 1101u);
+  XCTAssertEqualObjects(last, [OIDScopeSet scopeSetWithArray:@[ @"openid", scopes.lastObject ]]);
+  XCTAssertNotEqualObjects(last, [OIDScopeSet scopeSetWithArray:@[ scopes.lastObject ]]);
+}
+
+/*! @fn testSecureCoding
+    @brief Tests that sets are archived by their scopes rather than their process-local atoms.
+ */
+- (void)testSecureCoding {
+  OIDScopeSet *scopeSet = [OIDScopeSet scopeSetWithString:@"openid profile"];
+  NSData *data = [NSKeyedArchiver archivedDataWithRootObject:scopeSet];
+  OIDScopeSet *unarchived = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  XCTAssertEqualObjects(unarchived, scopeSet);
+}
+
+@end
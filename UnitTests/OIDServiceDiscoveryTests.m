@@ -34,6 +34,8 @@ static NSString *const kTokenEndpointKey = @"token_endpoint";
 static NSString *const kUserinfoEndpointKey = @"userinfo_endpoint";
 static NSString *const kJWKSURLKey = @"jwks_uri";
 static NSString *const kRegistrationEndpointKey = @"registration_endpoint";
+static NSString *const kRevocationEndpointKey = @"revocation_endpoint";
+static NSString *const kIntrospectionEndpointKey = @"introspection_endpoint";
 static NSString *const kScopesSupportedKey = @"scopes_supported";
 static NSString *const kResponseTypesSupportedKey = @"response_types_supported";
 static NSString *const kResponseModesSupportedKey = @"response_modes_supported";
@@ -479,6 +481,8 @@ TestURLFieldBackedBy(tokenEndpoint, kTokenEndpointKey, kTestURL);
 TestURLFieldBackedBy(userinfoEndpoint, kUserinfoEndpointKey, kTestURL);
 TestURLFieldBackedBy(jwksURL, kJWKSURLKey, kTestURL);
 TestURLFieldBackedBy(registrationEndpoint, kRegistrationEndpointKey, kTestURL);
+TestURLFieldBackedBy(revocationEndpoint, kRevocationEndpointKey, kTestURL);
+TestURLFieldBackedBy(introspectionEndpoint, kIntrospectionEndpointKey, kTestURL);
 TestFieldBackedBy(scopesSupported, kScopesSupportedKey, @"Scopes Supported");
 TestFieldBackedBy(responseTypesSupported, kResponseTypesSupportedKey, @"Response Types Supported");
 TestFieldBackedBy(responseModesSupported, kResponseModesSupportedKey, @"Response Modes Supported");
@@ -0,0 +1,261 @@
+/*! @file OIDSharedTokenStoreTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#import "OIDLoopbackServer.h"
+#import "Source/OIDAuthState.h"
+#import "Source/OIDAuthorizationRequest.h"
+#import "Source/OIDAuthorizationResponse.h"
+#import "Source/OIDClockSkewEstimator.h"
+#import "Source/OIDResponseTypes.h"
+#import "Source/OIDServiceConfiguration.h"
+#import "Source/OIDSharedTokenStore.h"
+#import "Source/OIDTokenResponse.h"
+
+/*! @var kTestTimeout
+    @brief How long to wait for a request to the loopback server.
+ */
+static const NSTimeInterval kTestTimeout = 5;
+
+/*! @class OIDSharedTokenStoreTests
+    @brief Unit tests for @c OIDSharedTokenStore.
+ */
+@interface OIDSharedTokenStoreTests : XCTestCase
+@end
+
+@implementation OIDSharedTokenStoreTests {
+  /*! @var _server
+      @brief The stand-in provider.
+   */
+  OIDLoopbackServer *_server;
+}
+
+- (void)setUp {
+  [super setUp];
+  _server = [[OIDLoopbackServer alloc] init];
+  XCTAssert([_server start]);
+}
+
+- (void)tearDown {
+  [_server stop];
+  _server = nil;
+  // the next test's server may reuse the port, and so the issuer
+  [[OIDClockSkewEstimator sharedEstimator] removeAllEstimates];
+  [super tearDown];
+}
+
+/*! @fn authStateWithAccessToken:
+    @brief An auth state of the loopback server, with the refresh token "refresh".
+    @param accessToken The access token of the state.
+ */
+- (OIDAuthState *)authStateWithAccessToken:(NSString *)accessToken {
+  OIDServiceConfiguration *configuration =
+      [[OIDServiceConfiguration alloc]
+          initWithAuthorizationEndpoint:[_server URLForPath:OIDLoopbackServerAuthorizationPath]
+                          tokenEndpoint:[_server URLForPath:OIDLoopbackServerTokenPath]];
+  OIDAuthorizationRequest *request =
+      [[OIDAuthorizationRequest alloc] initWithConfiguration:configuration
+                                                    clientId:@"client"
+                                                      scopes:@[ @"openid" ]
+                                                 redirectURL:[NSURL URLWithString:@"app:/cb"]
+                                                responseType:OIDResponseTypeCode
+                                        additionalParameters:nil];
+  OIDAuthorizationResponse *authorizationResponse =
+      [[OIDAuthorizationResponse alloc] initWithRequest:request
+                                             parameters:@{ @"code" : @"code",
+                                                           @"state" : request.state }];
+  OIDTokenResponse *tokenResponse =
+      [[OIDTokenResponse alloc] initWithRequest:[authorizationResponse tokenExchangeRequest]
+                                     parameters:@{
+        @"access_token" : accessToken,
+        @"expires_in" : @3600,
+        @"token_type" : @"Bearer",
+        @"refresh_token" : @"refresh",
+      }];
+  return [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                               tokenResponse:tokenResponse];
+}
+
+/*! @fn accessTokenOfAuthState:
+    @brief Gets a fresh access token of an auth state and waits for it.
+ */
+- (nullable NSString *)accessTokenOfAuthState:(OIDAuthState *)authState {
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  __block NSString *token;
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    XCTAssert([NSThread isMainThread]);
+    token = accessToken;
+    [expectation fulfill];
+  }];
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  return token;
+}
+
+/*! @fn testSharedTokenStore
+    @brief Tests that auth states sharing a token store use each other's refreshes.
+ */
+- (void)testSharedTokenStore {
+  NSString *path =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+  NSURL *fileURL = [NSURL fileURLWithPath:path];
+  // stores of the same file lock it independently, as those of separate processes would
+  NSError *error;
+  OIDSharedTokenStore *storeA = [[OIDSharedTokenStore alloc] initWithFileURL:fileURL error:&error];
+  OIDSharedTokenStore *storeB = [[OIDSharedTokenStore alloc] initWithFileURL:fileURL error:&error];
+  XCTAssertNotNil(storeA);
+  XCTAssertNotNil(storeB);
+  OIDAuthState *authStateA = [self authStateWithAccessToken:@"access-100"];
+  OIDAuthState *authStateB = [self authStateWithAccessToken:@"access-100"];
+  authStateA.sharedTokenStore = storeA;
+  authStateB.sharedTokenStore = storeB;
+
+  // a fresh published token is used without touching the network
+  [authStateA setNeedsTokenRefresh];
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authStateA],
+                        @"access-1");
+  [authStateB setNeedsTokenRefresh];
+  XCTAssertEqualObjects([self accessTokenOfAuthState:authStateB],
+                        @"access-1");
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+
+  // concurrent refreshes wait for each other, and the second uses the result of the first
+  _server.latency = 0.2;
+  [authStateA setNeedsTokenRefresh];
+  [authStateB setNeedsTokenRefresh];
+  NSMutableArray<NSString *> *tokens = [NSMutableArray array];
+  for (OIDAuthState *authState in @[ authStateA, authStateB ]) {
+    XCTestExpectation *expectation =
+        [self expectationWithDescription:@"Action should be called."];
+    [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                              NSString *_Nullable idToken,
+                                              NSError *_Nullable actionError) {
+      [tokens addObject:accessToken ?: @""];
+      [expectation fulfill];
+    }];
+  }
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqualObjects(tokens, (@[ @"access-2", @"access-2" ]));
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 2u);
+
+  [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+}
+
+/*! @fn testSharedTokenStoreUnlockedDuringRefresh
+    @brief Tests that the shared file isn't locked while a refresh waits for the token endpoint.
+ */
+- (void)testSharedTokenStoreUnlockedDuringRefresh {
+  NSString *path =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+  NSURL *fileURL = [NSURL fileURLWithPath:path];
+  NSError *error;
+  OIDSharedTokenStore *store = [[OIDSharedTokenStore alloc] initWithFileURL:fileURL error:&error];
+  XCTAssertNotNil(store);
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  authState.sharedTokenStore = store;
+  _server.latency = 0.5;
+  [authState setNeedsTokenRefresh];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable actionError) {
+    XCTAssertEqualObjects(accessToken, @"access-1");
+    [expectation fulfill];
+  }];
+
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.2]];
+  int fileDescriptor = open(path.fileSystemRepresentation, O_RDWR);
+  XCTAssertEqual(flock(fileDescriptor, LOCK_EX | LOCK_NB), 0);
+  flock(fileDescriptor, LOCK_UN);
+  close(fileDescriptor);
+
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+  [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+}
+
+#if TARGET_OS_SIMULATOR || !TARGET_OS_IPHONE
+/*! @fn testSharedTokenStoreLockedByAnotherProcess
+    @brief Tests that a refresh waits while another process holds the shared file's lock, and
+        proceeds once that process dies without unlocking it.
+    @remarks Only syscalls are made in the child, which can't use the Objective-C runtime of a
+        multithreaded parent. Processes can't be forked on iOS devices.
+ */
+- (void)testSharedTokenStoreLockedByAnotherProcess {
+  NSString *path =
+      [NSTemporaryDirectory() stringByAppendingPathComponent:[NSUUID UUID].UUIDString];
+  NSURL *fileURL = [NSURL fileURLWithPath:path];
+  NSError *error;
+  OIDSharedTokenStore *store = [[OIDSharedTokenStore alloc] initWithFileURL:fileURL error:&error];
+  XCTAssertNotNil(store);
+  OIDAuthState *authState = [self authStateWithAccessToken:@"access-100"];
+  authState.sharedTokenStore = store;
+
+  int locked[2];
+  XCTAssertEqual(pipe(locked), 0);
+  const char *fileSystemPath = path.fileSystemRepresentation;
+  pid_t child = fork();
+  if (child == 0) {
+    // the child's own open file description, as an inherited one would share the parent's lock
+    int fileDescriptor = open(fileSystemPath, O_RDWR);
+    char result = (fileDescriptor >= 0 && flock(fileDescriptor, LOCK_EX) == 0);
+    write(locked[1], &result, 1);
+    struct timespec holdTime = { .tv_sec = 0, .tv_nsec = 300 * NSEC_PER_MSEC };
+    nanosleep(&holdTime, NULL);
+    _exit(0);
+  }
+  close(locked[1]);
+  if (child < 0) {
+    XCTFail(@"The child process couldn't be forked.");
+    close(locked[0]);
+    return;
+  }
+  char childLocked = 0;
+  XCTAssertEqual(read(locked[0], &childLocked, 1), 1);
+  close(locked[0]);
+  XCTAssertTrue(childLocked);
+
+  [authState setNeedsTokenRefresh];
+  XCTestExpectation *expectation = [self expectationWithDescription:@"Action should be called."];
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable actionError) {
+    XCTAssertNil(actionError);
+    XCTAssertEqualObjects(accessToken, @"access-1");
+    [expectation fulfill];
+  }];
+  [[NSRunLoop currentRunLoop] runUntilDate:[NSDate dateWithTimeIntervalSinceNow:0.1]];
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 0u);
+  [self waitForExpectationsWithTimeout:kTestTimeout handler:nil];
+
+  int status = 0;
+  XCTAssertEqual(waitpid(child, &status, 0), child);
+  XCTAssertEqual([_server requestsForPath:OIDLoopbackServerTokenPath].count, 1u);
+  [[NSFileManager defaultManager] removeItemAtURL:fileURL error:NULL];
+}
+#endif
+
+@end
@@ -0,0 +1,110 @@
+/*! @file OIDSimulation.h
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <Foundation/Foundation.h>
+
+#import "Source/OIDExecutor.h"
+#import "Source/OIDMetricsObserver.h"
+#import "Source/OIDMonotonicClock.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @class OIDSimulation
+    @brief Runs the library in virtual time against a simulated token endpoint, to measure refresh
+        behavior across many sessions in moments and deterministically.
+    @discussion Once installed, the simulation is the library's clock, executor, \NSURLSession and
+        metrics observer. Nothing happens until @c runForInterval: is called, which runs the
+        submitted blocks in order of their virtual time, advancing the clock to each in turn.
+        Everything runs on the calling thread, so the library's behavior depends only on the
+        blocks submitted, never on real timing.
+ */
+@interface OIDSimulation : NSObject <OIDClock, OIDExecutor, OIDMetricsObserver>
+
+/*! @property tokenEndpoint
+    @brief The URL of the simulated token endpoint, which answers every request by issuing a new
+        access token, without rotating the refresh token.
+ */
+@property(nonatomic, readonly) NSURL *tokenEndpoint;
+
+/*! @property accessTokenLifetime
+    @brief The @c expires_in of issued access tokens. Defaults to 3600.
+ */
+@property(nonatomic) NSTimeInterval accessTokenLifetime;
+
+/*! @property latency
+    @brief How long the token endpoint takes to respond. Defaults to 0.2 seconds.
+ */
+@property(nonatomic) NSTimeInterval latency;
+
+/*! @property elapsedTime
+    @brief The virtual time passed since the simulation was created, in seconds.
+ */
+@property(nonatomic, readonly) NSTimeInterval elapsedTime;
+
+/*! @property tokenRequestCount
+    @brief The number of requests the token endpoint received.
+ */
+@property(nonatomic, readonly) NSUInteger tokenRequestCount;
+
+/*! @property peakTokenRequestsInFlight
+    @brief The most requests the token endpoint was serving at once.
+ */
+@property(nonatomic, readonly) NSUInteger peakTokenRequestsInFlight;
+
+/*! @property peakTokenRequestsPerSecond
+    @brief The most requests the token endpoint received within one second of virtual time.
+ */
+@property(nonatomic, readonly) NSUInteger peakTokenRequestsPerSecond;
+
+/*! @property cacheHitCount
+    @brief The number of actions performed with the current tokens, without waiting on a refresh.
+ */
+@property(nonatomic, readonly) NSUInteger cacheHitCount;
+
+/*! @property refreshCount
+    @brief The number of refreshes which actions waited on.
+ */
+@property(nonatomic, readonly) NSUInteger refreshCount;
+
+/*! @property refreshWaiterCount
+    @brief The number of actions which waited on a refresh, summed over all refreshes.
+ */
+@property(nonatomic, readonly) NSUInteger refreshWaiterCount;
+
+/*! @fn install
+    @brief Makes the simulation the library's clock, executor, session and metrics observer.
+    @discussion Should be called before creating the tokens to simulate, as their expiry is taken
+        on the clock.
+ */
+- (void)install;
+
+/*! @fn uninstall
+    @brief Restores the library's clock, executor and session, and removes the metrics observer.
+ */
+- (void)uninstall;
+
+/*! @fn runForInterval:
+    @brief Runs the blocks due within an interval of virtual time, including those they submit,
+        then advances the clock to its end.
+    @param interval The interval in seconds.
+ */
+- (void)runForInterval:(NSTimeInterval)interval;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,445 @@
+/*! @file OIDSimulation.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import "OIDSimulation.h"
+
+#import "Source/OIDAuthorizationService.h"
+
+/*! @var kDefaultAccessTokenLifetime
+    @brief The default of @c OIDSimulation.accessTokenLifetime.
+ */
+static const NSTimeInterval kDefaultAccessTokenLifetime = 3600;
+
+/*! @var kDefaultLatency
+    @brief The default of @c OIDSimulation.latency.
+ */
+static const NSTimeInterval kDefaultLatency = 0.2;
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*! @typedef OIDSimulatedTaskCompletionHandler
+    @brief The completion handler of a data task.
+ */
+typedef void (^OIDSimulatedTaskCompletionHandler)(NSData *_Nullable data,
+                                                   NSURLResponse *_Nullable response,
+                                                   NSError *_Nullable error);
+
+@class OIDSimulatedDataTask;
+
+@interface OIDSimulation ()
+
+/*! @fn startTask:
+    @brief Delivers the simulated token endpoint's response to a task once the latency has passed,
+        or fails it right away if it isn't a request to the token endpoint.
+    @param task The task.
+ */
+- (void)startTask:(OIDSimulatedDataTask *)task;
+
+@end
+
+/*! @class OIDSimulationEvent
+    @brief A block submitted to an @c OIDSimulation, and when it's due.
+ */
+@interface OIDSimulationEvent : NSObject
+
+/*! @property time
+    @brief When the block is due, in nanoseconds since the simulation was created.
+ */
+@property(nonatomic) OIDMonotonicTime time;
+
+/*! @property sequence
+    @brief The order the block was submitted in, which breaks ties between blocks due together.
+ */
+@property(nonatomic) NSUInteger sequence;
+
+/*! @property block
+    @brief The block.
+ */
+@property(nonatomic, copy) dispatch_block_t block;
+
+/*! @fn precedesEvent:
+    @brief Whether the event runs before another.
+    @param event The other event.
+ */
+- (BOOL)precedesEvent:(OIDSimulationEvent *)event;
+
+@end
+
+@implementation OIDSimulationEvent
+
+- (BOOL)precedesEvent:(OIDSimulationEvent *)event {
+  return _time < event.time || (_time == event.time && _sequence < event.sequence);
+}
+
+@end
+
+/*! @class OIDSimulatedDataTask
+    @brief A data task answered by the simulation rather than the network.
+ */
+@interface OIDSimulatedDataTask : NSURLSessionDataTask
+
+/*! @property request
+    @brief The request.
+ */
+@property(nonatomic, readonly) NSURLRequest *request;
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithRequest:simulation:completionHandler:
+    @brief Designated initializer.
+    @param request The request.
+    @param simulation The simulation answering the request.
+    @param completionHandler The completion handler of the task.
+ */
+- (instancetype)initWithRequest:(NSURLRequest *)request
+                     simulation:(OIDSimulation *)simulation
+              completionHandler:(OIDSimulatedTaskCompletionHandler)completionHandler
+    NS_DESIGNATED_INITIALIZER;
+
+/*! @fn completeWithData:response:error:
+    @brief Calls the completion handler, unless it was already called.
+    @return NO if the task had already completed, such as by being cancelled.
+ */
+- (BOOL)completeWithData:(nullable NSData *)data
+                response:(nullable NSURLResponse *)response
+                   error:(nullable NSError *)error;
+
+@end
+
+@implementation OIDSimulatedDataTask {
+  __weak OIDSimulation *_simulation;
+  OIDSimulatedTaskCompletionHandler _Nullable _completionHandler;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+- (instancetype)initWithRequest:(NSURLRequest *)request
+                     simulation:(OIDSimulation *)simulation
+              completionHandler:(OIDSimulatedTaskCompletionHandler)completionHandler {
+  self = [super init];
+  if (self) {
+    _request = [request copy];
+    _simulation = simulation;
+    _completionHandler = completionHandler;
+  }
+  return self;
+}
+#pragma clang diagnostic pop
+
+- (void)resume {
+  [_simulation startTask:self];
+}
+
+- (void)cancel {
+  NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                       code:NSURLErrorCancelled
+                                   userInfo:nil];
+  // like NSURLSession, calls the completion handler asynchronously
+  [_simulation performBlock:^{
+    [self completeWithData:nil response:nil error:error];
+  }];
+}
+
+- (BOOL)completeWithData:(nullable NSData *)data
+                response:(nullable NSURLResponse *)response
+                   error:(nullable NSError *)error {
+  OIDSimulatedTaskCompletionHandler completionHandler = _completionHandler;
+  _completionHandler = nil;
+  if (!completionHandler) {
+    return NO;
+  }
+  completionHandler(data, response, error);
+  return YES;
+}
+
+@end
+
+/*! @class OIDSimulatedURLSession
+    @brief A session whose data tasks are answered by the simulation.
+ */
+@interface OIDSimulatedURLSession : NSURLSession
+
+- (instancetype)init NS_UNAVAILABLE;
+
+/*! @fn initWithSimulation:
+    @brief Designated initializer.
+    @param simulation The simulation answering the session's requests.
+ */
+- (instancetype)initWithSimulation:(OIDSimulation *)simulation NS_DESIGNATED_INITIALIZER;
+
+@end
+
+@implementation OIDSimulatedURLSession {
+  __weak OIDSimulation *_simulation;
+}
+
+#pragma clang diagnostic push
+#pragma clang diagnostic ignored "-Wdeprecated-declarations"
+- (instancetype)initWithSimulation:(OIDSimulation *)simulation {
+  self = [super init];
+  if (self) {
+    _simulation = simulation;
+  }
+  return self;
+}
+#pragma clang diagnostic pop
+
+- (NSURLSessionDataTask *)dataTaskWithRequest:(NSURLRequest *)request
+                            completionHandler:(OIDSimulatedTaskCompletionHandler)completionHandler {
+  return [[OIDSimulatedDataTask alloc] initWithRequest:request
+                                            simulation:_simulation
+                                     completionHandler:completionHandler];
+}
+
+- (NSURLSessionDataTask *)dataTaskWithURL:(NSURL *)URL
+                        completionHandler:(OIDSimulatedTaskCompletionHandler)completionHandler {
+  return [self dataTaskWithRequest:[NSURLRequest requestWithURL:URL]
+                 completionHandler:completionHandler];
+}
+
+@end
+
+@implementation OIDSimulation {
+  /*! @var _session
+      @brief The session installed by @c install.
+   */
+  OIDSimulatedURLSession *_session;
+
+  /*! @var _origin
+      @brief The monotonic time the simulation starts at.
+   */
+  OIDMonotonicTime _origin;
+
+  /*! @var _originAbsoluteTime
+      @brief The wall-clock time the simulation starts at.
+   */
+  CFAbsoluteTime _originAbsoluteTime;
+
+  /*! @var _elapsed
+      @brief The virtual time passed, in nanoseconds.
+   */
+  OIDMonotonicTime _elapsed;
+
+  /*! @var _events
+      @brief The submitted blocks, as a binary min-heap ordered by @c precedesEvent:. Access is
+          synchronized on @c self.
+   */
+  NSMutableArray<OIDSimulationEvent *> *_events;
+
+  /*! @var _eventCount
+      @brief The number of blocks ever submitted, which numbers them. Access is synchronized on
+          @c self.
+   */
+  NSUInteger _eventCount;
+
+  /*! @var _tokenRequestsInFlight
+      @brief The number of requests the token endpoint is serving.
+   */
+  NSUInteger _tokenRequestsInFlight;
+
+  /*! @var _currentSecond
+      @brief The second of virtual time @c _tokenRequestsInCurrentSecond counts requests for.
+   */
+  uint64_t _currentSecond;
+
+  /*! @var _tokenRequestsInCurrentSecond
+      @brief The number of requests received in @c _currentSecond.
+   */
+  NSUInteger _tokenRequestsInCurrentSecond;
+}
+
+- (instancetype)init {
+  self = [super init];
+  if (self) {
+    _tokenEndpoint = [NSURL URLWithString:@"https://simulated.example/token"];
+    _accessTokenLifetime = kDefaultAccessTokenLifetime;
+    _latency = kDefaultLatency;
+    _session = [[OIDSimulatedURLSession alloc] initWithSimulation:self];
+    _origin = [OIDMonotonicClock now];
+    _originAbsoluteTime = [OIDMonotonicClock absoluteTime];
+    _events = [NSMutableArray array];
+  }
+  return self;
+}
+
+- (void)install {
+  [OIDMonotonicClock setClock:self];
+  [OIDAuthorizationService setExecutor:self];
+  [OIDAuthorizationService setURLSession:_session];
+  [OIDAuthorizationService setMetricsObserver:self];
+}
+
+- (void)uninstall {
+  [OIDMonotonicClock setClock:nil];
+  [OIDAuthorizationService setExecutor:nil];
+  [OIDAuthorizationService setURLSession:nil];
+  [OIDAuthorizationService setMetricsObserver:nil];
+}
+
+- (NSTimeInterval)elapsedTime {
+  return (NSTimeInterval)_elapsed / NSEC_PER_SEC;
+}
+
+- (void)runForInterval:(NSTimeInterval)interval {
+  OIDMonotonicTime end = _elapsed + [OIDMonotonicClock durationForInterval:interval];
+  while (YES) {
+    OIDSimulationEvent *event;
+    @synchronized(self) {
+      if (!_events.count || _events[0].time > end) {
+        break;
+      }
+      event = [self removeFirstEvent];
+    }
+    _elapsed = MAX(_elapsed, event.time);
+    event.block();
+  }
+  _elapsed = end;
+}
+
+#pragma mark - Event queue
+
+/*! @fn addEvent:
+    @brief Adds an event to the heap.
+    @remarks Must be called while synchronized on @c self.
+ */
+- (void)addEvent:(OIDSimulationEvent *)event {
+  NSUInteger index = _events.count;
+  [_events addObject:event];
+  while (index > 0) {
+    NSUInteger parent = (index - 1) / 2;
+    if (![event precedesEvent:_events[parent]]) {
+      break;
+    }
+    [_events exchangeObjectAtIndex:index withObjectAtIndex:parent];
+    index = parent;
+  }
+}
+
+/*! @fn removeFirstEvent
+    @brief Removes and returns the first event of the heap, which must not be empty.
+    @remarks Must be called while synchronized on @c self.
+ */
+- (OIDSimulationEvent *)removeFirstEvent {
+  OIDSimulationEvent *first = _events[0];
+  [_events exchangeObjectAtIndex:0 withObjectAtIndex:_events.count - 1];
+  [_events removeLastObject];
+  NSUInteger count = _events.count;
+  NSUInteger index = 0;
+  while (YES) {
+    NSUInteger smallest = index;
+    for (NSUInteger child = 2 * index + 1; child <= 2 * index + 2 && child < count; child++) {
+      if ([_events[child] precedesEvent:_events[smallest]]) {
+        smallest = child;
+      }
+    }
+    if (smallest == index) {
+      break;
+    }
+    [_events exchangeObjectAtIndex:index withObjectAtIndex:smallest];
+    index = smallest;
+  }
+  return first;
+}
+
+#pragma mark - OIDClock
+
+- (OIDMonotonicTime)now {
+  return _origin + _elapsed;
+}
+
+- (CFAbsoluteTime)absoluteTime {
+  return _originAbsoluteTime + self.elapsedTime;
+}
+
+#pragma mark - OIDExecutor
+
+- (void)performBlock:(dispatch_block_t)block {
+  [self performBlock:block afterDelay:0];
+}
+
+- (void)performBlock:(dispatch_block_t)block afterDelay:(NSTimeInterval)delay {
+  OIDSimulationEvent *event = [[OIDSimulationEvent alloc] init];
+  event.block = block;
+  @synchronized(self) {
+    event.time = _elapsed + [OIDMonotonicClock durationForInterval:delay];
+    event.sequence = _eventCount++;
+    [self addEvent:event];
+  }
+}
+
+#pragma mark - OIDMetricsObserver
+
+- (void)didRecordMetricsEvent:(OIDMetricsEvent *)event {
+  if (event.type != OIDMetricsEventTypeFreshTokens) {
+    return;
+  }
+  if (event.cacheResult == OIDMetricsCacheResultHit) {
+    _cacheHitCount++;
+  } else if (event.cacheResult == OIDMetricsCacheResultMiss) {
+    _refreshCount++;
+    _refreshWaiterCount += event.coalescedWaiterCount;
+  }
+}
+
+#pragma mark - Token endpoint
+
+- (void)startTask:(OIDSimulatedDataTask *)task {
+  if (![task.request.URL isEqual:_tokenEndpoint]) {
+    NSError *error = [NSError errorWithDomain:NSURLErrorDomain
+                                         code:NSURLErrorCannotFindHost
+                                     userInfo:nil];
+    [self performBlock:^{
+      [task completeWithData:nil response:nil error:error];
+    }];
+    return;
+  }
+
+  _tokenRequestCount++;
+  _tokenRequestsInFlight++;
+  _peakTokenRequestsInFlight = MAX(_peakTokenRequestsInFlight, _tokenRequestsInFlight);
+  uint64_t second = _elapsed / NSEC_PER_SEC;
+  if (second != _currentSecond) {
+    _currentSecond = second;
+    _tokenRequestsInCurrentSecond = 0;
+  }
+  _tokenRequestsInCurrentSecond++;
+  _peakTokenRequestsPerSecond = MAX(_peakTokenRequestsPerSecond, _tokenRequestsInCurrentSecond);
+
+  NSString *accessToken = [NSString stringWithFormat:@"access-%lu",
+                                                     (unsigned long)_tokenRequestCount];
+  NSDictionary<NSString *, id> *JSON = @{
+    @"access_token" : accessToken,
+    @"token_type" : @"Bearer",
+    @"expires_in" : @(_accessTokenLifetime),
+  };
+  [self performBlock:^{
+    self->_tokenRequestsInFlight--;
+    NSHTTPURLResponse *response =
+        [[NSHTTPURLResponse alloc] initWithURL:task.request.URL
+                                    statusCode:200
+                                   HTTPVersion:@"HTTP/1.1"
+                                  headerFields:@{ @"Content-Type" : @"application/json" }];
+    [task completeWithData:[NSJSONSerialization dataWithJSONObject:JSON options:0 error:NULL]
+                  response:response
+                     error:nil];
+  } afterDelay:_latency];
+}
+
+@end
+
+NS_ASSUME_NONNULL_END
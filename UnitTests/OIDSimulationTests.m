@@ -0,0 +1,286 @@
+/*! @file OIDSimulationTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "OIDSimulation.h"
+#import "Source/OIDAuthState.h"
+#import "Source/OIDAuthorizationRequest.h"
+#import "Source/OIDAuthorizationResponse.h"
+#import "Source/OIDError.h"
+#import "Source/OIDResponseTypes.h"
+#import "Source/OIDServiceConfiguration.h"
+#import "Source/OIDTokenRequest.h"
+#import "Source/OIDTokenRequestScheduler.h"
+#import "Source/OIDTokenResponse.h"
+
+/*! @var kPopulationSize
+    @brief The number of sessions in the simulated population.
+ */
+static const NSUInteger kPopulationSize = 1000;
+
+/*! @var kPopulationDuration
+    @brief How long the population is active for, in virtual seconds.
+ */
+static const NSTimeInterval kPopulationDuration = 4 * 60 * 60;
+
+/*! @var kMeanActivityInterval
+    @brief The mean time between a session's bursts of activity, in seconds.
+ */
+static const NSTimeInterval kMeanActivityInterval = 120;
+
+/*! @var kActionsPerActivity
+    @brief The number of actions needing fresh tokens in a burst of activity, such as the API
+        calls made to show a screen.
+ */
+static const NSUInteger kActionsPerActivity = 3;
+
+/*! @var kRefreshTolerance
+    @brief How long before its expiry @c OIDAuthState refreshes an access token.
+ */
+static const NSTimeInterval kRefreshTolerance = 60;
+
+/*! @var kMaxTokenRequestsPerSecond
+    @brief The most token requests the population may make within one second. It averages about
+        one every four seconds.
+ */
+static const NSUInteger kMaxTokenRequestsPerSecond = 10;
+
+/*! @class OIDSimulationTests
+    @brief Simulations of @c OIDAuthState refreshing tokens, run in virtual time with an
+        @c OIDSimulation.
+ */
+@interface OIDSimulationTests : XCTestCase
+@end
+
+@implementation OIDSimulationTests {
+  /*! @var _simulation
+      @brief The simulation, installed for each test.
+   */
+  OIDSimulation *_simulation;
+
+  /*! @var _actionCount
+      @brief The number of actions the simulated population performed.
+   */
+  NSUInteger _actionCount;
+
+  /*! @var _completedActionCount
+      @brief The number of actions which were called with an access token.
+   */
+  NSUInteger _completedActionCount;
+}
+
+- (void)setUp {
+  [super setUp];
+  _simulation = [[OIDSimulation alloc] init];
+  [_simulation install];
+}
+
+- (void)tearDown {
+  [_simulation uninstall];
+  _simulation = nil;
+  [super tearDown];
+}
+
+/*! @fn authStateWithAccessTokenLifetime:
+    @brief An auth state for the simulated token endpoint.
+    @param lifetime The remaining lifetime of the current access token.
+ */
+- (OIDAuthState *)authStateWithAccessTokenLifetime:(NSTimeInterval)lifetime {
+  OIDServiceConfiguration *configuration =
+      [[OIDServiceConfiguration alloc]
+          initWithAuthorizationEndpoint:[NSURL URLWithString:@"https://simulated.example/auth"]
+                          tokenEndpoint:_simulation.tokenEndpoint];
+  OIDAuthorizationRequest *request =
+      [[OIDAuthorizationRequest alloc] initWithConfiguration:configuration
+                                                    clientId:@"client"
+                                                      scopes:@[ @"openid" ]
+                                                 redirectURL:[NSURL URLWithString:@"app:/cb"]
+                                                responseType:OIDResponseTypeCode
+                                        additionalParameters:nil];
+  OIDAuthorizationResponse *authorizationResponse =
+      [[OIDAuthorizationResponse alloc] initWithRequest:request
+                                             parameters:@{ @"code" : @"code",
+                                                           @"state" : request.state }];
+  OIDTokenResponse *tokenResponse =
+      [[OIDTokenResponse alloc] initWithRequest:[authorizationResponse tokenExchangeRequest]
+                                     parameters:@{
+        @"access_token" : @"initial",
+        @"expires_in" : @(lifetime),
+        @"token_type" : @"Bearer",
+        @"refresh_token" : @"refresh",
+      }];
+  return [[OIDAuthState alloc] initWithAuthorizationResponse:authorizationResponse
+                                               tokenResponse:tokenResponse];
+}
+
+/*! @fn testVirtualTime
+    @brief Tests that blocks run in order of virtual time, and that the library reads that time.
+ */
+- (void)testVirtualTime {
+  NSDate *start = [OIDMonotonicClock date];
+  NSMutableArray<NSString *> *order = [NSMutableArray array];
+  [_simulation performBlock:^{
+    [order addObject:@"late"];
+  } afterDelay:3600];
+  [_simulation performBlock:^{
+    [order addObject:@"first"];
+    [self->_simulation performBlock:^{
+      [order addObject:@"submitted while running"];
+    }];
+  }];
+  [_simulation performBlock:^{
+    [order addObject:@"second"];
+  }];
+  [_simulation runForInterval:60];
+  NSArray<NSString *> *expected = @[ @"first", @"second", @"submitted while running" ];
+  XCTAssertEqualObjects(order, expected);
+
+  [_simulation runForInterval:3600];
+  XCTAssertEqualObjects(order.lastObject, @"late");
+  XCTAssertEqualWithAccuracy(_simulation.elapsedTime, 3660, 0.001);
+  XCTAssertEqualWithAccuracy([[OIDMonotonicClock date] timeIntervalSinceDate:start], 3660, 0.001);
+}
+
+/*! @fn testRefreshesCoalesce
+    @brief Tests that actions needing fresh tokens at the same time wait on a single refresh.
+ */
+- (void)testRefreshesCoalesce {
+  OIDAuthState *authState = [self authStateWithAccessTokenLifetime:3600];
+  [_simulation runForInterval:3600];
+  NSMutableArray<NSString *> *accessTokens = [NSMutableArray array];
+  for (NSUInteger i = 0; i < 10; i++) {
+    [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                              NSString *_Nullable idToken,
+                                              NSError *_Nullable error) {
+      XCTAssertNil(error);
+      [accessTokens addObject:accessToken ?: @""];
+    }];
+  }
+  [_simulation runForInterval:1];
+  XCTAssertEqual(accessTokens.count, 10u);
+  XCTAssertEqual([NSSet setWithArray:accessTokens].count, 1u);
+  XCTAssertEqualObjects(accessTokens.firstObject, @"access-1");
+  XCTAssertEqual(_simulation.tokenRequestCount, 1u);
+  XCTAssertEqual(_simulation.refreshCount, 1u);
+  XCTAssertEqual(_simulation.refreshWaiterCount, 10u);
+}
+
+/*! @fn testDeadline
+    @brief Tests that deadlines pass in virtual time.
+ */
+- (void)testDeadline {
+  _simulation.latency = 10;
+  OIDAuthState *authState = [self authStateWithAccessTokenLifetime:0];
+  NSDate *deadline = [[OIDMonotonicClock date] dateByAddingTimeInterval:5];
+  __block NSError *actionError;
+  __block NSTimeInterval actionTime = 0;
+  [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                            NSString *_Nullable idToken,
+                                            NSError *_Nullable error) {
+    actionError = error;
+    actionTime = self->_simulation.elapsedTime;
+  } deadline:deadline];
+  // also lets the abandoned request complete, releasing its slot in the shared scheduler
+  [_simulation runForInterval:20];
+  XCTAssertEqualObjects(actionError.domain, OIDGeneralErrorDomain);
+  XCTAssertEqual(actionError.code, OIDErrorCodeTimeout);
+  XCTAssertEqualWithAccuracy(actionTime, 5, 0.001);
+}
+
+/*! @fn scheduleActivityOfAuthState:
+    @brief Schedules a session's next burst of activity, after an exponentially distributed pause,
+        unless it would fall after the end of the simulation.
+    @param authState The session's auth state.
+ */
+- (void)scheduleActivityOfAuthState:(OIDAuthState *)authState {
+  NSTimeInterval delay = -log(1 - drand48()) * kMeanActivityInterval;
+  if (_simulation.elapsedTime + delay > kPopulationDuration) {
+    return;
+  }
+  [_simulation performBlock:^{
+    for (NSUInteger i = 0; i < kActionsPerActivity; i++) {
+      self->_actionCount++;
+      [authState withFreshTokensPerformAction:^(NSString *_Nullable accessToken,
+                                                NSString *_Nullable idToken,
+                                                NSError *_Nullable error) {
+        if (accessToken) {
+          self->_completedActionCount++;
+        }
+      }];
+    }
+    [self scheduleActivityOfAuthState:authState];
+  } afterDelay:delay];
+}
+
+/*! @fn testPopulation
+    @brief Simulates a population of sessions with tokens at every stage of their lifetime, and
+        measures the refreshes they cause.
+ */
+- (void)testPopulation {
+  srand48(1);
+  NSTimeInterval lifetime = _simulation.accessTokenLifetime;
+  NSMutableArray<OIDAuthState *> *authStates = [NSMutableArray array];
+  for (NSUInteger i = 0; i < kPopulationSize; i++) {
+    OIDAuthState *authState = [self authStateWithAccessTokenLifetime:drand48() * lifetime];
+    [authStates addObject:authState];
+    [self scheduleActivityOfAuthState:authState];
+  }
+  [_simulation runForInterval:kPopulationDuration + 60];
+
+  NSUInteger tokenRequestCount = _simulation.tokenRequestCount;
+  NSUInteger refreshCount = _simulation.refreshCount;
+
+  // every action got a token, either the current one or after waiting on a refresh
+  XCTAssertGreaterThan(_actionCount, 0u);
+  XCTAssertEqual(_completedActionCount, _actionCount);
+  XCTAssertEqual(_simulation.cacheHitCount + _simulation.refreshWaiterCount, _actionCount);
+  XCTAssertEqual(refreshCount, tokenRequestCount);
+
+  // each session refreshes at most once per token lifetime, and at least about as often
+  NSUInteger maxRefreshesPerSession =
+      1 + (NSUInteger)(kPopulationDuration / (lifetime - kRefreshTolerance));
+  XCTAssertLessThanOrEqual(tokenRequestCount, kPopulationSize * maxRefreshesPerSession);
+  XCTAssertGreaterThanOrEqual(tokenRequestCount,
+                              kPopulationSize * (NSUInteger)(kPopulationDuration / lifetime - 1));
+
+  // a token lasts about an hour, so each session refreshes about once an hour
+  double tokenRequestsPerSessionHour =
+      tokenRequestCount * 3600 / kPopulationDuration / kPopulationSize;
+  XCTAssertEqualWithAccuracy(tokenRequestsPerSessionHour, 3600 / lifetime, 0.1);
+
+  // the burst which finds the token stale waits on a single refresh, and only rarely does another
+  // burst of the same session arrive while it is in flight
+  double waitersPerRefresh = (double)_simulation.refreshWaiterCount / MAX(refreshCount, 1u);
+  XCTAssertGreaterThanOrEqual(waitersPerRefresh, kActionsPerActivity);
+  XCTAssertLessThan(waitersPerRefresh, kActionsPerActivity * 1.05);
+
+  // so all but the first burst after each expiry are served from the cache
+  double cacheHitRatio = (double)_simulation.cacheHitCount / _actionCount;
+  XCTAssertGreaterThan(cacheHitRatio, 0.9);
+  XCTAssertLessThan(cacheHitRatio, 0.99);
+
+  // expiries are spread out, so refreshes don't arrive in bursts
+  XCTAssertGreaterThan(_simulation.peakTokenRequestsPerSecond, 0u);
+  XCTAssertLessThanOrEqual(_simulation.peakTokenRequestsPerSecond, kMaxTokenRequestsPerSecond);
+  XCTAssertLessThanOrEqual(_simulation.peakTokenRequestsInFlight,
+                           [OIDTokenRequestScheduler sharedScheduler]
+                               .maxConcurrentRequestsPerEndpoint);
+}
+
+@end
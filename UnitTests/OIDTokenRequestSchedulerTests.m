@@ -0,0 +1,181 @@
+/*! @file OIDTokenRequestSchedulerTests.m
+    @brief AppAuth iOS SDK
+    @copyright
+        Copyright 2016 Google Inc. All Rights Reserved.
+    @copydetails
+        Licensed under the Apache License, Version 2.0 (the "License");
+        you may not use this file except in compliance with the License.
+        You may obtain a copy of the License at
+
+        http://www.apache.org/licenses/LICENSE-2.0
+
+        Unless required by applicable law or agreed to in writing, software
+        distributed under the License is distributed on an "AS IS" BASIS,
+        WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+        See the License for the specific language governing permissions and
+        limitations under the License.
+ */
+
+#import <XCTest/XCTest.h>
+
+#import "Source/OIDTokenRequestScheduler.h"
+
+/*! @var kTestEndpoint
+    @brief The endpoint used by most tests.
+ */
+static NSString *const kTestEndpoint = @"https://www.example.com/token";
+
+/*! @var kOtherTestEndpoint
+    @brief A second endpoint, for testing that limits apply per endpoint.
+ */
+static NSString *const kOtherTestEndpoint = @"https://www.example.net/token";
+
+/*! @class OIDTokenRequestSchedulerTests
+    @brief Unit tests for @c OIDTokenRequestScheduler.
+ */
+@interface OIDTokenRequestSchedulerTests : XCTestCase
+@end
+
+@implementation OIDTokenRequestSchedulerTests {
+  /*! @var _startedOperations
+      @brief The names of the operations started so far, in order.
+   */
+  NSMutableArray<NSString *> *_startedOperations;
+
+  /*! @var _completions
+      @brief The completion blocks of the started operations, keyed by name.
+   */
+  NSMutableDictionary<NSString *, dispatch_block_t> *_completions;
+}
+
+- (void)setUp {
+  [super setUp];
+  _startedOperations = [NSMutableArray array];
+  _completions = [NSMutableDictionary dictionary];
+}
+
+/*! @fn schedule:onScheduler:endpoint:priority:
+    @brief Schedules an operation which records when it is started, and keeps its completion block
+        so the test can complete it later.
+    @param name The name identifying the operation.
+    @param scheduler The scheduler.
+    @param endpoint The endpoint of the operation.
+    @param priority The priority of the operation.
+ */
+- (void)schedule:(NSString *)name
+     onScheduler:(OIDTokenRequestScheduler *)scheduler
+        endpoint:(NSString *)endpoint
+        priority:(OIDTokenRequestPriority)priority {
+  [scheduler scheduleOperationForEndpoint:[NSURL URLWithString:endpoint]
+                                 priority:priority
+                                operation:^(dispatch_block_t completion) {
+    [_startedOperations addObject:name];
+    _completions[name] = completion;
+  }];
+}
+
+/*! @fn complete:
+    @brief Completes a started operation.
+    @param name The name identifying the operation.
+ */
+- (void)complete:(NSString *)name {
+  dispatch_block_t completion = _completions[name];
+  XCTAssertNotNil(completion, @"Operation %@ was never started.", name);
+  [_completions removeObjectForKey:name];
+  completion();
+}
+
+/*! @fn testLimitPerEndpoint
+    @brief Tests that operations beyond the limit are queued, and started in order.
+ */
+- (void)testLimitPerEndpoint {
+  OIDTokenRequestScheduler *scheduler =
+      [[OIDTokenRequestScheduler alloc] initWithMaxConcurrentRequestsPerEndpoint:2
+                                      maxConcurrentBackgroundRequestsPerEndpoint:1];
+  [self schedule:@"a" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  [self schedule:@"b" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  [self schedule:@"c" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"a", @"b" ]));
+
+  [self complete:@"b"];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"a", @"b", @"c" ]));
+}
+
+/*! @fn testLimitIsPerEndpoint
+    @brief Tests that operations to different endpoints don't hold each other up.
+ */
+- (void)testLimitIsPerEndpoint {
+  OIDTokenRequestScheduler *scheduler =
+      [[OIDTokenRequestScheduler alloc] initWithMaxConcurrentRequestsPerEndpoint:1
+                                      maxConcurrentBackgroundRequestsPerEndpoint:1];
+  [self schedule:@"a" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  [self schedule:@"b" onScheduler:scheduler endpoint:kOtherTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"a", @"b" ]));
+}
+
+/*! @fn testForegroundJumpsBackgroundQueue
+    @brief Tests that queued foreground refreshes start before earlier queued background
+        prefetches.
+ */
+- (void)testForegroundJumpsBackgroundQueue {
+  OIDTokenRequestScheduler *scheduler =
+      [[OIDTokenRequestScheduler alloc] initWithMaxConcurrentRequestsPerEndpoint:1
+                                      maxConcurrentBackgroundRequestsPerEndpoint:1];
+  [self schedule:@"background1" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityBackgroundPrefetch];
+  [self schedule:@"background2" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityBackgroundPrefetch];
+  [self schedule:@"foreground" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"background1" ]));
+
+  [self complete:@"background1"];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"background1", @"foreground" ]));
+
+  [self complete:@"foreground"];
+  XCTAssertEqualObjects(_startedOperations,
+                        (@[ @"background1", @"foreground", @"background2" ]));
+}
+
+/*! @fn testBackgroundLimit
+    @brief Tests that background prefetches leave slots free for foreground refreshes.
+ */
+- (void)testBackgroundLimit {
+  OIDTokenRequestScheduler *scheduler =
+      [[OIDTokenRequestScheduler alloc] initWithMaxConcurrentRequestsPerEndpoint:3
+                                      maxConcurrentBackgroundRequestsPerEndpoint:1];
+  [self schedule:@"background1" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityBackgroundPrefetch];
+  [self schedule:@"background2" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityBackgroundPrefetch];
+  [self schedule:@"foreground" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"background1", @"foreground" ]));
+}
+
+/*! @fn testInteractiveIsNeverQueued
+    @brief Tests that interactive requests start immediately even when the endpoint is saturated.
+ */
+- (void)testInteractiveIsNeverQueued {
+  OIDTokenRequestScheduler *scheduler =
+      [[OIDTokenRequestScheduler alloc] initWithMaxConcurrentRequestsPerEndpoint:1
+                                      maxConcurrentBackgroundRequestsPerEndpoint:1];
+  [self schedule:@"foreground1" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  [self schedule:@"foreground2" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityForegroundRefresh];
+  [self schedule:@"interactive" onScheduler:scheduler endpoint:kTestEndpoint
+        priority:OIDTokenRequestPriorityInteractive];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"foreground1", @"interactive" ]));
+
+  // completing the interactive request doesn't free up a slot it never occupied
+  [self complete:@"interactive"];
+  XCTAssertEqualObjects(_startedOperations, (@[ @"foreground1", @"interactive" ]));
+}
+
+@end
@@ -19,6 +19,7 @@
 
 #import "OIDAuthorizationResponseTests.h"
 #import "OIDTokenRequestTests.h"
+#import "Source/OIDMonotonicClock.h"
 #import "Source/OIDTokenRequest.h"
 #import "Source/OIDTokenResponse.h"
 
@@ -200,4 +201,45 @@ static NSString *const kTestAdditionalParameterValue = @"example_value";
                         kTestAdditionalParameterValue);
 }
 
+/*! @fn testExpirationDeadline
+    @brief Tests that @c expires_in becomes a monotonic deadline, and isn't an additional parameter.
+ */
+- (void)testExpirationDeadline {
+  OIDTokenResponse *response = [[self class] testInstance];
+  NSTimeInterval remaining = [OIDMonotonicClock intervalUntilTime:
+                                 response.accessTokenExpirationDeadline];
+  XCTAssert(remaining > kExpiresInTestValue - 5 && remaining <= kExpiresInTestValue);
+  XCTAssertNil(response.additionalParameters[kExpiresInKey]);
+
+  OIDTokenResponse *noExpiry =
+      [[OIDTokenResponse alloc] initWithRequest:response.request
+                                     parameters:@{ kAccessTokenKey : kAccessTokenTestValue }];
+  XCTAssertEqual(noExpiry.accessTokenExpirationDeadline, 0u);
+  XCTAssertNil(noExpiry.accessTokenExpirationDate);
+}
+
+/*! @fn testSecureCodingKeepsExpiry
+    @brief Tests that the expiry is archived as a date, and restored as a deadline.
+ */
+- (void)testSecureCodingKeepsExpiry {
+  OIDTokenResponse *response = [[self class] testInstance];
+  // earlier versions decode the expiry as a date
+  NSMutableData *fields = [NSMutableData data];
+  NSKeyedArchiver *archiver = [[NSKeyedArchiver alloc] initForWritingWithMutableData:fields];
+  [response encodeWithCoder:archiver];
+  [archiver finishEncoding];
+  NSKeyedUnarchiver *unarchiver = [[NSKeyedUnarchiver alloc] initForReadingWithData:fields];
+  XCTAssertEqualObjects([unarchiver decodeObjectOfClass:[NSDate class] forKey:kExpiresInKey],
+                        response.accessTokenExpirationDate);
+
+  NSData *data = [NSKeyedArchiver archivedDataWithRootObject:response];
+  OIDTokenResponse *responseCopy = [NSKeyedUnarchiver unarchiveObjectWithData:data];
+  XCTAssertEqualWithAccuracy(responseCopy.accessTokenExpirationDate.timeIntervalSinceReferenceDate,
+                             response.accessTokenExpirationDate.timeIntervalSinceReferenceDate,
+                             0.001);
+  NSTimeInterval remaining = [OIDMonotonicClock intervalUntilTime:
+                                 responseCopy.accessTokenExpirationDeadline];
+  XCTAssert(remaining > kExpiresInTestValue - 5 && remaining <= kExpiresInTestValue);
+}
+
 @end
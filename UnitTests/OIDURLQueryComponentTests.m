@@ -140,4 +140,34 @@ static NSString *const kTestURLRoot = @"https://www.example.com/";
   XCTAssertEqualObjects(query.dictionaryValue, parameters);
 }
 
+/*! @fn testRedirectParameters
+    @brief Tests that redirect parameters are parsed from both the query and the fragment.
+ */
+- (void)testRedirectParameters {
+  NSString *URLString =
+      [NSString stringWithFormat:@"%@?code=abc&state=s%%20t#access_token=xyz&state=u&flag",
+                                 kTestURLRoot];
+  NSDictionary<NSString *, NSObject<NSCopying> *> *parameters =
+      [OIDURLQueryComponent redirectParametersWithURL:[NSURL URLWithString:URLString]];
+  NSDictionary<NSString *, NSObject<NSCopying> *> *expected =
+      @{
+        @"code" : @"abc",
+        @"state" : @[ @"s t", @"u" ],
+        @"access_token" : @"xyz",
+      };
+  XCTAssertEqualObjects(parameters, expected);
+}
+
+/*! @fn testRedirectParametersMatchQueryParsing
+    @brief Tests that redirect parameters in the query are parsed like any other query.
+ */
+- (void)testRedirectParametersMatchQueryParsing {
+  NSString *URLString =
+      [NSString stringWithFormat:@"%@?%@", kTestURLRoot, kTestSimpleParameterStringEncoded];
+  NSURL *URL = [NSURL URLWithString:URLString];
+  OIDURLQueryComponent *query = [[OIDURLQueryComponent alloc] initWithURL:URL];
+  XCTAssertEqualObjects([OIDURLQueryComponent redirectParametersWithURL:URL],
+                        query.dictionaryValue);
+}
+
 @end